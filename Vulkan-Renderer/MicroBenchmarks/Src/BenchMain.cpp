@@ -0,0 +1,85 @@
+#include "BenchUtils.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace Benchmarks
+{
+	void RunFrustumCullingBench(BenchReport& report);
+	void RunBvhBench(BenchReport& report);
+	void RunSoftwareOcclusionBench(BenchReport& report);
+	void RunDrawListBench(BenchReport& report);
+	void RunGBufferBench(BenchReport& report);
+	void RunVisibilityBufferBench(BenchReport& report);
+	void RunClusteredLightingBench(BenchReport& report);
+	void RunCascadedShadowsBench(BenchReport& report);
+	void RunRenderGraphBench(BenchReport& report);
+	void RunProfilerBench(BenchReport& report);
+	void RunMemoryPoolBench(BenchReport& report);
+}
+
+struct BenchEntry
+{
+	const char* name;
+	void (*run)(Benchmarks::BenchReport& report);
+};
+
+static const BenchEntry BENCHMARKS[] = {
+	{ "FrustumCulling", Benchmarks::RunFrustumCullingBench },
+	{ "BVH", Benchmarks::RunBvhBench },
+	{ "SoftwareOcclusion", Benchmarks::RunSoftwareOcclusionBench },
+	{ "DrawList", Benchmarks::RunDrawListBench },
+	{ "GBuffer", Benchmarks::RunGBufferBench },
+	{ "VisibilityBuffer", Benchmarks::RunVisibilityBufferBench },
+	{ "ClusteredLighting", Benchmarks::RunClusteredLightingBench },
+	{ "CascadedShadows", Benchmarks::RunCascadedShadowsBench },
+	{ "RenderGraph", Benchmarks::RunRenderGraphBench },
+	{ "Profiler", Benchmarks::RunProfilerBench },
+	{ "MemoryPool", Benchmarks::RunMemoryPoolBench },
+};
+
+// Usage : MicroBenchmarks [benchmark names...] [--json output.json]
+int main(int argc, char** argv)
+{
+	std::vector<std::string> filters;
+	std::string jsonPath = "microbenchmarks.json";
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			jsonPath = argv[++i];
+		}
+		else
+		{
+			filters.push_back(argv[i]);
+		}
+	}
+
+	Benchmarks::BenchReport report;
+	bool failed = false;
+
+	for (const BenchEntry& entry : BENCHMARKS)
+	{
+		if (!filters.empty() && std::find(filters.begin(), filters.end(), entry.name) == filters.end())
+		{
+			continue;
+		}
+
+		std::cout << "\n== " << entry.name << "\n";
+		// A benchmark throws when its results are wrong, the others still run
+		try
+		{
+			entry.run(report);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << entry.name << " failed : " << e.what() << "\n";
+			failed = true;
+		}
+	}
+
+	report.WriteJson(jsonPath);
+	std::cout << "\nResults written to " << jsonPath << "\n";
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Benchmarks
+{
+	struct BenchResult
+	{
+		std::string benchmark;
+		std::string variant;
+		size_t itemCount = 0;
+		double msPerRun = 0.0;
+		double nsPerItem = 0.0;
+		std::vector<std::pair<std::string, double>> metrics; // Extra named values, e.g. visible counts or speedups
+	};
+
+	class BenchReport
+	{
+	public:
+		void Add(const BenchResult& result)
+		{
+			std::cout << std::left << std::setw(24) << result.benchmark << std::setw(28) << result.variant
+				<< std::right << std::setw(10) << result.itemCount
+				<< std::setw(12) << std::fixed << std::setprecision(3) << result.msPerRun << " ms"
+				<< std::setw(10) << std::setprecision(2) << result.nsPerItem << " ns/item";
+
+			for (const auto& metric : result.metrics)
+			{
+				std::cout << "  " << metric.first << "=" << metric.second;
+			}
+
+			std::cout << "\n";
+			results.push_back(result);
+		}
+
+		void WriteJson(const std::string& filePath) const
+		{
+			std::ofstream outputStream(filePath);
+			outputStream << "{\"results\":[";
+
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const BenchResult& result = results[i];
+				outputStream << (i > 0 ? "," : "") << "{";
+				outputStream << "\"benchmark\":\"" << result.benchmark << "\",";
+				outputStream << "\"variant\":\"" << result.variant << "\",";
+				outputStream << "\"items\":" << result.itemCount << ",";
+				outputStream << "\"msPerRun\":" << result.msPerRun << ",";
+				outputStream << "\"nsPerItem\":" << result.nsPerItem;
+
+				for (const auto& metric : result.metrics)
+				{
+					outputStream << ",\"" << metric.first << "\":" << metric.second;
+				}
+
+				outputStream << "}";
+			}
+
+			outputStream << "]}";
+		}
+
+	private:
+		std::vector<BenchResult> results;
+	};
+
+	/** Runs func repeatedly and returns the median duration of a single run in milliseconds */
+	template<typename Func>
+	double MeasureMilliseconds(Func&& func, uint32_t iterations)
+	{
+		std::vector<double> timings(iterations);
+
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			func();
+			auto end = std::chrono::high_resolution_clock::now();
+			timings[i] = std::chrono::duration<double, std::milli>(end - start).count();
+		}
+
+		std::sort(timings.begin(), timings.end());
+		return timings[timings.size() / 2];
+	}
+
+	/** Keeps the compiler from discarding results that are otherwise unused, the value's address escapes to memory it can't reason about */
+	template<typename T>
+	void DoNotOptimize(const T& value)
+	{
+#if defined(_MSC_VER)
+		static volatile const void* sink;
+		sink = &value;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "g"(&value) : "memory");
+#endif
+	}
+
+	/** Small deterministic generator so every run sees the same scene */
+	struct Random
+	{
+		uint64_t state;
+
+		explicit Random(uint64_t seed) : state(seed * 6364136223846793005ULL + 1442695040888963407ULL) {}
+
+		uint32_t Next()
+		{
+			state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+			return static_cast<uint32_t>(state >> 33);
+		}
+
+		float Range(float minValue, float maxValue)
+		{
+			return minValue + (maxValue - minValue) * (Next() / static_cast<float>(0x7FFFFFFF));
+		}
+	};
+}
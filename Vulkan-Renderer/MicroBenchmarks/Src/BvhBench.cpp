@@ -0,0 +1,159 @@
+#include "BenchUtils.h"
+#include "BoundingVolumeHierarchy.h"
+#include "FrustumCulling.h"
+#include <GLM/gtc/matrix_transform.hpp>
+
+using namespace Renderer;
+
+namespace Benchmarks
+{
+	static BoundingBoxSoA CreateRandomSceneBounds(size_t count, Random& random)
+	{
+		BoundingBoxSoA bounds;
+		bounds.Resize(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			BoundingBox box;
+			glm::vec3 center(random.Range(-1000.0f, 1000.0f), random.Range(-1000.0f, 1000.0f), random.Range(-1000.0f, 1000.0f));
+			glm::vec3 extents(random.Range(0.5f, 10.0f), random.Range(0.5f, 10.0f), random.Range(0.5f, 10.0f));
+			box.min = center - extents;
+			box.max = center + extents;
+			bounds.Set(i, box);
+		}
+
+		return bounds;
+	}
+
+	static BenchResult MakeResult(const char* variant, size_t itemCount, double ms)
+	{
+		BenchResult result;
+		result.benchmark = "BVH";
+		result.variant = variant;
+		result.itemCount = itemCount;
+		result.msPerRun = ms;
+		result.nsPerItem = ms * 1e6 / itemCount;
+		return result;
+	}
+
+	void RunBvhBench(BenchReport& report)
+	{
+		const std::vector<size_t> objectCounts = { 10000, 100000, 1000000 };
+		constexpr uint32_t RAY_COUNT = 10000;
+
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+		projection[1][1] *= -1.0f;
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 200.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		Frustum frustum = Frustum::FromViewProjection(projection * view);
+
+		for (size_t objectCount : objectCounts)
+		{
+			Random random(objectCount);
+			BoundingBoxSoA bounds = CreateRandomSceneBounds(objectCount, random);
+			const uint32_t iterations = objectCount >= 1000000 ? 5 : 20;
+
+			BoundingVolumeHierarchy bvh;
+			double buildMs = MeasureMilliseconds([&]() { bvh.Build(bounds); }, iterations);
+
+			BenchResult buildResult = MakeResult("Build (binned SAH)", objectCount, buildMs);
+			buildResult.metrics.push_back({ "nodes", static_cast<double>(bvh.GetNodeCount()) });
+			buildResult.metrics.push_back({ "sahCost", bvh.GetSAHCost() });
+			report.Add(buildResult);
+
+			// Move 1% of the objects a little, as an animated scene would every frame
+			std::vector<uint32_t> movedItems;
+			for (size_t i = 0; i < objectCount; i += 100)
+			{
+				movedItems.push_back(static_cast<uint32_t>(i));
+			}
+
+			for (uint32_t item : movedItems)
+			{
+				BoundingBox box = bounds.Get(item);
+				const glm::vec3 offset(random.Range(-5.0f, 5.0f), random.Range(-5.0f, 5.0f), random.Range(-5.0f, 5.0f));
+				box.min += offset;
+				box.max += offset;
+				bounds.Set(item, box);
+			}
+
+			double refitMs = MeasureMilliseconds([&]() { bvh.Refit(bounds); }, iterations);
+			report.Add(MakeResult("Refit (full)", objectCount, refitMs));
+
+			double refitItemsMs = MeasureMilliseconds([&]() { bvh.RefitItems(bounds, movedItems); }, iterations);
+			BenchResult refitItemsResult = MakeResult("Refit (1% moved)", movedItems.size(), refitItemsMs);
+			refitItemsResult.metrics.push_back({ "sahCostAfterRefit", bvh.GetSAHCost() });
+			report.Add(refitItemsResult);
+
+			std::vector<uint32_t> flatVisible;
+			double flatMs = MeasureMilliseconds([&]() { FrustumCuller::Cull(frustum, bounds, flatVisible); DoNotOptimize(flatVisible); }, iterations);
+
+			std::vector<uint32_t> bvhVisible;
+			double bvhCullMs = MeasureMilliseconds([&]() { bvh.CullFrustum(frustum, bvhVisible); DoNotOptimize(bvhVisible); }, iterations);
+
+			std::vector<uint32_t> sortedBvhVisible = bvhVisible;
+			std::sort(sortedBvhVisible.begin(), sortedBvhVisible.end());
+
+			BenchResult flatResult = MakeResult("Frustum cull (flat SIMD)", objectCount, flatMs);
+			flatResult.metrics.push_back({ "visible", static_cast<double>(flatVisible.size()) });
+			report.Add(flatResult);
+
+			BenchResult bvhCullResult = MakeResult("Frustum cull (BVH)", objectCount, bvhCullMs);
+			bvhCullResult.metrics.push_back({ "visible", static_cast<double>(bvhVisible.size()) });
+			bvhCullResult.metrics.push_back({ "matchesFlat", sortedBvhVisible == flatVisible ? 1.0 : 0.0 });
+			bvhCullResult.metrics.push_back({ "speedup", flatMs / bvhCullMs });
+			report.Add(bvhCullResult);
+
+			// Random picking rays from the camera position, checked against a brute force search over every box
+			std::vector<BoundingVolumeHierarchy::Ray> rays(RAY_COUNT);
+			for (BoundingVolumeHierarchy::Ray& ray : rays)
+			{
+				ray.origin = glm::vec3(0.0f, 0.0f, 200.0f);
+				ray.direction = glm::normalize(glm::vec3(random.Range(-0.5f, 0.5f), random.Range(-0.3f, 0.3f), -1.0f));
+			}
+
+			uint32_t hitCount = 0;
+			double rayMs = MeasureMilliseconds([&]()
+				{
+					hitCount = 0;
+					for (const BoundingVolumeHierarchy::Ray& ray : rays)
+					{
+						BoundingVolumeHierarchy::RayHit hit;
+						hitCount += bvh.RayCast(ray, hit) ? 1 : 0;
+					}
+				}, iterations);
+
+			uint32_t mismatches = 0;
+			for (uint32_t r = 0; r < 100; r++)
+			{
+				const BoundingVolumeHierarchy::Ray& ray = rays[r];
+				const glm::vec3 inverseDirection = 1.0f / ray.direction;
+				float closest = FLT_MAX;
+
+				for (size_t i = 0; i < objectCount; i++)
+				{
+					const BoundingBox box = bounds.Get(i);
+					const glm::vec3 t0 = (box.min - ray.origin) * inverseDirection;
+					const glm::vec3 t1 = (box.max - ray.origin) * inverseDirection;
+					const glm::vec3 tNear = glm::min(t0, t1);
+					const glm::vec3 tFar = glm::max(t0, t1);
+					const float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+					const float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+
+					if (entry <= exit && entry < closest)
+					{
+						closest = entry;
+					}
+				}
+
+				BoundingVolumeHierarchy::RayHit hit;
+				bvh.RayCast(ray, hit);
+				mismatches += hit.distance == closest ? 0 : 1;
+			}
+
+			BenchResult rayResult = MakeResult("Ray query (pick)", RAY_COUNT, rayMs);
+			rayResult.metrics.push_back({ "hits", static_cast<double>(hitCount) });
+			rayResult.metrics.push_back({ "bruteForceMismatches", static_cast<double>(mismatches) });
+			report.Add(rayResult);
+		}
+	}
+}
@@ -0,0 +1,161 @@
+#include "BenchUtils.h"
+#include "CascadedShadows.h"
+#include <GLM/gtc/matrix_transform.hpp>
+#include <cmath>
+
+using namespace Renderer;
+
+namespace Benchmarks
+{
+	// Cascades and casters over a whole camera path, what would reach the shadow passes
+	struct ShadowPathTotals
+	{
+		uint64_t cascadesRendered = 0;
+		uint64_t casterDraws = 0;
+		uint64_t casterTests = 0;
+	};
+
+	void RunCascadedShadowsBench(BenchReport& report)
+	{
+		constexpr uint32_t STATIC_GRID = 64;
+		constexpr float STATIC_SPACING = 12.0f;
+		constexpr uint32_t DYNAMIC_COUNT = 16;
+		constexpr uint32_t FRAME_COUNT = 600;
+		constexpr uint32_t STATIC_CHANGE_INTERVAL = 150;
+		constexpr uint32_t SHADOW_MAP_SIZE = 2048;
+		constexpr float SHADOW_DISTANCE = 400.0f;
+		constexpr uint32_t ITERATIONS = 3;
+
+		glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+		projection[1][1] *= -1.0f;
+		const glm::vec3 toLight = glm::normalize(glm::vec3(0.29f, 0.92f, 0.26f));
+
+		// A field of static buildings, centered on the origin
+		Random random(36);
+		std::vector<Utilities::BoundingBox> staticBounds;
+		const float gridOffset = STATIC_GRID * STATIC_SPACING * 0.5f;
+		for (uint32_t z = 0; z < STATIC_GRID; z++)
+		{
+			for (uint32_t x = 0; x < STATIC_GRID; x++)
+			{
+				const glm::vec3 base(x * STATIC_SPACING - gridOffset, 0.0f, z * STATIC_SPACING - gridOffset);
+				const glm::vec3 size(random.Range(2.0f, 6.0f), random.Range(4.0f, 30.0f), random.Range(2.0f, 6.0f));
+				staticBounds.push_back({ base - glm::vec3(size.x, 0.0f, size.z), base + size });
+			}
+		}
+
+		// The camera walks through the field turning slowly, dynamic casters move around it
+		auto cameraView = [](uint32_t frame)
+		{
+			const float t = frame / static_cast<float>(FRAME_COUNT);
+			const glm::vec3 eye(-200.0f + 400.0f * t, 10.0f, 40.0f * std::sin(t * 6.0f));
+			const glm::vec3 forward(std::cos(t * 3.0f), -0.1f, -std::sin(t * 3.0f));
+			return glm::lookAt(eye, eye + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+		};
+
+		auto dynamicCaster = [](uint32_t frame, uint32_t index, const glm::mat4& view)
+		{
+			const glm::vec3 eye = glm::vec3(glm::inverse(view)[3]);
+			const float angle = frame * 0.05f + index * 6.2831853f / DYNAMIC_COUNT;
+			const glm::vec3 center = eye + glm::vec3(std::cos(angle) * 15.0f, -8.0f, std::sin(angle) * 15.0f);
+			return Utilities::BoundingBox{ center - glm::vec3(1.0f), center + glm::vec3(1.0f) };
+		};
+
+		auto runPath = [&](bool cacheStaticCascades, ShadowPathTotals& totals)
+		{
+			totals = {};
+			std::vector<Utilities::BoundingBox> pathStaticBounds = staticBounds;
+			ShadowCascadeCache cache;
+			ShadowCascades cascades;
+			std::array<bool, SHADOW_CASCADE_COUNT> renderCascades;
+			std::array<Utilities::BoundingBox, DYNAMIC_COUNT> dynamicBounds;
+
+			for (uint32_t frame = 0; frame < FRAME_COUNT; frame++)
+			{
+				const glm::mat4 view = cameraView(frame);
+
+				// A building is raised now and then, the cascades covering it have to drop what they cached
+				if (frame > 0 && frame % STATIC_CHANGE_INTERVAL == 0)
+				{
+					Utilities::BoundingBox& changed = pathStaticBounds[(frame * 7919) % pathStaticBounds.size()];
+					cache.InvalidateStaticBounds(changed);
+					changed.max.y += 10.0f;
+					cache.InvalidateStaticBounds(changed);
+				}
+
+				FitShadowCascades(view, projection, toLight, SHADOW_DISTANCE, SHADOW_MAP_SIZE, cascades);
+
+				// Same order as the renderer, only the moving casters decide which cascades render
+				for (uint32_t i = 0; i < DYNAMIC_COUNT; i++)
+				{
+					dynamicBounds[i] = dynamicCaster(frame, i, view);
+				}
+
+				if (cacheStaticCascades)
+				{
+					std::array<bool, SHADOW_CASCADE_COUNT> hasDynamicCasters = {};
+					for (const Utilities::BoundingBox& bounds : dynamicBounds)
+					{
+						for (uint32_t cascade = FIRST_CACHED_SHADOW_CASCADE; cascade < SHADOW_CASCADE_COUNT; cascade++)
+						{
+							hasDynamicCasters[cascade] = hasDynamicCasters[cascade] || CascadeSliceContainsCaster(cascades, cascade, view, bounds);
+						}
+					}
+					totals.casterTests += DYNAMIC_COUNT * (SHADOW_CASCADE_COUNT - FIRST_CACHED_SHADOW_CASCADE);
+
+					cache.Update(cascades, hasDynamicCasters, renderCascades);
+				}
+				else
+				{
+					renderCascades.fill(true);
+				}
+
+				// Casters are only gathered for the cascades being rendered, a cached cascade skips the whole scene
+				for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+				{
+					if (!renderCascades[cascade])
+					{
+						continue;
+					}
+
+					uint32_t casterCount = 0;
+					for (const Utilities::BoundingBox& bounds : pathStaticBounds)
+					{
+						casterCount += CascadeContainsCaster(cascades[cascade].viewProjection, bounds) ? 1 : 0;
+					}
+
+					// Uncached cascades take every moving caster, cached ones only those in their slice
+					for (const Utilities::BoundingBox& bounds : dynamicBounds)
+					{
+						const bool containsCaster = cacheStaticCascades && cascade >= FIRST_CACHED_SHADOW_CASCADE
+							? CascadeSliceContainsCaster(cascades, cascade, view, bounds) : CascadeContainsCaster(cascades[cascade].viewProjection, bounds);
+						casterCount += containsCaster ? 1 : 0;
+					}
+
+					totals.cascadesRendered++;
+					totals.casterDraws += casterCount;
+					totals.casterTests += pathStaticBounds.size() + DYNAMIC_COUNT;
+				}
+			}
+			DoNotOptimize(&totals);
+		};
+
+		for (bool cacheStaticCascades : { false, true })
+		{
+			ShadowPathTotals totals;
+			const double pathMs = MeasureMilliseconds([&]() { runPath(cacheStaticCascades, totals); }, ITERATIONS);
+
+			BenchResult result;
+			result.benchmark = "CascadedShadows";
+			result.variant = cacheStaticCascades ? "Cached static cascades" : "Every cascade every frame";
+			result.itemCount = FRAME_COUNT;
+			result.msPerRun = pathMs;
+			result.nsPerItem = pathMs * 1e6 / FRAME_COUNT;
+			result.metrics.push_back({ "casters", static_cast<double>(staticBounds.size() + DYNAMIC_COUNT) });
+			result.metrics.push_back({ "cascadesRenderedPerFrame", static_cast<double>(totals.cascadesRendered) / FRAME_COUNT });
+			result.metrics.push_back({ "casterDrawsPerFrame", static_cast<double>(totals.casterDraws) / FRAME_COUNT });
+			result.metrics.push_back({ "casterTestsPerFrame", static_cast<double>(totals.casterTests) / FRAME_COUNT });
+			report.Add(result);
+		}
+	}
+}
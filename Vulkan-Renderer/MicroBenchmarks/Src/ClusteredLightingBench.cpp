@@ -0,0 +1,190 @@
+#include "BenchUtils.h"
+#include "ClusteredLighting.h"
+#include <GLM/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <stdexcept>
+
+using namespace Renderer;
+
+namespace Benchmarks
+{
+	// A lit G-buffer pixel, its cluster is found the same way the lighting subpass finds it
+	struct ShadingSample
+	{
+		glm::vec3 worldPos;
+		glm::vec3 normal;
+		uint32_t cluster;
+	};
+
+	// Same falloff as the lighting subpasses, zero at the radius so lights outside a cluster contribute nothing
+	static glm::vec3 ShadePointLight(const PointLight& light, const ShadingSample& sample)
+	{
+		const glm::vec3 toLight = light.position - sample.worldPos;
+		const float distanceSquared = glm::dot(toLight, toLight);
+
+		const float ratio = distanceSquared / (light.radius * light.radius);
+		const float falloff = glm::clamp(1.0f - ratio * ratio, 0.0f, 1.0f);
+		const float attenuation = falloff * falloff / (distanceSquared + 1.0f);
+
+		const float lambert = std::max(glm::dot(sample.normal, toLight / std::sqrt(std::max(distanceSquared, 1e-6f))), 0.0f);
+		return light.colour * light.intensity * attenuation * lambert;
+	}
+
+	void RunClusteredLightingBench(BenchReport& report)
+	{
+		constexpr uint32_t SAMPLE_COUNT = 16384;
+		constexpr uint32_t ITERATIONS = 3;
+		constexpr float SCENE_EXTENT = 100.0f;
+
+		const std::vector<uint32_t> lightCounts = { 1, 10, 100, 1000, 10000 };
+
+		// Same camera as the renderer's default, zero to one depth with the y flip
+		glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+		projection[1][1] *= -1.0f;
+		const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 200.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		const float nearPlane = GetProjectionNearPlane(projection);
+		const float farPlane = GetProjectionFarPlane(projection);
+
+		std::vector<Utilities::BoundingBox> clusterBounds;
+		BuildClusterBounds(glm::inverse(projection), nearPlane, farPlane, clusterBounds);
+
+		// Surface points spread through the lit volume, kept only where they land on screen
+		Random random(36);
+		std::vector<ShadingSample> samples;
+		while (samples.size() < SAMPLE_COUNT)
+		{
+			ShadingSample sample;
+			sample.worldPos = glm::vec3(random.Range(-SCENE_EXTENT, SCENE_EXTENT), random.Range(-SCENE_EXTENT, SCENE_EXTENT), random.Range(-SCENE_EXTENT, SCENE_EXTENT));
+			sample.normal = glm::normalize(glm::vec3(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f)) + glm::vec3(0.0f, 0.0f, 0.01f));
+
+			const glm::vec4 viewPos = view * glm::vec4(sample.worldPos, 1.0f);
+			const glm::vec4 clip = projection * viewPos;
+			const glm::vec2 screen = glm::vec2(clip) / clip.w * 0.5f + 0.5f;
+			if (screen.x < 0.0f || screen.x >= 1.0f || screen.y < 0.0f || screen.y >= 1.0f)
+			{
+				continue;
+			}
+
+			const uint32_t tileX = std::min(static_cast<uint32_t>(screen.x * CLUSTER_COUNT_X), CLUSTER_COUNT_X - 1);
+			const uint32_t tileY = std::min(static_cast<uint32_t>(screen.y * CLUSTER_COUNT_Y), CLUSTER_COUNT_Y - 1);
+			const uint32_t slice = GetClusterSlice(-viewPos.z, nearPlane, farPlane);
+			sample.cluster = tileX + CLUSTER_COUNT_X * (tileY + CLUSTER_COUNT_Y * slice);
+			samples.push_back(sample);
+		}
+
+		std::vector<uint32_t> clusterLightOffsets;
+		std::vector<uint32_t> clusterLightCounts;
+		std::vector<uint32_t> clusterLightIndices;
+		std::vector<glm::vec3> clusteredColours(SAMPLE_COUNT);
+		std::vector<glm::vec3> bruteForceColours(SAMPLE_COUNT);
+
+		for (uint32_t lightCount : lightCounts)
+		{
+			std::vector<PointLight> lights(lightCount);
+			for (PointLight& light : lights)
+			{
+				light.position = glm::vec3(random.Range(-SCENE_EXTENT, SCENE_EXTENT), random.Range(-SCENE_EXTENT, SCENE_EXTENT), random.Range(-SCENE_EXTENT, SCENE_EXTENT));
+				light.radius = random.Range(20.0f, 40.0f);
+				light.colour = glm::vec3(random.Range(0.0f, 1.0f), random.Range(0.0f, 1.0f), random.Range(0.0f, 1.0f));
+				light.intensity = 200.0f;
+			}
+
+			// What the compute pass does every frame
+			const double binningMs = MeasureMilliseconds([&]()
+				{
+					BinLights(lights, view, clusterBounds, clusterLightOffsets, clusterLightCounts, clusterLightIndices);
+					DoNotOptimize(clusterLightIndices.data());
+				}, ITERATIONS);
+
+			const uint64_t listedLights = clusterLightIndices.size();
+			uint32_t maxClusterLights = 0;
+			for (uint32_t count : clusterLightCounts)
+			{
+				maxClusterLights = std::max(maxClusterLights, count);
+			}
+
+			uint64_t clusteredEvaluations = 0;
+			for (const ShadingSample& sample : samples)
+			{
+				clusteredEvaluations += clusterLightCounts[sample.cluster];
+			}
+
+			const double clusteredMs = MeasureMilliseconds([&]()
+				{
+					for (uint32_t i = 0; i < SAMPLE_COUNT; i++)
+					{
+						const ShadingSample& sample = samples[i];
+						const uint32_t* clusterLights = clusterLightIndices.data() + clusterLightOffsets[sample.cluster];
+
+						glm::vec3 colour(0.0f);
+						for (uint32_t light = 0; light < clusterLightCounts[sample.cluster]; light++)
+						{
+							colour += ShadePointLight(lights[clusterLights[light]], sample);
+						}
+						clusteredColours[i] = colour;
+					}
+					DoNotOptimize(clusteredColours.data());
+				}, ITERATIONS);
+
+			const double bruteForceMs = MeasureMilliseconds([&]()
+				{
+					for (uint32_t i = 0; i < SAMPLE_COUNT; i++)
+					{
+						glm::vec3 colour(0.0f);
+						for (const PointLight& light : lights)
+						{
+							colour += ShadePointLight(light, samples[i]);
+						}
+						bruteForceColours[i] = colour;
+					}
+					DoNotOptimize(bruteForceColours.data());
+				}, ITERATIONS);
+
+			// Culled lights contribute exactly zero, so any difference means binning missed a light that reaches the pixel
+			double maxShadingError = 0.0;
+			for (uint32_t i = 0; i < SAMPLE_COUNT; i++)
+			{
+				const glm::vec3 error = glm::abs(clusteredColours[i] - bruteForceColours[i]);
+				maxShadingError = std::max(maxShadingError, static_cast<double>(std::max(error.x, std::max(error.y, error.z))));
+			}
+
+			if (maxShadingError > 0.0)
+			{
+				throw std::runtime_error("Clustered shading differs from brute force by " + std::to_string(maxShadingError) + " with " + std::to_string(lightCount) + " lights");
+			}
+
+			const std::string lightsName = std::to_string(lightCount) + " lights";
+
+			BenchResult binning;
+			binning.benchmark = "ClusteredLighting";
+			binning.variant = "Binning " + lightsName;
+			binning.itemCount = lightCount;
+			binning.msPerRun = binningMs;
+			binning.nsPerItem = binningMs * 1e6 / lightCount;
+			binning.metrics.push_back({ "clusters", static_cast<double>(CLUSTER_COUNT) });
+			binning.metrics.push_back({ "avgLightsPerCluster", static_cast<double>(listedLights) / CLUSTER_COUNT });
+			binning.metrics.push_back({ "maxLightsPerCluster", static_cast<double>(maxClusterLights) });
+			binning.metrics.push_back({ "listedLights", static_cast<double>(listedLights) });
+			report.Add(binning);
+
+			BenchResult clustered;
+			clustered.benchmark = "ClusteredLighting";
+			clustered.variant = "Clustered shading " + lightsName;
+			clustered.itemCount = SAMPLE_COUNT;
+			clustered.msPerRun = clusteredMs;
+			clustered.nsPerItem = clusteredMs * 1e6 / SAMPLE_COUNT;
+			clustered.metrics.push_back({ "lightEvaluationsPerPixel", static_cast<double>(clusteredEvaluations) / SAMPLE_COUNT });
+			clustered.metrics.push_back({ "maxShadingError", maxShadingError });
+			report.Add(clustered);
+
+			BenchResult bruteForce;
+			bruteForce.benchmark = "ClusteredLighting";
+			bruteForce.variant = "Brute force shading " + lightsName;
+			bruteForce.itemCount = SAMPLE_COUNT;
+			bruteForce.msPerRun = bruteForceMs;
+			bruteForce.nsPerItem = bruteForceMs * 1e6 / SAMPLE_COUNT;
+			bruteForce.metrics.push_back({ "lightEvaluationsPerPixel", static_cast<double>(lightCount) });
+			report.Add(bruteForce);
+		}
+	}
+}
@@ -0,0 +1,116 @@
+#include "BenchUtils.h"
+#include "DrawList.h"
+
+using namespace Renderer;
+
+namespace Benchmarks
+{
+	struct SimulatedDraw
+	{
+		uint32_t texture;
+		uint32_t geometry;
+		float viewDepth;
+	};
+
+	/** Counts the texture and geometry changes between neighbouring draws, the binds recording would emit */
+	template<typename GetDraw>
+	static std::pair<uint32_t, uint32_t> CountStateChanges(size_t count, GetDraw&& getDraw)
+	{
+		uint32_t textureBinds = 0;
+		uint32_t geometryBinds = 0;
+		uint32_t boundTexture = UINT32_MAX;
+		uint32_t boundGeometry = UINT32_MAX;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const SimulatedDraw& draw = getDraw(i);
+			textureBinds += draw.texture != boundTexture ? 1 : 0;
+			geometryBinds += draw.geometry != boundGeometry ? 1 : 0;
+			boundTexture = draw.texture;
+			boundGeometry = draw.geometry;
+		}
+
+		return { textureBinds, geometryBinds };
+	}
+
+	void RunDrawListBench(BenchReport& report)
+	{
+		const std::vector<size_t> drawCounts = { 1000, 10000, 100000 };
+		constexpr uint32_t TEXTURE_COUNT = 64;
+		constexpr uint32_t GEOMETRY_COUNT = 256;
+		constexpr uint32_t ITERATIONS = 20;
+
+		for (size_t drawCount : drawCounts)
+		{
+			// Instanced looking scene : a limited set of meshes and textures spread over many draws, in insertion order
+			Random random(drawCount);
+			std::vector<SimulatedDraw> draws(drawCount);
+			for (SimulatedDraw& draw : draws)
+			{
+				draw.geometry = random.Next() % GEOMETRY_COUNT;
+				draw.texture = draw.geometry % TEXTURE_COUNT;
+				draw.viewDepth = random.Range(0.1f, 1000.0f);
+			}
+
+			DrawList drawList;
+			drawList.Reserve(drawCount);
+
+			auto buildDrawList = [&]()
+			{
+				drawList.Clear();
+				for (uint32_t i = 0; i < drawCount; i++)
+				{
+					drawList.Add(DrawList::MakeKey(0, 0, draws[i].texture, draws[i].geometry, draws[i].viewDepth), i);
+				}
+			};
+
+			double buildMs = MeasureMilliseconds([&]() { buildDrawList(); DoNotOptimize(drawList); }, ITERATIONS);
+			double radixMs = MeasureMilliseconds([&]() { buildDrawList(); drawList.Sort(); DoNotOptimize(drawList); }, ITERATIONS);
+
+			std::vector<DrawList::Entry> comparisonEntries;
+			double stdSortMs = MeasureMilliseconds([&]()
+				{
+					buildDrawList();
+					comparisonEntries = drawList.GetEntries();
+					std::stable_sort(comparisonEntries.begin(), comparisonEntries.end(),
+						[](const DrawList::Entry& a, const DrawList::Entry& b) { return a.key < b.key; });
+					DoNotOptimize(comparisonEntries);
+				}, ITERATIONS);
+
+			buildDrawList();
+			drawList.Sort();
+
+			bool matchesStableSort = drawList.Size() == comparisonEntries.size();
+			for (size_t i = 0; matchesStableSort && i < drawList.Size(); i++)
+			{
+				matchesStableSort = drawList[i].key == comparisonEntries[i].key && drawList[i].drawItem == comparisonEntries[i].drawItem;
+			}
+
+			const std::pair<uint32_t, uint32_t> unsortedBinds = CountStateChanges(drawCount, [&](size_t i) -> const SimulatedDraw& { return draws[i]; });
+			const std::pair<uint32_t, uint32_t> sortedBinds = CountStateChanges(drawCount, [&](size_t i) -> const SimulatedDraw& { return draws[drawList[i].drawItem]; });
+
+			BenchResult stdSortResult;
+			stdSortResult.benchmark = "DrawList";
+			stdSortResult.variant = "Build + std::stable_sort";
+			stdSortResult.itemCount = drawCount;
+			stdSortResult.msPerRun = stdSortMs;
+			stdSortResult.nsPerItem = stdSortMs * 1e6 / drawCount;
+			report.Add(stdSortResult);
+
+			BenchResult radixResult;
+			radixResult.benchmark = "DrawList";
+			radixResult.variant = "Build + radix sort";
+			radixResult.itemCount = drawCount;
+			radixResult.msPerRun = radixMs;
+			radixResult.nsPerItem = radixMs * 1e6 / drawCount;
+			radixResult.metrics.push_back({ "buildMs", buildMs });
+			radixResult.metrics.push_back({ "speedup", stdSortMs / radixMs });
+			radixResult.metrics.push_back({ "matchesStableSort", matchesStableSort ? 1.0 : 0.0 });
+			radixResult.metrics.push_back({ "textureBindsUnsorted", static_cast<double>(unsortedBinds.first) });
+			radixResult.metrics.push_back({ "textureBindsSorted", static_cast<double>(sortedBinds.first) });
+			radixResult.metrics.push_back({ "geometryBindsUnsorted", static_cast<double>(unsortedBinds.second) });
+			radixResult.metrics.push_back({ "geometryBindsSorted", static_cast<double>(sortedBinds.second) });
+			report.Add(radixResult);
+		}
+	}
+}
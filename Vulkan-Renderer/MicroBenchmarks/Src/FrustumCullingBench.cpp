@@ -0,0 +1,75 @@
+#include "BenchUtils.h"
+#include "FrustumCulling.h"
+#include <GLM/gtc/matrix_transform.hpp>
+
+using namespace Renderer;
+
+namespace Benchmarks
+{
+	static BoundingBoxSoA CreateRandomBounds(size_t count, Random& random)
+	{
+		BoundingBoxSoA bounds;
+		bounds.Resize(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			BoundingBox box;
+			glm::vec3 center(random.Range(-1000.0f, 1000.0f), random.Range(-1000.0f, 1000.0f), random.Range(-1000.0f, 1000.0f));
+			glm::vec3 extents(random.Range(0.5f, 10.0f), random.Range(0.5f, 10.0f), random.Range(0.5f, 10.0f));
+			box.min = center - extents;
+			box.max = center + extents;
+			bounds.Set(i, box);
+		}
+
+		return bounds;
+	}
+
+	void RunFrustumCullingBench(BenchReport& report)
+	{
+		const std::vector<size_t> objectCounts = { 10000, 100000, 1000000 };
+		const std::vector<std::pair<FrustumCuller::CullPath, const char*>> cullPaths = {
+			{ FrustumCuller::CullPath::SCALAR, "Scalar" },
+			{ FrustumCuller::CullPath::SSE, "SSE (4 wide)" },
+			{ FrustumCuller::CullPath::AVX, "AVX (8 wide)" } };
+
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+		projection[1][1] *= -1.0f;
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 200.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		Frustum frustum = Frustum::FromViewProjection(projection * view);
+
+		for (size_t objectCount : objectCounts)
+		{
+			Random random(objectCount);
+			BoundingBoxSoA bounds = CreateRandomBounds(objectCount, random);
+
+			std::vector<uint32_t> referenceVisible;
+			FrustumCuller::CullScalar(frustum, bounds, referenceVisible);
+
+			double scalarMs = 0.0;
+			for (const auto& cullPath : cullPaths)
+			{
+				std::vector<uint32_t> visible;
+				visible.reserve(objectCount);
+
+				const uint32_t iterations = objectCount >= 1000000 ? 10 : 50;
+				double ms = MeasureMilliseconds([&]() { FrustumCuller::Cull(cullPath.first, frustum, bounds, visible); DoNotOptimize(visible); }, iterations);
+
+				if (cullPath.first == FrustumCuller::CullPath::SCALAR)
+				{
+					scalarMs = ms;
+				}
+
+				BenchResult result;
+				result.benchmark = "FrustumCulling";
+				result.variant = cullPath.second;
+				result.itemCount = objectCount;
+				result.msPerRun = ms;
+				result.nsPerItem = ms * 1e6 / objectCount;
+				result.metrics.push_back({ "visible", static_cast<double>(visible.size()) });
+				result.metrics.push_back({ "matchesScalar", visible == referenceVisible ? 1.0 : 0.0 });
+				result.metrics.push_back({ "speedup", scalarMs / ms });
+				report.Add(result);
+			}
+		}
+	}
+}
@@ -0,0 +1,114 @@
+#include "BenchUtils.h"
+#include "GBufferLayout.h"
+#include <cmath>
+
+using namespace Renderer;
+
+namespace Benchmarks
+{
+	struct Resolution
+	{
+		const char* name;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	static uint16_t QuantizeUnorm16(float value)
+	{
+		return static_cast<uint16_t>(std::lround(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	void RunGBufferBench(BenchReport& report)
+	{
+		const std::vector<Resolution> resolutions = { { "1080p", 1920, 1080 }, { "4K", 3840, 2160 } };
+		const std::vector<std::pair<GBufferLayout, const char*>> layouts = { { GBufferLayout::STANDARD, "Standard" }, { GBufferLayout::COMPACT, "Compact" } };
+		constexpr uint32_t ITERATIONS = 10;
+		constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+		constexpr double FRAMES_PER_SECOND = 60.0;
+
+		// Every pixel's normal goes through the layout's packing, then round trips to check precision
+		Random random(34);
+		std::vector<glm::vec3> normals(resolutions.back().width * resolutions.back().height);
+		for (glm::vec3& normal : normals)
+		{
+			normal = glm::normalize(glm::vec3(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f)) + glm::vec3(0.0f, 0.0f, 1e-4f));
+		}
+
+		std::vector<uint32_t> packedNormals(normals.size());
+
+		for (const Resolution& resolution : resolutions)
+		{
+			const size_t pixelCount = static_cast<size_t>(resolution.width) * resolution.height;
+
+			for (const auto& layout : layouts)
+			{
+				const bool compact = layout.first == GBufferLayout::COMPACT;
+
+				double packMs = MeasureMilliseconds([&]()
+					{
+						for (size_t i = 0; i < pixelCount; i++)
+						{
+							if (compact)
+							{
+								const glm::vec2 encoded = EncodeOctahedralNormal(normals[i]);
+								packedNormals[i] = QuantizeUnorm16(encoded.x) | (static_cast<uint32_t>(QuantizeUnorm16(encoded.y)) << 16);
+							}
+							else
+							{
+								// UNORM targets hold [0, 1], the shader stores the normal remapped from [-1, 1]
+								const glm::vec3 n = (normals[i] * 0.5f + 0.5f) * 255.0f + 0.5f;
+								packedNormals[i] = static_cast<uint32_t>(n.x) | (static_cast<uint32_t>(n.y) << 8) | (static_cast<uint32_t>(n.z) << 16) | 0xFF000000u;
+							}
+						}
+						DoNotOptimize(packedNormals);
+					}, ITERATIONS);
+
+				// Upper bound when nothing stays on chip : colour targets written by the G-buffer subpass and read once by lighting,
+				// depth written by the early pass, read by the Hi-Z downsample, loaded by the main pass and read by lighting
+				uint32_t colourBytesPerPixel = 0;
+				for (const GBufferTarget& target : GetGBufferColourTargets(layout.first))
+				{
+					colourBytesPerPixel += target.bytesPerPixel;
+				}
+
+				const double memoryBytes = static_cast<double>(GetGBufferBytesPerPixel(layout.first)) * pixelCount;
+				const double trafficBytes = (2.0 * colourBytesPerPixel + 4.0 * GBUFFER_DEPTH_BYTES_PER_PIXEL) * pixelCount;
+
+				BenchResult result;
+				result.benchmark = "GBuffer";
+				result.variant = std::string(layout.second) + " " + resolution.name;
+				result.itemCount = pixelCount;
+				result.msPerRun = packMs;
+				result.nsPerItem = packMs * 1e6 / pixelCount;
+				result.metrics.push_back({ "bytesPerPixel", static_cast<double>(GetGBufferBytesPerPixel(layout.first)) });
+				result.metrics.push_back({ "memoryMB", memoryBytes / BYTES_PER_MB });
+				result.metrics.push_back({ "trafficMBPerFrame", trafficBytes / BYTES_PER_MB });
+				result.metrics.push_back({ "trafficGBps60", trafficBytes * FRAMES_PER_SECOND / (BYTES_PER_MB * 1024.0) });
+
+				double maxErrorDegrees = 0.0;
+				for (size_t i = 0; i < pixelCount; i++)
+				{
+					glm::vec3 decoded;
+					if (compact)
+					{
+						const glm::vec2 quantized((packedNormals[i] & 0xFFFF) / 65535.0f, (packedNormals[i] >> 16) / 65535.0f);
+						decoded = DecodeOctahedralNormal(quantized);
+					}
+					else
+					{
+						const glm::vec3 quantized(packedNormals[i] & 0xFF, (packedNormals[i] >> 8) & 0xFF, (packedNormals[i] >> 16) & 0xFF);
+						decoded = glm::normalize(quantized / 255.0f * 2.0f - 1.0f);
+					}
+
+					// atan2 of sine and cosine stays accurate for the tiny angles acos loses in float rounding
+					const float angle = std::atan2(glm::length(glm::cross(decoded, normals[i])), glm::dot(decoded, normals[i]));
+					maxErrorDegrees = std::max(maxErrorDegrees, static_cast<double>(glm::degrees(angle)));
+				}
+
+				result.metrics.push_back({ "maxNormalErrorMilliDeg", maxErrorDegrees * 1000.0 });
+
+				report.Add(result);
+			}
+		}
+	}
+}
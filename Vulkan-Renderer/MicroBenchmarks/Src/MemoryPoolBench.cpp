@@ -0,0 +1,419 @@
+#include "BenchUtils.h"
+#include "MemoryPool.h"
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace Benchmarks
+{
+	constexpr size_t MAX_LIVE_BLOCKS = 65536;
+	constexpr size_t MAX_LIVE_BYTES = 8 * 1024 * 1024; // Per allocator, larger than the caches so placement shows up in the touch pass
+	constexpr uint32_t ITERATIONS = 15;
+	constexpr uint32_t LATENCY_CYCLES = 5;
+	constexpr uint32_t LATENCY_BATCH = 64; // Single calls are too short for the clock, batches of them are timed instead
+	constexpr uint32_t THREAD_COUNT = 4;
+	constexpr uint32_t CYCLES_PER_THREAD = 5; // Long enough that starting the threads doesn't dominate
+
+	/** MemoryPool as it was before the intrusive free list : a {prev, next} header in front of every unit and a list of the allocated ones */
+	template<size_t Size>
+	class HeaderedMemoryPool
+	{
+	public:
+		explicit HeaderedMemoryPool(size_t unitCount) : memory(unitCount * UNIT_STRIDE)
+		{
+			for (size_t index = 0; index < unitCount; index++)
+			{
+				MemoryUnit* unit = reinterpret_cast<MemoryUnit*>(memory.data() + index * UNIT_STRIDE);
+				unit->prevPtr = nullptr;
+				unit->nextPtr = freeUnitsPtr;
+				if (freeUnitsPtr)
+				{
+					freeUnitsPtr->prevPtr = unit;
+				}
+				freeUnitsPtr = unit;
+			}
+		}
+
+		void* Allocate()
+		{
+			MemoryUnit* unit = freeUnitsPtr;
+			freeUnitsPtr = unit->nextPtr;
+			if (freeUnitsPtr)
+			{
+				freeUnitsPtr->prevPtr = nullptr;
+			}
+
+			unit->prevPtr = nullptr;
+			unit->nextPtr = allocatedUnitsPtr;
+			if (allocatedUnitsPtr)
+			{
+				allocatedUnitsPtr->prevPtr = unit;
+			}
+			allocatedUnitsPtr = unit;
+
+			return reinterpret_cast<char*>(unit) + sizeof(MemoryUnit);
+		}
+
+		void Free(void* ptr)
+		{
+			if (ptr <= static_cast<void*>(memory.data()) || ptr >= static_cast<void*>(memory.data() + memory.size()))
+			{
+				throw std::runtime_error("Cannot deallocate pointer not belonging to pool");
+			}
+
+			MemoryUnit* unit = reinterpret_cast<MemoryUnit*>(static_cast<char*>(ptr) - sizeof(MemoryUnit));
+			if (unit->prevPtr == nullptr)
+			{
+				allocatedUnitsPtr = unit->nextPtr;
+			}
+			else
+			{
+				unit->prevPtr->nextPtr = unit->nextPtr;
+			}
+			if (unit->nextPtr)
+			{
+				unit->nextPtr->prevPtr = unit->prevPtr;
+			}
+
+			unit->prevPtr = nullptr;
+			unit->nextPtr = freeUnitsPtr;
+			if (freeUnitsPtr)
+			{
+				freeUnitsPtr->prevPtr = unit;
+			}
+			freeUnitsPtr = unit;
+		}
+
+		size_t GetCurrentMemoryUnitsAllocated() const
+		{
+			size_t allocatedCount = 0;
+			for (const MemoryUnit* unit = allocatedUnitsPtr; unit; unit = unit->nextPtr)
+			{
+				allocatedCount++;
+			}
+			return allocatedCount;
+		}
+
+		size_t GetTotalMemoryAllocated() const { return memory.size(); }
+
+	private:
+		struct MemoryUnit
+		{
+			MemoryUnit* prevPtr;
+			MemoryUnit* nextPtr;
+		};
+		static constexpr size_t UNIT_STRIDE = Size + sizeof(MemoryUnit);
+
+		std::vector<char> memory;
+		MemoryUnit* allocatedUnitsPtr = nullptr;
+		MemoryUnit* freeUnitsPtr = nullptr;
+	};
+
+	template<size_t Size, typename Pool = MemoryPool<Size>>
+	struct PoolAllocator
+	{
+		static constexpr size_t SIZE = Size;
+		Pool pool;
+
+		explicit PoolAllocator(size_t blockCount) : pool(blockCount) {}
+		void* Allocate() { return pool.Allocate(); }
+		void Free(void* ptr) { pool.Free(ptr); }
+		void Reset() {}
+		size_t GetReservedBytes() const { return pool.GetTotalMemoryAllocated(); }
+	};
+
+	template<size_t Size>
+	struct MallocAllocator
+	{
+		static constexpr size_t SIZE = Size;
+
+		explicit MallocAllocator(size_t) {}
+		void* Allocate() { return malloc(Size); }
+		void Free(void* ptr) { free(ptr); }
+		void Reset() {}
+		size_t GetReservedBytes() const { return 0; } // Heap bookkeeping isn't visible
+	};
+
+	template<size_t Size>
+	struct PmrPoolAllocator
+	{
+		static constexpr size_t SIZE = Size;
+		std::pmr::unsynchronized_pool_resource resource;
+
+		explicit PmrPoolAllocator(size_t) {}
+		void* Allocate() { return resource.allocate(Size, alignof(std::max_align_t)); }
+		void Free(void* ptr) { resource.deallocate(ptr, Size, alignof(std::max_align_t)); }
+		void Reset() {}
+		size_t GetReservedBytes() const { return 0; }
+	};
+
+	/** Lower bound for any allocator : a pointer bump, frees do nothing and the whole arena is released at once */
+	template<size_t Size>
+	struct BumpArena
+	{
+		static constexpr size_t SIZE = Size;
+		static constexpr size_t STRIDE = (Size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+		std::vector<std::max_align_t> storage;
+		size_t offset = 0;
+
+		explicit BumpArena(size_t blockCount) : storage((blockCount * STRIDE + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)) {}
+
+		void* Allocate()
+		{
+			if (offset + STRIDE > storage.size() * sizeof(std::max_align_t))
+			{
+				return nullptr;
+			}
+			void* ptr = reinterpret_cast<char*>(storage.data()) + offset;
+			offset += STRIDE;
+			return ptr;
+		}
+
+		void Free(void*) {}
+		void Reset() { offset = 0; }
+		size_t GetReservedBytes() const { return storage.size() * sizeof(std::max_align_t); }
+	};
+
+	template<typename Allocator>
+	static void AllocateAll(Allocator& allocator, std::vector<void*>& blocks)
+	{
+		for (void*& block : blocks)
+		{
+			block = allocator.Allocate();
+		}
+	}
+
+	template<typename Allocator>
+	static void FreeLifo(Allocator& allocator, std::vector<void*>& blocks)
+	{
+		for (size_t i = blocks.size(); i > 0; i--)
+		{
+			allocator.Free(blocks[i - 1]);
+		}
+		allocator.Reset();
+	}
+
+	template<typename Allocator>
+	static void FreeInOrder(Allocator& allocator, std::vector<void*>& blocks, const std::vector<uint32_t>& freeOrder)
+	{
+		for (uint32_t index : freeOrder)
+		{
+			allocator.Free(blocks[index]);
+		}
+		allocator.Reset();
+	}
+
+	static double Percentile(std::vector<double>& values, double percentile)
+	{
+		std::sort(values.begin(), values.end());
+		return values[std::min(static_cast<size_t>(values.size() * percentile), values.size() - 1)];
+	}
+
+	/** Batched allocate and free costs over whole cycles in the given free order, per call at the 50th and 99th percentile */
+	template<typename Allocator>
+	static void AddLatencyMetrics(Allocator& allocator, std::vector<void*>& blocks, const std::vector<uint32_t>& freeOrder, BenchResult& result)
+	{
+		std::vector<double> allocateNs;
+		std::vector<double> freeNs;
+
+		for (uint32_t cycle = 0; cycle < LATENCY_CYCLES; cycle++)
+		{
+			for (size_t first = 0; first < blocks.size(); first += LATENCY_BATCH)
+			{
+				const size_t last = std::min(first + LATENCY_BATCH, blocks.size());
+				const auto start = std::chrono::high_resolution_clock::now();
+				for (size_t i = first; i < last; i++)
+				{
+					blocks[i] = allocator.Allocate();
+				}
+				const auto end = std::chrono::high_resolution_clock::now();
+				allocateNs.push_back(std::chrono::duration<double, std::nano>(end - start).count() / (last - first));
+			}
+
+			for (size_t first = 0; first < freeOrder.size(); first += LATENCY_BATCH)
+			{
+				const size_t last = std::min(first + LATENCY_BATCH, freeOrder.size());
+				const auto start = std::chrono::high_resolution_clock::now();
+				for (size_t i = first; i < last; i++)
+				{
+					allocator.Free(blocks[freeOrder[i]]);
+				}
+				const auto end = std::chrono::high_resolution_clock::now();
+				freeNs.push_back(std::chrono::duration<double, std::nano>(end - start).count() / (last - first));
+			}
+			allocator.Reset();
+		}
+
+		result.metrics.push_back({ "allocP50Ns", Percentile(allocateNs, 0.5) });
+		result.metrics.push_back({ "allocP99Ns", Percentile(allocateNs, 0.99) });
+		result.metrics.push_back({ "freeP50Ns", Percentile(freeNs, 0.5) });
+		result.metrics.push_back({ "freeP99Ns", Percentile(freeNs, 0.99) });
+	}
+
+	template<typename Allocator>
+	static void RunAllocator(BenchReport& report, const char* allocatorName, size_t blockCount)
+	{
+		std::vector<uint32_t> lifoOrder(blockCount);
+		std::vector<uint32_t> randomOrder(blockCount);
+		for (uint32_t i = 0; i < blockCount; i++)
+		{
+			lifoOrder[i] = static_cast<uint32_t>(blockCount - 1 - i);
+			randomOrder[i] = i;
+		}
+
+		Random random(blockCount + Allocator::SIZE);
+		for (size_t i = blockCount - 1; i > 0; i--)
+		{
+			std::swap(randomOrder[i], randomOrder[random.Next() % (i + 1)]);
+		}
+
+		auto addResult = [&](const std::string& pattern, uint32_t threads, size_t itemCount, double runMs)
+		{
+			BenchResult result;
+			result.benchmark = "MemoryPool";
+			result.variant = std::to_string(Allocator::SIZE) + "B " + allocatorName + " " + pattern;
+			result.itemCount = itemCount;
+			result.msPerRun = runMs;
+			result.nsPerItem = runMs * 1e6 * threads / itemCount;
+			result.metrics.push_back({ "blockBytes", static_cast<double>(Allocator::SIZE) });
+			result.metrics.push_back({ "threads", static_cast<double>(threads) });
+			return result;
+		};
+
+		Allocator allocator(blockCount);
+		std::vector<void*> blocks(blockCount);
+		const size_t reservedBytes = allocator.GetReservedBytes();
+
+		// Allocate everything then free it newest first, every allocator's best case
+		{
+			const double runMs = MeasureMilliseconds([&]() { AllocateAll(allocator, blocks); FreeLifo(allocator, blocks); }, ITERATIONS);
+			BenchResult result = addResult("LIFO", 1, blockCount, runMs);
+			if (reservedBytes > 0)
+			{
+				result.metrics.push_back({ "bytesPerBlock", static_cast<double>(reservedBytes) / blockCount });
+			}
+			AddLatencyMetrics(allocator, blocks, lifoOrder, result);
+			report.Add(result);
+		}
+
+		// Frees in shuffled order, later cycles allocate from whatever order the frees left behind
+		{
+			const double runMs = MeasureMilliseconds([&]() { AllocateAll(allocator, blocks); FreeInOrder(allocator, blocks, randomOrder); }, ITERATIONS);
+			BenchResult result = addResult("random", 1, blockCount, runMs);
+			AddLatencyMetrics(allocator, blocks, randomOrder, result);
+			report.Add(result);
+		}
+
+		// Walks blocks in the order they were handed out after the random frees, as code iterating its objects would
+		{
+			AllocateAll(allocator, blocks);
+			const double runMs = MeasureMilliseconds([&]()
+				{
+					for (void* block : blocks)
+					{
+						static_cast<volatile uint8_t*>(block)[0] += 1;
+					}
+				}, ITERATIONS);
+			FreeInOrder(allocator, blocks, randomOrder);
+
+			report.Add(addResult("touch", 1, blockCount, runMs));
+		}
+
+		// Allocator per thread, none of the pools are thread safe, malloc is the only one shared between threads
+		{
+			std::vector<std::unique_ptr<Allocator>> allocators;
+			std::vector<std::vector<void*>> threadBlocks(THREAD_COUNT, std::vector<void*>(blockCount));
+			for (uint32_t thread = 0; thread < THREAD_COUNT; thread++)
+			{
+				allocators.push_back(std::make_unique<Allocator>(blockCount));
+			}
+
+			auto runCycles = [&](uint32_t thread)
+			{
+				for (uint32_t cycle = 0; cycle < CYCLES_PER_THREAD; cycle++)
+				{
+					AllocateAll(*allocators[thread], threadBlocks[thread]);
+					FreeLifo(*allocators[thread], threadBlocks[thread]);
+				}
+			};
+
+			const double runMs = MeasureMilliseconds([&]()
+				{
+					std::vector<std::thread> workers;
+					for (uint32_t thread = 1; thread < THREAD_COUNT; thread++)
+					{
+						workers.emplace_back(runCycles, thread);
+					}
+					runCycles(0);
+					for (std::thread& worker : workers)
+					{
+						worker.join();
+					}
+				}, ITERATIONS);
+
+			report.Add(addResult("LIFO " + std::to_string(THREAD_COUNT) + " threads", THREAD_COUNT, blockCount * CYCLES_PER_THREAD * THREAD_COUNT, runMs));
+		}
+	}
+
+	/** Asking a full pool how many units are allocated, the headered pool walks its allocated list */
+	template<typename Allocator>
+	static void RunCountQuery(BenchReport& report, const char* poolName, size_t blockCount)
+	{
+		Allocator allocator(blockCount);
+		std::vector<void*> blocks(blockCount);
+		AllocateAll(allocator, blocks);
+
+		// A run is a batch of queries, the constant time query is too short to time alone
+		size_t allocatedCount = 0;
+		const double runMs = MeasureMilliseconds([&]()
+			{
+				for (uint32_t query = 0; query < LATENCY_BATCH; query++)
+				{
+					allocatedCount = allocator.pool.GetCurrentMemoryUnitsAllocated();
+					DoNotOptimize(allocatedCount);
+				}
+			}, ITERATIONS);
+
+		BenchResult result;
+		result.benchmark = "MemoryPool";
+		result.variant = std::string(poolName) + " count query";
+		result.itemCount = LATENCY_BATCH;
+		result.msPerRun = runMs;
+		result.nsPerItem = runMs * 1e6 / LATENCY_BATCH;
+		result.metrics.push_back({ "allocatedUnits", static_cast<double>(allocatedCount) });
+		report.Add(result);
+
+		FreeLifo(allocator, blocks);
+	}
+
+	template<size_t Size>
+	static void RunSizeClass(BenchReport& report)
+	{
+		const size_t blockCount = std::min(MAX_LIVE_BLOCKS, MAX_LIVE_BYTES / Size);
+
+		RunAllocator<PoolAllocator<Size>>(report, "MemoryPool", blockCount);
+		RunAllocator<PoolAllocator<Size, HeaderedMemoryPool<Size>>>(report, "headered pool", blockCount);
+		RunAllocator<MallocAllocator<Size>>(report, "malloc", blockCount);
+		RunAllocator<PmrPoolAllocator<Size>>(report, "pmr pool", blockCount);
+		RunAllocator<BumpArena<Size>>(report, "bump arena", blockCount);
+	}
+
+	void RunMemoryPoolBench(BenchReport& report)
+	{
+		// Every size the renderer instantiates a pool for
+		RunSizeClass<1>(report);
+		RunSizeClass<4>(report);
+		RunSizeClass<8>(report);
+		RunSizeClass<16>(report);
+		RunSizeClass<32>(report);
+		RunSizeClass<128>(report);
+		RunSizeClass<1024>(report);
+		RunSizeClass<4096>(report);
+
+		RunCountQuery<PoolAllocator<32>>(report, "MemoryPool", MAX_LIVE_BLOCKS);
+		RunCountQuery<PoolAllocator<32, HeaderedMemoryPool<32>>>(report, "headered pool", MAX_LIVE_BLOCKS);
+	}
+}
@@ -0,0 +1,195 @@
+#include "BenchUtils.h"
+#include "Profiler.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+using namespace Utilities;
+
+namespace Benchmarks
+{
+	static const char* SCOPE_NAMES[] = {
+		"bool __cdecl AppWindow::ShouldClose(void)",
+		"void __cdecl Renderer::VulkanRenderer::Draw(void)",
+		"void __cdecl Renderer::VulkanRenderer::RecordCommands(uint32_t,uint32_t)",
+		"Queue Submit & Present",
+	};
+	constexpr uint32_t SCOPE_NAME_COUNT = sizeof(SCOPE_NAMES) / sizeof(SCOPE_NAMES[0]);
+
+	// What every scope used to cost : format, write and flush on the thread that closed the scope
+	struct SynchronousTraceWriter
+	{
+		std::ofstream outputStream;
+		int profileCount = 0;
+
+		void WriteProfile(const char* scopeName, long long start, long long end, size_t threadID)
+		{
+			if (profileCount++ > 0)
+				outputStream << ",";
+
+			std::string name = scopeName;
+			std::replace(name.begin(), name.end(), '"', '\'');
+
+			const std::string toEraseStr("__cdecl");
+			const size_t pos = name.find(toEraseStr);
+			if (pos != std::string::npos)
+			{
+				name.erase(pos, toEraseStr.length());
+			}
+
+			outputStream << "{\"cat\":\"function\",\"dur\":" << (end - start) << ",\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+				<< threadID << ",\"ts\":" << start << "}";
+			outputStream.flush();
+		}
+	};
+
+	void RunProfilerBench(BenchReport& report)
+	{
+		constexpr uint32_t EVENTS_PER_THREAD = 20000; // Well under a ring, the writer drains between runs
+		constexpr uint32_t THREAD_COUNT = 4;
+		constexpr uint32_t ITERATIONS = 15;
+		const char* TRACE_PATH = "profiler_bench_trace.json";
+
+		auto addResult = [&](const char* variant, uint32_t threads, double runMs, const Profiler::Statistics* statistics)
+		{
+			const uint32_t eventCount = EVENTS_PER_THREAD * threads;
+
+			BenchResult result;
+			result.benchmark = "Profiler";
+			result.variant = variant;
+			result.itemCount = eventCount;
+			result.msPerRun = runMs;
+			result.nsPerItem = runMs * 1e6 * threads / eventCount; // Time each recording thread spends per event
+			result.metrics.push_back({ "threads", static_cast<double>(threads) });
+			if (statistics != nullptr)
+			{
+				result.metrics.push_back({ "writtenEvents", static_cast<double>(statistics->writtenEvents) });
+				result.metrics.push_back({ "droppedEvents", static_cast<double>(statistics->droppedEvents) });
+			}
+			report.Add(result);
+		};
+
+		// Old path, one thread
+		{
+			SynchronousTraceWriter writer;
+			writer.outputStream.open(TRACE_PATH);
+
+			const double runMs = MeasureMilliseconds([&]()
+				{
+					for (uint32_t i = 0; i < EVENTS_PER_THREAD; i++)
+					{
+						const auto start = std::chrono::high_resolution_clock::now();
+						const auto end = std::chrono::high_resolution_clock::now();
+						writer.WriteProfile(SCOPE_NAMES[i % SCOPE_NAME_COUNT],
+							std::chrono::time_point_cast<std::chrono::microseconds>(start).time_since_epoch().count(),
+							std::chrono::time_point_cast<std::chrono::microseconds>(end).time_since_epoch().count(),
+							std::hash<std::thread::id>{}(std::this_thread::get_id()));
+					}
+				}, ITERATIONS);
+
+			addResult("Synchronous ofstream", 1, runMs, nullptr);
+		}
+
+		Profiler& profiler = Profiler::Get();
+		uint32_t nameIds[SCOPE_NAME_COUNT];
+		for (uint32_t i = 0; i < SCOPE_NAME_COUNT; i++)
+		{
+			nameIds[i] = profiler.InternName(SCOPE_NAMES[i]);
+		}
+
+		// Same as a BenchmarkTimer going out of scope
+		auto recordEvents = [&]()
+		{
+			for (uint32_t i = 0; i < EVENTS_PER_THREAD; i++)
+			{
+				const int64_t start = Profiler::Now();
+				profiler.RecordScope(nameIds[i % SCOPE_NAME_COUNT], start, Profiler::Now());
+			}
+		};
+
+		// Runs are measured by hand so the writer can drain between them, outside the timings
+		auto measureRuns = [&](uint32_t threads, const Profiler::Statistics& before)
+		{
+			std::vector<double> timings(ITERATIONS);
+			uint64_t recordedEvents = 0;
+
+			for (double& timing : timings)
+			{
+				for (Profiler::Statistics statistics = profiler.GetStatistics();
+					statistics.writtenEvents + statistics.droppedEvents < before.writtenEvents + before.droppedEvents + recordedEvents;
+					statistics = profiler.GetStatistics())
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(PROFILE_WRITER_INTERVAL_MS));
+				}
+				recordedEvents += EVENTS_PER_THREAD * threads;
+
+				const auto start = std::chrono::high_resolution_clock::now();
+				std::vector<std::thread> workers;
+				for (uint32_t thread = 1; thread < threads; thread++)
+				{
+					workers.emplace_back(recordEvents);
+				}
+				recordEvents();
+				for (std::thread& worker : workers)
+				{
+					worker.join();
+				}
+				const auto end = std::chrono::high_resolution_clock::now();
+
+				timing = std::chrono::duration<double, std::milli>(end - start).count();
+			}
+
+			std::sort(timings.begin(), timings.end());
+			return timings[timings.size() / 2];
+		};
+
+		addResult("Per-thread rings, no session", 1, MeasureMilliseconds(recordEvents, ITERATIONS), nullptr);
+
+		for (uint32_t threads : { 1u, THREAD_COUNT })
+		{
+			const Profiler::Statistics before = profiler.GetStatistics();
+			profiler.BeginSession("ProfilerBench", TRACE_PATH);
+			const double runMs = measureRuns(threads, before);
+			profiler.EndSession();
+
+			Profiler::Statistics statistics = profiler.GetStatistics();
+			statistics.writtenEvents -= before.writtenEvents;
+			statistics.droppedEvents -= before.droppedEvents;
+
+			addResult(threads == 1 ? "Per-thread rings, 1 thread" : "Per-thread rings, 4 threads", threads, runMs, &statistics);
+		}
+
+		std::remove(TRACE_PATH);
+		std::remove("profiler_bench_trace_summary.json");
+
+		// What the writer adds per drained event to keep scope statistics, durations spread over several orders of magnitude
+		{
+			std::vector<int64_t> durations(EVENTS_PER_THREAD);
+			Random random(41);
+			for (int64_t& duration : durations)
+			{
+				duration = static_cast<int64_t>(std::exp(random.Range(4.0f, 18.0f)));
+			}
+
+			ProfileHistogram histogram;
+			const double runMs = MeasureMilliseconds([&]()
+				{
+					for (int64_t duration : durations)
+					{
+						histogram.Add(duration);
+					}
+					DoNotOptimize(&histogram);
+				}, ITERATIONS);
+
+			BenchResult result;
+			result.benchmark = "Profiler";
+			result.variant = "Scope histogram add";
+			result.itemCount = EVENTS_PER_THREAD;
+			result.msPerRun = runMs;
+			result.nsPerItem = runMs * 1e6 / EVENTS_PER_THREAD;
+			result.metrics.push_back({ "p99Ms", histogram.GetPercentile(0.99) / 1e6 });
+			report.Add(result);
+		}
+	}
+}
@@ -0,0 +1,179 @@
+#include "BenchUtils.h"
+#include "RenderGraph.h"
+#include "GBufferLayout.h"
+#include <string>
+
+using namespace Renderer;
+
+namespace Benchmarks
+{
+	// Frame graph shaped like the renderer's, optionally followed by SSAO, a bloom chain, tonemapping and debug views nothing reads
+	static RenderGraph BuildBenchFrameGraph(uint32_t width, uint32_t height, bool postProcessing, uint32_t bloomLevels)
+	{
+		RenderGraph graph;
+
+		const RenderGraphResource swapchain = graph.ImportImage("Swapchain", { VK_FORMAT_B8G8R8A8_SRGB, width, height },
+			{ VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0 },
+			{ VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0 });
+		const RenderGraphResource shadowMap = graph.ImportImage("Shadow map", { VK_FORMAT_D32_SFLOAT, 2048, 2048, 4 },
+			{ VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT },
+			{ VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, 0, 0 });
+		const RenderGraphResource lightLists = graph.ImportBuffer("Light lists",
+			{ VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT }, {});
+		const RenderGraphResource depthPyramid = graph.ImportImage("Depth pyramid", { VK_FORMAT_R32_SFLOAT, width / 2, height / 2 },
+			{ VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT }, { VK_IMAGE_LAYOUT_GENERAL, 0, 0 });
+
+		const RenderGraphResource depth = graph.CreateImage("Depth", { VK_FORMAT_D24_UNORM_S8_UINT, width, height });
+		std::vector<RenderGraphResource> gBuffer;
+		for (const GBufferTarget& target : GetGBufferColourTargets(GBufferLayout::STANDARD))
+		{
+			gBuffer.push_back(graph.CreateImage(target.name, { target.format, width, height }));
+		}
+
+		const RenderGraphPass earlyDepth = graph.AddPass("Early depth", RenderGraphPassType::GRAPHICS);
+		graph.Use(earlyDepth, depth, RenderGraphAccess::DEPTH_ATTACHMENT, RenderGraphLoad::CLEAR);
+
+		const RenderGraphPass pyramid = graph.AddPass("Depth pyramid", RenderGraphPassType::COMPUTE);
+		graph.Use(pyramid, depth, RenderGraphAccess::COMPUTE_SAMPLED);
+		graph.Use(pyramid, depthPyramid, RenderGraphAccess::COMPUTE_STORAGE_WRITE);
+
+		RenderGraphResource ambientOcclusion = 0;
+		if (postProcessing)
+		{
+			ambientOcclusion = graph.CreateImage("SSAO", { VK_FORMAT_R8_UNORM, width, height });
+			const RenderGraphResource rawAmbientOcclusion = graph.CreateImage("SSAO raw", { VK_FORMAT_R8_UNORM, width, height });
+
+			const RenderGraphPass ssao = graph.AddPass("SSAO", RenderGraphPassType::COMPUTE);
+			graph.Use(ssao, depth, RenderGraphAccess::COMPUTE_SAMPLED);
+			graph.Use(ssao, rawAmbientOcclusion, RenderGraphAccess::COMPUTE_STORAGE_WRITE, RenderGraphLoad::DISCARD);
+
+			const RenderGraphPass ssaoBlur = graph.AddPass("SSAO blur", RenderGraphPassType::COMPUTE);
+			graph.Use(ssaoBlur, rawAmbientOcclusion, RenderGraphAccess::COMPUTE_SAMPLED);
+			graph.Use(ssaoBlur, ambientOcclusion, RenderGraphAccess::COMPUTE_STORAGE_WRITE, RenderGraphLoad::DISCARD);
+		}
+
+		const RenderGraphPass gBufferPass = graph.AddPass("G-buffer", RenderGraphPassType::GRAPHICS);
+		for (RenderGraphResource target : gBuffer)
+		{
+			graph.Use(gBufferPass, target, RenderGraphAccess::COLOUR_ATTACHMENT, RenderGraphLoad::CLEAR);
+		}
+		graph.Use(gBufferPass, depth, RenderGraphAccess::DEPTH_ATTACHMENT);
+
+		// Without post processing lighting goes straight to the swapchain
+		const RenderGraphResource lit = postProcessing ? graph.CreateImage("HDR", { VK_FORMAT_R16G16B16A16_SFLOAT, width, height }) : swapchain;
+
+		const RenderGraphPass lighting = graph.AddPass("Lighting", RenderGraphPassType::GRAPHICS);
+		graph.Use(lighting, lit, RenderGraphAccess::COLOUR_ATTACHMENT, RenderGraphLoad::CLEAR);
+		for (RenderGraphResource target : gBuffer)
+		{
+			graph.Use(lighting, target, RenderGraphAccess::INPUT_ATTACHMENT);
+		}
+		graph.Use(lighting, depth, RenderGraphAccess::INPUT_ATTACHMENT);
+		graph.Use(lighting, shadowMap, RenderGraphAccess::FRAGMENT_SAMPLED);
+		graph.Use(lighting, lightLists, RenderGraphAccess::FRAGMENT_STORAGE_READ);
+
+		if (!postProcessing)
+		{
+			graph.SetSideEffects(lighting);
+			return graph;
+		}
+
+		graph.Use(lighting, ambientOcclusion, RenderGraphAccess::FRAGMENT_SAMPLED);
+
+		// Bloom downsamples the bright parts level by level, then adds each level back onto the one above
+		std::vector<RenderGraphResource> bloomDown;
+		for (uint32_t level = 0; level < bloomLevels; level++)
+		{
+			bloomDown.push_back(graph.CreateImage("Bloom down " + std::to_string(level),
+				{ VK_FORMAT_B10G11R11_UFLOAT_PACK32, std::max(width >> (level + 1), 1u), std::max(height >> (level + 1), 1u) }));
+
+			const RenderGraphPass downsample = graph.AddPass("Bloom downsample " + std::to_string(level), RenderGraphPassType::COMPUTE);
+			graph.Use(downsample, level == 0 ? lit : bloomDown[level - 1], RenderGraphAccess::COMPUTE_SAMPLED);
+			graph.Use(downsample, bloomDown[level], RenderGraphAccess::COMPUTE_STORAGE_WRITE, RenderGraphLoad::DISCARD);
+		}
+
+		RenderGraphResource bloom = bloomDown.back();
+		for (uint32_t level = bloomLevels - 1; level-- > 0;)
+		{
+			const RenderGraphResource bloomUp = graph.CreateImage("Bloom up " + std::to_string(level), graph.GetImageDesc(bloomDown[level]));
+
+			const RenderGraphPass upsample = graph.AddPass("Bloom upsample " + std::to_string(level), RenderGraphPassType::COMPUTE);
+			graph.Use(upsample, bloom, RenderGraphAccess::COMPUTE_SAMPLED);
+			graph.Use(upsample, bloomDown[level], RenderGraphAccess::COMPUTE_SAMPLED);
+			graph.Use(upsample, bloomUp, RenderGraphAccess::COMPUTE_STORAGE_WRITE, RenderGraphLoad::DISCARD);
+			bloom = bloomUp;
+		}
+
+		// Debug views are declared every frame but only kept while something reads them
+		const RenderGraphResource normalsView = graph.CreateImage("Normals view", { VK_FORMAT_R8G8B8A8_UNORM, width, height });
+		const RenderGraphPass normalsDebug = graph.AddPass("Normals debug", RenderGraphPassType::COMPUTE);
+		graph.Use(normalsDebug, depth, RenderGraphAccess::COMPUTE_SAMPLED);
+		graph.Use(normalsDebug, normalsView, RenderGraphAccess::COMPUTE_STORAGE_WRITE, RenderGraphLoad::DISCARD);
+
+		const RenderGraphResource overdrawView = graph.CreateImage("Overdraw view", { VK_FORMAT_R8G8B8A8_UNORM, width, height });
+		const RenderGraphPass overdrawDebug = graph.AddPass("Overdraw debug", RenderGraphPassType::COMPUTE);
+		graph.Use(overdrawDebug, normalsView, RenderGraphAccess::COMPUTE_SAMPLED);
+		graph.Use(overdrawDebug, overdrawView, RenderGraphAccess::COMPUTE_STORAGE_WRITE, RenderGraphLoad::DISCARD);
+
+		const RenderGraphPass tonemap = graph.AddPass("Tonemap", RenderGraphPassType::GRAPHICS);
+		graph.Use(tonemap, swapchain, RenderGraphAccess::COLOUR_ATTACHMENT, RenderGraphLoad::CLEAR);
+		graph.Use(tonemap, lit, RenderGraphAccess::FRAGMENT_SAMPLED);
+		graph.Use(tonemap, bloom, RenderGraphAccess::FRAGMENT_SAMPLED);
+		graph.SetSideEffects(tonemap);
+
+		return graph;
+	}
+
+	void RunRenderGraphBench(BenchReport& report)
+	{
+		constexpr uint32_t WIDTH = 1920;
+		constexpr uint32_t HEIGHT = 1080;
+		constexpr uint32_t BLOOM_LEVELS = 6;
+		constexpr uint32_t ITERATIONS = 2000;
+		constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+
+		for (bool postProcessing : { false, true })
+		{
+			const RenderGraph graph = BuildBenchFrameGraph(WIDTH, HEIGHT, postProcessing, BLOOM_LEVELS);
+
+			CompiledRenderGraph compiled;
+			const double compileMs = MeasureMilliseconds([&]()
+				{
+					graph.Compile(compiled);
+					DoNotOptimize(&compiled);
+				}, ITERATIONS);
+
+			size_t barriers = compiled.finalBarriers.size();
+			for (const CompiledRenderGraph::Pass& pass : compiled.passes)
+			{
+				barriers += pass.barriers.size();
+			}
+
+			size_t subpasses = 0;
+			size_t dependencies = 0;
+			for (const CompiledRenderGraph::RenderPass& renderPass : compiled.renderPasses)
+			{
+				subpasses += renderPass.subpasses.size();
+				dependencies += renderPass.dependencies.size();
+			}
+
+			BenchResult result;
+			result.benchmark = "RenderGraph";
+			result.variant = postProcessing ? "Renderer passes with post processing" : "Renderer passes";
+			result.itemCount = graph.GetPassCount();
+			result.msPerRun = compileMs;
+			result.nsPerItem = compileMs * 1e6 / graph.GetPassCount();
+			result.metrics.push_back({ "scheduledPasses", static_cast<double>(compiled.passes.size()) });
+			result.metrics.push_back({ "culledPasses", static_cast<double>(compiled.culledPasses.size()) });
+			result.metrics.push_back({ "renderPasses", static_cast<double>(compiled.renderPasses.size()) });
+			result.metrics.push_back({ "subpasses", static_cast<double>(subpasses) });
+			result.metrics.push_back({ "subpassDependencies", static_cast<double>(dependencies) });
+			result.metrics.push_back({ "pipelineBarriers", static_cast<double>(barriers) });
+			result.metrics.push_back({ "transientMB", compiled.transientBytes / BYTES_PER_MB });
+			result.metrics.push_back({ "aliasedMB", compiled.aliasedBytes / BYTES_PER_MB });
+			report.Add(result);
+
+			std::cout << graph.Describe(compiled) << "\n";
+		}
+	}
+}
@@ -0,0 +1,244 @@
+#include "BenchUtils.h"
+#include "SoftwareOcclusionCulling.h"
+#include "FrustumCulling.h"
+#include <GLM/gtc/matrix_transform.hpp>
+
+using namespace Renderer;
+
+namespace Benchmarks
+{
+	static OccluderMesh CreateBoxOccluder(const glm::vec3& center, const glm::vec3& extents)
+	{
+		OccluderMesh mesh;
+
+		for (int i = 0; i < 8; i++)
+		{
+			mesh.positions.push_back(center + extents * glm::vec3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f));
+		}
+
+		mesh.indices = {
+			0, 1, 3, 0, 3, 2,	// -Z
+			4, 6, 7, 4, 7, 5,	// +Z
+			0, 4, 5, 0, 5, 1,	// -Y
+			2, 3, 7, 2, 7, 6,	// +Y
+			0, 2, 6, 0, 6, 4,	// -X
+			1, 5, 7, 1, 7, 3 };	// +X
+
+		return mesh;
+	}
+
+	/** Plain per pixel depth buffer at the same resolution and sampling rules, every box the culler rejects must also be rejected here */
+	class ReferenceDepthBuffer
+	{
+	public:
+		ReferenceDepthBuffer(uint32_t width, uint32_t height, const glm::mat4& viewProjection)
+			: width(width), height(height), viewProjection(viewProjection), depth(static_cast<size_t>(width) * height, 1.0f) {}
+
+		void RenderOccluder(const OccluderMesh& mesh)
+		{
+			for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+			{
+				glm::vec3 screen[3];
+				bool clipped = false;
+
+				for (int v = 0; v < 3; v++)
+				{
+					const glm::vec4 clipPos = viewProjection * glm::vec4(mesh.positions[mesh.indices[i + v]], 1.0f);
+					clipped |= clipPos.w <= 0.0f || clipPos.z < 0.0f;
+					screen[v] = glm::vec3((clipPos.x / clipPos.w * 0.5f + 0.5f) * width, (clipPos.y / clipPos.w * 0.5f + 0.5f) * height, clipPos.z / clipPos.w);
+				}
+
+				if (!clipped)
+				{
+					RasterizeTriangle(screen[0], screen[1], screen[2]);
+				}
+			}
+		}
+
+		bool IsBoxVisible(const BoundingBox& box) const
+		{
+			glm::vec3 screenMin(FLT_MAX), screenMax(-FLT_MAX);
+
+			for (int i = 0; i < 8; i++)
+			{
+				const glm::vec4 clipPos = viewProjection * glm::vec4((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z, 1.0f);
+				if (clipPos.w <= 0.0f || clipPos.z < 0.0f)
+				{
+					return true;
+				}
+
+				const glm::vec3 screenPos((clipPos.x / clipPos.w * 0.5f + 0.5f) * width, (clipPos.y / clipPos.w * 0.5f + 0.5f) * height, clipPos.z / clipPos.w);
+				screenMin = glm::min(screenMin, screenPos);
+				screenMax = glm::max(screenMax, screenPos);
+			}
+
+			if (screenMax.x < 0.0f || screenMax.y < 0.0f || screenMin.x >= width || screenMin.y >= height)
+			{
+				return true;
+			}
+
+			const int32_t firstX = static_cast<int32_t>(std::max(screenMin.x, 0.0f));
+			const int32_t lastX = static_cast<int32_t>(std::min(screenMax.x, width - 1.0f));
+			const int32_t firstY = static_cast<int32_t>(std::max(screenMin.y, 0.0f));
+			const int32_t lastY = static_cast<int32_t>(std::min(screenMax.y, height - 1.0f));
+
+			for (int32_t y = firstY; y <= lastY; y++)
+			{
+				for (int32_t x = firstX; x <= lastX; x++)
+				{
+					if (screenMin.z <= depth[static_cast<size_t>(y) * width + x])
+					{
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		uint32_t width;
+		uint32_t height;
+		glm::mat4 viewProjection;
+		std::vector<float> depth;
+
+		void RasterizeTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2)
+		{
+			float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+			if (std::abs(area) < 1e-6f)
+			{
+				return;
+			}
+
+			if (area < 0.0f)
+			{
+				std::swap(v1, v2);
+				area = -area;
+			}
+
+			for (uint32_t y = 0; y < height; y++)
+			{
+				for (uint32_t x = 0; x < width; x++)
+				{
+					const glm::vec2 p(x + 0.5f, y + 0.5f);
+					const float w0 = (v2.x - v1.x) * (p.y - v1.y) - (v2.y - v1.y) * (p.x - v1.x);
+					const float w1 = (v0.x - v2.x) * (p.y - v2.y) - (v0.y - v2.y) * (p.x - v2.x);
+					const float w2 = (v1.x - v0.x) * (p.y - v0.y) - (v1.y - v0.y) * (p.x - v0.x);
+
+					if (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f)
+					{
+						const float z = (w0 * v0.z + w1 * v1.z + w2 * v2.z) / area;
+						float& pixelDepth = depth[static_cast<size_t>(y) * width + x];
+						pixelDepth = std::min(pixelDepth, z);
+					}
+				}
+			}
+		}
+	};
+
+	void RunSoftwareOcclusionBench(BenchReport& report)
+	{
+		const std::vector<size_t> objectCounts = { 1000, 10000, 100000 };
+		constexpr uint32_t BUFFER_WIDTH = 256;
+		constexpr uint32_t BUFFER_HEIGHT = 144;
+		constexpr uint32_t ITERATIONS = 20;
+
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+		projection[1][1] *= -1.0f;
+		const glm::mat4 viewProjection = projection * glm::lookAt(glm::vec3(0.0f, 0.0f, 200.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		const Frustum frustum = Frustum::FromViewProjection(viewProjection);
+
+		// City block like scene : a row of thick walls with gaps at z = 0, and a second row further back covering the gaps
+		std::vector<OccluderMesh> occluders;
+		for (int i = 0; i < 5; i++)
+		{
+			occluders.push_back(CreateBoxOccluder(glm::vec3(-180.0f + i * 90.0f, 0.0f, 0.0f), glm::vec3(35.0f, 90.0f, 4.0f)));
+			occluders.push_back(CreateBoxOccluder(glm::vec3(-135.0f + i * 90.0f, -20.0f, -150.0f), glm::vec3(30.0f, 120.0f, 4.0f)));
+		}
+
+		ReferenceDepthBuffer referenceBuffer(BUFFER_WIDTH, BUFFER_HEIGHT, viewProjection);
+		for (const OccluderMesh& occluder : occluders)
+		{
+			referenceBuffer.RenderOccluder(occluder);
+		}
+
+		for (size_t objectCount : objectCounts)
+		{
+			Random random(objectCount);
+			BoundingBoxSoA bounds;
+			bounds.Resize(objectCount);
+
+			for (size_t i = 0; i < objectCount; i++)
+			{
+				const glm::vec3 center(random.Range(-250.0f, 250.0f), random.Range(-140.0f, 140.0f), random.Range(-500.0f, 120.0f));
+				const glm::vec3 extents(random.Range(1.0f, 6.0f), random.Range(1.0f, 6.0f), random.Range(1.0f, 6.0f));
+
+				BoundingBox box;
+				box.min = center - extents;
+				box.max = center + extents;
+				bounds.Set(i, box);
+			}
+
+			std::vector<uint32_t> frustumVisible;
+			FrustumCuller::Cull(frustum, bounds, frustumVisible);
+
+			SoftwareOcclusionCuller culler;
+			culler.Resize(BUFFER_WIDTH, BUFFER_HEIGHT);
+
+			double rasterMs = MeasureMilliseconds([&]()
+				{
+					culler.BeginFrame(viewProjection);
+					for (const OccluderMesh& occluder : occluders)
+					{
+						culler.RenderOccluder(occluder, glm::mat4(1.0f));
+					}
+				}, ITERATIONS);
+
+			std::vector<uint32_t> visible;
+			double testMs = MeasureMilliseconds([&]()
+				{
+					visible = frustumVisible;
+					culler.CullBoxes(bounds, visible);
+					DoNotOptimize(visible);
+				}, ITERATIONS);
+
+			const SoftwareOcclusionCuller::Statistics& statistics = culler.GetStatistics();
+
+			// Every box the culler rejected must be hidden in the per pixel reference too
+			uint32_t nonConservativeCulls = 0;
+			uint32_t referenceCulled = 0;
+			size_t visibleCursor = 0;
+
+			for (uint32_t index : frustumVisible)
+			{
+				const bool kept = visibleCursor < visible.size() && visible[visibleCursor] == index;
+				visibleCursor += kept ? 1 : 0;
+
+				const bool referenceVisible = referenceBuffer.IsBoxVisible(bounds.Get(index));
+				referenceCulled += referenceVisible ? 0 : 1;
+				nonConservativeCulls += (!kept && referenceVisible) ? 1 : 0;
+			}
+
+			BenchResult rasterResult;
+			rasterResult.benchmark = "SoftwareOcclusion";
+			rasterResult.variant = "Rasterize occluders";
+			rasterResult.itemCount = statistics.occluderTriangles;
+			rasterResult.msPerRun = rasterMs;
+			rasterResult.nsPerItem = rasterMs * 1e6 / statistics.occluderTriangles;
+			rasterResult.metrics.push_back({ "rasterizedTriangles", static_cast<double>(statistics.rasterizedTriangles) });
+			report.Add(rasterResult);
+
+			BenchResult testResult;
+			testResult.benchmark = "SoftwareOcclusion";
+			testResult.variant = "Test boxes";
+			testResult.itemCount = frustumVisible.size();
+			testResult.msPerRun = testMs;
+			testResult.nsPerItem = testMs * 1e6 / std::max<size_t>(frustumVisible.size(), 1);
+			testResult.metrics.push_back({ "frameMs", rasterMs + testMs });
+			testResult.metrics.push_back({ "culledPercent", 100.0 * (frustumVisible.size() - visible.size()) / std::max<size_t>(frustumVisible.size(), 1) });
+			testResult.metrics.push_back({ "referenceCulledPercent", 100.0 * referenceCulled / std::max<size_t>(frustumVisible.size(), 1) });
+			testResult.metrics.push_back({ "nonConservativeCulls", static_cast<double>(nonConservativeCulls) });
+			report.Add(testResult);
+		}
+	}
+}
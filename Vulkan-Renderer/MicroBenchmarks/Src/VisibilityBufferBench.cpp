@@ -0,0 +1,229 @@
+#include "BenchUtils.h"
+#include "GBufferLayout.h"
+#include <GLM/gtc/matrix_transform.hpp>
+#include <cmath>
+
+using namespace Renderer;
+
+namespace Benchmarks
+{
+	struct SceneVertex
+	{
+		glm::vec3 pos;
+		glm::vec3 normal;
+		glm::vec2 uv;
+	};
+
+	// A pixel of the visibility buffer, the pixel centre stands in for gl_FragCoord
+	struct VisibilitySample
+	{
+		uint32_t id;
+		glm::vec2 pixelNdc;
+		glm::vec3 expectedLambda;
+	};
+
+	// Tilted grid filling the view so triangles cover roughly the requested number of pixels and w varies across them
+	static void BuildGrid(uint32_t quadsPerSide, std::vector<SceneVertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		const uint32_t verticesPerSide = quadsPerSide + 1;
+		vertices.clear();
+		indices.clear();
+
+		for (uint32_t y = 0; y < verticesPerSide; y++)
+		{
+			for (uint32_t x = 0; x < verticesPerSide; x++)
+			{
+				const glm::vec2 uv(x / static_cast<float>(quadsPerSide), y / static_cast<float>(quadsPerSide));
+				const glm::vec3 pos((uv.x - 0.5f) * 4.0f, (uv.y - 0.5f) * 2.5f, -2.5f - uv.y * 2.0f);
+				vertices.push_back({ pos, glm::normalize(glm::vec3(uv.x - 0.5f, 1.0f, uv.y - 0.5f)), uv * 8.0f });
+			}
+		}
+
+		for (uint32_t y = 0; y < quadsPerSide; y++)
+		{
+			for (uint32_t x = 0; x < quadsPerSide; x++)
+			{
+				const uint32_t i = y * verticesPerSide + x;
+				indices.insert(indices.end(), { i, i + 1, i + verticesPerSide, i + 1, i + verticesPerSide + 1, i + verticesPerSide });
+			}
+		}
+	}
+
+	// Helper lanes a 2x2 quad rasterizer shades per covered pixel for triangles of the given pixel area
+	static double QuadLanesPerPixel(double pixelsPerTriangle)
+	{
+		const double side = std::sqrt(pixelsPerTriangle);
+		return (side + 1.0) * (side + 1.0) / pixelsPerTriangle;
+	}
+
+	void RunVisibilityBufferBench(BenchReport& report)
+	{
+		constexpr uint32_t WIDTH = 1920;
+		constexpr uint32_t HEIGHT = 1080;
+		constexpr size_t PIXEL_COUNT = static_cast<size_t>(WIDTH) * HEIGHT;
+		constexpr uint32_t ITERATIONS = 5;
+		constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+		// Texel bytes per textured lane after the texture cache, and the unique index and vertex bytes a triangle adds in a
+		// shared vertex mesh (three indices, about half a 44 byte vertex)
+		constexpr double TEXEL_BYTES = 4.0;
+		constexpr double TRIANGLE_FETCH_BYTES = 3.0 * 4.0 + 0.5 * 44.0;
+
+		const std::vector<double> densities = { 64.0, 8.0, 1.0 }; // Pixels per triangle
+		const std::vector<GBufferLayout> layouts = { GBufferLayout::STANDARD, GBufferLayout::COMPACT, GBufferLayout::VISIBILITY };
+
+		const glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), WIDTH / static_cast<float>(HEIGHT), 0.1f, 100.0f);
+		const glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+		const glm::vec2 inverseExtent(1.0f / WIDTH, 1.0f / HEIGHT);
+
+		// G-buffer inputs the two subpass lighting reads, filled once since their cost doesn't depend on triangle density
+		Random random(35);
+		std::vector<glm::vec4> positions(PIXEL_COUNT);
+		std::vector<glm::vec2> packedNormals(PIXEL_COUNT);
+		std::vector<float> depths(PIXEL_COUNT);
+		for (size_t i = 0; i < PIXEL_COUNT; i++)
+		{
+			positions[i] = glm::vec4(random.Range(-2.0f, 2.0f), random.Range(-1.0f, 1.0f), random.Range(-4.5f, -2.5f), 1.0f);
+			packedNormals[i] = EncodeOctahedralNormal(glm::normalize(glm::vec3(random.Range(-1.0f, 1.0f), 1.0f, random.Range(-1.0f, 1.0f))));
+			depths[i] = random.Range(0.9f, 1.0f);
+		}
+
+		std::vector<SceneVertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<VisibilitySample> samples(PIXEL_COUNT);
+
+		for (double pixelsPerTriangle : densities)
+		{
+			// The grid covers about half the screen, size its quads so its triangles average the requested area
+			const uint32_t triangleTarget = std::min(VISIBILITY_MAX_TRIANGLES, static_cast<uint32_t>(PIXEL_COUNT * 0.5 / pixelsPerTriangle));
+			const uint32_t quadsPerSide = std::max(1u, static_cast<uint32_t>(std::sqrt(triangleTarget / 2.0)));
+			BuildGrid(quadsPerSide, vertices, indices);
+			const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+			// Each sample is a point on a random triangle, its projection is the pixel and its barycentrics the reference
+			for (VisibilitySample& sample : samples)
+			{
+				const uint32_t triangle = random.Next() % triangleCount;
+				float u = random.Range(0.0f, 1.0f);
+				float v = random.Range(0.0f, 1.0f);
+				if (u + v > 1.0f)
+				{
+					u = 1.0f - u;
+					v = 1.0f - v;
+				}
+
+				sample.expectedLambda = glm::vec3(1.0f - u - v, u, v);
+				glm::vec3 worldPos(0.0f);
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					worldPos += sample.expectedLambda[corner] * vertices[indices[triangle * 3 + corner]].pos;
+				}
+
+				const glm::vec4 clip = viewProjection * glm::vec4(worldPos, 1.0f);
+				sample.pixelNdc = glm::vec2(clip) / clip.w;
+				sample.id = triangle; // The grid is the only draw, its triangles are numbered from zero
+			}
+
+			for (GBufferLayout layout : layouts)
+			{
+				double checksum = 0.0;
+				double maxLambdaError = 0.0;
+
+				// What each layout's lighting subpass does per pixel before shading : load the targets, or refetch and interpolate the triangle
+				double resolveMs = MeasureMilliseconds([&]()
+					{
+						glm::vec3 sum(0.0f);
+
+						if (layout == GBufferLayout::STANDARD)
+						{
+							for (size_t i = 0; i < PIXEL_COUNT; i++)
+							{
+								const glm::vec2 n = packedNormals[i];
+								sum += glm::vec3(positions[i]) * n.x;
+							}
+						}
+						else if (layout == GBufferLayout::COMPACT)
+						{
+							for (size_t i = 0; i < PIXEL_COUNT; i++)
+							{
+								const glm::vec2 ndc = samples[i].pixelNdc;
+								glm::vec4 worldPos = inverseViewProjection * glm::vec4(ndc, depths[i], 1.0f);
+								sum += glm::vec3(worldPos) / worldPos.w * DecodeOctahedralNormal(packedNormals[i]).y;
+							}
+						}
+						else
+						{
+							for (size_t i = 0; i < PIXEL_COUNT; i++)
+							{
+								const uint32_t triangle = samples[i].id;
+								const SceneVertex& v0 = vertices[indices[triangle * 3]];
+								const SceneVertex& v1 = vertices[indices[triangle * 3 + 1]];
+								const SceneVertex& v2 = vertices[indices[triangle * 3 + 2]];
+
+								const VisibilityBarycentrics barycentrics = ComputeVisibilityBarycentrics(viewProjection * glm::vec4(v0.pos, 1.0f),
+									viewProjection * glm::vec4(v1.pos, 1.0f), viewProjection * glm::vec4(v2.pos, 1.0f), samples[i].pixelNdc, inverseExtent);
+
+								const glm::vec3& lambda = barycentrics.lambda;
+								const glm::vec3 normal = lambda.x * v0.normal + lambda.y * v1.normal + lambda.z * v2.normal;
+								const glm::vec2 uvDdx = barycentrics.ddx.x * v0.uv + barycentrics.ddx.y * v1.uv + barycentrics.ddx.z * v2.uv;
+								sum += (lambda.x * v0.pos + lambda.y * v1.pos + lambda.z * v2.pos) * normal.y + glm::vec3(uvDdx, 0.0f);
+							}
+						}
+
+						DoNotOptimize(sum);
+						checksum = sum.x;
+					}, ITERATIONS);
+
+				DoNotOptimize(checksum);
+
+				if (layout == GBufferLayout::VISIBILITY)
+				{
+					for (const VisibilitySample& sample : samples)
+					{
+						const uint32_t triangle = sample.id;
+						const VisibilityBarycentrics barycentrics = ComputeVisibilityBarycentrics(
+							viewProjection * glm::vec4(vertices[indices[triangle * 3]].pos, 1.0f),
+							viewProjection * glm::vec4(vertices[indices[triangle * 3 + 1]].pos, 1.0f),
+							viewProjection * glm::vec4(vertices[indices[triangle * 3 + 2]].pos, 1.0f), sample.pixelNdc, inverseExtent);
+
+						const glm::vec3 error = glm::abs(barycentrics.lambda - sample.expectedLambda);
+						maxLambdaError = std::max(maxLambdaError, static_cast<double>(std::max(error.x, std::max(error.y, error.z))));
+					}
+				}
+
+				// Per pixel traffic. The early depth pass leaves one surviving G-buffer write per pixel, so colour targets are
+				// written and read once and depth costs the same 4 accesses in every layout. The G-buffer layouts sample
+				// textures in the geometry subpass where small triangles waste quad lanes, the visibility layout samples once
+				// per pixel in the full screen lighting subpass but refetches the triangle's indices and vertices
+				uint32_t colourBytesPerPixel = 0;
+				for (const GBufferTarget& target : GetGBufferColourTargets(layout))
+				{
+					colourBytesPerPixel += target.bytesPerPixel;
+				}
+
+				const bool visibility = layout == GBufferLayout::VISIBILITY;
+				const double texturedLanes = visibility ? 1.0 : QuadLanesPerPixel(pixelsPerTriangle);
+				const double geometryFetchBytes = visibility ? TRIANGLE_FETCH_BYTES / pixelsPerTriangle : 0.0;
+				const double bytesPerPixel = 2.0 * colourBytesPerPixel + 4.0 * GBUFFER_DEPTH_BYTES_PER_PIXEL + TEXEL_BYTES * texturedLanes + geometryFetchBytes;
+
+				BenchResult result;
+				result.benchmark = "VisibilityBuffer";
+				result.variant = std::string(GetGBufferLayoutName(layout)) + " " + std::to_string(static_cast<int>(pixelsPerTriangle)) + "px triangles";
+				result.itemCount = PIXEL_COUNT;
+				result.msPerRun = resolveMs;
+				result.nsPerItem = resolveMs * 1e6 / PIXEL_COUNT;
+				result.metrics.push_back({ "triangles", static_cast<double>(triangleCount) });
+				result.metrics.push_back({ "attachmentBytesPerPixel", static_cast<double>(GetGBufferBytesPerPixel(layout)) });
+				result.metrics.push_back({ "texturedLanesPerPixel", texturedLanes });
+				result.metrics.push_back({ "geometryFetchBytesPerPixel", geometryFetchBytes });
+				result.metrics.push_back({ "trafficMBPerFrame", bytesPerPixel * PIXEL_COUNT / BYTES_PER_MB });
+
+				if (visibility)
+				{
+					result.metrics.push_back({ "maxBarycentricErrorMicro", maxLambdaError * 1e6 });
+				}
+
+				report.Add(result);
+			}
+		}
+	}
+}
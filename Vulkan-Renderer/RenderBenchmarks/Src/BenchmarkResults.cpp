@@ -0,0 +1,185 @@
+#include "BenchmarkResults.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace RenderBenchmarks
+{
+	/** Nearest rank percentile of values, which are sorted */
+	static double GetPercentile(const std::vector<double>& values, double fraction)
+	{
+		if (values.empty())
+		{
+			return 0.0;
+		}
+
+		const size_t rank = static_cast<size_t>(std::ceil(fraction * values.size()));
+		return values[std::min(std::max(rank, size_t(1)), values.size()) - 1];
+	}
+
+	static void AddDistribution(SummaryMetrics& summary, const std::string& name, std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+
+		double total = 0.0;
+		for (double value : values)
+		{
+			total += value;
+		}
+
+		summary.push_back({ name + "Mean", values.empty() ? 0.0 : total / values.size() });
+		summary.push_back({ name + "P50", GetPercentile(values, 0.50) });
+		summary.push_back({ name + "P95", GetPercentile(values, 0.95) });
+		summary.push_back({ name + "P99", GetPercentile(values, 0.99) });
+	}
+
+	SummaryMetrics BenchmarkResults::Summarize() const
+	{
+		SummaryMetrics summary;
+		summary.push_back({ "setupMs", setupMs });
+
+		auto collect = [&](auto member)
+		{
+			std::vector<double> values;
+			values.reserve(frames.size());
+			for (const FrameSample& frame : frames)
+			{
+				values.push_back(static_cast<double>(frame.*member));
+			}
+			return values;
+		};
+
+		AddDistribution(summary, "cpuMs", collect(&FrameSample::cpuMs));
+		AddDistribution(summary, "gpuMs", collect(&FrameSample::gpuMs));
+		AddDistribution(summary, "shadowMs", collect(&FrameSample::shadowMs));
+		AddDistribution(summary, "depthMs", collect(&FrameSample::depthMs));
+		AddDistribution(summary, "gBufferMs", collect(&FrameSample::gBufferMs));
+		AddDistribution(summary, "lightingMs", collect(&FrameSample::lightingMs));
+
+		// Device memory is a running total, every other counter was reset each frame
+		for (size_t counter = 0; counter < static_cast<size_t>(Utilities::ProfileCounter::COUNT); counter++)
+		{
+			const std::string counterName = Utilities::Profiler::GetCounterName(static_cast<Utilities::ProfileCounter>(counter));
+			const bool isDeviceMemory = static_cast<Utilities::ProfileCounter>(counter) == Utilities::ProfileCounter::DEVICE_MEMORY_BYTES;
+
+			int64_t value = 0;
+			for (const FrameSample& frame : frames)
+			{
+				value = isDeviceMemory ? std::max(value, frame.counters[counter]) : value + frame.counters[counter];
+			}
+
+			summary.push_back({ counterName + (isDeviceMemory ? " peak" : " total"), static_cast<double>(value) });
+		}
+
+		return summary;
+	}
+
+	void BenchmarkResults::WriteJson(const std::string& filePath) const
+	{
+		std::ofstream outputStream(filePath);
+		outputStream << std::setprecision(10);
+
+		outputStream << "{\"scene\":\"" << sceneName << "\",\"width\":" << width << ",\"height\":" << height
+			<< ",\"warmupFrames\":" << warmupFrames << ",\"frameCount\":" << frames.size() << ",\"objectCount\":" << objectCount
+			<< ",\"generatedTriangles\":" << generatedTriangles << ",\"summary\":{";
+
+		const SummaryMetrics summary = Summarize();
+		for (size_t i = 0; i < summary.size(); i++)
+		{
+			outputStream << (i > 0 ? "," : "") << "\"" << summary[i].first << "\":" << summary[i].second;
+		}
+
+		outputStream << "},\"frames\":[";
+
+		for (size_t i = 0; i < frames.size(); i++)
+		{
+			const FrameSample& frame = frames[i];
+			outputStream << (i > 0 ? "," : "") << "{\"cpuMs\":" << frame.cpuMs << ",\"gpuMs\":" << frame.gpuMs << ",\"shadowMs\":" << frame.shadowMs
+				<< ",\"depthMs\":" << frame.depthMs << ",\"gBufferMs\":" << frame.gBufferMs << ",\"lightingMs\":" << frame.lightingMs;
+
+			for (size_t counter = 0; counter < frame.counters.size(); counter++)
+			{
+				outputStream << ",\"" << Utilities::Profiler::GetCounterName(static_cast<Utilities::ProfileCounter>(counter)) << "\":" << frame.counters[counter];
+			}
+
+			outputStream << "}";
+		}
+
+		outputStream << "]}";
+	}
+
+	bool BenchmarkResults::ReadSummary(const std::string& filePath, SummaryMetrics& summary)
+	{
+		std::ifstream inputStream(filePath);
+		if (!inputStream.is_open())
+		{
+			return false;
+		}
+
+		std::stringstream contents;
+		contents << inputStream.rdbuf();
+		const std::string json = contents.str();
+
+		// Only what WriteJson produces is read back, a flat object of quoted names and numbers
+		const std::string summaryKey = "\"summary\":{";
+		size_t position = json.find(summaryKey);
+		if (position == std::string::npos)
+		{
+			return false;
+		}
+		position += summaryKey.size();
+
+		summary.clear();
+		while (position < json.size() && json[position] == '"')
+		{
+			const size_t nameEnd = json.find('"', position + 1);
+			if (nameEnd == std::string::npos || nameEnd + 1 >= json.size() || json[nameEnd + 1] != ':')
+			{
+				return false;
+			}
+
+			const std::string name = json.substr(position + 1, nameEnd - position - 1);
+			char* valueEnd = nullptr;
+			const double value = std::strtod(json.c_str() + nameEnd + 2, &valueEnd);
+			summary.push_back({ name, value });
+
+			position = valueEnd - json.c_str();
+			if (position < json.size() && json[position] == ',')
+			{
+				position++;
+			}
+		}
+
+		return position < json.size() && json[position] == '}';
+	}
+
+	std::vector<Regression> BenchmarkResults::Compare(const SummaryMetrics& baseline, const SummaryMetrics& current, double thresholdPercent)
+	{
+		std::vector<Regression> regressions;
+
+		for (const auto& metric : current)
+		{
+			auto baselineMetric = std::find_if(baseline.begin(), baseline.end(),
+				[&](const std::pair<std::string, double>& entry) { return entry.first == metric.first; });
+			if (baselineMetric == baseline.end())
+			{
+				continue;
+			}
+
+			// Anything appearing where the baseline had none counts as doubling
+			const double changePercent = baselineMetric->second > 0.0
+				? (metric.second - baselineMetric->second) / baselineMetric->second * 100.0
+				: (metric.second > 0.0 ? 100.0 : 0.0);
+
+			if (changePercent > thresholdPercent)
+			{
+				regressions.push_back({ metric.first, baselineMetric->second, metric.second, changePercent });
+			}
+		}
+
+		return regressions;
+	}
+}
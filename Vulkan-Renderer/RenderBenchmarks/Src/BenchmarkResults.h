@@ -0,0 +1,54 @@
+#pragma once
+#include "Profiler.h"
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+namespace RenderBenchmarks
+{
+	/** What one measured frame cost */
+	struct FrameSample
+	{
+		double cpuMs = 0.0; // Scene updates and Draw(), including any wait on the frame context's fence
+		double gpuMs = 0.0; // Sum of the pass timings, they belong to the last completed use of the frame context
+		float shadowMs = 0.0f;
+		float depthMs = 0.0f;
+		float gBufferMs = 0.0f;
+		float lightingMs = 0.0f;
+		Utilities::Profiler::CounterValues counters = {};
+	};
+
+	using SummaryMetrics = std::vector<std::pair<std::string, double>>;
+
+	/** Summary metric that got worse than the baseline by more than the threshold */
+	struct Regression
+	{
+		std::string metric;
+		double baseline;
+		double current;
+		double changePercent;
+	};
+
+	class BenchmarkResults
+	{
+	public:
+		std::string sceneName;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t warmupFrames = 0;
+		uint64_t objectCount = 0;
+		uint64_t generatedTriangles = 0; // Drawn triangles of the generated objects, before culling
+		double setupMs = 0.0; // Loading, generating and uploading the scene
+		std::vector<FrameSample> frames;
+
+		/** Scene setup time, percentiles of the frame times, peak device memory and counter totals. Every metric is better when lower */
+		SummaryMetrics Summarize() const;
+		void WriteJson(const std::string& filePath) const;
+
+		/** Reads the summary of a results file written by WriteJson, false when it can't be read */
+		static bool ReadSummary(const std::string& filePath, SummaryMetrics& summary);
+		/** Metrics in both summaries where current is more than thresholdPercent above the baseline */
+		static std::vector<Regression> Compare(const SummaryMetrics& baseline, const SummaryMetrics& current, double thresholdPercent);
+	};
+}
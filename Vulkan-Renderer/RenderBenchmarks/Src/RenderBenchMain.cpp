@@ -0,0 +1,222 @@
+#include "BenchmarkResults.h"
+#include "SceneScript.h"
+#include "VulkanRenderer.h"
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+using namespace RenderBenchmarks;
+
+namespace
+{
+	struct SceneInstance
+	{
+		const ModelPlacement* placement;
+		uint32_t instance;
+		int32_t modelId;
+	};
+
+	void PlaceInstances(Renderer::VulkanRenderer& renderer, const SceneScript& script, const std::vector<SceneInstance>& instances, uint32_t frame, bool onlySpinning)
+	{
+		for (const SceneInstance& sceneInstance : instances)
+		{
+			// Models that never move stay static so cached shadow cascades behave as in a real scene
+			if (!onlySpinning || sceneInstance.placement->spinDegreesPerFrame != 0.0f)
+			{
+				renderer.Update(sceneInstance.modelId, script.GetInstanceTransform(*sceneInstance.placement, sceneInstance.instance, frame));
+			}
+		}
+	}
+
+	BenchmarkResults RunScene(const SceneScript& script)
+	{
+		Renderer::VulkanRenderer renderer;
+		if (renderer.InitHeadless({ script.width, script.height }) != EXIT_SUCCESS)
+		{
+			throw std::runtime_error("Failed to initialise the headless renderer");
+		}
+
+		const int64_t setupStartNs = Utilities::Profiler::Now();
+
+		std::vector<SceneInstance> instances;
+		for (const ModelPlacement& placement : script.models)
+		{
+			for (uint32_t instance = 0; instance < placement.count; instance++)
+			{
+				instances.push_back({ &placement, instance, renderer.CreateModel(placement.fileName, placement.scale) });
+			}
+		}
+		PlaceInstances(renderer, script, instances, 0, false);
+
+		uint64_t generatedTriangles = 0;
+		for (const StressSceneSettings& settings : script.stressScenes)
+		{
+			const StressSceneStatistics statistics = StressSceneGenerator::Generate(renderer, settings);
+			std::cout << "Generated " << statistics.objectCount << " objects from " << statistics.meshCount << " meshes and " << statistics.textureCount
+				<< " textures, " << statistics.drawnTriangles << " triangles (" << statistics.uniqueTriangles << " unique)\n";
+			generatedTriangles += statistics.drawnTriangles;
+		}
+
+		const double setupMs = (Utilities::Profiler::Now() - setupStartNs) / 1e6;
+
+		// Warm-up holds the first frame so pipelines, caches and allocations settle before anything is measured
+		const CameraKey firstCamera = script.SampleCamera(0);
+		renderer.SetCamera(firstCamera.location, firstCamera.lookAt);
+		for (uint32_t frame = 0; frame < script.warmupFrames; frame++)
+		{
+			renderer.Draw();
+			Utilities::Profiler::Get().EndFrame();
+		}
+
+		BenchmarkResults results;
+		results.sceneName = script.name;
+		results.width = script.width;
+		results.height = script.height;
+		results.warmupFrames = script.warmupFrames;
+		results.objectCount = renderer.GetModelCount();
+		results.generatedTriangles = generatedTriangles;
+		results.setupMs = setupMs;
+		results.frames.reserve(script.frameCount);
+
+		for (uint32_t frame = 0; frame < script.frameCount; frame++)
+		{
+			const int64_t startNs = Utilities::Profiler::Now();
+
+			const CameraKey camera = script.SampleCamera(frame);
+			renderer.SetCamera(camera.location, camera.lookAt);
+			PlaceInstances(renderer, script, instances, frame, true);
+			renderer.Draw();
+
+			const int64_t endNs = Utilities::Profiler::Now();
+			Utilities::Profiler::Get().EndFrame();
+
+			const Renderer::VulkanRenderer::GpuPassTimings& gpuPassTimings = renderer.GetGpuPassTimings();
+
+			FrameSample sample;
+			sample.cpuMs = (endNs - startNs) / 1e6;
+			sample.shadowMs = gpuPassTimings.shadowMs;
+			sample.depthMs = gpuPassTimings.depthMs;
+			sample.gBufferMs = gpuPassTimings.gBufferMs;
+			sample.lightingMs = gpuPassTimings.lightingMs;
+			sample.gpuMs = static_cast<double>(sample.shadowMs) + sample.depthMs + sample.gBufferMs + sample.lightingMs;
+			sample.counters = Utilities::Profiler::Get().GetFrameCounters();
+			results.frames.push_back(sample);
+		}
+
+		renderer.WaitForFrames();
+		renderer.CleanUp();
+
+		return results;
+	}
+
+	void PrintSummary(const SummaryMetrics& summary)
+	{
+		for (const auto& metric : summary)
+		{
+			std::cout << std::left << std::setw(32) << metric.first << std::right << std::setw(16) << std::fixed << std::setprecision(3) << metric.second << "\n";
+		}
+		std::cout << std::defaultfloat;
+	}
+}
+
+// Usage : RenderBenchmarks <scene script> [--json output.json] [--baseline baseline.json] [--threshold percent] [--trace trace.json]
+// Run from the Vulkan-Renderer project directory so shaders, models and textures are found.
+// Returns 2 when a summary metric regressed past the threshold against the baseline
+int main(int argc, char** argv)
+{
+	std::string scenePath;
+	std::string jsonPath = "renderbenchmarks.json";
+	std::string baselinePath;
+	std::string tracePath;
+	double thresholdPercent = 5.0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			jsonPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+		{
+			baselinePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+		{
+			thresholdPercent = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+		{
+			tracePath = argv[++i];
+		}
+		else
+		{
+			scenePath = argv[i];
+		}
+	}
+
+	if (scenePath.empty())
+	{
+		std::cerr << "Usage : RenderBenchmarks <scene script> [--json output.json] [--baseline baseline.json] [--threshold percent] [--trace trace.json]\n";
+		return EXIT_FAILURE;
+	}
+
+	BenchmarkResults results;
+	try
+	{
+		const SceneScript script = SceneScript::Load(scenePath);
+
+		if (!tracePath.empty())
+		{
+			Utilities::Profiler::Get().BeginSession(script.name, tracePath);
+		}
+
+		std::cout << "== " << script.name << " : " << script.width << "x" << script.height << ", " << script.warmupFrames << " warm-up and "
+			<< script.frameCount << " measured frames\n";
+		results = RunScene(script);
+
+		if (!tracePath.empty())
+		{
+			Utilities::Profiler::Get().EndSession();
+		}
+	}
+	catch (const std::runtime_error& e)
+	{
+		std::cerr << "\nRender benchmark error : " << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	const SummaryMetrics summary = results.Summarize();
+	PrintSummary(summary);
+
+	results.WriteJson(jsonPath);
+	std::cout << "\nResults written to " << jsonPath << "\n";
+
+	if (baselinePath.empty())
+	{
+		return EXIT_SUCCESS;
+	}
+
+	SummaryMetrics baseline;
+	if (!BenchmarkResults::ReadSummary(baselinePath, baseline))
+	{
+		std::cerr << "Failed to read baseline " << baselinePath << "\n";
+		return EXIT_FAILURE;
+	}
+
+	const std::vector<Regression> regressions = BenchmarkResults::Compare(baseline, summary, thresholdPercent);
+	if (regressions.empty())
+	{
+		std::cout << "No regressions over " << thresholdPercent << "% against " << baselinePath << "\n";
+		return EXIT_SUCCESS;
+	}
+
+	std::cout << "\n" << regressions.size() << " regressions over " << thresholdPercent << "% against " << baselinePath << "\n";
+	for (const Regression& regression : regressions)
+	{
+		std::cout << std::left << std::setw(32) << regression.metric << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(16) << regression.baseline << " -> " << std::setw(16) << regression.current
+			<< std::setprecision(1) << "  (+" << regression.changePercent << "%)\n";
+	}
+
+	return 2;
+}
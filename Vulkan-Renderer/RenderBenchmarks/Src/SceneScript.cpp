@@ -0,0 +1,268 @@
+#include "SceneScript.h"
+#include <GLM/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace RenderBenchmarks
+{
+	static glm::vec3 ReadVec3(std::istringstream& statement)
+	{
+		glm::vec3 value;
+		statement >> value.x >> value.y >> value.z;
+		return value;
+	}
+
+	static ModelPlacement ReadModelPlacement(std::istringstream& statement)
+	{
+		ModelPlacement placement;
+		statement >> placement.fileName;
+
+		std::string option;
+		while (statement >> option)
+		{
+			if (option == "scale")
+			{
+				statement >> placement.scale;
+			}
+			else if (option == "count")
+			{
+				statement >> placement.count;
+			}
+			else if (option == "columns")
+			{
+				statement >> placement.columns;
+			}
+			else if (option == "spacing")
+			{
+				statement >> placement.spacing;
+			}
+			else if (option == "offset")
+			{
+				placement.offset = ReadVec3(statement);
+			}
+			else if (option == "spin")
+			{
+				statement >> placement.spinDegreesPerFrame;
+			}
+			else
+			{
+				throw std::runtime_error("Failed to read model placement, Unknown option " + option);
+			}
+		}
+
+		// Options are read until the line runs out, stopping anywhere else means a value didn't parse
+		if (!statement.eof())
+		{
+			throw std::runtime_error("Failed to read model placement, Malformed option value");
+		}
+		statement.clear();
+
+		placement.columns = std::max(placement.columns, 1u);
+		return placement;
+	}
+
+	static StressSceneSettings ReadStressSettings(std::istringstream& statement)
+	{
+		StressSceneSettings settings;
+
+		std::string option;
+		while (statement >> option)
+		{
+			if (option == "layout")
+			{
+				std::string layout;
+				statement >> layout;
+				if (layout == "grid")
+				{
+					settings.layout = StressLayout::GRID;
+				}
+				else if (layout == "random")
+				{
+					settings.layout = StressLayout::RANDOM;
+				}
+				else
+				{
+					throw std::runtime_error("Failed to read stress scene, Unknown layout " + layout);
+				}
+			}
+			else if (option == "count")
+			{
+				statement >> settings.objectCount;
+			}
+			else if (option == "meshes")
+			{
+				statement >> settings.uniqueMeshCount;
+			}
+			else if (option == "textures")
+			{
+				statement >> settings.textureCount;
+			}
+			else if (option == "triangles")
+			{
+				statement >> settings.trianglesPerMesh;
+			}
+			else if (option == "texturesize")
+			{
+				statement >> settings.textureSize;
+			}
+			else if (option == "spacing")
+			{
+				statement >> settings.spacing;
+			}
+			else if (option == "extent")
+			{
+				statement >> settings.extent;
+			}
+			else if (option == "scale")
+			{
+				statement >> settings.minScale >> settings.maxScale;
+			}
+			else if (option == "offset")
+			{
+				settings.offset = ReadVec3(statement);
+			}
+			else if (option == "seed")
+			{
+				statement >> settings.seed;
+			}
+			else
+			{
+				throw std::runtime_error("Failed to read stress scene, Unknown option " + option);
+			}
+		}
+
+		if (!statement.eof())
+		{
+			throw std::runtime_error("Failed to read stress scene, Malformed option value");
+		}
+		statement.clear();
+
+		return settings;
+	}
+
+	SceneScript SceneScript::Load(const std::string& filePath)
+	{
+		std::ifstream inputStream(filePath);
+		if (!inputStream.is_open())
+		{
+			throw std::runtime_error("Failed to open scene script " + filePath);
+		}
+
+		SceneScript script;
+		script.name = filePath;
+
+		std::string line;
+		for (uint32_t lineNumber = 1; std::getline(inputStream, line); lineNumber++)
+		{
+			const size_t commentStart = line.find('#');
+			if (commentStart != std::string::npos)
+			{
+				line.erase(commentStart);
+			}
+
+			std::istringstream statement(line);
+			std::string keyword;
+			if (!(statement >> keyword))
+			{
+				continue;
+			}
+
+			if (keyword == "name")
+			{
+				statement >> script.name;
+			}
+			else if (keyword == "resolution")
+			{
+				statement >> script.width >> script.height;
+			}
+			else if (keyword == "warmup")
+			{
+				statement >> script.warmupFrames;
+			}
+			else if (keyword == "frames")
+			{
+				statement >> script.frameCount;
+			}
+			else if (keyword == "model")
+			{
+				script.models.push_back(ReadModelPlacement(statement));
+			}
+			else if (keyword == "stress")
+			{
+				script.stressScenes.push_back(ReadStressSettings(statement));
+			}
+			else if (keyword == "camera")
+			{
+				CameraKey key;
+				statement >> key.frame;
+				key.location = ReadVec3(statement);
+				key.lookAt = ReadVec3(statement);
+				script.cameraPath.push_back(key);
+			}
+			else
+			{
+				throw std::runtime_error("Failed to read scene script " + filePath + ", Unknown statement on line " + std::to_string(lineNumber));
+			}
+
+			if (statement.fail())
+			{
+				throw std::runtime_error("Failed to read scene script " + filePath + ", Malformed statement on line " + std::to_string(lineNumber));
+			}
+		}
+
+		if ((script.models.empty() && script.stressScenes.empty()) || script.frameCount == 0 || script.width == 0 || script.height == 0)
+		{
+			throw std::runtime_error("Failed to read scene script " + filePath + ", It needs models, a resolution and frames to measure");
+		}
+
+		if (script.cameraPath.empty())
+		{
+			script.cameraPath.push_back({});
+		}
+
+		std::stable_sort(script.cameraPath.begin(), script.cameraPath.end(),
+			[](const CameraKey& a, const CameraKey& b) { return a.frame < b.frame; });
+
+		return script;
+	}
+
+	CameraKey SceneScript::SampleCamera(uint32_t frame) const
+	{
+		if (frame <= cameraPath.front().frame)
+		{
+			return cameraPath.front();
+		}
+
+		for (size_t i = 1; i < cameraPath.size(); i++)
+		{
+			const CameraKey& previous = cameraPath[i - 1];
+			const CameraKey& next = cameraPath[i];
+			if (frame <= next.frame)
+			{
+				const float t = static_cast<float>(frame - previous.frame) / static_cast<float>(next.frame - previous.frame);
+
+				CameraKey sample;
+				sample.frame = frame;
+				sample.location = glm::mix(previous.location, next.location, t);
+				sample.lookAt = glm::mix(previous.lookAt, next.lookAt, t);
+				return sample;
+			}
+		}
+
+		return cameraPath.back();
+	}
+
+	glm::mat4 SceneScript::GetInstanceTransform(const ModelPlacement& placement, uint32_t instance, uint32_t frame) const
+	{
+		const uint32_t rows = (placement.count + placement.columns - 1) / placement.columns;
+		const float column = static_cast<float>(instance % placement.columns) - (placement.columns - 1) * 0.5f;
+		const float row = static_cast<float>(instance / placement.columns) - (rows - 1) * 0.5f;
+
+		const glm::vec3 location = placement.offset + glm::vec3(column * placement.spacing, 0.0f, row * placement.spacing);
+		const glm::mat4 transform = glm::translate(glm::mat4(1.0f), location);
+
+		return glm::rotate(transform, glm::radians(placement.spinDegreesPerFrame * frame), glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "StressSceneGenerator.h"
+#include <GLM/glm.hpp>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace RenderBenchmarks
+{
+	/** Copies of one model laid out on a grid in the XZ plane, centred on offset */
+	struct ModelPlacement
+	{
+		std::string fileName;
+		float scale = 1.0f;
+		uint32_t count = 1;
+		uint32_t columns = 1;
+		float spacing = 0.0f;
+		glm::vec3 offset = glm::vec3(0.0f);
+		float spinDegreesPerFrame = 0.0f; // Turns every copy around the vertical axis, moving models go through the refit paths
+	};
+
+	/** Camera position and target at a frame of the measured run, frames between keys are interpolated linearly */
+	struct CameraKey
+	{
+		uint32_t frame = 0;
+		glm::vec3 location = glm::vec3(0.0f, 0.0f, 200.0f);
+		glm::vec3 lookAt = glm::vec3(0.0f);
+	};
+
+	/**
+	* Fixed workload the benchmark replays, read from a text file with one statement per line and '#' comments :
+	*   name <scene name>
+	*   resolution <width> <height>
+	*   warmup <frames>            Drawn first and left out of the results
+	*   frames <frames>            Measured frames
+	*   model <file> [scale s] [count n] [columns c] [spacing d] [offset x y z] [spin degreesPerFrame]
+	*   camera <frame> <x y z> <lookAt x y z>
+	*   stress [layout grid|random] [count n] [meshes n] [textures n] [triangles n] [texturesize n] [spacing d] [extent e]
+	*          [scale min max] [offset x y z] [seed s]   Generated objects, see StressSceneSettings
+	* Nothing depends on wall clock time, every run of a script draws the same frames
+	*/
+	struct SceneScript
+	{
+		std::string name;
+		uint32_t width = 1280;
+		uint32_t height = 720;
+		uint32_t warmupFrames = 30;
+		uint32_t frameCount = 300;
+		std::vector<ModelPlacement> models;
+		std::vector<StressSceneSettings> stressScenes;
+		std::vector<CameraKey> cameraPath; // Sorted by frame
+
+		/** Throws when the file can't be read or a statement isn't understood */
+		static SceneScript Load(const std::string& filePath);
+
+		/** Camera of a measured frame, warm-up frames hold the first key */
+		CameraKey SampleCamera(uint32_t frame) const;
+		/** Transform of a model copy at a measured frame */
+		glm::mat4 GetInstanceTransform(const ModelPlacement& placement, uint32_t instance, uint32_t frame) const;
+	};
+}
@@ -0,0 +1,181 @@
+#include "StressSceneGenerator.h"
+#include <GLM/gtc/matrix_transform.hpp>
+#include <GLM/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace RenderBenchmarks
+{
+	/** Only the engine's raw output is used, the standard distributions give different numbers on different standard libraries */
+	struct StressRandom
+	{
+		std::mt19937 engine;
+
+		explicit StressRandom(uint32_t seed) : engine(seed) {}
+
+		float Next()
+		{
+			return (engine() >> 8) * (1.0f / 16777216.0f);
+		}
+
+		float Range(float minValue, float maxValue)
+		{
+			return minValue + (maxValue - minValue) * Next();
+		}
+
+		uint32_t Below(uint32_t count)
+		{
+			return std::min(static_cast<uint32_t>(Next() * count), count - 1);
+		}
+
+		glm::vec3 Colour()
+		{
+			return glm::vec3(Range(0.2f, 1.0f), Range(0.2f, 1.0f), Range(0.2f, 1.0f));
+		}
+	};
+
+	StressSceneStatistics StressSceneGenerator::Generate(Renderer::VulkanRenderer& renderer, const StressSceneSettings& settings)
+	{
+		PROFILE_FUNCTION();
+
+		StressSceneStatistics statistics;
+		StressRandom random(settings.seed);
+
+		const uint32_t meshCount = std::max(settings.uniqueMeshCount, 1u);
+		// A texture belongs to a mesh, more textures than meshes could never all be drawn
+		const uint32_t textureCount = std::min(std::max(settings.textureCount, 1u), meshCount);
+
+		std::vector<int32_t> textureIds(textureCount);
+		std::vector<uint8_t> rgba;
+		for (uint32_t texture = 0; texture < textureCount; texture++)
+		{
+			const glm::vec3 colourA = random.Colour();
+			const glm::vec3 colourB = random.Colour();
+			GenerateCheckerTexture(settings.textureSize, 2 + random.Below(7), colourA, colourB, rgba);
+
+			textureIds[texture] = renderer.CreateTexture(settings.textureSize, settings.textureSize, rgba.data());
+			statistics.textureBytes += rgba.size();
+		}
+
+		std::vector<int32_t> meshIds(meshCount);
+		std::vector<uint32_t> meshTriangles(meshCount);
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		for (uint32_t mesh = 0; mesh < meshCount; mesh++)
+		{
+			// Rings are half the segments, so a sphere has about segments squared triangles
+			const float triangles = settings.trianglesPerMesh * random.Range(0.75f, 1.25f);
+			const uint32_t segments = std::max(static_cast<uint32_t>(std::lround(std::sqrt(triangles))), 4u);
+			const uint32_t rings = std::max(segments / 2, 2u);
+
+			const glm::vec3 radii(random.Range(0.5f, 1.0f), random.Range(0.5f, 1.0f), random.Range(0.5f, 1.0f));
+			GenerateSphere(rings, segments, radii, random.Colour(), vertices, indices);
+
+			meshIds[mesh] = renderer.CreateMesh(vertices, indices, textureIds[mesh % textureCount]);
+			meshTriangles[mesh] = static_cast<uint32_t>(indices.size() / 3);
+			statistics.uniqueTriangles += meshTriangles[mesh];
+		}
+
+		const uint32_t columns = std::max(static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(settings.objectCount)))), 1u);
+		const float gridHalfSize = (columns - 1) * settings.spacing * 0.5f;
+
+		for (uint32_t object = 0; object < settings.objectCount; object++)
+		{
+			uint32_t mesh = object % meshCount;
+			glm::mat4 transform;
+
+			if (settings.layout == StressLayout::GRID)
+			{
+				const glm::vec3 location(
+					(object % columns) * settings.spacing - gridHalfSize,
+					0.0f,
+					(object / columns) * settings.spacing - gridHalfSize);
+				transform = glm::translate(glm::mat4(1.0f), settings.offset + location);
+			}
+			else
+			{
+				mesh = random.Below(meshCount);
+
+				const glm::vec3 location(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f));
+				const glm::vec3 axis(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f));
+				const float angle = random.Range(0.0f, glm::two_pi<float>());
+				const float scale = random.Range(settings.minScale, settings.maxScale);
+
+				transform = glm::translate(glm::mat4(1.0f), settings.offset + location * settings.extent);
+				if (glm::dot(axis, axis) > 1e-6f)
+				{
+					transform = glm::rotate(transform, angle, glm::normalize(axis));
+				}
+				transform = glm::scale(transform, glm::vec3(scale));
+			}
+
+			renderer.CreateModelFromMeshes({ meshIds[mesh] }, transform);
+			statistics.drawnTriangles += meshTriangles[mesh];
+		}
+
+		statistics.objectCount = settings.objectCount;
+		statistics.meshCount = meshCount;
+		statistics.textureCount = textureCount;
+
+		return statistics;
+	}
+
+	void StressSceneGenerator::GenerateSphere(uint32_t rings, uint32_t segments, const glm::vec3& radii, const glm::vec3& colour,
+		std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		vertices.clear();
+		indices.clear();
+
+		// The seam repeats its column of vertices so texture coordinates don't wrap back to zero inside a triangle
+		for (uint32_t ring = 0; ring <= rings; ring++)
+		{
+			const float theta = glm::pi<float>() * ring / rings;
+			for (uint32_t segment = 0; segment <= segments; segment++)
+			{
+				const float phi = glm::two_pi<float>() * segment / segments;
+				const glm::vec3 direction(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+
+				Vertex vertex;
+				vertex.pos = direction * radii;
+				vertex.col = colour;
+				vertex.normal = glm::normalize(direction / radii);
+				vertex.uv = glm::vec2(static_cast<float>(segment) / segments, static_cast<float>(ring) / rings);
+				vertices.push_back(vertex);
+			}
+		}
+
+		// Counter clockwise seen from outside, the G-buffer pipelines cull back faces
+		const uint32_t rowLength = segments + 1;
+		for (uint32_t ring = 0; ring < rings; ring++)
+		{
+			for (uint32_t segment = 0; segment < segments; segment++)
+			{
+				const uint32_t upper = ring * rowLength + segment;
+				const uint32_t lower = upper + rowLength;
+
+				indices.insert(indices.end(), { upper, upper + 1, lower });
+				indices.insert(indices.end(), { upper + 1, lower + 1, lower });
+			}
+		}
+	}
+
+	void StressSceneGenerator::GenerateCheckerTexture(uint32_t size, uint32_t cellCount, const glm::vec3& colourA, const glm::vec3& colourB, std::vector<uint8_t>& rgba)
+	{
+		rgba.resize(static_cast<size_t>(size) * size * 4);
+		const uint32_t cellSize = std::max(size / std::max(cellCount, 1u), 1u);
+
+		for (uint32_t y = 0; y < size; y++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				const glm::vec3& colour = ((x / cellSize + y / cellSize) & 1) ? colourB : colourA;
+				uint8_t* pixel = &rgba[(static_cast<size_t>(y) * size + x) * 4];
+				pixel[0] = static_cast<uint8_t>(colour.r * 255.0f);
+				pixel[1] = static_cast<uint8_t>(colour.g * 255.0f);
+				pixel[2] = static_cast<uint8_t>(colour.b * 255.0f);
+				pixel[3] = 255;
+			}
+		}
+	}
+}
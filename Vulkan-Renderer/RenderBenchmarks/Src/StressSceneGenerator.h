@@ -0,0 +1,57 @@
+#pragma once
+#include "VulkanRenderer.h"
+#include <cstdint>
+#include <vector>
+
+namespace RenderBenchmarks
+{
+	enum class StressLayout
+	{
+		GRID, // Evenly spaced on the XZ plane, unrotated and unscaled
+		RANDOM // Anywhere in a cube, randomly rotated and scaled
+	};
+
+	/** Procedural objects for scaling tests, every count is independent so one can be varied while the rest stay fixed */
+	struct StressSceneSettings
+	{
+		StressLayout layout = StressLayout::GRID;
+		uint32_t objectCount = 1000; // One model each
+		uint32_t uniqueMeshCount = 1; // Objects share these, one mesh means every object is an instance of it
+		uint32_t textureCount = 1; // Unique textures spread over the meshes, bounded by the bindless texture array
+		uint32_t trianglesPerMesh = 200; // Roughly, meshes are tessellated spheres with some variation
+		uint32_t textureSize = 64;
+		float spacing = 4.0f; // Grid
+		float extent = 500.0f; // Random, half the size of the cube objects are placed in
+		float minScale = 0.5f; // Random
+		float maxScale = 1.5f;
+		glm::vec3 offset = glm::vec3(0.0f);
+		uint32_t seed = 1;
+	};
+
+	/** What a generated scene put into the renderer */
+	struct StressSceneStatistics
+	{
+		uint32_t objectCount = 0;
+		uint32_t meshCount = 0;
+		uint32_t textureCount = 0;
+		uint64_t drawnTriangles = 0; // Summed over every object, before culling
+		uint64_t uniqueTriangles = 0; // Summed over the unique meshes
+		uint64_t textureBytes = 0; // Base levels only
+	};
+
+	/**
+	* Feeds generated meshes, textures and models straight into the renderer, bypassing model files.
+	* The same settings and seed always produce the same scene
+	*/
+	class StressSceneGenerator
+	{
+	public:
+		static StressSceneStatistics Generate(Renderer::VulkanRenderer& renderer, const StressSceneSettings& settings);
+
+		/** UV sphere with rings * segments * 2 triangles, radii give each mesh its own shape */
+		static void GenerateSphere(uint32_t rings, uint32_t segments, const glm::vec3& radii, const glm::vec3& colour,
+			std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		/** Checkerboard of two colours, cellCount cells along each side */
+		static void GenerateCheckerTexture(uint32_t size, uint32_t cellCount, const glm::vec3& colourA, const glm::vec3& colourB, std::vector<uint8_t>& rgba);
+	};
+}
@@ -0,0 +1,25 @@
+#version 450
+
+// Position only, the depth passes skip fetching and transforming the other vertex attributes
+layout(location = 0) in vec3 pos;
+
+layout(set = 0, binding = 0) uniform UboVP
+{
+	mat4 projection;
+	mat4 view;
+} uboVP;
+
+layout(push_constant) uniform PushModel
+{
+	mat4 model;
+	uint textureIndex;
+} pushModel;
+
+// Must match simple_shader.vert bit for bit, the G-buffer pass tests equal against this depth
+invariant gl_Position;
+
+void main()
+{
+	vec4 worldPos = pushModel.model * vec4(pos, 1.0);
+	gl_Position = uboVP.projection * uboVP.view * worldPos;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in vec3 inNorm;
+layout(location = 2) in vec2 inUV;
+
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform PushModel
+{
+	mat4 model;
+	uint textureIndex;
+} pushModel;
+
+layout (location = 0) out vec2 outNorm; // Octahedral, RG16
+layout (location = 1) out vec4 outCol; // Alpha left for a material channel
+
+// Projects onto the octahedron and folds the lower hemisphere over the diagonals into [0, 1]^2
+vec2 EncodeOctahedral(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 encoded = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return encoded * 0.5 + 0.5;
+}
+
+void main()
+{
+	outCol = texture(textures[pushModel.textureIndex], inUV);
+	outCol.a = 1.0;
+
+	outNorm = EncodeOctahedral(normalize(inNorm));
+}
\ No newline at end of file
@@ -7,17 +7,107 @@ layout(input_attachment_index = 3, binding = 3) uniform subpassInput inputDepth;
 
 layout(location = 0) out vec4 outCol;
 
+struct PointLight
+{
+	vec3 position;
+	float radius;
+	vec3 colour;
+	float intensity;
+};
+
+// Written by light_cluster.comp, the lights touching each cluster of the view frustum
+layout(set = 1, binding = 0) uniform ClusterUniforms
+{
+	mat4 view;
+	mat4 inverseProjection;
+	vec2 inverseExtent;
+	float nearPlane;
+	float farPlane;
+	float sliceScale;
+	float sliceBias;
+	uint lightCount;
+	uint lightIndexCapacity;
+} clusterUniforms;
+
+layout(std430, set = 1, binding = 1) readonly buffer Lights { PointLight lights[]; };
+layout(std430, set = 1, binding = 2) readonly buffer ClusterLightRanges { uvec2 clusterLightRanges[]; };
+layout(std430, set = 1, binding = 3) readonly buffer ClusterLightIndices { uint clusterLightIndices[]; };
+
+const uvec3 CLUSTER_COUNTS = uvec3(16, 9, 24);
+
+// Written by ShadowMapper, the key light's cascades and their view space split depths
+layout(set = 2, binding = 0) uniform ShadowUniforms
+{
+	mat4 cascadeViewProjections[4];
+	vec4 cascadeSplits;
+	vec4 cascadeTexelSizes;
+	vec4 toLight;
+} shadowUniforms;
+
+layout(set = 2, binding = 1) uniform sampler2DArrayShadow shadowMap;
+
+const uint SHADOW_CASCADE_COUNT = 4;
+
+// Point lights listed for the pixel's cluster, each fades smoothly to nothing at its radius
+vec3 ClusteredLighting(vec3 worldPos, vec3 normal)
+{
+	float viewDepth = max(-(clusterUniforms.view * vec4(worldPos, 1.0)).z, clusterUniforms.nearPlane);
+	float slice = clamp(floor(log(viewDepth) * clusterUniforms.sliceScale + clusterUniforms.sliceBias), 0.0, float(CLUSTER_COUNTS.z - 1));
+	uvec2 tile = min(uvec2(gl_FragCoord.xy * clusterUniforms.inverseExtent * vec2(CLUSTER_COUNTS.xy)), CLUSTER_COUNTS.xy - 1);
+	uint cluster = tile.x + CLUSTER_COUNTS.x * (tile.y + CLUSTER_COUNTS.y * uint(slice));
+
+	vec3 lighting = vec3(0.0);
+	uvec2 lightRange = clusterLightRanges[cluster]; // Offset and count of the cluster's light indices
+
+	for (uint i = 0; i < lightRange.y; i++)
+	{
+		PointLight light = lights[clusterLightIndices[lightRange.x + i]];
+		vec3 toLight = light.position - worldPos;
+		float distanceSquared = dot(toLight, toLight);
+
+		float ratio = distanceSquared / (light.radius * light.radius);
+		float falloff = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+		float attenuation = falloff * falloff / (distanceSquared + 1.0);
+
+		float lambert = max(dot(normal, toLight * inversesqrt(max(distanceSquared, 1e-6))), 0.0);
+		lighting += light.colour * light.intensity * attenuation * lambert;
+	}
+
+	return lighting;
+}
+
+// Key light's shadow from the first cascade whose slice holds the pixel, nothing is shadowed past the last one
+float KeyLightShadow(vec3 worldPos, vec3 normal)
+{
+	float viewDepth = -(clusterUniforms.view * vec4(worldPos, 1.0)).z;
+	uint cascade = 0;
+	while (cascade < SHADOW_CASCADE_COUNT && viewDepth > shadowUniforms.cascadeSplits[cascade])
+	{
+		cascade++;
+	}
+
+	if (cascade == SHADOW_CASCADE_COUNT)
+	{
+		return 1.0;
+	}
+
+	// Pushed out along the normal by a texel and a half so surfaces don't shadow themselves
+	vec3 offsetPos = worldPos + normal * shadowUniforms.cascadeTexelSizes[cascade] * 1.5;
+	vec4 shadowPos = shadowUniforms.cascadeViewProjections[cascade] * vec4(offsetPos, 1.0);
+	return texture(shadowMap, vec4(shadowPos.xy * 0.5 + 0.5, float(cascade), shadowPos.z));
+}
+
 void main()
 {
-	vec3 normal = subpassLoad(inputNormal).rgb;
-	normal = normal * 0.5 + 0.5;
-	outCol.rgb = subpassLoad(inputColour).rgb;
-	outCol.rgb *= clamp(dot(normal, vec3(0,1,0)), 0.0, 1.0);
-
-	float lightMul = pow(1.0/distance(subpassLoad(inputPos).rgb, vec3(20, 40, 0)), 1.25);
-	lightMul *= 35.0;
-	lightMul = clamp(lightMul, 0.0, 1.0);
-	outCol.rgb *= lightMul;
+	vec3 worldPos = subpassLoad(inputPos).rgb;
+	vec3 normal = normalize(subpassLoad(inputNormal).rgb * 2.0 - 1.0); // Stored remapped to [0, 1] by simple_shader.frag
+	vec3 clusteredLight = ClusteredLighting(worldPos, normal);
+
+	float shadow = KeyLightShadow(worldPos, normal);
+
+	float keyLight = clamp(dot(normal, shadowUniforms.toLight.xyz), 0.0, 1.0) * shadow;
+
+	outCol.rgb = subpassLoad(inputColour).rgb * (keyLight + clusteredLight);
 
 	float depth = subpassLoad(inputDepth).r;
 
@@ -0,0 +1,139 @@
+#version 450
+
+layout(input_attachment_index = 0, binding = 0) uniform subpassInput inputNormal; // Octahedral normal output from subpass 1
+layout(input_attachment_index = 1, binding = 1) uniform subpassInput inputColour; // Colour output from subpass 1
+layout(input_attachment_index = 2, binding = 2) uniform subpassInput inputDepth; // Depth output from subpass 1
+
+layout(push_constant) uniform PushReconstruction
+{
+	mat4 inverseViewProjection;
+	vec2 inverseExtent;
+} pushReconstruction;
+
+layout(location = 0) out vec4 outCol;
+
+struct PointLight
+{
+	vec3 position;
+	float radius;
+	vec3 colour;
+	float intensity;
+};
+
+// Written by light_cluster.comp, the lights touching each cluster of the view frustum
+layout(set = 1, binding = 0) uniform ClusterUniforms
+{
+	mat4 view;
+	mat4 inverseProjection;
+	vec2 inverseExtent;
+	float nearPlane;
+	float farPlane;
+	float sliceScale;
+	float sliceBias;
+	uint lightCount;
+	uint lightIndexCapacity;
+} clusterUniforms;
+
+layout(std430, set = 1, binding = 1) readonly buffer Lights { PointLight lights[]; };
+layout(std430, set = 1, binding = 2) readonly buffer ClusterLightRanges { uvec2 clusterLightRanges[]; };
+layout(std430, set = 1, binding = 3) readonly buffer ClusterLightIndices { uint clusterLightIndices[]; };
+
+const uvec3 CLUSTER_COUNTS = uvec3(16, 9, 24);
+
+// Written by ShadowMapper, the key light's cascades and their view space split depths
+layout(set = 2, binding = 0) uniform ShadowUniforms
+{
+	mat4 cascadeViewProjections[4];
+	vec4 cascadeSplits;
+	vec4 cascadeTexelSizes;
+	vec4 toLight;
+} shadowUniforms;
+
+layout(set = 2, binding = 1) uniform sampler2DArrayShadow shadowMap;
+
+const uint SHADOW_CASCADE_COUNT = 4;
+
+vec3 DecodeOctahedral(vec2 encoded)
+{
+	vec2 f = encoded * 2.0 - 1.0;
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
+// Point lights listed for the pixel's cluster, each fades smoothly to nothing at its radius
+vec3 ClusteredLighting(vec3 worldPos, vec3 normal)
+{
+	float viewDepth = max(-(clusterUniforms.view * vec4(worldPos, 1.0)).z, clusterUniforms.nearPlane);
+	float slice = clamp(floor(log(viewDepth) * clusterUniforms.sliceScale + clusterUniforms.sliceBias), 0.0, float(CLUSTER_COUNTS.z - 1));
+	uvec2 tile = min(uvec2(gl_FragCoord.xy * clusterUniforms.inverseExtent * vec2(CLUSTER_COUNTS.xy)), CLUSTER_COUNTS.xy - 1);
+	uint cluster = tile.x + CLUSTER_COUNTS.x * (tile.y + CLUSTER_COUNTS.y * uint(slice));
+
+	vec3 lighting = vec3(0.0);
+	uvec2 lightRange = clusterLightRanges[cluster]; // Offset and count of the cluster's light indices
+
+	for (uint i = 0; i < lightRange.y; i++)
+	{
+		PointLight light = lights[clusterLightIndices[lightRange.x + i]];
+		vec3 toLight = light.position - worldPos;
+		float distanceSquared = dot(toLight, toLight);
+
+		float ratio = distanceSquared / (light.radius * light.radius);
+		float falloff = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+		float attenuation = falloff * falloff / (distanceSquared + 1.0);
+
+		float lambert = max(dot(normal, toLight * inversesqrt(max(distanceSquared, 1e-6))), 0.0);
+		lighting += light.colour * light.intensity * attenuation * lambert;
+	}
+
+	return lighting;
+}
+
+// Key light's shadow from the first cascade whose slice holds the pixel, nothing is shadowed past the last one
+float KeyLightShadow(vec3 worldPos, vec3 normal)
+{
+	float viewDepth = -(clusterUniforms.view * vec4(worldPos, 1.0)).z;
+	uint cascade = 0;
+	while (cascade < SHADOW_CASCADE_COUNT && viewDepth > shadowUniforms.cascadeSplits[cascade])
+	{
+		cascade++;
+	}
+
+	if (cascade == SHADOW_CASCADE_COUNT)
+	{
+		return 1.0;
+	}
+
+	// Pushed out along the normal by a texel and a half so surfaces don't shadow themselves
+	vec3 offsetPos = worldPos + normal * shadowUniforms.cascadeTexelSizes[cascade] * 1.5;
+	vec4 shadowPos = shadowUniforms.cascadeViewProjections[cascade] * vec4(offsetPos, 1.0);
+	return texture(shadowMap, vec4(shadowPos.xy * 0.5 + 0.5, float(cascade), shadowPos.z));
+}
+
+void main()
+{
+	float depth = subpassLoad(inputDepth).r;
+
+	// World position from the pixel's clip space position, the projection's y flip is part of the inverse
+	vec2 ndc = gl_FragCoord.xy * pushReconstruction.inverseExtent * 2.0 - 1.0;
+	vec4 worldPos = pushReconstruction.inverseViewProjection * vec4(ndc, depth, 1.0);
+	worldPos.xyz /= worldPos.w;
+
+	vec3 normal = DecodeOctahedral(subpassLoad(inputNormal).rg);
+	vec3 clusteredLight = ClusteredLighting(worldPos.xyz, normal);
+
+	float shadow = KeyLightShadow(worldPos.xyz, normal);
+
+	float keyLight = clamp(dot(normal, shadowUniforms.toLight.xyz), 0.0, 1.0) * shadow;
+
+	outCol.rgb = subpassLoad(inputColour).rgb * (keyLight + clusteredLight);
+
+	const float upperBound = 1.0f;
+	const float lowerBound = 0.999f;
+	float depthScaled = 1.0f - ((depth - lowerBound)/(upperBound - lowerBound));
+
+	outCol.rgb *= depthScaled;
+
+	outCol.a = 1.0;
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform usubpassInput inputVisibility; // Draw and triangle IDs from subpass 1
+layout(input_attachment_index = 1, set = 0, binding = 1) uniform subpassInput inputDepth; // Depth output from subpass 1
+
+layout(set = 3, binding = 0) uniform sampler2D textures[];
+
+struct DrawData
+{
+	mat4 model;
+	uint firstIndex;
+	uint vertexOffset;
+	uint textureIndex;
+	uint firstTriangle; // Visibility ID of the draw's first triangle
+};
+
+// Every mesh merged into one buffer each, positions and the colour, normal and uv attributes are packed as floats
+layout(std430, set = 4, binding = 0) readonly buffer Positions { float positionData[]; };
+layout(std430, set = 4, binding = 1) readonly buffer Attributes { float attributeData[]; };
+layout(std430, set = 4, binding = 2) readonly buffer Indices { uint indices[]; };
+layout(std430, set = 4, binding = 3) readonly buffer Draws { DrawData draws[]; };
+
+layout(push_constant) uniform PushVisibility
+{
+	mat4 viewProjection;
+	vec2 inverseExtent;
+	uint drawCount;
+} pushVisibility;
+
+layout(location = 0) out vec4 outCol;
+
+struct PointLight
+{
+	vec3 position;
+	float radius;
+	vec3 colour;
+	float intensity;
+};
+
+// Written by light_cluster.comp, the lights touching each cluster of the view frustum
+layout(set = 1, binding = 0) uniform ClusterUniforms
+{
+	mat4 view;
+	mat4 inverseProjection;
+	vec2 inverseExtent;
+	float nearPlane;
+	float farPlane;
+	float sliceScale;
+	float sliceBias;
+	uint lightCount;
+	uint lightIndexCapacity;
+} clusterUniforms;
+
+layout(std430, set = 1, binding = 1) readonly buffer Lights { PointLight lights[]; };
+layout(std430, set = 1, binding = 2) readonly buffer ClusterLightRanges { uvec2 clusterLightRanges[]; };
+layout(std430, set = 1, binding = 3) readonly buffer ClusterLightIndices { uint clusterLightIndices[]; };
+
+const uvec3 CLUSTER_COUNTS = uvec3(16, 9, 24);
+
+// Written by ShadowMapper, the key light's cascades and their view space split depths
+layout(set = 2, binding = 0) uniform ShadowUniforms
+{
+	mat4 cascadeViewProjections[4];
+	vec4 cascadeSplits;
+	vec4 cascadeTexelSizes;
+	vec4 toLight;
+} shadowUniforms;
+
+layout(set = 2, binding = 1) uniform sampler2DArrayShadow shadowMap;
+
+const uint SHADOW_CASCADE_COUNT = 4;
+
+const uint EMPTY_ID = 0xFFFFFFFF;
+const uint ATTRIBUTE_STRIDE = 8;
+
+// Last draw starting at or before the triangle, draws are numbered in draw item order so their first triangles ascend
+uint FindDraw(uint triangle)
+{
+	uint low = 0;
+	uint high = pushVisibility.drawCount;
+	while (high - low > 1)
+	{
+		uint middle = (low + high) / 2;
+		if (draws[middle].firstTriangle <= triangle)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	return low;
+}
+
+vec3 LoadPosition(uint vertexIndex)
+{
+	uint base = vertexIndex * 3;
+	return vec3(positionData[base], positionData[base + 1], positionData[base + 2]);
+}
+
+vec3 LoadNormal(uint vertexIndex)
+{
+	uint base = vertexIndex * ATTRIBUTE_STRIDE + 3;
+	return vec3(attributeData[base], attributeData[base + 1], attributeData[base + 2]);
+}
+
+vec2 LoadUV(uint vertexIndex)
+{
+	uint base = vertexIndex * ATTRIBUTE_STRIDE + 6;
+	return vec2(attributeData[base], attributeData[base + 1]);
+}
+
+// Perspective correct barycentrics and their change one pixel right and down, screen space barycentrics are linear in ndc
+// and divided by w they interpolate linearly along with 1 / w
+void ComputeBarycentrics(vec4 clip0, vec4 clip1, vec4 clip2, vec2 pixelNdc, out vec3 lambda, out vec3 lambdaDdx, out vec3 lambdaDdy)
+{
+	vec3 invW = 1.0 / vec3(clip0.w, clip1.w, clip2.w);
+	vec2 ndc0 = clip0.xy * invW.x;
+	vec2 ndc1 = clip1.xy * invW.y;
+	vec2 ndc2 = clip2.xy * invW.z;
+
+	float invDet = 1.0 / determinant(mat2(ndc2 - ndc1, ndc0 - ndc1));
+	vec3 ddx = vec3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * invDet * invW;
+	vec3 ddy = vec3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * invDet * invW;
+	float ddxSum = dot(ddx, vec3(1.0));
+	float ddySum = dot(ddy, vec3(1.0));
+
+	vec2 delta = pixelNdc - ndc0;
+	float interpInvW = invW.x + delta.x * ddxSum + delta.y * ddySum;
+	vec3 numerator = vec3(invW.x, 0.0, 0.0) + delta.x * ddx + delta.y * ddy;
+	lambda = numerator / interpInvW;
+
+	// One pixel is two over the extent in ndc
+	vec2 pixelSize = 2.0 * pushVisibility.inverseExtent;
+	ddx *= pixelSize.x;
+	ddy *= pixelSize.y;
+	ddxSum *= pixelSize.x;
+	ddySum *= pixelSize.y;
+
+	lambdaDdx = (numerator + ddx) / (interpInvW + ddxSum) - lambda;
+	lambdaDdy = (numerator + ddy) / (interpInvW + ddySum) - lambda;
+}
+
+// Point lights listed for the pixel's cluster, each fades smoothly to nothing at its radius
+vec3 ClusteredLighting(vec3 worldPos, vec3 normal)
+{
+	float viewDepth = max(-(clusterUniforms.view * vec4(worldPos, 1.0)).z, clusterUniforms.nearPlane);
+	float slice = clamp(floor(log(viewDepth) * clusterUniforms.sliceScale + clusterUniforms.sliceBias), 0.0, float(CLUSTER_COUNTS.z - 1));
+	uvec2 tile = min(uvec2(gl_FragCoord.xy * clusterUniforms.inverseExtent * vec2(CLUSTER_COUNTS.xy)), CLUSTER_COUNTS.xy - 1);
+	uint cluster = tile.x + CLUSTER_COUNTS.x * (tile.y + CLUSTER_COUNTS.y * uint(slice));
+
+	vec3 lighting = vec3(0.0);
+	uvec2 lightRange = clusterLightRanges[cluster]; // Offset and count of the cluster's light indices
+
+	for (uint i = 0; i < lightRange.y; i++)
+	{
+		PointLight light = lights[clusterLightIndices[lightRange.x + i]];
+		vec3 toLight = light.position - worldPos;
+		float distanceSquared = dot(toLight, toLight);
+
+		float ratio = distanceSquared / (light.radius * light.radius);
+		float falloff = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+		float attenuation = falloff * falloff / (distanceSquared + 1.0);
+
+		float lambert = max(dot(normal, toLight * inversesqrt(max(distanceSquared, 1e-6))), 0.0);
+		lighting += light.colour * light.intensity * attenuation * lambert;
+	}
+
+	return lighting;
+}
+
+// Key light's shadow from the first cascade whose slice holds the pixel, nothing is shadowed past the last one
+float KeyLightShadow(vec3 worldPos, vec3 normal)
+{
+	float viewDepth = -(clusterUniforms.view * vec4(worldPos, 1.0)).z;
+	uint cascade = 0;
+	while (cascade < SHADOW_CASCADE_COUNT && viewDepth > shadowUniforms.cascadeSplits[cascade])
+	{
+		cascade++;
+	}
+
+	if (cascade == SHADOW_CASCADE_COUNT)
+	{
+		return 1.0;
+	}
+
+	// Pushed out along the normal by a texel and a half so surfaces don't shadow themselves
+	vec3 offsetPos = worldPos + normal * shadowUniforms.cascadeTexelSizes[cascade] * 1.5;
+	vec4 shadowPos = shadowUniforms.cascadeViewProjections[cascade] * vec4(offsetPos, 1.0);
+	return texture(shadowMap, vec4(shadowPos.xy * 0.5 + 0.5, float(cascade), shadowPos.z));
+}
+
+void main()
+{
+	uint visibility = subpassLoad(inputVisibility).r;
+
+	if (visibility == EMPTY_ID)
+	{
+		outCol = vec4(0.0, 0.0, 0.0, 1.0);
+		return;
+	}
+
+	DrawData draw = draws[FindDraw(visibility)];
+	uint firstIndex = draw.firstIndex + (visibility - draw.firstTriangle) * 3;
+
+	uint vertex0 = indices[firstIndex] + draw.vertexOffset;
+	uint vertex1 = indices[firstIndex + 1] + draw.vertexOffset;
+	uint vertex2 = indices[firstIndex + 2] + draw.vertexOffset;
+
+	vec4 worldPos0 = draw.model * vec4(LoadPosition(vertex0), 1.0);
+	vec4 worldPos1 = draw.model * vec4(LoadPosition(vertex1), 1.0);
+	vec4 worldPos2 = draw.model * vec4(LoadPosition(vertex2), 1.0);
+
+	vec2 ndc = gl_FragCoord.xy * pushVisibility.inverseExtent * 2.0 - 1.0;
+	vec3 lambda;
+	vec3 lambdaDdx;
+	vec3 lambdaDdy;
+	ComputeBarycentrics(pushVisibility.viewProjection * worldPos0, pushVisibility.viewProjection * worldPos1,
+		pushVisibility.viewProjection * worldPos2, ndc, lambda, lambdaDdx, lambdaDdy);
+
+	vec3 worldPos = lambda.x * worldPos0.xyz + lambda.y * worldPos1.xyz + lambda.z * worldPos2.xyz;
+	vec3 normal = lambda.x * LoadNormal(vertex0) + lambda.y * LoadNormal(vertex1) + lambda.z * LoadNormal(vertex2);
+	normal = normalize((draw.model * vec4(normal, 0.0)).xyz);
+
+	// The analytic uv derivatives pick the same mip level the G-buffer pass gets from its quad
+	mat3x2 uvs = mat3x2(LoadUV(vertex0), LoadUV(vertex1), LoadUV(vertex2));
+	vec2 uv = uvs * lambda;
+	outCol.rgb = textureGrad(textures[nonuniformEXT(draw.textureIndex)], uv, uvs * lambdaDdx, uvs * lambdaDdy).rgb;
+
+	// Same lighting as the G-buffer layouts
+	vec3 clusteredLight = ClusteredLighting(worldPos, normal);
+
+	float shadow = KeyLightShadow(worldPos, normal);
+
+	float keyLight = clamp(dot(normal, shadowUniforms.toLight.xyz), 0.0, 1.0) * shadow;
+
+	outCol.rgb *= keyLight + clusteredLight;
+
+	float depth = subpassLoad(inputDepth).r;
+
+	const float upperBound = 1.0f;
+	const float lowerBound = 0.999f;
+	float depthScaled = 1.0f - ((depth - lowerBound)/(upperBound - lowerBound));
+
+	outCol.rgb *= depthScaled;
+
+	outCol.a = 1.0;
+}
\ No newline at end of file
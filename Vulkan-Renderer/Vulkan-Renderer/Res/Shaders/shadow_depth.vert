@@ -0,0 +1,14 @@
+#version 450
+
+// Shadow cascades only need depth, so only the position stream is fetched
+layout(location = 0) in vec3 pos;
+
+layout(push_constant) uniform PushShadow
+{
+	mat4 lightModelViewProjection;
+} pushShadow;
+
+void main()
+{
+	gl_Position = pushShadow.lightModelViewProjection * vec4(pos, 1.0);
+}
\ No newline at end of file
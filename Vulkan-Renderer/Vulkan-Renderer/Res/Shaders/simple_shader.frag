@@ -1,10 +1,17 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inNorm;
 layout(location = 2) in vec2 inUV;
 
-layout(set = 1, binding = 0) uniform sampler2D textureSampler;
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform PushModel
+{
+	mat4 model;
+	uint textureIndex;
+} pushModel;
 
 layout (location = 0) out vec4 outPos;
 layout (location = 1) out vec4 outNorm;
@@ -12,11 +19,12 @@ layout (location = 2) out vec4 outCol;
 
 void main()
 {
-	outCol = texture(textureSampler, inUV);
+	outCol = texture(textures[pushModel.textureIndex], inUV);
 	outCol.a = 1.0;
 
+	// The normal target is UNORM, negative components would clamp to zero without the remap
 	vec3 normalVal = normalize(inNorm);
-	outNorm = vec4(normalVal,1);
+	outNorm = vec4(normalVal * 0.5 + 0.5, 1);
 
 	outPos = vec4(inPos, 1.0);
 }
\ No newline at end of file
@@ -11,24 +11,25 @@ layout(set = 0, binding = 0) uniform UboVP
 	mat4 view;
 } uboVP;
 
-layout(set = 0, binding = 1) uniform UboModel
-{
-	mat4 model;
-} uboModel;
-
 layout(push_constant) uniform PushModel
 {
 	mat4 model;
+	uint textureIndex;
 } pushModel;
 
 layout(location = 0) out vec3 outPos;
 layout(location = 1) out vec3 outNorm;
 layout(location = 2) out vec2 outUV;
+layout(location = 3) flat out uint outFirstTriangle; // Triangles of the draw items before this one, the indirect command's first instance
+
+// depth_only.vert and the G-buffer pass must produce identical depth for the equal depth test
+invariant gl_Position;
 
 void main()
 {
 	outNorm = (pushModel.model * vec4(normal, 0.0)).rgb;
 	outUV = uv;
+	outFirstTriangle = uint(gl_InstanceIndex);
 	vec4 worldPos = pushModel.model * vec4(pos, 1.0);
 	outPos = worldPos.rgb;
 	gl_Position = uboVP.projection * uboVP.view * worldPos;
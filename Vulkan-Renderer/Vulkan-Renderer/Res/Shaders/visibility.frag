@@ -0,0 +1,10 @@
+#version 450
+
+layout(location = 3) flat in uint inFirstTriangle;
+
+layout (location = 0) out uint outVisibility; // Triangle index among every draw item's triangles, R32_UINT
+
+void main()
+{
+	outVisibility = inFirstTriangle + uint(gl_PrimitiveID);
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "AppWindow.h"
 #include <stdexcept>
+#include <utility>
 #include "ConstantsAndDefines.h"
 #include "Utils.h"
 
@@ -30,12 +31,32 @@ bool ApplicationWindow::AppWindow::ShouldClose() const
 	return glfwWindowShouldClose(windowPtr);
 }
 
-void ApplicationWindow::AppWindow::PollInputs() const
+void ApplicationWindow::AppWindow::PollInputs()
 {
 	using namespace Utilities;
 	PROFILE_FUNCTION();
 
 	glfwPollEvents();
+
+	for (InputBinding& binding : inputBindings)
+	{
+		const int state = binding.mouseButton ? glfwGetMouseButton(windowPtr, binding.code) : glfwGetKey(windowPtr, binding.code);
+		if (state == GLFW_PRESS && binding.lastState == GLFW_RELEASE)
+		{
+			binding.action();
+		}
+		binding.lastState = state;
+	}
+}
+
+void ApplicationWindow::AppWindow::BindKey(int key, std::function<void()> action)
+{
+	inputBindings.push_back({ key, false, std::move(action) });
+}
+
+void ApplicationWindow::AppWindow::BindMouseButton(int button, std::function<void()> action)
+{
+	inputBindings.push_back({ button, true, std::move(action) });
 }
 
 GLFWwindow* ApplicationWindow::AppWindow::GetWindow() const
@@ -1,7 +1,9 @@
 #pragma once
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#include <functional>
 #include <string>
+#include <vector>
 
 namespace ApplicationWindow
 {
@@ -28,13 +30,27 @@ namespace ApplicationWindow
 		void Initwindow(const WindowProperties& _windowProps);
 		WindowProperties GetWindowProperties() const;
 		bool ShouldClose() const;
-		void PollInputs() const;
+		/** Polls window events, then runs the actions of keys and buttons pressed since the last poll */
+		void PollInputs();
 		GLFWwindow* GetWindow() const;
 
+		/** Runs action once each time the key goes down, holding it doesn't repeat */
+		void BindKey(int key, std::function<void()> action);
+		void BindMouseButton(int button, std::function<void()> action);
+
 	protected:
 		WindowProperties windowProps;
 
 	private:
+		struct InputBinding
+		{
+			int code;
+			bool mouseButton;
+			std::function<void()> action;
+			int lastState = GLFW_RELEASE;
+		};
+
 		GLFWwindow* windowPtr = nullptr;
+		std::vector<InputBinding> inputBindings;
 	};
 }
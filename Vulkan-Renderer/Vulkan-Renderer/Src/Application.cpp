@@ -1,10 +1,23 @@
 #include "Application.h"
 #include "VulkanRenderer.h"
 #include "ConstantsAndDefines.h"
+#include <iomanip>
+#include <iostream>
+#include <random>
 
 Application::Application()
 {
-	Benchmark::Get().BeginSession("Profile");
+	if (PROFILER_FLIGHT_RECORDER)
+	{
+		FlightRecorderSettings settings;
+		settings.windowSeconds = PROFILER_FLIGHT_RECORDER_SECONDS;
+		settings.frameBudgetMs = PROFILER_FRAME_BUDGET_MS;
+		Profiler::Get().BeginFlightRecorder("Profile", settings);
+	}
+	else
+	{
+		Profiler::Get().BeginSession("Profile");
+	}
 	PROFILE_FUNCTION();
 	appWindow.Initwindow({ 1920, 1080, "Vulkan Test Window" });
 }
@@ -15,6 +28,7 @@ void Application::Run()
 
 	renderer.Init(appWindow.GetWindow());
 	int32_t planeModelId = renderer.CreateModel("11805_airplane_v2_L2.obj", 0.1f);
+	BindDebugInputs();
 	{
 		PROFILE_SCOPE("RenderLoop");
 		while (!appWindow.ShouldClose())
@@ -34,8 +48,10 @@ void Application::Run()
 			rot = glm::rotate(rot, glm::radians(angle * 20.0f), GLOBAL_UP);
 
 			appWindow.PollInputs();
+
 			renderer.Update(planeModelId, rot);
 			renderer.Draw();
+			Profiler::Get().EndFrame();
 
 			lastTime = now;
 
@@ -43,5 +59,152 @@ void Application::Run()
 	}
 
 	renderer.CleanUp();
-	Benchmark::Get().EndSession();
+	Profiler::Get().EndSession();
+}
+
+void Application::BindDebugInputs()
+{
+	if (LOG_PICKED_MODELS)
+	{
+		appWindow.BindMouseButton(GLFW_MOUSE_BUTTON_LEFT, [this]()
+			{
+				double cursorX = 0.0, cursorY = 0.0;
+				glfwGetCursorPos(appWindow.GetWindow(), &cursorX, &cursorY);
+
+				float hitDistance = 0.0f;
+				int32_t pickedModelId = renderer.PickModel(cursorX, cursorY, &hitDistance);
+				if (pickedModelId >= 0)
+				{
+					std::cout << "\nPicked model : " << pickedModelId << " at distance " << hitDistance;
+				}
+			});
+	}
+
+	appWindow.BindKey(GLFW_KEY_O, [this]()
+		{
+			occlusionCullingEnabled = !occlusionCullingEnabled;
+			renderer.SetOcclusionCullingEnabled(occlusionCullingEnabled);
+			std::cout << "\nOcclusion culling : " << (occlusionCullingEnabled ? "on" : "off");
+		});
+
+	appWindow.BindKey(GLFW_KEY_B, [this]()
+		{
+			const DrawList::Statistics& drawStatistics = renderer.GetDrawStatistics();
+			std::cout << "\nDraws : " << drawStatistics.draws << ", pipeline binds : " << drawStatistics.pipelineBinds
+				<< ", descriptor set binds : " << drawStatistics.descriptorSetBinds << ", vertex buffer binds : " << drawStatistics.vertexBufferBinds
+				<< ", index buffer binds : " << drawStatistics.indexBufferBinds << ", push constant updates : " << drawStatistics.pushConstantUpdates;
+
+			const VulkanRenderer::ShadowStatistics& shadowStatistics = renderer.GetShadowStatistics();
+			std::cout << "\nShadow cascades rendered : " << shadowStatistics.cascadesRendered << ", cached : " << shadowStatistics.cascadesCached
+				<< ", caster draws : " << shadowStatistics.casterDraws;
+
+			// Whole frame, every pass and upload included
+			const Profiler::CounterValues& frameCounters = Profiler::Get().GetFrameCounters();
+			std::cout << "\nLast frame :";
+			for (size_t counter = 0; counter < frameCounters.size(); counter++)
+			{
+				std::cout << (counter > 0 ? ", " : " ") << Profiler::GetCounterName(static_cast<ProfileCounter>(counter)) << " : " << frameCounters[counter];
+			}
+		});
+
+	appWindow.BindKey(GLFW_KEY_F, [this]()
+		{
+			renderer.SetFramesInFlight(renderer.GetFramesInFlight() % MAX_FRAMES_IN_FLIGHT + 1);
+			std::cout << "\nFrames in flight : " << renderer.GetFramesInFlight();
+		});
+
+	appWindow.BindKey(GLFW_KEY_G, [this]()
+		{
+			// Standard, compact, visibility, and back to standard when the device can't run the visibility layout
+			const GBufferLayout current = renderer.GetGBufferLayout();
+			const GBufferLayout next = current == GBufferLayout::STANDARD ? GBufferLayout::COMPACT
+				: current == GBufferLayout::COMPACT ? GBufferLayout::VISIBILITY : GBufferLayout::STANDARD;
+
+			renderer.SetGBufferLayout(next);
+			if (renderer.GetGBufferLayout() == current)
+			{
+				renderer.SetGBufferLayout(GBufferLayout::STANDARD);
+			}
+		});
+
+	appWindow.BindKey(GLFW_KEY_L, [this]()
+		{
+			// Scatters a batch of coloured point lights around the model
+			std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				PointLight light = {};
+				light.position = glm::vec3(position(lightRandom), position(lightRandom), position(lightRandom));
+				light.radius = 20.0f + unit(lightRandom) * 20.0f;
+				light.colour = glm::vec3(unit(lightRandom), unit(lightRandom), unit(lightRandom));
+				light.intensity = 200.0f;
+				renderer.AddLight(light);
+			}
+
+			std::cout << "\nPoint lights : " << renderer.GetLightCount();
+		});
+
+	appWindow.BindKey(GLFW_KEY_D, [this]()
+		{
+			renderer.SetDepthPrepassEnabled(!renderer.IsDepthPrepassEnabled());
+			std::cout << "\nDepth pre-pass : " << (renderer.IsDepthPrepassEnabled() ? "on" : "off");
+		});
+
+	appWindow.BindKey(GLFW_KEY_T, [this]()
+		{
+			const VulkanRenderer::GpuPassTimings& gpuPassTimings = renderer.GetGpuPassTimings();
+			std::cout << "\nGPU shadows : " << gpuPassTimings.shadowMs << " ms, depth : " << gpuPassTimings.depthMs << " ms, G-buffer : " << gpuPassTimings.gBufferMs
+				<< " ms, lighting : " << gpuPassTimings.lightingMs << " ms";
+		});
+
+	appWindow.BindKey(GLFW_KEY_K, [this]()
+		{
+			// Overdraw test scene, copies stacked along the view axis cover the same pixels back to front. Only made once
+			if (overdrawStackCreated)
+			{
+				return;
+			}
+			overdrawStackCreated = true;
+			for (int32_t i = 0; i < 8; i++)
+			{
+				int32_t stackModelId = renderer.CreateModel("11805_airplane_v2_L2.obj", 0.1f);
+				renderer.Update(stackModelId, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -20.0f * (8 - i))));
+			}
+		});
+
+	appWindow.BindKey(GLFW_KEY_V, [this]()
+		{
+			// Swings the key light around the vertical axis, every shadow cascade has to be rendered again
+			const glm::mat4 swing = glm::rotate(glm::mat4(1.0f), glm::radians(30.0f), GLOBAL_UP);
+			renderer.SetKeyLightDirection(glm::vec3(swing * glm::vec4(renderer.GetKeyLightDirection(), 0.0f)));
+		});
+
+	appWindow.BindKey(GLFW_KEY_R, [this]()
+		{
+			std::cout << "\n" << renderer.DescribeFrameGraph();
+		});
+
+	if (PROFILER_FLIGHT_RECORDER)
+	{
+		appWindow.BindKey(GLFW_KEY_P, []()
+			{
+				Profiler::Get().RequestDump();
+				std::cout << "\nFlight recording " << Profiler::Get().GetStatistics().dumpCount << " requested";
+			});
+	}
+
+	appWindow.BindKey(GLFW_KEY_H, []()
+		{
+			std::cout << "\nScope                                      count    mean ms     p50 ms     p95 ms     p99 ms     max ms";
+			for (const Profiler::ScopeSummary& summary : Profiler::Get().GetScopeSummaries())
+			{
+				const std::string name = (summary.track == ProfileTrack::GPU ? "[GPU] " : "") + summary.name;
+				std::cout << "\n" << std::left << std::setw(40) << name.substr(0, 39) << std::right << std::setw(8) << summary.count
+					<< std::fixed << std::setprecision(3) << std::setw(11) << summary.meanMs << std::setw(11) << summary.p50Ms
+					<< std::setw(11) << summary.p95Ms << std::setw(11) << summary.p99Ms << std::setw(11) << summary.maxMs;
+			}
+			std::cout << std::defaultfloat;
+		});
 }
@@ -2,6 +2,7 @@
 #include "AppWindow.h"
 #include "RenderPipeline.h"
 #include "VulkanRenderer.h"
+#include <random>
 
 using namespace ApplicationWindow;
 using namespace Renderer;
@@ -15,5 +16,11 @@ public:
 private:
 	AppWindow appWindow;
 	VulkanRenderer renderer;
+	bool occlusionCullingEnabled = true;
+	bool overdrawStackCreated = false;
+	std::mt19937 lightRandom{ 36 };
+
+	/** Debug hotkeys toggling renderer features and printing statistics */
+	void BindDebugInputs();
 };
 
@@ -0,0 +1,440 @@
+#include "BoundingVolumeHierarchy.h"
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+	struct SAHBin
+	{
+		Utilities::BoundingBox bounds;
+		uint32_t itemCount = 0;
+	};
+
+	uint32_t GetBinIndex(float centroid, float centroidMin, float binScale)
+	{
+		const uint32_t binIndex = static_cast<uint32_t>((centroid - centroidMin) * binScale);
+		return std::min(binIndex, Renderer::BoundingVolumeHierarchy::SAH_BIN_COUNT - 1);
+	}
+
+	/** Slab test, returns the entry distance along the ray or FLT_MAX on a miss */
+	float IntersectRayBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& boxMin, const glm::vec3& boxMax)
+	{
+		float entry = 0.0f;
+		float exit = FLT_MAX;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			// Parallel to the slab, 0 * inf would be NaN. The ray stays inside the slab or never reaches it
+			if (std::isinf(inverseDirection[axis]))
+			{
+				if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis])
+				{
+					return FLT_MAX;
+				}
+				continue;
+			}
+
+			const float t0 = (boxMin[axis] - origin[axis]) * inverseDirection[axis];
+			const float t1 = (boxMax[axis] - origin[axis]) * inverseDirection[axis];
+			entry = std::max(entry, std::min(t0, t1));
+			exit = std::min(exit, std::max(t0, t1));
+		}
+
+		return entry <= exit ? entry : FLT_MAX;
+	}
+}
+
+void Renderer::BoundingVolumeHierarchy::Build(const BoundingBoxSoA& itemBounds)
+{
+	const uint32_t itemCount = static_cast<uint32_t>(itemBounds.Size());
+
+	nodes.clear();
+	sortedItems.resize(itemCount);
+	std::iota(sortedItems.begin(), sortedItems.end(), 0);
+	sortedItemBounds.resize(itemCount);
+	itemLeaf.assign(itemCount, 0);
+	buildCentroids.resize(itemCount);
+	buildBounds.resize(itemCount);
+
+	for (uint32_t i = 0; i < itemCount; i++)
+	{
+		buildCentroids[i] = glm::vec3(itemBounds.centerX[i], itemBounds.centerY[i], itemBounds.centerZ[i]);
+		buildBounds[i] = itemBounds.Get(i);
+	}
+
+	if (itemCount == 0)
+	{
+		builtSAHCost = 0.0f;
+		return;
+	}
+
+	// A binary tree with leaves of at least one item never exceeds 2n - 1 nodes
+	nodes.reserve(static_cast<size_t>(itemCount) * 2 - 1);
+
+	Node root;
+	root.firstItem = 0;
+	root.itemCount = itemCount;
+	nodes.push_back(root);
+
+	std::vector<uint32_t> buildStack = { 0 };
+	while (!buildStack.empty())
+	{
+		const uint32_t nodeIndex = buildStack.back();
+		buildStack.pop_back();
+
+		Subdivide(nodeIndex, itemBounds);
+
+		if (!nodes[nodeIndex].IsLeaf())
+		{
+			buildStack.push_back(nodes[nodeIndex].leftChild);
+			buildStack.push_back(nodes[nodeIndex].leftChild + 1);
+		}
+	}
+
+	builtSAHCost = GetSAHCost();
+}
+
+void Renderer::BoundingVolumeHierarchy::Subdivide(uint32_t nodeIndex, const BoundingBoxSoA& itemBounds)
+{
+	const uint32_t firstItem = nodes[nodeIndex].firstItem;
+	const uint32_t itemCount = nodes[nodeIndex].itemCount;
+
+	if (itemCount <= MAX_LEAF_ITEMS)
+	{
+		RefitLeaf(nodes[nodeIndex], itemBounds);
+		return;
+	}
+
+	BoundingBox nodeBounds;
+	BoundingBox centroidBounds;
+	for (uint32_t i = firstItem; i < firstItem + itemCount; i++)
+	{
+		nodeBounds.Expand(buildBounds[sortedItems[i]]);
+		centroidBounds.Expand(buildCentroids[sortedItems[i]]);
+	}
+
+	nodes[nodeIndex].bounds = nodeBounds;
+
+	// Bin every axis in a single pass over the items, then evaluate the SAH at every bin boundary
+	const glm::vec3 centroidMin = centroidBounds.min;
+	const glm::vec3 centroidExtent = centroidBounds.max - centroidBounds.min;
+	glm::vec3 binScale;
+	SAHBin bins[3][SAH_BIN_COUNT];
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		binScale[axis] = centroidExtent[axis] > 0.0f ? SAH_BIN_COUNT / centroidExtent[axis] : 0.0f;
+	}
+
+	for (uint32_t i = firstItem; i < firstItem + itemCount; i++)
+	{
+		const uint32_t item = sortedItems[i];
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			SAHBin& bin = bins[axis][GetBinIndex(buildCentroids[item][axis], centroidMin[axis], binScale[axis])];
+			bin.bounds.Expand(buildBounds[item]);
+			bin.itemCount++;
+		}
+	}
+
+	int bestAxis = -1;
+	uint32_t bestSplit = 0;
+	float bestCost = FLT_MAX;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (centroidExtent[axis] <= 0.0f)
+		{
+			continue;
+		}
+
+		float leftArea[SAH_BIN_COUNT - 1];
+		uint32_t leftCount[SAH_BIN_COUNT - 1];
+		BoundingBox leftBounds;
+		uint32_t leftSum = 0;
+
+		for (uint32_t i = 0; i < SAH_BIN_COUNT - 1; i++)
+		{
+			leftBounds.Expand(bins[axis][i].bounds);
+			leftSum += bins[axis][i].itemCount;
+			leftArea[i] = leftBounds.GetSurfaceArea();
+			leftCount[i] = leftSum;
+		}
+
+		BoundingBox rightBounds;
+		uint32_t rightSum = 0;
+
+		for (uint32_t i = SAH_BIN_COUNT - 1; i > 0; i--)
+		{
+			rightBounds.Expand(bins[axis][i].bounds);
+			rightSum += bins[axis][i].itemCount;
+
+			if (leftCount[i - 1] == 0 || rightSum == 0)
+			{
+				continue;
+			}
+
+			const float cost = leftCount[i - 1] * leftArea[i - 1] + rightSum * rightBounds.GetSurfaceArea();
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i;
+			}
+		}
+	}
+
+	// Every centroid is identical, nothing left to separate
+	if (bestAxis < 0)
+	{
+		RefitLeaf(nodes[nodeIndex], itemBounds);
+		return;
+	}
+
+	auto middle = std::partition(sortedItems.begin() + firstItem, sortedItems.begin() + firstItem + itemCount,
+		[&](uint32_t item) { return GetBinIndex(buildCentroids[item][bestAxis], centroidMin[bestAxis], binScale[bestAxis]) < bestSplit; });
+
+	const uint32_t leftItemCount = static_cast<uint32_t>(middle - (sortedItems.begin() + firstItem));
+	const uint32_t leftChild = static_cast<uint32_t>(nodes.size());
+
+	Node left;
+	left.firstItem = firstItem;
+	left.itemCount = leftItemCount;
+	left.parent = nodeIndex;
+
+	Node right;
+	right.firstItem = firstItem + leftItemCount;
+	right.itemCount = itemCount - leftItemCount;
+	right.parent = nodeIndex;
+
+	nodes.push_back(left);
+	nodes.push_back(right);
+	nodes[nodeIndex].leftChild = leftChild;
+}
+
+void Renderer::BoundingVolumeHierarchy::RefitLeaf(Node& node, const BoundingBoxSoA& itemBounds)
+{
+	const uint32_t nodeIndex = static_cast<uint32_t>(&node - nodes.data());
+
+	node.bounds = BoundingBox();
+	for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+	{
+		sortedItemBounds[i] = itemBounds.Get(sortedItems[i]);
+		node.bounds.Expand(sortedItemBounds[i]);
+		itemLeaf[sortedItems[i]] = nodeIndex;
+	}
+}
+
+void Renderer::BoundingVolumeHierarchy::Refit(const BoundingBoxSoA& itemBounds)
+{
+	// Children are always stored after their parent so a reverse sweep visits them first
+	for (size_t i = nodes.size(); i-- > 0;)
+	{
+		Node& node = nodes[i];
+
+		if (node.IsLeaf())
+		{
+			RefitLeaf(node, itemBounds);
+		}
+		else
+		{
+			node.bounds = nodes[node.leftChild].bounds;
+			node.bounds.Expand(nodes[node.leftChild + 1].bounds);
+		}
+	}
+}
+
+void Renderer::BoundingVolumeHierarchy::RefitItems(const BoundingBoxSoA& itemBounds, const std::vector<uint32_t>& itemIndices)
+{
+	for (uint32_t item : itemIndices)
+	{
+		uint32_t nodeIndex = itemLeaf[item];
+		RefitLeaf(nodes[nodeIndex], itemBounds);
+
+		while (nodes[nodeIndex].parent != UINT32_MAX)
+		{
+			nodeIndex = nodes[nodeIndex].parent;
+
+			Node& node = nodes[nodeIndex];
+			node.bounds = nodes[node.leftChild].bounds;
+			node.bounds.Expand(nodes[node.leftChild + 1].bounds);
+		}
+	}
+}
+
+void Renderer::BoundingVolumeHierarchy::CullFrustum(const Frustum& frustum, std::vector<uint32_t>& visibleIndices) const
+{
+	visibleIndices.clear();
+
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	constexpr uint32_t ALL_PLANES = (1 << 6) - 1;
+
+	// Each entry carries the planes its parent was not already fully inside of
+	std::vector<std::pair<uint32_t, uint32_t>> traversalStack;
+	traversalStack.reserve(64);
+	traversalStack.push_back({ 0, ALL_PLANES });
+
+	while (!traversalStack.empty())
+	{
+		const uint32_t nodeIndex = traversalStack.back().first;
+		uint32_t planeMask = traversalStack.back().second;
+		traversalStack.pop_back();
+
+		const Node& node = nodes[nodeIndex];
+		const glm::vec3 center = node.bounds.GetCenter();
+		const glm::vec3 extents = node.bounds.GetExtents();
+		bool outside = false;
+
+		for (uint32_t p = 0; p < 6; p++)
+		{
+			if ((planeMask & (1 << p)) == 0)
+			{
+				continue;
+			}
+
+			const glm::vec4& plane = frustum.planes[p];
+			const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+			const float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+
+			if (distance + radius < 0.0f)
+			{
+				outside = true;
+				break;
+			}
+
+			if (distance - radius >= 0.0f)
+			{
+				planeMask &= ~(1 << p);
+			}
+		}
+
+		if (outside)
+		{
+			continue;
+		}
+
+		// Fully inside, accept the whole subtree without testing it any further
+		if (planeMask == 0)
+		{
+			AppendSubtree(node, visibleIndices);
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+			{
+				if (frustum.IsBoxVisible(sortedItemBounds[i].GetCenter(), sortedItemBounds[i].GetExtents()))
+				{
+					visibleIndices.push_back(sortedItems[i]);
+				}
+			}
+			continue;
+		}
+
+		traversalStack.push_back({ node.leftChild, planeMask });
+		traversalStack.push_back({ node.leftChild + 1, planeMask });
+	}
+}
+
+bool Renderer::BoundingVolumeHierarchy::RayCast(const Ray& ray, RayHit& hit) const
+{
+	hit = RayHit();
+
+	if (nodes.empty())
+	{
+		return false;
+	}
+
+	const glm::vec3 inverseDirection = 1.0f / ray.direction;
+
+	std::vector<uint32_t> traversalStack;
+	traversalStack.reserve(64);
+	traversalStack.push_back(0);
+
+	while (!traversalStack.empty())
+	{
+		const Node& node = nodes[traversalStack.back()];
+		traversalStack.pop_back();
+
+		if (IntersectRayBox(ray.origin, inverseDirection, node.bounds.min, node.bounds.max) >= hit.distance)
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+			{
+				const float distance = IntersectRayBox(ray.origin, inverseDirection, sortedItemBounds[i].min, sortedItemBounds[i].max);
+				if (distance < hit.distance)
+				{
+					hit.distance = distance;
+					hit.itemIndex = sortedItems[i];
+				}
+			}
+			continue;
+		}
+
+		// Push the farther child first so the nearer one is visited first and tightens the hit distance early
+		const float leftDistance = IntersectRayBox(ray.origin, inverseDirection, nodes[node.leftChild].bounds.min, nodes[node.leftChild].bounds.max);
+		const float rightDistance = IntersectRayBox(ray.origin, inverseDirection, nodes[node.leftChild + 1].bounds.min, nodes[node.leftChild + 1].bounds.max);
+
+		if (leftDistance < rightDistance)
+		{
+			traversalStack.push_back(node.leftChild + 1);
+			traversalStack.push_back(node.leftChild);
+		}
+		else
+		{
+			traversalStack.push_back(node.leftChild);
+			traversalStack.push_back(node.leftChild + 1);
+		}
+	}
+
+	return hit.IsValid();
+}
+
+bool Renderer::BoundingVolumeHierarchy::NeedsRebuild() const
+{
+	return !nodes.empty() && GetSAHCost() > builtSAHCost * REBUILD_COST_RATIO;
+}
+
+bool Renderer::BoundingVolumeHierarchy::IsEmpty() const
+{
+	return nodes.empty();
+}
+
+float Renderer::BoundingVolumeHierarchy::GetSAHCost() const
+{
+	if (nodes.empty())
+	{
+		return 0.0f;
+	}
+
+	// Expected number of node visits plus item tests for a random ray, relative to hitting the root
+	const float rootArea = std::max(nodes[0].bounds.GetSurfaceArea(), FLT_MIN);
+	float cost = 0.0f;
+
+	for (const Node& node : nodes)
+	{
+		cost += node.bounds.GetSurfaceArea() * (node.IsLeaf() ? static_cast<float>(node.itemCount) : 1.0f);
+	}
+
+	return cost / rootArea;
+}
+
+size_t Renderer::BoundingVolumeHierarchy::GetNodeCount() const
+{
+	return nodes.size();
+}
+
+void Renderer::BoundingVolumeHierarchy::AppendSubtree(const Node& node, std::vector<uint32_t>& visibleIndices) const
+{
+	visibleIndices.insert(visibleIndices.end(), sortedItems.begin() + node.firstItem, sortedItems.begin() + node.firstItem + node.itemCount);
+}
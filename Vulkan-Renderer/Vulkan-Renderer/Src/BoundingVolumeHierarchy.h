@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "BoundingVolumes.h"
+
+namespace Renderer
+{
+	using namespace Utilities;
+
+	/** Binned SAH bounding volume hierarchy over item bounds, supports incremental refits, frustum culling and ray queries */
+	class BoundingVolumeHierarchy
+	{
+	public:
+		static constexpr uint32_t SAH_BIN_COUNT = 16;
+		static constexpr uint32_t MAX_LEAF_ITEMS = 4;
+		// Rebuild once refits have degraded the tree cost by this factor
+		static constexpr float REBUILD_COST_RATIO = 1.5f;
+
+		struct Ray
+		{
+			glm::vec3 origin;
+			glm::vec3 direction;
+		};
+
+		struct RayHit
+		{
+			uint32_t itemIndex = UINT32_MAX;
+			float distance = FLT_MAX;
+
+			bool IsValid() const
+			{
+				return itemIndex != UINT32_MAX;
+			}
+		};
+
+		void Build(const BoundingBoxSoA& itemBounds);
+		/** Refits every node bottom up, keeping the tree topology */
+		void Refit(const BoundingBoxSoA& itemBounds);
+		/** Refits only the leaves holding the given items and their ancestors */
+		void RefitItems(const BoundingBoxSoA& itemBounds, const std::vector<uint32_t>& itemIndices);
+		void CullFrustum(const Frustum& frustum, std::vector<uint32_t>& visibleIndices) const;
+		bool RayCast(const Ray& ray, RayHit& hit) const;
+		bool NeedsRebuild() const;
+		bool IsEmpty() const;
+		float GetSAHCost() const;
+		size_t GetNodeCount() const;
+
+	private:
+		struct Node
+		{
+			BoundingBox bounds;
+			uint32_t firstItem = 0; // Every subtree owns a contiguous range of sortedItems
+			uint32_t itemCount = 0;
+			uint32_t leftChild = 0; // Right child is leftChild + 1, 0 marks a leaf since the root is never a child
+			uint32_t parent = UINT32_MAX;
+
+			bool IsLeaf() const
+			{
+				return leftChild == 0;
+			}
+		};
+
+		std::vector<Node> nodes;
+		std::vector<uint32_t> sortedItems;
+		std::vector<BoundingBox> sortedItemBounds; // Item bounds copied in leaf order so leaf tests stay cache friendly
+		std::vector<uint32_t> itemLeaf;
+		std::vector<glm::vec3> buildCentroids;
+		std::vector<BoundingBox> buildBounds;
+		float builtSAHCost = 0.0f;
+
+		void Subdivide(uint32_t nodeIndex, const BoundingBoxSoA& itemBounds);
+		void RefitLeaf(Node& node, const BoundingBoxSoA& itemBounds);
+		void AppendSubtree(const Node& node, std::vector<uint32_t>& visibleIndices) const;
+	};
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include <GLM/glm.hpp>
+#include <array>
+#include <vector>
+#include <cfloat>
+#include <cmath>
+
+namespace Utilities
+{
+	struct BoundingBox
+	{
+		glm::vec3 min = glm::vec3(FLT_MAX);
+		glm::vec3 max = glm::vec3(-FLT_MAX);
+
+		bool IsValid() const
+		{
+			return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+		}
+
+		void Expand(const glm::vec3& point)
+		{
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		void Expand(const BoundingBox& box)
+		{
+			min = glm::min(min, box.min);
+			max = glm::max(max, box.max);
+		}
+
+		glm::vec3 GetCenter() const
+		{
+			return (min + max) * 0.5f;
+		}
+
+		glm::vec3 GetExtents() const
+		{
+			return (max - min) * 0.5f;
+		}
+
+		float GetSurfaceArea() const
+		{
+			if (!IsValid())
+			{
+				return 0.0f;
+			}
+
+			const glm::vec3 size = max - min;
+			return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		/** Returns the axis aligned box enclosing this box after it has been transformed by the matrix */
+		BoundingBox Transform(const glm::mat4& matrix) const
+		{
+			const glm::vec3 center = glm::vec3(matrix * glm::vec4(GetCenter(), 1.0f));
+			const glm::vec3 extents = GetExtents();
+
+			glm::vec3 newExtents;
+			for (int row = 0; row < 3; row++)
+			{
+				newExtents[row] = std::abs(matrix[0][row]) * extents.x + std::abs(matrix[1][row]) * extents.y + std::abs(matrix[2][row]) * extents.z;
+			}
+
+			BoundingBox result;
+			result.min = center - newExtents;
+			result.max = center + newExtents;
+			return result;
+		}
+	};
+
+	struct Frustum
+	{
+		// Plane equations (xyz = normal, w = distance), a point p is inside when dot(normal, p) + w >= 0
+		std::array<glm::vec4, 6> planes;
+
+		static Frustum FromViewProjection(const glm::mat4& viewProjection)
+		{
+			const glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+			const glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+			const glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+			const glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+			// Near plane uses the -1..1 depth range, conservative for both depth conventions since depth clamp is enabled
+			Frustum frustum;
+			frustum.planes[0] = row3 + row0; // Left
+			frustum.planes[1] = row3 - row0; // Right
+			frustum.planes[2] = row3 + row1; // Bottom
+			frustum.planes[3] = row3 - row1; // Top
+			frustum.planes[4] = row3 + row2; // Near
+			frustum.planes[5] = row3 - row2; // Far
+
+			for (glm::vec4& plane : frustum.planes)
+			{
+				plane /= glm::length(glm::vec3(plane));
+			}
+
+			return frustum;
+		}
+
+		bool IsBoxVisible(const glm::vec3& center, const glm::vec3& extents) const
+		{
+			for (const glm::vec4& plane : planes)
+			{
+				const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+				const float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+
+				if (distance + radius < 0.0f)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+	};
+
+	/** Bounding boxes stored as structure of arrays so several boxes can be tested per SIMD instruction */
+	struct BoundingBoxSoA
+	{
+		std::vector<float> centerX;
+		std::vector<float> centerY;
+		std::vector<float> centerZ;
+		std::vector<float> extentX;
+		std::vector<float> extentY;
+		std::vector<float> extentZ;
+
+		size_t Size() const
+		{
+			return centerX.size();
+		}
+
+		void Resize(size_t count)
+		{
+			centerX.resize(count);
+			centerY.resize(count);
+			centerZ.resize(count);
+			extentX.resize(count);
+			extentY.resize(count);
+			extentZ.resize(count);
+		}
+
+		void Clear()
+		{
+			Resize(0);
+		}
+
+		void Set(size_t index, const BoundingBox& box)
+		{
+			const glm::vec3 center = box.GetCenter();
+			const glm::vec3 extents = box.GetExtents();
+
+			centerX[index] = center.x;
+			centerY[index] = center.y;
+			centerZ[index] = center.z;
+			extentX[index] = extents.x;
+			extentY[index] = extents.y;
+			extentZ[index] = extents.z;
+		}
+
+		void Add(const BoundingBox& box)
+		{
+			Resize(Size() + 1);
+			Set(Size() - 1, box);
+		}
+
+		BoundingBox Get(size_t index) const
+		{
+			const glm::vec3 center(centerX[index], centerY[index], centerZ[index]);
+			const glm::vec3 extents(extentX[index], extentY[index], extentZ[index]);
+
+			BoundingBox box;
+			box.min = center - extents;
+			box.max = center + extents;
+			return box;
+		}
+	};
+}
@@ -0,0 +1,149 @@
+#include "CascadedShadows.h"
+#include "Projection.h"
+#include <GLM/gtc/matrix_transform.hpp>
+#include <algorithm>
+
+std::array<float, Renderer::SHADOW_CASCADE_COUNT> Renderer::ComputeCascadeSplits(float nearPlane, float shadowDistance, float lambda)
+{
+	std::array<float, SHADOW_CASCADE_COUNT> splitDepths;
+
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		const float fraction = (i + 1) / static_cast<float>(SHADOW_CASCADE_COUNT);
+		const float logSplit = nearPlane * std::pow(shadowDistance / nearPlane, fraction);
+		const float uniformSplit = nearPlane + (shadowDistance - nearPlane) * fraction;
+		splitDepths[i] = lambda * logSplit + (1.0f - lambda) * uniformSplit;
+	}
+
+	return splitDepths;
+}
+
+void Renderer::FitShadowCascades(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& toLight, float shadowDistance,
+	uint32_t shadowMapSize, ShadowCascades& cascades)
+{
+	const float nearPlane = GetProjectionNearPlane(projection);
+	const float farPlane = std::min(GetProjectionFarPlane(projection), shadowDistance);
+	const std::array<float, SHADOW_CASCADE_COUNT> splitDepths = ComputeCascadeSplits(nearPlane, farPlane, 0.75f);
+
+	const glm::mat4 inverseProjection = glm::inverse(projection);
+	const glm::mat4 inverseView = glm::inverse(view);
+
+	// View space direction through the four frustum corners, scaled to unit depth
+	std::array<glm::vec3, 4> cornerRays;
+	for (uint32_t corner = 0; corner < 4; corner++)
+	{
+		const glm::vec2 ndc(corner % 2 == 0 ? -1.0f : 1.0f, corner / 2 == 0 ? -1.0f : 1.0f);
+		const glm::vec4 farPoint = inverseProjection * glm::vec4(ndc, 1.0f, 1.0f);
+		const glm::vec3 ray = glm::vec3(farPoint) / farPoint.w;
+		cornerRays[corner] = ray / -ray.z;
+	}
+
+	// Snapping happens in a light space that only depends on the light direction
+	const glm::vec3 lightDirection = glm::normalize(toLight);
+	const glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	const glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), -lightDirection, up);
+	const glm::mat4 inverseLightRotation = glm::transpose(lightRotation);
+
+	float sliceNear = nearPlane;
+	for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		const float sliceFar = splitDepths[cascade];
+
+		// The corners' centroid lies on the view axis, so the sphere is the same whichever way the camera faces
+		glm::vec3 center(0.0f);
+		for (const glm::vec3& ray : cornerRays)
+		{
+			center += ray * sliceNear + ray * sliceFar;
+		}
+		center /= 8.0f;
+
+		float radius = 0.0f;
+		for (const glm::vec3& ray : cornerRays)
+		{
+			radius = std::max(radius, glm::length(ray * sliceNear - center));
+			radius = std::max(radius, glm::length(ray * sliceFar - center));
+		}
+		// Rounded up, float noise would otherwise change the projection every frame
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		// The near cascade snaps to whole texels so its edges don't shimmer, cached cascades snap to coarse steps and only move
+		// when the camera leaves one. Widening by the step keeps the slice inside after the center has been snapped
+		const float desiredStep = cascade < FIRST_CACHED_SHADOW_CASCADE ? 2.0f * radius / shadowMapSize : radius * SHADOW_CACHE_SNAP_FRACTION;
+		const float halfWidth = radius + desiredStep;
+		const float texelSize = 2.0f * halfWidth / shadowMapSize;
+		const float snapStep = std::max(1.0f, std::floor(desiredStep / texelSize)) * texelSize;
+
+		const glm::vec3 worldCenter = glm::vec3(inverseView * glm::vec4(center, 1.0f));
+		const glm::vec3 lightCenter = glm::vec3(lightRotation * glm::vec4(worldCenter, 1.0f));
+		const glm::vec3 snappedLightCenter = glm::floor(lightCenter / snapStep + 0.5f) * snapStep;
+		const glm::vec3 snappedCenter = glm::vec3(inverseLightRotation * glm::vec4(snappedLightCenter, 1.0f));
+
+		const glm::mat4 lightView = glm::lookAt(snappedCenter + lightDirection * halfWidth, snappedCenter, up);
+		const glm::mat4 lightProjection = glm::orthoRH_ZO(-halfWidth, halfWidth, -halfWidth, halfWidth, 0.0f, 2.0f * halfWidth);
+
+		cascades[cascade].viewProjection = lightProjection * lightView;
+		cascades[cascade].splitDepth = sliceFar;
+		cascades[cascade].texelSize = texelSize;
+
+		sliceNear = sliceFar;
+	}
+}
+
+bool Renderer::CascadeContainsCaster(const glm::mat4& cascadeViewProjection, const Utilities::BoundingBox& worldBounds)
+{
+	// Orthographic, so the box stays a box in clip space. Nothing is rejected for being in front of the near plane
+	const Utilities::BoundingBox clipBounds = worldBounds.Transform(cascadeViewProjection);
+
+	return clipBounds.max.x >= -1.0f && clipBounds.min.x <= 1.0f
+		&& clipBounds.max.y >= -1.0f && clipBounds.min.y <= 1.0f
+		&& clipBounds.min.z <= 1.0f;
+}
+
+bool Renderer::CascadeSliceContainsCaster(const ShadowCascades& cascades, uint32_t cascade, const glm::mat4& view, const Utilities::BoundingBox& worldBounds)
+{
+	const Utilities::BoundingBox viewBounds = worldBounds.Transform(view);
+	const float sliceNear = cascade == 0 ? 0.0f : cascades[cascade - 1].splitDepth;
+	const float sliceFar = cascades[cascade].splitDepth;
+
+	// View space looks down -z
+	return -viewBounds.min.z >= sliceNear && -viewBounds.max.z <= sliceFar && CascadeContainsCaster(cascades[cascade].viewProjection, worldBounds);
+}
+
+void Renderer::ShadowCascadeCache::Update(const ShadowCascades& cascades, const std::array<bool, SHADOW_CASCADE_COUNT>& hasDynamicCasters,
+	std::array<bool, SHADOW_CASCADE_COUNT>& renderCascades)
+{
+	for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		CachedCascade& cached = cachedCascades[cascade];
+
+		// A cascade that held dynamic casters last time is rendered once more so they don't stay behind in it
+		renderCascades[cascade] = cascade < FIRST_CACHED_SHADOW_CASCADE || !cached.valid || cached.viewProjection != cascades[cascade].viewProjection
+			|| hasDynamicCasters[cascade] || cached.hadDynamicCasters;
+
+		if (renderCascades[cascade])
+		{
+			cached.viewProjection = cascades[cascade].viewProjection;
+			cached.valid = true;
+			cached.hadDynamicCasters = hasDynamicCasters[cascade];
+		}
+	}
+}
+
+void Renderer::ShadowCascadeCache::InvalidateStaticBounds(const Utilities::BoundingBox& worldBounds)
+{
+	for (CachedCascade& cached : cachedCascades)
+	{
+		if (cached.valid && CascadeContainsCaster(cached.viewProjection, worldBounds))
+		{
+			cached.valid = false;
+		}
+	}
+}
+
+void Renderer::ShadowCascadeCache::Invalidate()
+{
+	for (CachedCascade& cached : cachedCascades)
+	{
+		cached.valid = false;
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <GLM/glm.hpp>
+#include "BoundingVolumes.h"
+
+namespace Renderer
+{
+	/**
+	* The key light's shadow is split into cascades along the view direction, each with its own square orthographic shadow map
+	* sized to its slice of the view frustum. Cascades from FIRST_CACHED_SHADOW_CASCADE on only move in coarse steps so their
+	* shadow map can be kept across frames
+	*/
+	constexpr uint32_t SHADOW_CASCADE_COUNT = 4;
+	constexpr uint32_t FIRST_CACHED_SHADOW_CASCADE = 1;
+	// Cached cascades snap to steps of this fraction of their radius, the shadow map is widened by one step so the slice always fits
+	constexpr float SHADOW_CACHE_SNAP_FRACTION = 0.25f;
+
+	struct ShadowCascade
+	{
+		glm::mat4 viewProjection; // World to the cascade's shadow map, zero to one depth
+		float splitDepth; // View space distance where the next cascade takes over
+		float texelSize; // World units covered by one shadow map texel
+	};
+
+	using ShadowCascades = std::array<ShadowCascade, SHADOW_CASCADE_COUNT>;
+
+	/** Practical split scheme, lambda blends logarithmic (1) and uniform (0) splits. Returns the far distance of every cascade */
+	std::array<float, SHADOW_CASCADE_COUNT> ComputeCascadeSplits(float nearPlane, float shadowDistance, float lambda);
+
+	/**
+	* Fits every cascade around a bounding sphere of its slice of the view frustum, so the projection doesn't change size as
+	* the camera turns. Sphere centers are snapped to whole texels, or to coarse steps for cached cascades, in light space.
+	* toLight points from the scene towards the directional light
+	*/
+	void FitShadowCascades(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& toLight, float shadowDistance,
+		uint32_t shadowMapSize, ShadowCascades& cascades);
+
+	/** Whether geometry inside these world bounds can cast a shadow into the cascade, depth is clamped so casters between it and the light count */
+	bool CascadeContainsCaster(const glm::mat4& cascadeViewProjection, const Utilities::BoundingBox& worldBounds);
+
+	/**
+	* Dynamic casters are only drawn into the cached cascades whose slice of the view frustum they overlap. Their shadows reaching past
+	* the slice are dropped, otherwise anything moving near the camera would keep every far cascade from being cached
+	*/
+	bool CascadeSliceContainsCaster(const ShadowCascades& cascades, uint32_t cascade, const glm::mat4& view, const Utilities::BoundingBox& worldBounds);
+
+	/**
+	* Remembers what every cached cascade's shadow map was last rendered with. A cascade is rendered again when its projection
+	* changes, when static geometry it covers changes, or while dynamic casters overlap it, and once more after they leave
+	*/
+	class ShadowCascadeCache
+	{
+	public:
+		/** Decides which cascades to render this frame and records them as rendered. Cascades before FIRST_CACHED_SHADOW_CASCADE always are */
+		void Update(const ShadowCascades& cascades, const std::array<bool, SHADOW_CASCADE_COUNT>& hasDynamicCasters,
+			std::array<bool, SHADOW_CASCADE_COUNT>& renderCascades);
+		/** Static geometry inside these world bounds was added, moved or removed */
+		void InvalidateStaticBounds(const Utilities::BoundingBox& worldBounds);
+		void Invalidate();
+
+	private:
+		struct CachedCascade
+		{
+			glm::mat4 viewProjection = glm::mat4(0.0f);
+			bool valid = false;
+			bool hadDynamicCasters = false;
+		};
+
+		std::array<CachedCascade, SHADOW_CASCADE_COUNT> cachedCascades;
+	};
+}
@@ -0,0 +1,118 @@
+#include "ClusteredLighting.h"
+#include <algorithm>
+#include <utility>
+
+void Renderer::BuildClusterBounds(const glm::mat4& inverseProjection, float nearPlane, float farPlane, std::vector<Utilities::BoundingBox>& clusterBounds)
+{
+	clusterBounds.resize(CLUSTER_COUNT);
+
+	// View space direction through every tile corner, scaled to unit depth
+	std::vector<glm::vec3> cornerRays((CLUSTER_COUNT_X + 1) * (CLUSTER_COUNT_Y + 1));
+	for (uint32_t y = 0; y <= CLUSTER_COUNT_Y; y++)
+	{
+		for (uint32_t x = 0; x <= CLUSTER_COUNT_X; x++)
+		{
+			const glm::vec2 ndc(x * 2.0f / CLUSTER_COUNT_X - 1.0f, y * 2.0f / CLUSTER_COUNT_Y - 1.0f);
+			glm::vec4 farPoint = inverseProjection * glm::vec4(ndc, 1.0f, 1.0f);
+			const glm::vec3 ray = glm::vec3(farPoint) / farPoint.w;
+			cornerRays[y * (CLUSTER_COUNT_X + 1) + x] = ray / -ray.z;
+		}
+	}
+
+	for (uint32_t z = 0; z < CLUSTER_COUNT_Z; z++)
+	{
+		const float sliceNear = nearPlane * std::pow(farPlane / nearPlane, z / static_cast<float>(CLUSTER_COUNT_Z));
+		const float sliceFar = nearPlane * std::pow(farPlane / nearPlane, (z + 1) / static_cast<float>(CLUSTER_COUNT_Z));
+
+		for (uint32_t y = 0; y < CLUSTER_COUNT_Y; y++)
+		{
+			for (uint32_t x = 0; x < CLUSTER_COUNT_X; x++)
+			{
+				Utilities::BoundingBox bounds;
+				for (uint32_t corner = 0; corner < 4; corner++)
+				{
+					const glm::vec3& ray = cornerRays[(y + corner / 2) * (CLUSTER_COUNT_X + 1) + x + corner % 2];
+					bounds.Expand(ray * sliceNear);
+					bounds.Expand(ray * sliceFar);
+				}
+
+				clusterBounds[x + CLUSTER_COUNT_X * (y + CLUSTER_COUNT_Y * z)] = bounds;
+			}
+		}
+	}
+}
+
+uint32_t Renderer::GetClusterSlice(float viewDepth, float nearPlane, float farPlane)
+{
+	const float slice = std::floor(std::log(viewDepth / nearPlane) / std::log(farPlane / nearPlane) * CLUSTER_COUNT_Z);
+	return static_cast<uint32_t>(glm::clamp(slice, 0.0f, static_cast<float>(CLUSTER_COUNT_Z - 1)));
+}
+
+void Renderer::BinLights(const std::vector<PointLight>& lights, const glm::mat4& view, const std::vector<Utilities::BoundingBox>& clusterBounds,
+	std::vector<uint32_t>& clusterLightOffsets, std::vector<uint32_t>& clusterLightCounts, std::vector<uint32_t>& clusterLightIndices)
+{
+	clusterLightCounts.assign(CLUSTER_COUNT, 0);
+
+	// Cluster and light of every hit, gathered first so the runs can be sized before they are filled
+	std::vector<std::pair<uint32_t, uint32_t>> clusterLights;
+
+	// Slice depth bounds grow monotonically, so a light only needs testing against the slices its depth range overlaps
+	std::vector<float> sliceNearDepths(CLUSTER_COUNT_Z + 1);
+	for (uint32_t z = 0; z < CLUSTER_COUNT_Z; z++)
+	{
+		sliceNearDepths[z] = -clusterBounds[CLUSTER_COUNT_X * CLUSTER_COUNT_Y * z].max.z;
+	}
+	sliceNearDepths[CLUSTER_COUNT_Z] = -clusterBounds[CLUSTER_COUNT - 1].min.z;
+
+	// Lights in index order, so every cluster lists the same lights in the same order as the compute pass
+	for (uint32_t lightIndex = 0; lightIndex < lights.size(); lightIndex++)
+	{
+		const PointLight& light = lights[lightIndex];
+		const glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+		const float radiusSquared = light.radius * light.radius;
+
+		const float depthMin = -center.z - light.radius;
+		const float depthMax = -center.z + light.radius;
+		if (depthMax < sliceNearDepths.front() || depthMin > sliceNearDepths.back())
+		{
+			continue;
+		}
+
+		const uint32_t firstSlice = static_cast<uint32_t>(std::upper_bound(sliceNearDepths.begin(), sliceNearDepths.end(), depthMin) - sliceNearDepths.begin());
+		const uint32_t endSlice = static_cast<uint32_t>(std::upper_bound(sliceNearDepths.begin(), sliceNearDepths.end(), depthMax) - sliceNearDepths.begin());
+
+		for (uint32_t z = firstSlice > 0 ? firstSlice - 1 : 0; z < std::min(endSlice, CLUSTER_COUNT_Z); z++)
+		{
+			for (uint32_t tile = 0; tile < CLUSTER_COUNT_X * CLUSTER_COUNT_Y; tile++)
+			{
+				const uint32_t cluster = tile + CLUSTER_COUNT_X * CLUSTER_COUNT_Y * z;
+				const Utilities::BoundingBox& bounds = clusterBounds[cluster];
+
+				const glm::vec3 offset = glm::clamp(center, bounds.min, bounds.max) - center;
+				if (glm::dot(offset, offset) > radiusSquared)
+				{
+					continue;
+				}
+
+				clusterLightCounts[cluster]++;
+				clusterLights.emplace_back(cluster, lightIndex);
+			}
+		}
+	}
+
+	clusterLightOffsets.resize(CLUSTER_COUNT);
+	uint32_t offset = 0;
+	for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+	{
+		clusterLightOffsets[cluster] = offset;
+		offset += clusterLightCounts[cluster];
+	}
+
+	// Hits were gathered in light order, so filling the runs in the same order keeps every run in light order
+	clusterLightIndices.resize(offset);
+	std::vector<uint32_t> runEnds(clusterLightOffsets);
+	for (const std::pair<uint32_t, uint32_t>& clusterLight : clusterLights)
+	{
+		clusterLightIndices[runEnds[clusterLight.first]++] = clusterLight.second;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+#include "BoundingVolumes.h"
+#include "Projection.h"
+
+namespace Renderer
+{
+	/** Mirrors the lights buffer of light_cluster.comp and the lighting subpasses, std430 */
+	struct PointLight
+	{
+		glm::vec3 position;
+		float radius; // Light has no effect past this distance
+		glm::vec3 colour;
+		float intensity;
+	};
+
+	/**
+	* The view frustum is split into a grid of clusters, screen tiles in x and y and exponentially spaced depth slices in z
+	* so clusters stay roughly cube shaped. Every cluster lists the lights whose sphere touches it as a run of one shared index list
+	*/
+	constexpr uint32_t CLUSTER_COUNT_X = 16;
+	constexpr uint32_t CLUSTER_COUNT_Y = 9;
+	constexpr uint32_t CLUSTER_COUNT_Z = 24;
+	constexpr uint32_t CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+
+	/** View space bounds of every cluster, x fastest then y then depth slice, same order as the shaders index them */
+	void BuildClusterBounds(const glm::mat4& inverseProjection, float nearPlane, float farPlane, std::vector<Utilities::BoundingBox>& clusterBounds);
+	/** Depth slice of a view space depth (positive distance along the view direction) */
+	uint32_t GetClusterSlice(float viewDepth, float nearPlane, float farPlane);
+
+	/**
+	* Same binning as light_cluster.comp. Cluster c lists clusterLightCounts[c] lights starting at clusterLightOffsets[c],
+	* in light order, the runs are packed back to back in cluster order
+	*/
+	void BinLights(const std::vector<PointLight>& lights, const glm::mat4& view, const std::vector<Utilities::BoundingBox>& clusterBounds,
+		std::vector<uint32_t>& clusterLightOffsets, std::vector<uint32_t>& clusterLightCounts, std::vector<uint32_t>& clusterLightIndices);
+}
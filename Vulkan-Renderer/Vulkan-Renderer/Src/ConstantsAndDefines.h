@@ -2,17 +2,19 @@
 #define STB_IMAGE_IMPLEMENTATION
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #define GLFW_INCLUDE_VULKAN
-constexpr auto COMPILED_SHADER_PATH = "Res\\CompiledShaders\\";
+// Forward slashes so headless runs on Linux find the same resources, Windows accepts either
+constexpr auto COMPILED_SHADER_PATH = "Res/CompiledShaders/";
 constexpr auto COMPILED_SHADER_SUFFIX = ".spv";
-constexpr auto SHADER_PATH = "Res\\Shaders\\";
-constexpr auto TEXTURE_PATH = "Res\\Textures\\";
-constexpr auto MODELS_PATH = "Res\\Models\\";
+constexpr auto SHADER_PATH = "Res/Shaders/";
+constexpr auto TEXTURE_PATH = "Res/Textures/";
+constexpr auto MODELS_PATH = "Res/Models/";
 #include <vector>
 #include <GLM/glm.hpp>
 //#include <stb/stb_image.h>
 
 
-constexpr uint32_t MAX_OBJECTS = 10;
+// Upper bound of the bindless texture array, clamped further to the device's update after bind limits
+constexpr uint32_t MAX_TEXTURES = 4096;
 
 const std::vector<const char*> DEVICE_EXTENSIONS = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 #if VULKAN_SDK_INSTALLED
@@ -21,7 +23,30 @@ const std::vector<const char*> VALIDATION_LAYERS = { "VK_LAYER_KHRONOS_validatio
 const std::vector<const char*> VALIDATION_LAYERS;
 #endif
 
-constexpr int MAX_FRAME_DRAWS = 2;
+// Frames the CPU may record ahead of the GPU, changeable at runtime up to the maximum
+constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+// Scenes with fewer draw items are culled with the flat SIMD path, the BVH only pays off for larger scenes
+constexpr uint32_t BVH_CULLING_MIN_DRAW_ITEMS = 256;
+// Frames between checks on whether refits have degraded the scene BVH enough to rebuild it
+constexpr uint32_t BVH_REBUILD_CHECK_INTERVAL = 60;
+// Resolution of the CPU occlusion buffer, independent of the swapchain so the cost stays fixed
+constexpr uint32_t SOFTWARE_OCCLUSION_WIDTH = 256;
+constexpr uint32_t SOFTWARE_OCCLUSION_HEIGHT = 144;
+// Resolution of every shadow cascade and how far from the camera the key light's shadows reach
+constexpr uint32_t SHADOW_MAP_SIZE = 2048;
+// Normalised direction towards the key light, tilted so its shadows fall to the side
+constexpr glm::vec3 DEFAULT_KEY_LIGHT_DIRECTION(0.29f, 0.92f, 0.26f);
+constexpr float MAX_SHADOW_DISTANCE = 400.0f;
+// Models that haven't moved for this many frames are static shadow casters and can stay in cached cascades
+constexpr uint64_t STATIC_MODEL_FRAMES = 30;
+// Profile into the flight recorder instead of a trace of the whole run, dumping the last few seconds whenever a frame runs over budget
+constexpr bool PROFILER_FLIGHT_RECORDER = true;
+constexpr double PROFILER_FLIGHT_RECORDER_SECONDS = 10.0;
+constexpr double PROFILER_FRAME_BUDGET_MS = 50.0;
+// Print the model under the cursor on every left click
+constexpr bool LOG_PICKED_MODELS = false;
 
 constexpr glm::vec3 GLOBAL_UP(0.0f, 1.0f, 0.0f);
 constexpr glm::vec3 GLOBAL_RIGHT(1.0f, 0.0f, 0.0f);
@@ -0,0 +1,111 @@
+#include "DrawList.h"
+#include <cstring>
+#include <algorithm>
+
+uint64_t Renderer::DrawList::MakeKey(uint32_t pass, uint32_t pipeline, uint32_t texture, uint32_t geometry, float viewDepth)
+{
+	// Bit patterns of non negative floats order the same as their values, the top bits keep exponent and leading mantissa
+	uint32_t depthBits = 0;
+	viewDepth = std::max(viewDepth, 0.0f);
+	std::memcpy(&depthBits, &viewDepth, sizeof(float));
+
+	uint64_t key = pass & ((1u << PASS_BITS) - 1);
+	key = (key << PIPELINE_BITS) | (pipeline & ((1u << PIPELINE_BITS) - 1));
+	key = (key << TEXTURE_BITS) | (texture & ((1u << TEXTURE_BITS) - 1));
+	key = (key << GEOMETRY_BITS) | (geometry & ((1u << GEOMETRY_BITS) - 1));
+	key = (key << DEPTH_BITS) | (depthBits >> (32 - DEPTH_BITS));
+	return key;
+}
+
+void Renderer::DrawList::Clear()
+{
+	entries.clear();
+}
+
+void Renderer::DrawList::Reserve(size_t count)
+{
+	entries.reserve(count);
+	sortScratch.reserve(count);
+}
+
+void Renderer::DrawList::Add(uint64_t key, uint32_t drawItem)
+{
+	entries.push_back({ key, drawItem });
+}
+
+void Renderer::DrawList::Sort()
+{
+	constexpr uint32_t DIGIT_BITS = 8;
+	constexpr uint32_t DIGIT_COUNT = 64 / DIGIT_BITS;
+	constexpr uint32_t BUCKET_COUNT = 1u << DIGIT_BITS;
+
+	// Below this the histogram setup of 8 passes costs more than a comparison sort
+	constexpr size_t RADIX_SORT_MIN_COUNT = 2048;
+
+	const size_t count = entries.size();
+	if (count < RADIX_SORT_MIN_COUNT)
+	{
+		std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+		return;
+	}
+
+	// One read of the keys builds the histograms of all digits
+	uint32_t histograms[DIGIT_COUNT][BUCKET_COUNT] = {};
+	for (const Entry& entry : entries)
+	{
+		for (uint32_t digit = 0; digit < DIGIT_COUNT; digit++)
+		{
+			histograms[digit][(entry.key >> (digit * DIGIT_BITS)) & (BUCKET_COUNT - 1)]++;
+		}
+	}
+
+	sortScratch.resize(count);
+	Entry* source = entries.data();
+	Entry* destination = sortScratch.data();
+
+	for (uint32_t digit = 0; digit < DIGIT_COUNT; digit++)
+	{
+		uint32_t* histogram = histograms[digit];
+
+		// Pass and pipeline bits rarely vary, a digit shared by all keys leaves the order unchanged
+		if (histogram[(source[0].key >> (digit * DIGIT_BITS)) & (BUCKET_COUNT - 1)] == count)
+		{
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (uint32_t bucket = 0; bucket < BUCKET_COUNT; bucket++)
+		{
+			const uint32_t bucketSize = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketSize;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			destination[histogram[(source[i].key >> (digit * DIGIT_BITS)) & (BUCKET_COUNT - 1)]++] = source[i];
+		}
+
+		std::swap(source, destination);
+	}
+
+	if (source != entries.data())
+	{
+		entries.swap(sortScratch);
+	}
+}
+
+size_t Renderer::DrawList::Size() const
+{
+	return entries.size();
+}
+
+const Renderer::DrawList::Entry& Renderer::DrawList::operator[](size_t index) const
+{
+	return entries[index];
+}
+
+const std::vector<Renderer::DrawList::Entry>& Renderer::DrawList::GetEntries() const
+{
+	return entries;
+}
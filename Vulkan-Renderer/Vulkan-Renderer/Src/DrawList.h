@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Renderer
+{
+	/**
+	* Per frame list of draws ordered by a 64 bit sort key so that draws sharing state end up next to each other.
+	* Key layout from the most significant bit : pass (4) | pipeline (8) | texture (16) | geometry (16) | depth (20)
+	*/
+	class DrawList
+	{
+	public:
+		struct Entry
+		{
+			uint64_t key;
+			uint32_t drawItem;
+		};
+
+		/** State changes emitted while recording the sorted list, accumulated over every pass of a frame */
+		struct Statistics
+		{
+			uint32_t draws = 0;
+			uint32_t pipelineBinds = 0;
+			uint32_t descriptorSetBinds = 0;
+			uint32_t vertexBufferBinds = 0;
+			uint32_t indexBufferBinds = 0;
+			uint32_t pushConstantUpdates = 0;
+		};
+
+		static constexpr uint32_t PASS_BITS = 4;
+		static constexpr uint32_t PIPELINE_BITS = 8;
+		static constexpr uint32_t TEXTURE_BITS = 16;
+		static constexpr uint32_t GEOMETRY_BITS = 16;
+		static constexpr uint32_t DEPTH_BITS = 20;
+
+		/** View depth must be positive, nearer draws sort first within the same state */
+		static uint64_t MakeKey(uint32_t pass, uint32_t pipeline, uint32_t texture, uint32_t geometry, float viewDepth);
+
+		void Clear();
+		void Reserve(size_t count);
+		void Add(uint64_t key, uint32_t drawItem);
+		/** Stable, LSD radix sort with 8 bits per pass for large lists, skipping the passes where every key has the same digit */
+		void Sort();
+		size_t Size() const;
+		const Entry& operator[](size_t index) const;
+		const std::vector<Entry>& GetEntries() const;
+
+	private:
+		std::vector<Entry> entries;
+		std::vector<Entry> sortScratch;
+	};
+}
@@ -0,0 +1,170 @@
+#include "FrustumCulling.h"
+#include <immintrin.h>
+
+void Renderer::FrustumCuller::Cull(const Frustum& frustum, const BoundingBoxSoA& bounds, std::vector<uint32_t>& visibleIndices)
+{
+	Cull(GetWidestCullPath(), frustum, bounds, visibleIndices);
+}
+
+void Renderer::FrustumCuller::Cull(CullPath cullPath, const Frustum& frustum, const BoundingBoxSoA& bounds, std::vector<uint32_t>& visibleIndices)
+{
+	switch (cullPath)
+	{
+	case CullPath::SCALAR: CullScalar(frustum, bounds, visibleIndices); break;
+	case CullPath::SSE: CullSSE(frustum, bounds, visibleIndices); break;
+	case CullPath::AVX: CullAVX(frustum, bounds, visibleIndices); break;
+	}
+}
+
+void Renderer::FrustumCuller::CullScalar(const Frustum& frustum, const BoundingBoxSoA& bounds, std::vector<uint32_t>& visibleIndices)
+{
+	visibleIndices.clear();
+	CullScalarRange(frustum, bounds, 0, bounds.Size(), visibleIndices);
+}
+
+void Renderer::FrustumCuller::CullSSE(const Frustum& frustum, const BoundingBoxSoA& bounds, std::vector<uint32_t>& visibleIndices)
+{
+	visibleIndices.clear();
+
+	const size_t count = bounds.Size();
+	const size_t simdCount = count & ~static_cast<size_t>(3);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	__m128 absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+
+	for (size_t p = 0; p < 6; p++)
+	{
+		planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+		absPlaneX[p] = _mm_andnot_ps(signMask, planeX[p]);
+		absPlaneY[p] = _mm_andnot_ps(signMask, planeY[p]);
+		absPlaneZ[p] = _mm_andnot_ps(signMask, planeZ[p]);
+	}
+
+	for (size_t i = 0; i < simdCount; i += 4)
+	{
+		const __m128 centerX = _mm_loadu_ps(&bounds.centerX[i]);
+		const __m128 centerY = _mm_loadu_ps(&bounds.centerY[i]);
+		const __m128 centerZ = _mm_loadu_ps(&bounds.centerZ[i]);
+		const __m128 extentX = _mm_loadu_ps(&bounds.extentX[i]);
+		const __m128 extentY = _mm_loadu_ps(&bounds.extentY[i]);
+		const __m128 extentZ = _mm_loadu_ps(&bounds.extentZ[i]);
+
+		__m128 outside = _mm_setzero_ps();
+
+		for (size_t p = 0; p < 6; p++)
+		{
+			__m128 distance = _mm_add_ps(_mm_mul_ps(centerX, planeX[p]), planeW[p]);
+			distance = _mm_add_ps(distance, _mm_mul_ps(centerY, planeY[p]));
+			distance = _mm_add_ps(distance, _mm_mul_ps(centerZ, planeZ[p]));
+
+			__m128 radius = _mm_mul_ps(extentX, absPlaneX[p]);
+			radius = _mm_add_ps(radius, _mm_mul_ps(extentY, absPlaneY[p]));
+			radius = _mm_add_ps(radius, _mm_mul_ps(extentZ, absPlaneZ[p]));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		int visibleMask = ~_mm_movemask_ps(outside) & 0xF;
+		for (uint32_t lane = 0; visibleMask; lane++, visibleMask >>= 1)
+		{
+			if (visibleMask & 1)
+			{
+				visibleIndices.push_back(static_cast<uint32_t>(i + lane));
+			}
+		}
+	}
+
+	CullScalarRange(frustum, bounds, simdCount, count, visibleIndices);
+}
+
+void Renderer::FrustumCuller::CullAVX(const Frustum& frustum, const BoundingBoxSoA& bounds, std::vector<uint32_t>& visibleIndices)
+{
+#if defined(__AVX__)
+	visibleIndices.clear();
+
+	const size_t count = bounds.Size();
+	const size_t simdCount = count & ~static_cast<size_t>(7);
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	const __m256 zero = _mm256_setzero_ps();
+
+	__m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+	__m256 absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+
+	for (size_t p = 0; p < 6; p++)
+	{
+		planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+		absPlaneX[p] = _mm256_andnot_ps(signMask, planeX[p]);
+		absPlaneY[p] = _mm256_andnot_ps(signMask, planeY[p]);
+		absPlaneZ[p] = _mm256_andnot_ps(signMask, planeZ[p]);
+	}
+
+	for (size_t i = 0; i < simdCount; i += 8)
+	{
+		const __m256 centerX = _mm256_loadu_ps(&bounds.centerX[i]);
+		const __m256 centerY = _mm256_loadu_ps(&bounds.centerY[i]);
+		const __m256 centerZ = _mm256_loadu_ps(&bounds.centerZ[i]);
+		const __m256 extentX = _mm256_loadu_ps(&bounds.extentX[i]);
+		const __m256 extentY = _mm256_loadu_ps(&bounds.extentY[i]);
+		const __m256 extentZ = _mm256_loadu_ps(&bounds.extentZ[i]);
+
+		__m256 outside = _mm256_setzero_ps();
+
+		for (size_t p = 0; p < 6; p++)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(centerX, planeX[p]), planeW[p]);
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(centerY, planeY[p]));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(centerZ, planeZ[p]));
+
+			__m256 radius = _mm256_mul_ps(extentX, absPlaneX[p]);
+			radius = _mm256_add_ps(radius, _mm256_mul_ps(extentY, absPlaneY[p]));
+			radius = _mm256_add_ps(radius, _mm256_mul_ps(extentZ, absPlaneZ[p]));
+
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+		}
+
+		int visibleMask = ~_mm256_movemask_ps(outside) & 0xFF;
+		for (uint32_t lane = 0; visibleMask; lane++, visibleMask >>= 1)
+		{
+			if (visibleMask & 1)
+			{
+				visibleIndices.push_back(static_cast<uint32_t>(i + lane));
+			}
+		}
+	}
+
+	CullScalarRange(frustum, bounds, simdCount, count, visibleIndices);
+#else
+	CullSSE(frustum, bounds, visibleIndices);
+#endif
+}
+
+Renderer::FrustumCuller::CullPath Renderer::FrustumCuller::GetWidestCullPath()
+{
+#if defined(__AVX__)
+	return CullPath::AVX;
+#else
+	return CullPath::SSE;
+#endif
+}
+
+void Renderer::FrustumCuller::CullScalarRange(const Frustum& frustum, const BoundingBoxSoA& bounds, size_t begin, size_t end, std::vector<uint32_t>& visibleIndices)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		const glm::vec3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+		const glm::vec3 extents(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+
+		if (frustum.IsBoxVisible(center, extents))
+		{
+			visibleIndices.push_back(static_cast<uint32_t>(i));
+		}
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "BoundingVolumes.h"
+
+namespace Renderer
+{
+	using namespace Utilities;
+
+	class FrustumCuller
+	{
+	public:
+		enum class CullPath
+		{
+			SCALAR,
+			SSE,
+			AVX
+		};
+
+		/** Writes the indices of all boxes intersecting the frustum to visibleIndices, using the widest SIMD path available */
+		static void Cull(const Frustum& frustum, const BoundingBoxSoA& bounds, std::vector<uint32_t>& visibleIndices);
+		static void Cull(CullPath cullPath, const Frustum& frustum, const BoundingBoxSoA& bounds, std::vector<uint32_t>& visibleIndices);
+		static void CullScalar(const Frustum& frustum, const BoundingBoxSoA& bounds, std::vector<uint32_t>& visibleIndices);
+		static void CullSSE(const Frustum& frustum, const BoundingBoxSoA& bounds, std::vector<uint32_t>& visibleIndices);
+		/** Falls back to the SSE path when not compiled with AVX enabled */
+		static void CullAVX(const Frustum& frustum, const BoundingBoxSoA& bounds, std::vector<uint32_t>& visibleIndices);
+		static CullPath GetWidestCullPath();
+
+	private:
+		static void CullScalarRange(const Frustum& frustum, const BoundingBoxSoA& bounds, size_t begin, size_t end, std::vector<uint32_t>& visibleIndices);
+	};
+}
@@ -0,0 +1,115 @@
+#include "GBufferLayout.h"
+#include <cmath>
+
+std::vector<Renderer::GBufferTarget> Renderer::GetGBufferColourTargets(GBufferLayout layout)
+{
+	const VkClearColorValue black = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+	const VkClearColorValue sky = { { 0.3f, 0.5f, 0.6f, 1.0f } };
+
+	if (layout == GBufferLayout::VISIBILITY)
+	{
+		VkClearColorValue empty = {};
+		empty.uint32[0] = VISIBILITY_EMPTY_ID;
+
+		return { { "visibility", VK_FORMAT_R32_UINT, 4, empty } };
+	}
+
+	if (layout == GBufferLayout::COMPACT)
+	{
+		// Albedo alpha is unused and left for a material channel
+		return {
+			{ "normal", VK_FORMAT_R16G16_UNORM, 4, black },
+			{ "albedo", VK_FORMAT_R8G8B8A8_UNORM, 4, sky } };
+	}
+
+	return {
+		{ "position", VK_FORMAT_R32G32B32A32_SFLOAT, 16, black },
+		{ "normal", VK_FORMAT_R8G8B8A8_UNORM, 4, black },
+		{ "albedo", VK_FORMAT_R8G8B8A8_UNORM, 4, sky } };
+}
+
+uint32_t Renderer::GetGBufferBytesPerPixel(GBufferLayout layout)
+{
+	uint32_t bytesPerPixel = GBUFFER_DEPTH_BYTES_PER_PIXEL;
+	for (const GBufferTarget& target : GetGBufferColourTargets(layout))
+	{
+		bytesPerPixel += target.bytesPerPixel;
+	}
+
+	return bytesPerPixel;
+}
+
+const char* Renderer::GetGBufferLayoutName(GBufferLayout layout)
+{
+	switch (layout)
+	{
+	case GBufferLayout::COMPACT:
+		return "Compact";
+	case GBufferLayout::VISIBILITY:
+		return "Visibility";
+	default:
+		return "Standard";
+	}
+}
+
+glm::vec2 Renderer::EncodeOctahedralNormal(const glm::vec3& normal)
+{
+	// Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower hemisphere over the diagonals
+	glm::vec3 n = normal / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+	glm::vec2 encoded(n.x, n.y);
+
+	if (n.z < 0.0f)
+	{
+		encoded.x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+		encoded.y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	return encoded * 0.5f + 0.5f;
+}
+
+glm::vec3 Renderer::DecodeOctahedralNormal(const glm::vec2& encoded)
+{
+	const glm::vec2 f = encoded * 2.0f - 1.0f;
+	glm::vec3 n(f.x, f.y, 1.0f - std::abs(f.x) - std::abs(f.y));
+
+	// Unfold the lower hemisphere
+	const float t = glm::clamp(-n.z, 0.0f, 1.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+
+	return glm::normalize(n);
+}
+
+Renderer::VisibilityBarycentrics Renderer::ComputeVisibilityBarycentrics(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2,
+	const glm::vec2& pixelNdc, const glm::vec2& inverseExtent)
+{
+	const glm::vec3 invW = 1.0f / glm::vec3(clip0.w, clip1.w, clip2.w);
+	const glm::vec2 ndc0 = glm::vec2(clip0) * invW.x;
+	const glm::vec2 ndc1 = glm::vec2(clip1) * invW.y;
+	const glm::vec2 ndc2 = glm::vec2(clip2) * invW.z;
+
+	// Screen space barycentrics are linear in ndc, divided by w they interpolate linearly along with 1 / w
+	const float invDet = 1.0f / glm::determinant(glm::mat2(ndc2 - ndc1, ndc0 - ndc1));
+	glm::vec3 ddx = glm::vec3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * invDet * invW;
+	glm::vec3 ddy = glm::vec3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * invDet * invW;
+	float ddxSum = ddx.x + ddx.y + ddx.z;
+	float ddySum = ddy.x + ddy.y + ddy.z;
+
+	const glm::vec2 delta = pixelNdc - ndc0;
+	const float interpInvW = invW.x + delta.x * ddxSum + delta.y * ddySum;
+	const glm::vec3 numerator = glm::vec3(invW.x, 0.0f, 0.0f) + delta.x * ddx + delta.y * ddy;
+
+	VisibilityBarycentrics barycentrics;
+	barycentrics.lambda = numerator / interpInvW;
+
+	// One pixel is two over the extent in ndc
+	ddx *= 2.0f * inverseExtent.x;
+	ddy *= 2.0f * inverseExtent.y;
+	ddxSum *= 2.0f * inverseExtent.x;
+	ddySum *= 2.0f * inverseExtent.y;
+
+	barycentrics.ddx = (numerator + ddx) / (interpInvW + ddxSum) - barycentrics.lambda;
+	barycentrics.ddy = (numerator + ddy) / (interpInvW + ddySum) - barycentrics.lambda;
+
+	return barycentrics;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+#include <GLM/glm.hpp>
+
+namespace Renderer
+{
+	/**
+	* Attachments written by the first subpass and read as input attachments by the lighting subpass.
+	* STANDARD stores world position and normal directly, COMPACT reconstructs position from depth and octahedral packs the normal.
+	* VISIBILITY only stores which triangle covers the pixel, the lighting subpass refetches and interpolates its vertices
+	*/
+	enum class GBufferLayout
+	{
+		STANDARD,
+		COMPACT,
+		VISIBILITY
+	};
+
+	struct GBufferTarget
+	{
+		const char* name;
+		VkFormat format;
+		uint32_t bytesPerPixel;
+		VkClearColorValue clearValue;
+	};
+
+	/** Depth attachment bytes per pixel, the same for every layout since depth is always kept for the Hi-Z pyramid */
+	constexpr uint32_t GBUFFER_DEPTH_BYTES_PER_PIXEL = 4;
+
+	/** Colour targets in fragment output and input attachment order, the depth input follows the last one */
+	std::vector<GBufferTarget> GetGBufferColourTargets(GBufferLayout layout);
+	uint32_t GetGBufferBytesPerPixel(GBufferLayout layout);
+	const char* GetGBufferLayoutName(GBufferLayout layout);
+
+	/** Lighting subpass push constants of the compact layout, the inverse extent turns gl_FragCoord into a screen uv */
+	struct PushReconstruction
+	{
+		glm::mat4 inverseViewProjection;
+		glm::vec2 inverseExtent;
+	};
+
+	/** Lighting subpass push constants of the visibility layout, the triangle's corners are projected again to find the pixel's barycentrics */
+	struct PushVisibility
+	{
+		glm::mat4 viewProjection;
+		glm::vec2 inverseExtent;
+		uint32_t drawCount; // Draws the lighting subpass searches for the one holding a pixel's triangle
+	};
+
+	/**
+	* Visibility IDs number the triangles of every draw item one after another, a draw's first triangle is the sum of the triangles
+	* of the draw items before it. All bits set marks pixels no triangle covered
+	*/
+	constexpr uint32_t VISIBILITY_EMPTY_ID = 0xFFFFFFFF;
+	constexpr uint32_t VISIBILITY_MAX_TRIANGLES = VISIBILITY_EMPTY_ID; // Across every draw item of the scene
+
+	/** Perspective correct barycentrics of a pixel and their change one pixel right and down */
+	struct VisibilityBarycentrics
+	{
+		glm::vec3 lambda;
+		glm::vec3 ddx;
+		glm::vec3 ddy;
+	};
+
+	/** Same as second_subpass_visibility.frag, the derivatives give texture lookups their mip level without a rasterized quad */
+	VisibilityBarycentrics ComputeVisibilityBarycentrics(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2,
+		const glm::vec2& pixelNdc, const glm::vec2& inverseExtent);
+
+	/** Same mapping as gbuffer_compact.frag and second_subpass_compact.frag, unit normal to [0, 1]^2 and back */
+	glm::vec2 EncodeOctahedralNormal(const glm::vec3& normal);
+	glm::vec3 DecodeOctahedralNormal(const glm::vec2& encoded);
+}
@@ -0,0 +1,280 @@
+#include "GpuProfiler.h"
+#include <stdexcept>
+
+Renderer::GpuProfiler::~GpuProfiler()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	for (QuerySlot& slot : frameSlots)
+	{
+		vkDestroyQueryPool(device, slot.queryPool, nullptr);
+	}
+
+	vkDestroyQueryPool(device, uploadSlot.queryPool, nullptr);
+}
+
+void Renderer::GpuProfiler::Init(const GpuProfilerCreateInfo& gpuProfilerCreateInfo)
+{
+	PROFILE_FUNCTION();
+
+	createInfo = gpuProfilerCreateInfo;
+
+	if (!IsSupported())
+	{
+		return;
+	}
+
+	frameSlots.resize(createInfo.frameCount);
+	for (QuerySlot& slot : frameSlots)
+	{
+		CreateQuerySlot(slot, GPU_PROFILER_MAX_SCOPES);
+	}
+
+	CreateQuerySlot(uploadSlot, GPU_PROFILER_MAX_UPLOAD_SCOPES);
+
+	if (createInfo.calibratedTimestamps)
+	{
+		getCalibratedTimestamps = (PFN_vkGetCalibratedTimestampsEXT)vkGetDeviceProcAddr(createInfo.device.logicalDevice, "vkGetCalibratedTimestampsEXT");
+	}
+
+	Calibrate();
+}
+
+bool Renderer::GpuProfiler::IsSupported() const
+{
+	return createInfo.timestampPeriod != 0.0f;
+}
+
+void Renderer::GpuProfiler::ReadFrame(uint32_t frameIndex)
+{
+	PROFILE_FUNCTION();
+
+	frameScopes.clear();
+
+	if (!IsSupported())
+	{
+		return;
+	}
+
+	if (getCalibratedTimestamps != nullptr && ++framesSinceCalibration >= GPU_PROFILER_CALIBRATION_FRAMES)
+	{
+		Calibrate();
+	}
+
+	// Scopes of a frame whose results aren't there are dropped, the next use of the slot resets them anyway
+	ReadQuerySlot(frameSlots[frameIndex], frameScopes);
+
+	std::vector<Scope> uploadScopes;
+	ReadQuerySlot(uploadSlot, uploadScopes);
+
+	Profiler& profiler = Profiler::Get();
+	for (const std::vector<Scope>* scopes : { &frameScopes, &uploadScopes })
+	{
+		for (const Scope& scope : *scopes)
+		{
+			profiler.RecordScope(scope.nameId, scope.startNs, scope.endNs, ProfileTrack::GPU);
+		}
+	}
+}
+
+void Renderer::GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	if (!IsSupported())
+	{
+		return;
+	}
+
+	QuerySlot& slot = frameSlots[frameIndex];
+	vkCmdResetQueryPool(commandBuffer, slot.queryPool, 0, slot.capacity * 2);
+	slot.scopeNameIds.clear();
+}
+
+uint32_t Renderer::GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t nameId)
+{
+	if (!IsSupported() || frameSlots[frameIndex].scopeNameIds.size() == GPU_PROFILER_MAX_SCOPES)
+	{
+		return UINT32_MAX;
+	}
+
+	QuerySlot& slot = frameSlots[frameIndex];
+	const uint32_t scope = static_cast<uint32_t>(slot.scopeNameIds.size());
+	slot.scopeNameIds.push_back(nameId);
+
+	// Bottom of pipe on both ends, a scope then runs from the end of the work before it to the end of its own
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slot.queryPool, scope * 2);
+	return scope;
+}
+
+void Renderer::GpuProfiler::EndScope(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t scope)
+{
+	if (scope != UINT32_MAX)
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frameSlots[frameIndex].queryPool, scope * 2 + 1);
+	}
+}
+
+uint32_t Renderer::GpuProfiler::BeginUploadScope(VkCommandBuffer commandBuffer, uint32_t nameId)
+{
+	if (!IsSupported() || uploadSlot.scopeNameIds.size() == uploadSlot.capacity)
+	{
+		return UINT32_MAX;
+	}
+
+	const uint32_t scope = static_cast<uint32_t>(uploadSlot.scopeNameIds.size());
+	uploadSlot.scopeNameIds.push_back(nameId);
+
+	// Upload scopes are recorded one at a time between frames, so each resets only its own queries
+	vkCmdResetQueryPool(commandBuffer, uploadSlot.queryPool, scope * 2, 2);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, uploadSlot.queryPool, scope * 2);
+	return scope;
+}
+
+void Renderer::GpuProfiler::EndUploadScope(VkCommandBuffer commandBuffer, uint32_t scope)
+{
+	if (scope != UINT32_MAX)
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, uploadSlot.queryPool, scope * 2 + 1);
+	}
+}
+
+void Renderer::GpuProfiler::ResetFrames()
+{
+	for (QuerySlot& slot : frameSlots)
+	{
+		slot.scopeNameIds.clear();
+	}
+
+	frameScopes.clear();
+}
+
+const std::vector<Renderer::GpuProfiler::Scope>& Renderer::GpuProfiler::GetFrameScopes() const
+{
+	return frameScopes;
+}
+
+void Renderer::GpuProfiler::CreateQuerySlot(QuerySlot& slot, uint32_t capacity)
+{
+	PROFILE_FUNCTION();
+
+	VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = capacity * 2;
+
+	VkResult vkResult = vkCreateQueryPool(createInfo.device.logicalDevice, &queryPoolCreateInfo, nullptr, &slot.queryPool);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create timestamp query pool");
+	}
+
+	slot.capacity = capacity;
+}
+
+bool Renderer::GpuProfiler::ReadQuerySlot(QuerySlot& slot, std::vector<Scope>& scopes)
+{
+	if (slot.scopeNameIds.empty())
+	{
+		return true;
+	}
+
+	const uint32_t queryCount = static_cast<uint32_t>(slot.scopeNameIds.size()) * 2;
+	timestamps.resize(queryCount);
+
+	// No wait flag, the slot's submission is known to be done and anything else is better skipped than waited for
+	VkResult vkResult = vkGetQueryPoolResults(createInfo.device.logicalDevice, slot.queryPool, 0, queryCount, queryCount * sizeof(uint64_t),
+		timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	const bool available = vkResult == VK_SUCCESS;
+	if (available)
+	{
+		for (size_t scope = 0; scope < slot.scopeNameIds.size(); scope++)
+		{
+			scopes.push_back({ slot.scopeNameIds[scope], TicksToProfilerNs(timestamps[scope * 2]), TicksToProfilerNs(timestamps[scope * 2 + 1]) });
+		}
+	}
+
+	slot.scopeNameIds.clear();
+	return available;
+}
+
+void Renderer::GpuProfiler::Calibrate()
+{
+	PROFILE_FUNCTION();
+
+	framesSinceCalibration = 0;
+
+	if (getCalibratedTimestamps == nullptr)
+	{
+		CalibrateWithSubmission();
+		return;
+	}
+
+	// Host time domains are QueryPerformanceCounter or CLOCK_MONOTONIC depending on the platform, reading the device's time
+	// between two reads of the profiler's own clock puts it on that clock directly, to within the call's duration
+	VkCalibratedTimestampInfoEXT timestampInfo = {};
+	timestampInfo.sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	timestampInfo.timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+
+	uint64_t ticks = 0;
+	uint64_t maxDeviation = 0;
+
+	const int64_t beforeNs = Profiler::Now();
+	VkResult vkResult = getCalibratedTimestamps(createInfo.device.logicalDevice, 1, &timestampInfo, &ticks, &maxDeviation);
+	const int64_t afterNs = Profiler::Now();
+
+	if (vkResult == VK_SUCCESS)
+	{
+		calibrationTicks = ticks;
+		calibrationNs = beforeNs + (afterNs - beforeNs) / 2;
+	}
+}
+
+void Renderer::GpuProfiler::CalibrateWithSubmission()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = 1;
+
+	VkQueryPool queryPool = nullptr;
+	VkResult vkResult = vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &queryPool);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create timestamp query pool");
+	}
+
+	VkCommandBuffer commandBuffer = Utils::BeginCmdBuffer(device, createInfo.commandPool);
+	vkCmdResetQueryPool(commandBuffer, queryPool, 0, 1);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+
+	// The timestamp is written somewhere between the submission and the wait returning, the middle is off by at most half of that
+	const int64_t beforeNs = Profiler::Now();
+	Utils::EndAndSubmitCmdBuffer(device, createInfo.commandPool, createInfo.queue, commandBuffer);
+	const int64_t afterNs = Profiler::Now();
+
+	uint64_t ticks = 0;
+	vkResult = vkGetQueryPoolResults(device, queryPool, 0, 1, sizeof(ticks), &ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+	if (vkResult == VK_SUCCESS)
+	{
+		calibrationTicks = ticks;
+		calibrationNs = beforeNs + (afterNs - beforeNs) / 2;
+	}
+
+	vkDestroyQueryPool(device, queryPool, nullptr);
+}
+
+int64_t Renderer::GpuProfiler::TicksToProfilerNs(uint64_t ticks) const
+{
+	// Signed, scopes read back after a calibration started before it
+	const int64_t elapsedTicks = static_cast<int64_t>(ticks - calibrationTicks);
+	return calibrationNs + static_cast<int64_t>(elapsedTicks * static_cast<double>(createInfo.timestampPeriod));
+}
@@ -0,0 +1,93 @@
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+#include <vector>
+#include "Utils.h"
+
+namespace Renderer
+{
+	using namespace Utilities;
+
+	/**
+	* Timestamp queries around passes and upload batches, written into the profiler's trace on its GPU track. Every frame in flight
+	* records into its own query range and reads it back once its fence has signalled, a few frames later, so the CPU never waits on them.
+	* GPU ticks are put on the profiler's clock with calibrated timestamps where the device has them, otherwise with one
+	* measurement at start up
+	*/
+	class GpuProfiler
+	{
+	public:
+		struct GpuProfilerCreateInfo
+		{
+			DeviceHandle device;
+			VkQueue queue;
+			VkCommandPool commandPool;
+			uint32_t frameCount = 0; // Most frames that can be in flight
+			float timestampPeriod = 0.0f; // Nanoseconds per tick, zero when the queue can't write timestamps
+			bool calibratedTimestamps = false; // VK_EXT_calibrated_timestamps is enabled and has the device time domain
+		};
+
+		/** A scope that has been read back, on the profiler's clock */
+		struct Scope
+		{
+			uint32_t nameId;
+			int64_t startNs;
+			int64_t endNs;
+		};
+
+		GpuProfiler() = default;
+		~GpuProfiler();
+		void Init(const GpuProfilerCreateInfo& gpuProfilerCreateInfo);
+		bool IsSupported() const;
+
+		/** Reads back what the frame context recorded last time and hands it to the profiler, its fence must have signalled */
+		void ReadFrame(uint32_t frameIndex);
+		/** Resets the frame's queries, recorded before its first scope and outside any render pass */
+		void BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		/** Returns the scope to end, scopes past GPU_PROFILER_MAX_SCOPES in a frame are not timed */
+		uint32_t BeginScope(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t nameId);
+		void EndScope(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t scope);
+		/** Scopes in one time command buffers, read back with the next frame. The caller waits for the submission as uploads do */
+		uint32_t BeginUploadScope(VkCommandBuffer commandBuffer, uint32_t nameId);
+		void EndUploadScope(VkCommandBuffer commandBuffer, uint32_t scope);
+		/** Forgets every frame's pending scopes, for when the frames in flight are rebuilt */
+		void ResetFrames();
+		/** Scopes of the last frame read back */
+		const std::vector<Scope>& GetFrameScopes() const;
+
+	private:
+		/** Query range of a frame in flight, or of the upload scopes recorded between frames */
+		struct QuerySlot
+		{
+			VkQueryPool queryPool = nullptr;
+			uint32_t capacity = 0; // In scopes
+			std::vector<uint32_t> scopeNameIds; // Scope i owns queries 2i and 2i + 1
+		};
+
+		GpuProfilerCreateInfo createInfo;
+		std::vector<QuerySlot> frameSlots;
+		QuerySlot uploadSlot;
+		std::vector<Scope> frameScopes;
+		std::vector<uint64_t> timestamps;
+
+		// GPU tick and profiler time taken at the same moment
+		uint64_t calibrationTicks = 0;
+		int64_t calibrationNs = 0;
+		uint32_t framesSinceCalibration = 0;
+		PFN_vkGetCalibratedTimestampsEXT getCalibratedTimestamps = nullptr;
+
+		void CreateQuerySlot(QuerySlot& slot, uint32_t capacity);
+		/** Reads the slot's scopes into scopes, false while the GPU hasn't written them */
+		bool ReadQuerySlot(QuerySlot& slot, std::vector<Scope>& scopes);
+		void Calibrate();
+		/** Without calibrated timestamps, times a one time submission that only writes a timestamp */
+		void CalibrateWithSubmission();
+		int64_t TicksToProfilerNs(uint64_t ticks) const;
+	};
+
+	// Scopes each frame can time, two queries each
+	constexpr uint32_t GPU_PROFILER_MAX_SCOPES = 32;
+	constexpr uint32_t GPU_PROFILER_MAX_UPLOAD_SCOPES = 64;
+	// GPU and CPU clocks drift apart slowly, calibrated timestamps are cheap enough to take again every few seconds
+	constexpr uint32_t GPU_PROFILER_CALIBRATION_FRAMES = 300;
+}
@@ -0,0 +1,396 @@
+#include "LightClusterer.h"
+#include <array>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+Renderer::LightClusterer::~LightClusterer()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	DestroyLightBuffers();
+	DestroyLightIndexBuffers();
+	DestroyClusterBuffers();
+
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+	vkDestroyPipeline(device, pipeline, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+}
+
+void Renderer::LightClusterer::Init(const LightClustererCreateInfo& clustererCreateInfo)
+{
+	PROFILE_FUNCTION();
+
+	createInfo = clustererCreateInfo;
+
+	CreateDescriptorSetLayout();
+	CreatePipeline();
+	CreateDescriptorPool();
+	CreateClusterBuffers();
+	CreateLightBuffers(MIN_LIGHT_CAPACITY);
+	CreateLightIndexBuffers(MIN_LIGHT_INDEX_CAPACITY);
+	CreateDescriptorSets();
+}
+
+void Renderer::LightClusterer::UpdateLights(uint32_t frameIndex, const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection)
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+	const uint32_t lightCount = static_cast<uint32_t>(lights.size());
+	void* data = nullptr;
+
+	// What the last frame recorded with these buffers listed, then zeroed for the cluster pass of this one
+	LightListCounters counters = {};
+	vkMapMemory(device, counterBufferMemory[frameIndex], 0, sizeof(LightListCounters), 0, &data);
+	memcpy(&counters, data, sizeof(LightListCounters));
+	memset(data, 0, sizeof(LightListCounters));
+	vkUnmapMemory(device, counterBufferMemory[frameIndex]);
+	PROFILE_COUNT_ADD(DROPPED_CLUSTER_LIGHTS, counters.droppedLightCount);
+
+	if (lightCount > lightCapacity || counters.listedLightCount > lightIndexCapacity)
+	{
+		// Buffers may still be in use by frames in flight
+		vkDeviceWaitIdle(device);
+
+		if (lightCount > lightCapacity)
+		{
+			DestroyLightBuffers();
+			CreateLightBuffers(std::max(lightCount, lightCapacity * 2));
+		}
+
+		if (counters.listedLightCount > lightIndexCapacity)
+		{
+			DestroyLightIndexBuffers();
+			CreateLightIndexBuffers(std::max(counters.listedLightCount, lightIndexCapacity * 2));
+		}
+
+		WriteDescriptorSets();
+	}
+
+	if (lightCount > 0)
+	{
+		vkMapMemory(device, lightBufferMemory[frameIndex], 0, sizeof(PointLight) * lightCount, 0, &data);
+		PROFILE_COUNT_ADD(UPLOADED_BYTES, sizeof(PointLight) * lightCount);
+		memcpy(data, lights.data(), sizeof(PointLight) * lightCount);
+		vkUnmapMemory(device, lightBufferMemory[frameIndex]);
+	}
+
+	const float nearPlane = GetProjectionNearPlane(projection);
+	const float farPlane = GetProjectionFarPlane(projection);
+	const float sliceScale = CLUSTER_COUNT_Z / std::log(farPlane / nearPlane);
+
+	ClusterUniforms clusterUniforms = {};
+	clusterUniforms.view = view;
+	clusterUniforms.inverseProjection = glm::inverse(projection);
+	clusterUniforms.inverseExtent = glm::vec2(1.0f / createInfo.extent.width, 1.0f / createInfo.extent.height);
+	clusterUniforms.nearPlane = nearPlane;
+	clusterUniforms.farPlane = farPlane;
+	clusterUniforms.sliceScale = sliceScale;
+	clusterUniforms.sliceBias = -std::log(nearPlane) * sliceScale;
+	clusterUniforms.lightCount = lightCount;
+	clusterUniforms.lightIndexCapacity = lightIndexCapacity;
+
+	vkMapMemory(device, uniformBufferMemory[frameIndex], 0, sizeof(ClusterUniforms), 0, &data);
+	PROFILE_COUNT_ADD(UPLOADED_BYTES, sizeof(ClusterUniforms));
+	memcpy(data, &clusterUniforms, sizeof(ClusterUniforms));
+	vkUnmapMemory(device, uniformBufferMemory[frameIndex]);
+}
+
+void Renderer::LightClusterer::RecordClusterPass(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	PROFILE_FUNCTION();
+
+	// Always dispatched so clusters are emptied when the last light is removed
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	PROFILE_COUNT(PIPELINE_BINDS);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSets[frameIndex], 0, nullptr);
+	PROFILE_COUNT(DESCRIPTOR_SET_BINDS);
+	vkCmdDispatch(commandBuffer, (CLUSTER_COUNT + CLUSTER_GROUP_SIZE - 1) / CLUSTER_GROUP_SIZE, 1, 1);
+	PROFILE_COUNT(DISPATCHES);
+
+	// Light lists are read by the lighting subpass, the counters by UpdateLights once the frame's fence signals
+	VkMemoryBarrier memoryBarrier = {};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+		0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+	PROFILE_COUNT(PIPELINE_BARRIERS);
+}
+
+VkDescriptorSetLayout Renderer::LightClusterer::GetDescriptorSetLayout() const
+{
+	return descriptorSetLayout;
+}
+
+VkDescriptorSet& Renderer::LightClusterer::GetDescriptorSet(uint32_t frameIndex)
+{
+	return descriptorSets[frameIndex];
+}
+
+void Renderer::LightClusterer::CreateDescriptorSetLayout()
+{
+	PROFILE_FUNCTION();
+
+	// Uniforms, lights, cluster light ranges, light indices, list counters. Written by the cluster pass, read by the lighting subpass
+	std::array<VkDescriptorSetLayoutBinding, 5> bindings = {};
+	for (uint32_t i = 0; i < bindings.size(); i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutCreateInfo.pBindings = bindings.data();
+
+	VkResult vkResult = vkCreateDescriptorSetLayout(createInfo.device.logicalDevice, &layoutCreateInfo, nullptr, &descriptorSetLayout);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor set layout");
+	}
+}
+
+void Renderer::LightClusterer::CreatePipeline()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = 1;
+	pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+
+	VkResult vkResult = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout");
+	}
+
+	VkComputePipelineCreateInfo computePipelineCreateInfo = {};
+	computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	computePipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	computePipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	computePipelineCreateInfo.stage.module = createInfo.clusterShaderModule;
+	computePipelineCreateInfo.stage.pName = "main";
+	computePipelineCreateInfo.layout = pipelineLayout;
+
+	vkResult = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &computePipelineCreateInfo, nullptr, &pipeline);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create light cluster pipeline");
+	}
+}
+
+void Renderer::LightClusterer::CreateDescriptorPool()
+{
+	PROFILE_FUNCTION();
+
+	const uint32_t frameCount = static_cast<uint32_t>(createInfo.frameCount);
+
+	std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].descriptorCount = frameCount;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[1].descriptorCount = frameCount * 4;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = frameCount;
+	poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolCreateInfo.pPoolSizes = poolSizes.data();
+
+	VkResult vkResult = vkCreateDescriptorPool(createInfo.device.logicalDevice, &poolCreateInfo, nullptr, &descriptorPool);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor pool");
+	}
+}
+
+void Renderer::LightClusterer::CreateDescriptorSets()
+{
+	PROFILE_FUNCTION();
+
+	descriptorSets.resize(createInfo.frameCount);
+	std::vector<VkDescriptorSetLayout> setLayouts(descriptorSets.size(), descriptorSetLayout);
+
+	VkDescriptorSetAllocateInfo setAllocateInfo = {};
+	setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocateInfo.descriptorPool = descriptorPool;
+	setAllocateInfo.descriptorSetCount = static_cast<uint32_t>(descriptorSets.size());
+	setAllocateInfo.pSetLayouts = setLayouts.data();
+
+	if (vkAllocateDescriptorSets(createInfo.device.logicalDevice, &setAllocateInfo, descriptorSets.data()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate light cluster descriptor sets");
+	}
+
+	WriteDescriptorSets();
+}
+
+void Renderer::LightClusterer::CreateClusterBuffers()
+{
+	PROFILE_FUNCTION();
+
+	const size_t frameCount = createInfo.frameCount;
+
+	uniformBuffers.resize(frameCount);
+	uniformBufferMemory.resize(frameCount);
+	clusterRangeBuffers.resize(frameCount);
+	clusterRangeBufferMemory.resize(frameCount);
+	counterBuffers.resize(frameCount);
+	counterBufferMemory.resize(frameCount);
+
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, sizeof(ClusterUniforms),
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&uniformBuffers[i], &uniformBufferMemory[i] });
+
+		// Only ever touched by the GPU, the cluster pass rewrites every cluster's offset and count each frame
+		Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, sizeof(uint32_t) * 2 * static_cast<VkDeviceSize>(CLUSTER_COUNT),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			&clusterRangeBuffers[i], &clusterRangeBufferMemory[i] });
+
+		Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, sizeof(LightListCounters),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&counterBuffers[i], &counterBufferMemory[i] });
+
+		void* data = nullptr;
+		vkMapMemory(createInfo.device.logicalDevice, counterBufferMemory[i], 0, sizeof(LightListCounters), 0, &data);
+		memset(data, 0, sizeof(LightListCounters));
+		vkUnmapMemory(createInfo.device.logicalDevice, counterBufferMemory[i]);
+	}
+}
+
+void Renderer::LightClusterer::DestroyClusterBuffers()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	for (size_t i = 0; i < uniformBuffers.size(); i++)
+	{
+		vkDestroyBuffer(device, uniformBuffers[i], nullptr);
+		Utils::FreeMemory(device, uniformBufferMemory[i]);
+		vkDestroyBuffer(device, clusterRangeBuffers[i], nullptr);
+		Utils::FreeMemory(device, clusterRangeBufferMemory[i]);
+		vkDestroyBuffer(device, counterBuffers[i], nullptr);
+		Utils::FreeMemory(device, counterBufferMemory[i]);
+	}
+
+	uniformBuffers.clear();
+	uniformBufferMemory.clear();
+	clusterRangeBuffers.clear();
+	clusterRangeBufferMemory.clear();
+	counterBuffers.clear();
+	counterBufferMemory.clear();
+}
+
+void Renderer::LightClusterer::CreateLightBuffers(uint32_t capacity)
+{
+	PROFILE_FUNCTION();
+
+	const size_t frameCount = createInfo.frameCount;
+	lightCapacity = capacity;
+
+	lightBuffers.resize(frameCount);
+	lightBufferMemory.resize(frameCount);
+
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, sizeof(PointLight) * static_cast<VkDeviceSize>(capacity),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&lightBuffers[i], &lightBufferMemory[i] });
+	}
+}
+
+void Renderer::LightClusterer::DestroyLightBuffers()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	for (size_t i = 0; i < lightBuffers.size(); i++)
+	{
+		vkDestroyBuffer(device, lightBuffers[i], nullptr);
+		Utils::FreeMemory(device, lightBufferMemory[i]);
+	}
+
+	lightBuffers.clear();
+	lightBufferMemory.clear();
+}
+
+void Renderer::LightClusterer::CreateLightIndexBuffers(uint32_t capacity)
+{
+	PROFILE_FUNCTION();
+
+	const size_t frameCount = createInfo.frameCount;
+	lightIndexCapacity = capacity;
+
+	clusterIndexBuffers.resize(frameCount);
+	clusterIndexBufferMemory.resize(frameCount);
+
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, sizeof(uint32_t) * static_cast<VkDeviceSize>(capacity),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			&clusterIndexBuffers[i], &clusterIndexBufferMemory[i] });
+	}
+}
+
+void Renderer::LightClusterer::DestroyLightIndexBuffers()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	for (size_t i = 0; i < clusterIndexBuffers.size(); i++)
+	{
+		vkDestroyBuffer(device, clusterIndexBuffers[i], nullptr);
+		Utils::FreeMemory(device, clusterIndexBufferMemory[i]);
+	}
+
+	clusterIndexBuffers.clear();
+	clusterIndexBufferMemory.clear();
+}
+
+void Renderer::LightClusterer::WriteDescriptorSets()
+{
+	PROFILE_FUNCTION();
+
+	for (size_t i = 0; i < descriptorSets.size(); i++)
+	{
+		std::array<VkDescriptorBufferInfo, 5> bufferInfos = {};
+		bufferInfos[0] = { uniformBuffers[i], 0, sizeof(ClusterUniforms) };
+		bufferInfos[1] = { lightBuffers[i], 0, VK_WHOLE_SIZE };
+		bufferInfos[2] = { clusterRangeBuffers[i], 0, VK_WHOLE_SIZE };
+		bufferInfos[3] = { clusterIndexBuffers[i], 0, VK_WHOLE_SIZE };
+		bufferInfos[4] = { counterBuffers[i], 0, VK_WHOLE_SIZE };
+
+		std::array<VkWriteDescriptorSet, 5> setWrites = {};
+		for (uint32_t binding = 0; binding < setWrites.size(); binding++)
+		{
+			setWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			setWrites[binding].dstSet = descriptorSets[i];
+			setWrites[binding].dstBinding = binding;
+			setWrites[binding].descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			setWrites[binding].descriptorCount = 1;
+			setWrites[binding].pBufferInfo = &bufferInfos[binding];
+		}
+
+		vkUpdateDescriptorSets(createInfo.device.logicalDevice, static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
+	}
+}
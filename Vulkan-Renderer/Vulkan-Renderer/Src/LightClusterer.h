@@ -0,0 +1,99 @@
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+#include <vector>
+#include "Utils.h"
+#include "ClusteredLighting.h"
+
+namespace Renderer
+{
+	using namespace Utilities;
+
+	/**
+	* Bins the scene's point lights into the cluster grid on the GPU every frame. The lighting subpass binds the same
+	* descriptor set and only shades each pixel with the lights listed for its cluster
+	*/
+	class LightClusterer
+	{
+	public:
+		struct LightClustererCreateInfo
+		{
+			DeviceHandle device;
+			VkExtent2D extent;
+			size_t frameCount = 0; // Frames in flight, uniforms, light lists and descriptor sets are created once per frame
+			VkShaderModule clusterShaderModule;
+		};
+
+		LightClusterer() = default;
+		~LightClusterer();
+		void Init(const LightClustererCreateInfo& clustererCreateInfo);
+		/**
+		* Uploads the lights and camera the cluster pass bins with, the frame's fence must have signalled. Grows the light index list
+		* once the frame last recorded with these buffers listed more lights than fit
+		*/
+		void UpdateLights(uint32_t frameIndex, const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection);
+		/** Rebuilds every cluster's light list, made visible to fragment shaders of the passes that follow */
+		void RecordClusterPass(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		VkDescriptorSetLayout GetDescriptorSetLayout() const;
+		VkDescriptorSet& GetDescriptorSet(uint32_t frameIndex);
+
+	private:
+		// Mirrors light_cluster.comp and the lighting subpasses, std140
+		struct ClusterUniforms
+		{
+			glm::mat4 view;
+			glm::mat4 inverseProjection;
+			glm::vec2 inverseExtent;
+			float nearPlane;
+			float farPlane;
+			float sliceScale; // Slice of a view depth is log(depth) * sliceScale + sliceBias
+			float sliceBias;
+			uint32_t lightCount;
+			uint32_t lightIndexCapacity;
+		};
+
+		// Mirrors LightListCounters of light_cluster.comp
+		struct LightListCounters
+		{
+			uint32_t listedLightCount;
+			uint32_t droppedLightCount;
+		};
+
+		static constexpr uint32_t CLUSTER_GROUP_SIZE = 64;
+		static constexpr uint32_t MIN_LIGHT_CAPACITY = 256;
+		static constexpr uint32_t MIN_LIGHT_INDEX_CAPACITY = CLUSTER_COUNT * 32;
+
+		LightClustererCreateInfo createInfo;
+		uint32_t lightCapacity = 0;
+		uint32_t lightIndexCapacity = 0;
+
+		VkDescriptorSetLayout descriptorSetLayout = nullptr;
+		VkPipelineLayout pipelineLayout = nullptr;
+		VkPipeline pipeline = nullptr;
+		VkDescriptorPool descriptorPool = nullptr;
+		std::vector<VkDescriptorSet> descriptorSets; // One per frame in flight
+
+		std::vector<VkBuffer> uniformBuffers;
+		std::vector<VkDeviceMemory> uniformBufferMemory;
+		std::vector<VkBuffer> lightBuffers;
+		std::vector<VkDeviceMemory> lightBufferMemory;
+		std::vector<VkBuffer> clusterRangeBuffers;
+		std::vector<VkDeviceMemory> clusterRangeBufferMemory;
+		std::vector<VkBuffer> counterBuffers;
+		std::vector<VkDeviceMemory> counterBufferMemory;
+		std::vector<VkBuffer> clusterIndexBuffers;
+		std::vector<VkDeviceMemory> clusterIndexBufferMemory;
+
+		void CreateDescriptorSetLayout();
+		void CreatePipeline();
+		void CreateDescriptorPool();
+		void CreateDescriptorSets();
+		void CreateClusterBuffers();
+		void DestroyClusterBuffers();
+		void CreateLightBuffers(uint32_t capacity);
+		void DestroyLightBuffers();
+		void CreateLightIndexBuffers(uint32_t capacity);
+		void DestroyLightIndexBuffers();
+		void WriteDescriptorSets();
+	};
+}
@@ -1,32 +1,23 @@
 #include "MemoryPool.h"
-#include <exception>
-#include <string>
+#include <cstdlib>
+#include <new>
 #include <stdexcept>
 
 template<size_t T>
 MemoryPool<T>::MemoryPool(size_t unitCount)
 {
 	this->unitCount = unitCount;
+	totalBytesAllocated = unitCount * UNIT_SIZE;
 
-	constexpr unsigned int memUnitSize = sizeof(MemoryUnit);
-	totalBytesAllocated = unitCount * (unitSize + memUnitSize);
-
+	// malloc aligns for any type, every unit after the first is UNIT_SIZE further on and keeps UNIT_ALIGNMENT
 	memblockPtr = malloc(totalBytesAllocated);
 	if (memblockPtr)
 	{
-		memset(memblockPtr, 255, totalBytesAllocated);
-
-		for (size_t index = 0; index < unitCount; ++index)
+		// Chained in address order so a fresh pool hands out consecutive units
+		for (size_t index = unitCount; index > 0; --index)
 		{
-			MemoryUnit* curUnitPtr = (MemoryUnit*)((char*)memblockPtr + index * (unitSize + sizeof(MemoryUnit)));
-
-			curUnitPtr->prevPtr = nullptr;
-			curUnitPtr->nextPtr = freeUnitsPtr; //Inserts new unit at head
-
-			if (freeUnitsPtr)
-			{
-				freeUnitsPtr->prevPtr = curUnitPtr;
-			}
+			FreeUnit* curUnitPtr = (FreeUnit*)((char*)memblockPtr + (index - 1) * UNIT_SIZE);
+			curUnitPtr->nextPtr = freeUnitsPtr;
 			freeUnitsPtr = curUnitPtr;
 		}
 	}
@@ -78,33 +69,23 @@ void* MemoryPool<T>::GetEnd() const
 template<size_t T>
 bool MemoryPool<T>::BelongsToPool(void* ptr) const
 {
-	return GetStart() < ptr && ptr < GetEnd();
+	if (ptr < GetStart() || ptr >= GetEnd())
+	{
+		return false;
+	}
+	return ((char*)ptr - (char*)memblockPtr) % UNIT_SIZE == 0;
 }
 
 template<size_t T>
 size_t MemoryPool<T>::GetCurrentMemoryUnitsAllocated() const
 {
-	MemoryUnit* curUnitA = allocatedUnitsPtr;
-	size_t allocatedCount = 0;
-	while (curUnitA)
-	{
-		curUnitA = curUnitA->nextPtr;
-		allocatedCount++;
-	}
-	return allocatedCount;
+	return allocatedUnitCount;
 }
 
 template<size_t T>
 size_t MemoryPool<T>::GetCurrentMemoryUnitsUnAllocated() const
 {
-	MemoryUnit* curUnitA = freeUnitsPtr;
-	size_t unAllocatedCount = 0;
-	while (curUnitA)
-	{
-		curUnitA = curUnitA->nextPtr;
-		unAllocatedCount++;
-	}
-	return unAllocatedCount;
+	return unitCount - allocatedUnitCount;
 }
 
 template<size_t T>
@@ -116,58 +97,33 @@ size_t MemoryPool<T>::GetTotalMemoryAllocated() const
 template<size_t T>
 void* MemoryPool<T>::Internal_Allocate()
 {
-	MemoryUnit* curUnitPtr = freeUnitsPtr;
-	freeUnitsPtr = curUnitPtr->nextPtr;
-	if (freeUnitsPtr)
+	FreeUnit* curUnitPtr = freeUnitsPtr;
+	if (curUnitPtr == nullptr)
 	{
-		freeUnitsPtr->prevPtr = nullptr;
+		return nullptr;
 	}
 
-	curUnitPtr->nextPtr = allocatedUnitsPtr;
-	if (allocatedUnitsPtr)
-	{
-		allocatedUnitsPtr->prevPtr = curUnitPtr;
-	}
-	allocatedUnitsPtr = curUnitPtr;
+	freeUnitsPtr = curUnitPtr->nextPtr;
+	allocatedUnitCount++;
 
-	return (void*)((char*)curUnitPtr + sizeof(MemoryUnit));
+	return curUnitPtr;
 }
 
 template<size_t T>
 void MemoryPool<T>::Internal_Free(void* ptr)
 {
-	MemoryUnit* curUnitPtr = (MemoryUnit*)((char*)ptr - sizeof(MemoryUnit));
-	MemoryUnit* prevPtr = curUnitPtr->prevPtr;
-	MemoryUnit* nextPtr = curUnitPtr->nextPtr;
-
-	if (prevPtr == nullptr)
-	{
-		allocatedUnitsPtr = curUnitPtr->nextPtr;
-	}
-	else
-	{
-		prevPtr->nextPtr = nextPtr;
-	}
-
-	if (nextPtr)
-	{
-		nextPtr->prevPtr = prevPtr;
-	}
-
+	// Most recently freed goes out first, it is the unit most likely still in cache
+	FreeUnit* curUnitPtr = (FreeUnit*)ptr;
 	curUnitPtr->nextPtr = freeUnitsPtr;
-	if (freeUnitsPtr)
-	{
-		freeUnitsPtr->prevPtr = curUnitPtr;
-	}
-
 	freeUnitsPtr = curUnitPtr;
+	allocatedUnitCount--;
 }
 
-template MemoryPool<1>;
-template MemoryPool<4>;
-template MemoryPool<8>;
-template MemoryPool<16>;
-template MemoryPool<32>;
-template MemoryPool<128>;
-template MemoryPool<1024>;
-template MemoryPool<4096>;
\ No newline at end of file
+template class MemoryPool<1>;
+template class MemoryPool<4>;
+template class MemoryPool<8>;
+template class MemoryPool<16>;
+template class MemoryPool<32>;
+template class MemoryPool<128>;
+template class MemoryPool<1024>;
+template class MemoryPool<4096>;
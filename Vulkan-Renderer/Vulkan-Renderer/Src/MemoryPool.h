@@ -1,34 +1,49 @@
 #pragma once
+#include <cstddef>
+
+/**
+* Fixed number of T byte units carved from one block. Free units are chained through their own first bytes,
+* allocated units carry no header, so a unit costs T bytes rounded up to hold the link and keep its alignment
+*/
 template<size_t T>
 class MemoryPool
 {
 public:
 	MemoryPool(size_t unitCount);
 	~MemoryPool();
+	MemoryPool(const MemoryPool&) = delete;
+	MemoryPool& operator=(const MemoryPool&) = delete;
+
+	/** nullptr once every unit is allocated */
 	void* Allocate();
 	void Free(void* ptr);
 	void* GetStart() const;
 	void* GetEnd()const;
+	/** True for the start of a unit inside the pool */
 	bool BelongsToPool(void* ptr) const;
 	size_t GetCurrentMemoryUnitsAllocated() const;
 	size_t GetCurrentMemoryUnitsUnAllocated() const;
 	size_t GetTotalMemoryAllocated() const;
 
+	/** The largest power of two dividing T, what any object of T bytes can need, clamped between a pointer's and max_align_t's alignment */
+	static constexpr size_t UNIT_ALIGNMENT = (T & (~T + 1)) < alignof(void*) ? alignof(void*)
+		: (T & (~T + 1)) > alignof(std::max_align_t) ? alignof(std::max_align_t) : (T & (~T + 1));
+	static constexpr size_t UNIT_SIZE = ((T < sizeof(void*) ? sizeof(void*) : T) + UNIT_ALIGNMENT - 1) & ~(UNIT_ALIGNMENT - 1);
+
 protected:
 
 	void* memblockPtr = nullptr;
 
-	struct MemoryUnit
+	/** Overlays a unit only while it is free */
+	struct FreeUnit
 	{
-		MemoryUnit* prevPtr = nullptr;
-		MemoryUnit* nextPtr = nullptr;
+		FreeUnit* nextPtr;
 	};
 
-	MemoryUnit* allocatedUnitsPtr = nullptr;
-	MemoryUnit* freeUnitsPtr = nullptr;
+	FreeUnit* freeUnitsPtr = nullptr;
 
 	size_t unitCount;
-	size_t unitSize = T;
+	size_t allocatedUnitCount = 0;
 	size_t totalBytesAllocated = 0;
 
 	void* Internal_Allocate();
@@ -42,4 +57,4 @@ using MemoryPool_16_Bytes  = MemoryPool<16>;
 using MemoryPool_32_Bytes = MemoryPool<32>;
 using MemoryPool_128_Bytes = MemoryPool<128>;
 using MemoryPool_1_KiloByte = MemoryPool<1024>;
-using MemoryPool_4_KiloBytes = MemoryPool<4096>;
\ No newline at end of file
+using MemoryPool_4_KiloBytes = MemoryPool<4096>;
@@ -17,7 +17,12 @@ Mesh::Mesh(VkPhysicalDevice physicalDevice, VkDevice device, VkQueue transferQue
 	this->device = device;
 	this->texId = texId;
 
-	CreateVertexBuffer(transferQueue, transferCommandPool, vertices);
+	for (const Vertex& vertex : *vertices)
+	{
+		localBounds.Expand(vertex.pos);
+	}
+
+	CreateVertexBuffers(transferQueue, transferCommandPool, vertices);
 	CreateIndexBuffer(transferQueue, transferCommandPool, indices);
 
 	uboModel.model = glm::mat4(1.0f);
@@ -33,9 +38,14 @@ size_t Mesh::GetIndexCount() const
 	return indexCount;
 }
 
-VkBuffer Mesh::GetVertexBuffer() const
+VkBuffer Mesh::GetPositionBuffer() const
+{
+	return positionBuffer;
+}
+
+VkBuffer Mesh::GetAttributeBuffer() const
 {
-	return vertexBuffer;
+	return attributeBuffer;
 }
 
 VkBuffer Mesh::GetIndexBuffer() const
@@ -47,11 +57,13 @@ void Mesh::DestroyBuffers()
 {
 	PROFILE_FUNCTION();
 
-	vkDestroyBuffer(device, vertexBuffer, nullptr);
-	vkFreeMemory(device, vertexBufferMemory, nullptr);
+	vkDestroyBuffer(device, positionBuffer, nullptr);
+	Utils::FreeMemory(device, positionBufferMemory);
+	vkDestroyBuffer(device, attributeBuffer, nullptr);
+	Utils::FreeMemory(device, attributeBufferMemory);
 
 	vkDestroyBuffer(device, indexBuffer, nullptr);
-	vkFreeMemory(device, indexBufferMemory, nullptr);
+	Utils::FreeMemory(device, indexBufferMemory);
 }
 
 void Mesh::SetModel(const glm::mat4& newModel)
@@ -69,16 +81,40 @@ uint32_t Mesh::GetTexId() const
 	return texId;
 }
 
+const BoundingBox& Mesh::GetLocalBounds() const
+{
+	return localBounds;
+}
+
 Mesh::~Mesh()
 {
 
 }
 
-void Mesh::CreateVertexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex>* vertices)
+void Mesh::CreateVertexBuffers(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex>* vertices)
 {
 	PROFILE_FUNCTION();
 
-	VkDeviceSize bufferSize = sizeof(Vertex) * vertices->size();
+	// Deinterleaved so passes that only need positions fetch 12 bytes a vertex instead of the whole vertex
+	std::vector<glm::vec3> positions(vertices->size());
+	std::vector<VertexAttributes> attributes(vertices->size());
+	for (size_t i = 0; i < vertices->size(); i++)
+	{
+		const Vertex& vertex = (*vertices)[i];
+		positions[i] = vertex.pos;
+		attributes[i] = { vertex.col, vertex.normal, vertex.uv };
+	}
+
+	// Both streams are also the source of the merged visibility buffer geometry
+	const VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	CreateDeviceLocalBuffer(transferQueue, transferCommandPool, positions.data(), sizeof(glm::vec3) * positions.size(), usageFlags, &positionBuffer, &positionBufferMemory);
+	CreateDeviceLocalBuffer(transferQueue, transferCommandPool, attributes.data(), sizeof(VertexAttributes) * attributes.size(), usageFlags, &attributeBuffer, &attributeBufferMemory);
+}
+
+void Mesh::CreateDeviceLocalBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, const void* srcData, VkDeviceSize bufferSize,
+	VkBufferUsageFlags usageFlags, VkBuffer* buffer, VkDeviceMemory* bufferMemory)
+{
+	PROFILE_FUNCTION();
 
 	VkBuffer stagingBuffer;
 	VkDeviceMemory stagingBufferMemory;
@@ -96,17 +132,18 @@ void Mesh::CreateVertexBuffer(VkQueue transferQueue, VkCommandPool transferComma
 
 	void* data;
 	vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, vertices->data(), static_cast<size_t>(bufferSize));
+	PROFILE_COUNT_ADD(UPLOADED_BYTES, bufferSize);
+	memcpy(data, srcData, static_cast<size_t>(bufferSize));
 	vkUnmapMemory(device, stagingBufferMemory);
 
 	CreateBufferInfo dstBufferInfo;
 	dstBufferInfo.physicalDevice = physicalDevice;
 	dstBufferInfo.device = device;
 	dstBufferInfo.bufferSize = bufferSize;
-	dstBufferInfo.bufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	dstBufferInfo.bufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | usageFlags;
 	dstBufferInfo.memoryPropFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-	dstBufferInfo.buffer = &vertexBuffer;
-	dstBufferInfo.bufferMemory = &vertexBufferMemory;
+	dstBufferInfo.buffer = buffer;
+	dstBufferInfo.bufferMemory = bufferMemory;
 
 	Utils::CreateBuffer(dstBufferInfo);
 
@@ -116,12 +153,12 @@ void Mesh::CreateVertexBuffer(VkQueue transferQueue, VkCommandPool transferComma
 	copyBufferInfo.transferQueue = transferQueue;
 	copyBufferInfo.transCommandPool = transferCommandPool;
 	copyBufferInfo.srcBuffer = stagingBuffer;
-	copyBufferInfo.dstBuffer = vertexBuffer;
+	copyBufferInfo.dstBuffer = *buffer;
 
 	Utils::CopyBuffer(copyBufferInfo);
 
 	vkDestroyBuffer(device, stagingBuffer, nullptr);
-	vkFreeMemory(device, stagingBufferMemory, nullptr);
+	Utils::FreeMemory(device, stagingBufferMemory);
 }
 
 void Mesh::CreateIndexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<uint32_t>* indices)
@@ -139,15 +176,16 @@ void Mesh::CreateIndexBuffer(VkQueue transferQueue, VkCommandPool transferComman
 
 	void* data;
 	vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
+	PROFILE_COUNT_ADD(UPLOADED_BYTES, bufferSize);
 	memcpy(data, indices->data(), static_cast<size_t>(bufferSize));
 	vkUnmapMemory(device, stagingBufferMemory);
 
-	Utils::CreateBuffer({ physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+	Utils::CreateBuffer({ physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT , &indexBuffer, &indexBufferMemory });
 
 	Utils::CopyBuffer({device, transferQueue, transferCommandPool, stagingBuffer, indexBuffer, bufferSize});
 
 	vkDestroyBuffer(device, stagingBuffer, nullptr);
-	vkFreeMemory(device, stagingBufferMemory, nullptr);
+	Utils::FreeMemory(device, stagingBufferMemory);
 
 }
@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 #include <vector>
 #include "Utils.h"
+#include "BoundingVolumes.h"
 
 using namespace Utilities;
 
@@ -11,6 +12,13 @@ struct UboModel
 	glm::mat4 model;
 };
 
+/** Per draw data of the G-buffer pipelines, the texture index selects from the bindless texture array */
+struct PushModel
+{
+	glm::mat4 model;
+	uint32_t textureIndex;
+};
+
 class Mesh
 {
 public:
@@ -18,12 +26,16 @@ public:
 	Mesh(VkPhysicalDevice physicalDevice, VkDevice device, VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex>* vertices, std::vector<uint32_t>* indices, uint32_t texId);
 	size_t GetVertexCount() const;
 	size_t GetIndexCount() const;
-	VkBuffer GetVertexBuffer() const;
+	/** Tightly packed positions, vertex binding 0. Depth only passes fetch nothing else */
+	VkBuffer GetPositionBuffer() const;
+	/** VertexAttributes in the same vertex order, vertex binding 1 */
+	VkBuffer GetAttributeBuffer() const;
 	VkBuffer GetIndexBuffer() const;
 	void DestroyBuffers();
 	void SetModel(const glm::mat4& newModel);
 	UboModel GetModel() const;
 	uint32_t GetTexId() const;
+	const BoundingBox& GetLocalBounds() const;
 	~Mesh();
 
 private:
@@ -31,10 +43,13 @@ private:
 	UboModel uboModel;
 
 	uint32_t texId;
+	BoundingBox localBounds;
 
 	size_t vertexCount = 0;
-	VkBuffer vertexBuffer = nullptr;
-	VkDeviceMemory vertexBufferMemory = nullptr;
+	VkBuffer positionBuffer = nullptr;
+	VkDeviceMemory positionBufferMemory = nullptr;
+	VkBuffer attributeBuffer = nullptr;
+	VkDeviceMemory attributeBufferMemory = nullptr;
 
 	size_t indexCount = 0;
 	VkBuffer indexBuffer = nullptr;
@@ -43,7 +58,9 @@ private:
 	VkPhysicalDevice physicalDevice = nullptr;
 	VkDevice device = nullptr;
 
-	void CreateVertexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex>* vertices);
+	void CreateVertexBuffers(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex>* vertices);
+	void CreateDeviceLocalBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, const void* srcData, VkDeviceSize bufferSize,
+		VkBufferUsageFlags usageFlags, VkBuffer* buffer, VkDeviceMemory* bufferMemory);
 	void CreateIndexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<uint32_t>* indices);
 };
 
@@ -5,9 +5,10 @@ Model::Model()
 	model = glm::mat4(1.0f);
 }
 
-Model::Model(const std::vector<Mesh>& meshList)
+Model::Model(const std::vector<Mesh>& meshList, bool ownsMeshes /*= true*/)
 {
 	this->meshList = meshList;
+	this->ownsMeshes = ownsMeshes;
 	model = glm::mat4(1.0f);
 }
 
@@ -39,6 +40,11 @@ void Model::DestroyModel()
 {
 	PROFILE_FUNCTION();
 
+	if (!ownsMeshes)
+	{
+		return;
+	}
+
 	for (auto& mesh : meshList)
 	{
 		mesh.DestroyBuffers();
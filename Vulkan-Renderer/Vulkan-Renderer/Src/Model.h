@@ -7,7 +7,8 @@ class Model
 {
 public:
 	Model();
-	Model(const std::vector<Mesh>& meshList);
+	/** A model that doesn't own its meshes shares their buffers with other models, whoever created them destroys them */
+	Model(const std::vector<Mesh>& meshList, bool ownsMeshes = true);
 	size_t GetMeshCount() const;
 	const Mesh* GetMesh(size_t index)const;
 	const glm::mat4& GetModelMatrix() const;
@@ -24,5 +25,6 @@ public:
 private:
 	std::vector<Mesh> meshList;
 	glm::mat4 model;
+	bool ownsMeshes = true;
 };
 
@@ -0,0 +1,691 @@
+#include "OcclusionCulling.h"
+#include <array>
+#include <stdexcept>
+#include <cstring>
+
+Renderer::OcclusionCuller::~OcclusionCuller()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	DestroyDrawBuffers();
+
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+	vkDestroyPipeline(device, cullPipeline, nullptr);
+	vkDestroyPipeline(device, downsamplePipeline, nullptr);
+	vkDestroyPipelineLayout(device, cullPipelineLayout, nullptr);
+	vkDestroyPipelineLayout(device, downsamplePipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(device, cullSetLayout, nullptr);
+	vkDestroyDescriptorSetLayout(device, downsampleSetLayout, nullptr);
+	vkDestroySampler(device, depthSampler, nullptr);
+
+	for (VkImageView mipView : depthPyramidMipViews)
+	{
+		vkDestroyImageView(device, mipView, nullptr);
+	}
+
+	vkDestroyImageView(device, depthPyramidView, nullptr);
+	vkDestroyImage(device, depthPyramidImage, nullptr);
+	Utils::FreeMemory(device, depthPyramidMemory);
+}
+
+void Renderer::OcclusionCuller::Init(const OcclusionCullerCreateInfo& cullerCreateInfo)
+{
+	PROFILE_FUNCTION();
+
+	createInfo = cullerCreateInfo;
+
+	CreateDepthPyramid();
+	CreateSampler();
+	CreateDescriptorSetLayouts();
+	CreatePipelines();
+	CreateDescriptorPool();
+	CreateDrawBuffers(MIN_DRAW_CAPACITY);
+	CreateDescriptorSets();
+}
+
+void Renderer::OcclusionCuller::UpdateDrawData(uint32_t frameIndex, const BoundingBoxSoA& bounds, const std::vector<uint32_t>& indexCounts, const glm::mat4& viewProjection)
+{
+	PROFILE_FUNCTION();
+
+	drawCount = static_cast<uint32_t>(bounds.Size());
+
+	if (drawCount > drawCapacity)
+	{
+		// Buffers may still be in use by frames in flight
+		vkDeviceWaitIdle(createInfo.device.logicalDevice);
+		DestroyDrawBuffers();
+		CreateDrawBuffers(std::max(drawCount, drawCapacity * 2));
+		WriteCullDescriptorSets();
+	}
+
+	VkDevice device = createInfo.device.logicalDevice;
+	void* data = nullptr;
+
+	if (drawCount > 0)
+	{
+		vkMapMemory(device, drawDataBufferMemory[frameIndex], 0, sizeof(DrawCullData) * drawCount, 0, &data);
+		PROFILE_COUNT_ADD(UPLOADED_BYTES, sizeof(DrawCullData) * drawCount);
+		DrawCullData* drawData = static_cast<DrawCullData*>(data);
+
+		uint32_t firstTriangle = 0;
+		for (uint32_t i = 0; i < drawCount; i++)
+		{
+			drawData[i].center = glm::vec3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+			drawData[i].indexCount = indexCounts[i];
+			drawData[i].extents = glm::vec3(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+			drawData[i].firstTriangle = firstTriangle;
+			firstTriangle += indexCounts[i] / 3;
+		}
+
+		vkUnmapMemory(device, drawDataBufferMemory[frameIndex]);
+	}
+
+	CullUniforms cullUniforms = {};
+	cullUniforms.viewProjection = viewProjection;
+	cullUniforms.pyramidViewProjection = pyramidViewProjection;
+	cullUniforms.pyramidSize = glm::vec2(depthPyramidExtent.width, depthPyramidExtent.height);
+	cullUniforms.drawCount = drawCount;
+	cullUniforms.occlusionEnabled = enabled ? 1 : 0;
+
+	vkMapMemory(device, cullUniformBufferMemory[frameIndex], 0, sizeof(CullUniforms), 0, &data);
+	PROFILE_COUNT_ADD(UPLOADED_BYTES, sizeof(CullUniforms));
+	memcpy(data, &cullUniforms, sizeof(CullUniforms));
+	vkUnmapMemory(device, cullUniformBufferMemory[frameIndex]);
+
+	// The pyramid built this frame is rendered with this frame's view projection, next frame's early pass tests against it
+	if (enabled)
+	{
+		pyramidViewProjection = viewProjection;
+	}
+}
+
+void Renderer::OcclusionCuller::RecordCullPass(VkCommandBuffer commandBuffer, uint32_t frameIndex, CullPhase phase)
+{
+	PROFILE_FUNCTION();
+
+	VkMemoryBarrier memoryBarrier = {};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+	if (phase == CullPhase::EARLY)
+	{
+		// Pyramid written by the previous frame, indirect buffers last read by the previous use of this frame context
+		memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+		PROFILE_COUNT(PIPELINE_BARRIERS);
+	}
+
+	if (drawCount > 0)
+	{
+		const uint32_t phaseIndex = phase == CullPhase::EARLY ? 0 : 1;
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+		PROFILE_COUNT(PIPELINE_BINDS);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 1, &cullSets[frameIndex], 0, nullptr);
+		PROFILE_COUNT(DESCRIPTOR_SET_BINDS);
+		vkCmdPushConstants(commandBuffer, cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &phaseIndex);
+		vkCmdDispatch(commandBuffer, (drawCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+		PROFILE_COUNT(DISPATCHES);
+	}
+
+	// Commands are consumed by the indirect draws, the late phase also reads what the early phase drew
+	memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+	PROFILE_COUNT(PIPELINE_BARRIERS);
+}
+
+void Renderer::OcclusionCuller::RecordDepthPyramid(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	PROFILE_FUNCTION();
+
+	// With culling disabled every draw goes through the early pass and the pyramid is never read
+	if (!enabled)
+	{
+		return;
+	}
+
+	VkMemoryBarrier memoryBarrier = {};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+	// Early cull pass reads the pyramid about to be overwritten
+	memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+	PROFILE_COUNT(PIPELINE_BARRIERS);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, downsamplePipeline);
+	PROFILE_COUNT(PIPELINE_BINDS);
+
+	VkExtent2D sourceExtent = createInfo.extent;
+
+	for (uint32_t level = 0; level < depthPyramidLevels; level++)
+	{
+		const VkExtent2D destinationExtent = { std::max(depthPyramidExtent.width >> level, 1u), std::max(depthPyramidExtent.height >> level, 1u) };
+		const VkDescriptorSet sourceSet = level == 0 ? depthDownsampleSets[frameIndex] : mipDownsampleSets[level];
+
+		DownsamplePushConstants pushConstants = {};
+		pushConstants.sourceSize = glm::ivec2(sourceExtent.width, sourceExtent.height);
+		pushConstants.destinationSize = glm::ivec2(destinationExtent.width, destinationExtent.height);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, downsamplePipelineLayout, 0, 1, &sourceSet, 0, nullptr);
+		PROFILE_COUNT(DESCRIPTOR_SET_BINDS);
+		vkCmdPushConstants(commandBuffer, downsamplePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DownsamplePushConstants), &pushConstants);
+		vkCmdDispatch(commandBuffer, (destinationExtent.width + DOWNSAMPLE_GROUP_SIZE - 1) / DOWNSAMPLE_GROUP_SIZE,
+			(destinationExtent.height + DOWNSAMPLE_GROUP_SIZE - 1) / DOWNSAMPLE_GROUP_SIZE, 1);
+		PROFILE_COUNT(DISPATCHES);
+
+		// Next level (or the late cull pass) reads what was just written
+		memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+		PROFILE_COUNT(PIPELINE_BARRIERS);
+
+		sourceExtent = destinationExtent;
+	}
+}
+
+VkBuffer Renderer::OcclusionCuller::GetIndirectBuffer(uint32_t frameIndex, CullPhase phase) const
+{
+	return phase == CullPhase::EARLY ? earlyIndirectBuffers[frameIndex] : lateIndirectBuffers[frameIndex];
+}
+
+void Renderer::OcclusionCuller::SetEnabled(bool enabled)
+{
+	this->enabled = enabled;
+}
+
+bool Renderer::OcclusionCuller::IsEnabled() const
+{
+	return enabled;
+}
+
+void Renderer::OcclusionCuller::CreateDepthPyramid()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	// Power of two below the depth buffer size so every level halves exactly, mip 0 takes the max over its whole footprint
+	auto previousPowerOfTwo = [](uint32_t value)
+	{
+		uint32_t result = 1;
+		while (result * 2 <= value)
+		{
+			result *= 2;
+		}
+		return result;
+	};
+
+	depthPyramidExtent = { previousPowerOfTwo(createInfo.extent.width), previousPowerOfTwo(createInfo.extent.height) };
+	depthPyramidLevels = 1;
+	while ((std::max(depthPyramidExtent.width, depthPyramidExtent.height) >> depthPyramidLevels) > 0)
+	{
+		depthPyramidLevels++;
+	}
+
+	VkImageCreateInfo imageCreateInfo = {};
+	imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageCreateInfo.extent = { depthPyramidExtent.width, depthPyramidExtent.height, 1 };
+	imageCreateInfo.mipLevels = depthPyramidLevels;
+	imageCreateInfo.arrayLayers = 1;
+	imageCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageCreateInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkResult vkResult = vkCreateImage(device, &imageCreateInfo, nullptr, &depthPyramidImage);
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create depth pyramid image");
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetImageMemoryRequirements(device, depthPyramidImage, &memoryRequirements);
+
+	VkMemoryAllocateInfo memoryAllocInfo = {};
+	memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memoryAllocInfo.allocationSize = memoryRequirements.size;
+	memoryAllocInfo.memoryTypeIndex = Utils::FindMemoryTypeIndex(createInfo.device.physicalDevice, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	vkResult = Utils::AllocateMemory(device, &memoryAllocInfo, &depthPyramidMemory);
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate memory for depth pyramid");
+	}
+
+	vkBindImageMemory(device, depthPyramidImage, depthPyramidMemory, 0);
+
+	VkImageViewCreateInfo viewCreateInfo = {};
+	viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewCreateInfo.image = depthPyramidImage;
+	viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+	viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewCreateInfo.subresourceRange.baseMipLevel = 0;
+	viewCreateInfo.subresourceRange.levelCount = depthPyramidLevels;
+	viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+	viewCreateInfo.subresourceRange.layerCount = 1;
+
+	vkResult = vkCreateImageView(device, &viewCreateInfo, nullptr, &depthPyramidView);
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create depth pyramid image view");
+	}
+
+	depthPyramidMipViews.resize(depthPyramidLevels);
+	viewCreateInfo.subresourceRange.levelCount = 1;
+
+	for (uint32_t level = 0; level < depthPyramidLevels; level++)
+	{
+		viewCreateInfo.subresourceRange.baseMipLevel = level;
+
+		vkResult = vkCreateImageView(device, &viewCreateInfo, nullptr, &depthPyramidMipViews[level]);
+		if (vkResult != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create depth pyramid mip view");
+		}
+	}
+
+	// Start at the far plane so nothing is rejected before the first pyramid is built, then keep it in GENERAL for storage and sampling
+	VkCommandBuffer commandBuffer = Utils::BeginCmdBuffer(device, createInfo.commandPool);
+
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = depthPyramidImage;
+	imageBarrier.subresourceRange = viewCreateInfo.subresourceRange;
+	imageBarrier.subresourceRange.baseMipLevel = 0;
+	imageBarrier.subresourceRange.levelCount = depthPyramidLevels;
+	imageBarrier.srcAccessMask = 0;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+	PROFILE_COUNT(PIPELINE_BARRIERS);
+
+	VkClearColorValue farDepth = {};
+	farDepth.float32[0] = 1.0f;
+	vkCmdClearColorImage(commandBuffer, depthPyramidImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &farDepth, 1, &imageBarrier.subresourceRange);
+
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+	PROFILE_COUNT(PIPELINE_BARRIERS);
+
+	Utils::EndAndSubmitCmdBuffer(device, createInfo.commandPool, createInfo.queue, commandBuffer);
+}
+
+void Renderer::OcclusionCuller::CreateSampler()
+{
+	PROFILE_FUNCTION();
+
+	VkSamplerCreateInfo samplerCreateInfo = {};
+	samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+	samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.anisotropyEnable = VK_FALSE;
+	samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerCreateInfo.minLod = 0.0f;
+	samplerCreateInfo.maxLod = static_cast<float>(depthPyramidLevels);
+
+	VkResult vkResult = vkCreateSampler(createInfo.device.logicalDevice, &samplerCreateInfo, nullptr, &depthSampler);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create depth pyramid sampler");
+	}
+}
+
+void Renderer::OcclusionCuller::CreateDescriptorSetLayouts()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	// Downsample : source depth (or previous level) and destination level
+	std::array<VkDescriptorSetLayoutBinding, 2> downsampleBindings = {};
+	downsampleBindings[0].binding = 0;
+	downsampleBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	downsampleBindings[0].descriptorCount = 1;
+	downsampleBindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	downsampleBindings[1].binding = 1;
+	downsampleBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	downsampleBindings[1].descriptorCount = 1;
+	downsampleBindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.bindingCount = static_cast<uint32_t>(downsampleBindings.size());
+	layoutCreateInfo.pBindings = downsampleBindings.data();
+
+	VkResult vkResult = vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr, &downsampleSetLayout);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor set layout");
+	}
+
+	// Cull : uniforms, draw data, early and late indirect commands, depth pyramid
+	std::array<VkDescriptorSetLayoutBinding, 5> cullBindings = {};
+	const std::array<VkDescriptorType, 5> cullBindingTypes = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER };
+
+	for (uint32_t i = 0; i < cullBindings.size(); i++)
+	{
+		cullBindings[i].binding = i;
+		cullBindings[i].descriptorType = cullBindingTypes[i];
+		cullBindings[i].descriptorCount = 1;
+		cullBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	layoutCreateInfo.bindingCount = static_cast<uint32_t>(cullBindings.size());
+	layoutCreateInfo.pBindings = cullBindings.data();
+
+	vkResult = vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr, &cullSetLayout);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor set layout");
+	}
+}
+
+void Renderer::OcclusionCuller::CreatePipelines()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(DownsamplePushConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = 1;
+	pipelineLayoutCreateInfo.pSetLayouts = &downsampleSetLayout;
+	pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+	pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkResult vkResult = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &downsamplePipelineLayout);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout");
+	}
+
+	pushConstantRange.size = sizeof(uint32_t);
+	pipelineLayoutCreateInfo.pSetLayouts = &cullSetLayout;
+
+	vkResult = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &cullPipelineLayout);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout");
+	}
+
+	VkComputePipelineCreateInfo computePipelineCreateInfo = {};
+	computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	computePipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	computePipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	computePipelineCreateInfo.stage.module = createInfo.downsampleShaderModule;
+	computePipelineCreateInfo.stage.pName = "main";
+	computePipelineCreateInfo.layout = downsamplePipelineLayout;
+
+	vkResult = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &computePipelineCreateInfo, nullptr, &downsamplePipeline);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create depth downsample pipeline");
+	}
+
+	computePipelineCreateInfo.stage.module = createInfo.cullShaderModule;
+	computePipelineCreateInfo.layout = cullPipelineLayout;
+
+	vkResult = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &computePipelineCreateInfo, nullptr, &cullPipeline);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create occlusion cull pipeline");
+	}
+}
+
+void Renderer::OcclusionCuller::CreateDescriptorPool()
+{
+	PROFILE_FUNCTION();
+
+	const uint32_t frameCount = static_cast<uint32_t>(createInfo.frameCount);
+	const uint32_t downsampleSetCount = frameCount + depthPyramidLevels;
+
+	VkDescriptorPoolSize samplerPoolSize = {};
+	samplerPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	samplerPoolSize.descriptorCount = downsampleSetCount + frameCount;
+
+	VkDescriptorPoolSize storageImagePoolSize = {};
+	storageImagePoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	storageImagePoolSize.descriptorCount = downsampleSetCount;
+
+	VkDescriptorPoolSize uniformPoolSize = {};
+	uniformPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uniformPoolSize.descriptorCount = frameCount;
+
+	VkDescriptorPoolSize storageBufferPoolSize = {};
+	storageBufferPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	storageBufferPoolSize.descriptorCount = frameCount * 3;
+
+	std::array<VkDescriptorPoolSize, 4> poolSizes = { samplerPoolSize, storageImagePoolSize, uniformPoolSize, storageBufferPoolSize };
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = downsampleSetCount + frameCount;
+	poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolCreateInfo.pPoolSizes = poolSizes.data();
+
+	VkResult vkResult = vkCreateDescriptorPool(createInfo.device.logicalDevice, &poolCreateInfo, nullptr, &descriptorPool);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor pool");
+	}
+}
+
+void Renderer::OcclusionCuller::CreateDescriptorSets()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+	const uint32_t frameCount = static_cast<uint32_t>(createInfo.frameCount);
+
+	depthDownsampleSets.resize(frameCount);
+	mipDownsampleSets.resize(depthPyramidLevels);
+	cullSets.resize(frameCount);
+
+	auto allocateSets = [&](VkDescriptorSetLayout setLayout, std::vector<VkDescriptorSet>& sets)
+	{
+		std::vector<VkDescriptorSetLayout> setLayouts(sets.size(), setLayout);
+
+		VkDescriptorSetAllocateInfo setAllocateInfo = {};
+		setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		setAllocateInfo.descriptorPool = descriptorPool;
+		setAllocateInfo.descriptorSetCount = static_cast<uint32_t>(sets.size());
+		setAllocateInfo.pSetLayouts = setLayouts.data();
+
+		if (vkAllocateDescriptorSets(device, &setAllocateInfo, sets.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate occlusion culling descriptor sets");
+		}
+	};
+
+	allocateSets(downsampleSetLayout, depthDownsampleSets);
+	allocateSets(downsampleSetLayout, mipDownsampleSets);
+	allocateSets(cullSetLayout, cullSets);
+
+	auto writeDownsampleSet = [&](VkDescriptorSet set, VkImageView sourceView, VkImageLayout sourceLayout, VkImageView destinationView)
+	{
+		VkDescriptorImageInfo sourceInfo = {};
+		sourceInfo.imageLayout = sourceLayout;
+		sourceInfo.imageView = sourceView;
+		sourceInfo.sampler = depthSampler;
+
+		VkDescriptorImageInfo destinationInfo = {};
+		destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		destinationInfo.imageView = destinationView;
+
+		std::array<VkWriteDescriptorSet, 2> setWrites = {};
+		setWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		setWrites[0].dstSet = set;
+		setWrites[0].dstBinding = 0;
+		setWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		setWrites[0].descriptorCount = 1;
+		setWrites[0].pImageInfo = &sourceInfo;
+
+		setWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		setWrites[1].dstSet = set;
+		setWrites[1].dstBinding = 1;
+		setWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		setWrites[1].descriptorCount = 1;
+		setWrites[1].pImageInfo = &destinationInfo;
+
+		vkUpdateDescriptorSets(device, static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
+	};
+
+	for (uint32_t i = 0; i < frameCount; i++)
+	{
+		writeDownsampleSet(depthDownsampleSets[i], createInfo.depthBufferImageViews[i], VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, depthPyramidMipViews[0]);
+	}
+
+	// Level 0 always comes from the depth buffer, its entry is unused
+	for (uint32_t level = 1; level < depthPyramidLevels; level++)
+	{
+		writeDownsampleSet(mipDownsampleSets[level], depthPyramidMipViews[level - 1], VK_IMAGE_LAYOUT_GENERAL, depthPyramidMipViews[level]);
+	}
+
+	WriteCullDescriptorSets();
+}
+
+void Renderer::OcclusionCuller::CreateDrawBuffers(uint32_t capacity)
+{
+	PROFILE_FUNCTION();
+
+	const size_t frameCount = createInfo.frameCount;
+	drawCapacity = capacity;
+
+	drawDataBuffers.resize(frameCount);
+	drawDataBufferMemory.resize(frameCount);
+	cullUniformBuffers.resize(frameCount);
+	cullUniformBufferMemory.resize(frameCount);
+	earlyIndirectBuffers.resize(frameCount);
+	earlyIndirectBufferMemory.resize(frameCount);
+	lateIndirectBuffers.resize(frameCount);
+	lateIndirectBufferMemory.resize(frameCount);
+
+	const VkDeviceSize drawDataSize = sizeof(DrawCullData) * static_cast<VkDeviceSize>(capacity);
+	const VkDeviceSize indirectSize = sizeof(VkDrawIndexedIndirectCommand) * static_cast<VkDeviceSize>(capacity);
+
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, drawDataSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&drawDataBuffers[i], &drawDataBufferMemory[i] });
+
+		Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, sizeof(CullUniforms),
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&cullUniformBuffers[i], &cullUniformBufferMemory[i] });
+
+		Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, indirectSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			&earlyIndirectBuffers[i], &earlyIndirectBufferMemory[i] });
+
+		Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, indirectSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			&lateIndirectBuffers[i], &lateIndirectBufferMemory[i] });
+	}
+}
+
+void Renderer::OcclusionCuller::DestroyDrawBuffers()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	for (size_t i = 0; i < drawDataBuffers.size(); i++)
+	{
+		vkDestroyBuffer(device, drawDataBuffers[i], nullptr);
+		Utils::FreeMemory(device, drawDataBufferMemory[i]);
+		vkDestroyBuffer(device, cullUniformBuffers[i], nullptr);
+		Utils::FreeMemory(device, cullUniformBufferMemory[i]);
+		vkDestroyBuffer(device, earlyIndirectBuffers[i], nullptr);
+		Utils::FreeMemory(device, earlyIndirectBufferMemory[i]);
+		vkDestroyBuffer(device, lateIndirectBuffers[i], nullptr);
+		Utils::FreeMemory(device, lateIndirectBufferMemory[i]);
+	}
+
+	drawDataBuffers.clear();
+	drawDataBufferMemory.clear();
+	cullUniformBuffers.clear();
+	cullUniformBufferMemory.clear();
+	earlyIndirectBuffers.clear();
+	earlyIndirectBufferMemory.clear();
+	lateIndirectBuffers.clear();
+	lateIndirectBufferMemory.clear();
+}
+
+void Renderer::OcclusionCuller::WriteCullDescriptorSets()
+{
+	PROFILE_FUNCTION();
+
+	for (size_t i = 0; i < cullSets.size(); i++)
+	{
+		std::array<VkDescriptorBufferInfo, 4> bufferInfos = {};
+		bufferInfos[0] = { cullUniformBuffers[i], 0, sizeof(CullUniforms) };
+		bufferInfos[1] = { drawDataBuffers[i], 0, VK_WHOLE_SIZE };
+		bufferInfos[2] = { earlyIndirectBuffers[i], 0, VK_WHOLE_SIZE };
+		bufferInfos[3] = { lateIndirectBuffers[i], 0, VK_WHOLE_SIZE };
+
+		VkDescriptorImageInfo pyramidInfo = {};
+		pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		pyramidInfo.imageView = depthPyramidView;
+		pyramidInfo.sampler = depthSampler;
+
+		std::array<VkWriteDescriptorSet, 5> setWrites = {};
+		for (uint32_t binding = 0; binding < setWrites.size(); binding++)
+		{
+			setWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			setWrites[binding].dstSet = cullSets[i];
+			setWrites[binding].dstBinding = binding;
+			setWrites[binding].descriptorCount = 1;
+
+			if (binding < bufferInfos.size())
+			{
+				setWrites[binding].descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				setWrites[binding].pBufferInfo = &bufferInfos[binding];
+			}
+			else
+			{
+				setWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				setWrites[binding].pImageInfo = &pyramidInfo;
+			}
+		}
+
+		vkUpdateDescriptorSets(createInfo.device.logicalDevice, static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+#include <vector>
+#include "Utils.h"
+#include "BoundingVolumes.h"
+
+namespace Renderer
+{
+	using namespace Utilities;
+
+	/**
+	* GPU occlusion culling against a hierarchical depth (Hi-Z) pyramid, done in two phases per frame :
+	* EARLY tests every draw against the pyramid built last frame, LATE rebuilds the pyramid from the early depth
+	* and retests the draws EARLY rejected so disoccluded objects are drawn the same frame they appear
+	*/
+	class OcclusionCuller
+	{
+	public:
+		enum class CullPhase { EARLY, LATE };
+
+		struct OcclusionCullerCreateInfo
+		{
+			DeviceHandle device;
+			VkQueue queue;
+			VkCommandPool commandPool;
+			VkExtent2D extent;
+			size_t frameCount = 0; // Frames in flight, uniforms and descriptor sets are created once per frame
+			VkShaderModule downsampleShaderModule;
+			VkShaderModule cullShaderModule;
+			std::vector<VkImageView> depthBufferImageViews; // One per frame in flight
+		};
+
+		OcclusionCuller() = default;
+		~OcclusionCuller();
+		void Init(const OcclusionCullerCreateInfo& cullerCreateInfo);
+		/** Uploads world bounds and index counts of every draw item, the indirect buffers hold one command per draw item in the same order */
+		void UpdateDrawData(uint32_t frameIndex, const BoundingBoxSoA& bounds, const std::vector<uint32_t>& indexCounts, const glm::mat4& viewProjection);
+		void RecordCullPass(VkCommandBuffer commandBuffer, uint32_t frameIndex, CullPhase phase);
+		/** Depth of the early pass must be in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL */
+		void RecordDepthPyramid(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		VkBuffer GetIndirectBuffer(uint32_t frameIndex, CullPhase phase) const;
+		void SetEnabled(bool enabled);
+		bool IsEnabled() const;
+
+	private:
+		struct DrawCullData
+		{
+			glm::vec3 center;
+			uint32_t indexCount;
+			glm::vec3 extents;
+			uint32_t firstTriangle; // Triangles of the draws before this one, the visibility buffer numbers each draw's triangles from it
+		};
+
+		struct CullUniforms
+		{
+			glm::mat4 viewProjection;
+			glm::mat4 pyramidViewProjection; // View projection the pyramid depth was rendered with
+			glm::vec2 pyramidSize;
+			uint32_t drawCount;
+			uint32_t occlusionEnabled;
+		};
+
+		struct DownsamplePushConstants
+		{
+			glm::ivec2 sourceSize;
+			glm::ivec2 destinationSize;
+		};
+
+		static constexpr uint32_t CULL_GROUP_SIZE = 64;
+		static constexpr uint32_t DOWNSAMPLE_GROUP_SIZE = 8;
+		static constexpr uint32_t MIN_DRAW_CAPACITY = 256;
+
+		OcclusionCullerCreateInfo createInfo;
+		bool enabled = true;
+		uint32_t drawCapacity = 0;
+		uint32_t drawCount = 0;
+		glm::mat4 pyramidViewProjection = glm::mat4(1.0f);
+
+		VkImage depthPyramidImage = nullptr;
+		VkDeviceMemory depthPyramidMemory = nullptr;
+		VkImageView depthPyramidView = nullptr; // All mip levels, sampled by the cull pass
+		std::vector<VkImageView> depthPyramidMipViews; // One per mip level, written by the downsample pass
+		VkExtent2D depthPyramidExtent = {};
+		uint32_t depthPyramidLevels = 0;
+		VkSampler depthSampler = nullptr;
+
+		VkDescriptorSetLayout downsampleSetLayout = nullptr;
+		VkDescriptorSetLayout cullSetLayout = nullptr;
+		VkPipelineLayout downsamplePipelineLayout = nullptr;
+		VkPipelineLayout cullPipelineLayout = nullptr;
+		VkPipeline downsamplePipeline = nullptr;
+		VkPipeline cullPipeline = nullptr;
+
+		VkDescriptorPool descriptorPool = nullptr;
+		std::vector<VkDescriptorSet> depthDownsampleSets; // Per frame in flight, depth buffer to mip 0
+		std::vector<VkDescriptorSet> mipDownsampleSets; // Per mip level, previous level to this level
+		std::vector<VkDescriptorSet> cullSets; // Per frame in flight
+
+		std::vector<VkBuffer> drawDataBuffers;
+		std::vector<VkDeviceMemory> drawDataBufferMemory;
+		std::vector<VkBuffer> cullUniformBuffers;
+		std::vector<VkDeviceMemory> cullUniformBufferMemory;
+		std::vector<VkBuffer> earlyIndirectBuffers;
+		std::vector<VkDeviceMemory> earlyIndirectBufferMemory;
+		std::vector<VkBuffer> lateIndirectBuffers;
+		std::vector<VkDeviceMemory> lateIndirectBufferMemory;
+
+		void CreateDepthPyramid();
+		void CreateSampler();
+		void CreateDescriptorSetLayouts();
+		void CreatePipelines();
+		void CreateDescriptorPool();
+		void CreateDescriptorSets();
+		void CreateDrawBuffers(uint32_t capacity);
+		void DestroyDrawBuffers();
+		void WriteCullDescriptorSets();
+	};
+}
@@ -0,0 +1,629 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+	constexpr uint32_t SUB_BUCKET_COUNT = 1u << Utilities::PROFILE_HISTOGRAM_SUB_BUCKET_BITS;
+	// Values below SUB_BUCKET_COUNT get a bucket each, every power of two above gets SUB_BUCKET_COUNT buckets
+	constexpr uint32_t HISTOGRAM_BUCKET_COUNT = (Utilities::PROFILE_HISTOGRAM_MAX_BITS - Utilities::PROFILE_HISTOGRAM_SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+	uint32_t GetHistogramBucket(uint64_t valueNs)
+	{
+		if (valueNs < SUB_BUCKET_COUNT)
+		{
+			return static_cast<uint32_t>(valueNs);
+		}
+
+		uint32_t highestBit = 0;
+		for (uint64_t remaining = valueNs >> 1; remaining != 0; remaining >>= 1)
+		{
+			highestBit++;
+		}
+
+		const uint32_t shift = highestBit - Utilities::PROFILE_HISTOGRAM_SUB_BUCKET_BITS;
+		const uint32_t subBucket = static_cast<uint32_t>(valueNs >> shift) & (SUB_BUCKET_COUNT - 1);
+		return std::min((shift + 1) * SUB_BUCKET_COUNT + subBucket, HISTOGRAM_BUCKET_COUNT - 1);
+	}
+
+	/** Middle of the range of values that land in the bucket */
+	int64_t GetHistogramBucketValue(uint32_t bucket)
+	{
+		if (bucket < SUB_BUCKET_COUNT)
+		{
+			return bucket;
+		}
+
+		const uint32_t shift = bucket / SUB_BUCKET_COUNT - 1;
+		const uint64_t lowest = static_cast<uint64_t>(SUB_BUCKET_COUNT + bucket % SUB_BUCKET_COUNT) << shift;
+		return static_cast<int64_t>(lowest + ((1ull << shift) >> 1));
+	}
+
+	double NsToMs(double valueNs)
+	{
+		return valueNs / 1e6;
+	}
+
+	const char* COUNTER_NAMES[] = {
+		"Draw calls",
+		"Dispatches",
+		"Pipeline binds",
+		"Descriptor set binds",
+		"Vertex buffer binds",
+		"Pipeline barriers",
+		"Uploaded bytes",
+		"Dropped cluster lights",
+		"Memory allocations",
+		"Device memory bytes",
+	};
+	static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == static_cast<size_t>(Utilities::ProfileCounter::COUNT), "Every counter needs a name");
+
+	/** A counter sample keeps its value where a scope keeps its end */
+	int64_t GetEventEndNs(const Utilities::ProfileEvent& event)
+	{
+		return event.track == Utilities::ProfileTrack::COUNTER ? event.startNs : event.endNs;
+	}
+}
+
+Utilities::ProfileHistogram::ProfileHistogram() : buckets(HISTOGRAM_BUCKET_COUNT, 0)
+{
+}
+
+void Utilities::ProfileHistogram::Add(int64_t valueNs)
+{
+	valueNs = std::max<int64_t>(valueNs, 0);
+
+	buckets[GetHistogramBucket(static_cast<uint64_t>(valueNs))]++;
+	count++;
+	minNs = std::min(minNs, valueNs);
+	maxNs = std::max(maxNs, valueNs);
+	totalNs += valueNs;
+}
+
+int64_t Utilities::ProfileHistogram::GetPercentile(double fraction) const
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	// Rank of the sample the percentile falls on, counting from 1
+	const uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(fraction * count + 0.5), 1);
+	uint64_t seen = 0;
+
+	for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; bucket++)
+	{
+		seen += buckets[bucket];
+		if (seen >= rank)
+		{
+			// The bucket's middle can lie outside what was actually recorded
+			return std::min(std::max(GetHistogramBucketValue(bucket), minNs), maxNs);
+		}
+	}
+
+	return maxNs;
+}
+
+Utilities::ProfileEventRing::ProfileEventRing(uint32_t capacity)
+{
+	uint32_t roundedCapacity = 1;
+	while (roundedCapacity < capacity)
+	{
+		roundedCapacity <<= 1;
+	}
+
+	events.resize(roundedCapacity);
+	mask = roundedCapacity - 1;
+}
+
+Utilities::Profiler::ThreadBuffer::ThreadBuffer(uint32_t threadIndex) : ring(PROFILE_RING_CAPACITY), threadIndex(threadIndex)
+{
+}
+
+Utilities::Profiler& Utilities::Profiler::Get()
+{
+	static Profiler instance;
+	return instance;
+}
+
+Utilities::Profiler::~Profiler()
+{
+	EndSession();
+}
+
+void Utilities::Profiler::BeginSession(const std::string& name, const std::string& filepath /*= "results.json"*/)
+{
+	EndSession();
+
+	flightRecorder = false;
+	summaryPath = filepath.substr(0, filepath.rfind(".json")) + "_summary.json";
+	traceFilepath = filepath;
+
+	StartWriter(name);
+}
+
+void Utilities::Profiler::BeginFlightRecorder(const std::string& name, const FlightRecorderSettings& settings /*= FlightRecorderSettings()*/)
+{
+	EndSession();
+
+	flightRecorder = true;
+	flightRecorderSettings = settings;
+	lastHitchDumpNs = 0;
+	summaryPath = settings.filePrefix + "_summary.json";
+
+	StartWriter(name);
+}
+
+void Utilities::Profiler::StartWriter(const std::string& name)
+{
+	// Whatever was recorded between sessions belongs to neither
+	DrainThreadBuffers(false);
+
+	sessionName = name;
+	lastFrameEndNs = 0;
+	if (!flightRecorder)
+	{
+		outputStream.open(traceFilepath);
+		WriteTraceHeader(outputStream, "");
+	}
+	{
+		std::lock_guard<std::mutex> lock(histogramsMutex);
+		for (std::vector<ProfileHistogram>& trackHistograms : histograms)
+		{
+			trackHistograms.clear();
+		}
+	}
+	dumpRequested.store(false, std::memory_order_relaxed);
+	hitchFrameNs.store(0, std::memory_order_relaxed);
+	writerStop = false;
+	sessionActive.store(true, std::memory_order_relaxed);
+	writerThread = std::thread(&Profiler::WriterLoop, this);
+}
+
+void Utilities::Profiler::EndSession()
+{
+	if (!sessionActive.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	sessionActive.store(false, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lock(writerMutex);
+		writerStop = true;
+	}
+	writerWake.notify_one();
+	writerThread.join();
+
+	// The writer is gone, this thread is the only consumer left
+	DrainThreadBuffers(true);
+	WriteSummary();
+
+	if (flightRecorder)
+	{
+		if (dumpRequested.exchange(false))
+		{
+			WriteFlightRecording();
+		}
+
+		retainedEvents.clear();
+		retainedEventCount.store(0, std::memory_order_relaxed);
+		return;
+	}
+
+	outputStream << "]}";
+	outputStream.close();
+}
+
+void Utilities::Profiler::RequestDump()
+{
+	dumpRequested.store(true, std::memory_order_relaxed);
+}
+
+void Utilities::Profiler::EndFrame()
+{
+	static const uint32_t frameNameId = InternName("Frame");
+	static const std::array<uint32_t, static_cast<size_t>(ProfileCounter::COUNT)> counterNameIds = [this]()
+	{
+		std::array<uint32_t, static_cast<size_t>(ProfileCounter::COUNT)> nameIds;
+		for (size_t counter = 0; counter < nameIds.size(); counter++)
+		{
+			nameIds[counter] = InternName(COUNTER_NAMES[counter]);
+		}
+		return nameIds;
+	}();
+	const int64_t now = Now();
+
+	for (size_t counter = 0; counter < counters.size(); counter++)
+	{
+		frameCounters[counter] = static_cast<ProfileCounter>(counter) == ProfileCounter::DEVICE_MEMORY_BYTES
+			? counters[counter].load(std::memory_order_relaxed) : counters[counter].exchange(0, std::memory_order_relaxed);
+	}
+
+	if (lastFrameEndNs != 0 && sessionActive.load(std::memory_order_relaxed))
+	{
+		RecordScope(frameNameId, lastFrameEndNs, now);
+		for (size_t counter = 0; counter < counters.size(); counter++)
+		{
+			RecordScope(counterNameIds[counter], now, frameCounters[counter], ProfileTrack::COUNTER);
+		}
+
+		// One dump per window, a long stall over several frames would otherwise write the same events again and again
+		const int64_t frameNs = now - lastFrameEndNs;
+		const int64_t windowNs = static_cast<int64_t>(flightRecorderSettings.windowSeconds * 1e9);
+		if (flightRecorder && flightRecorderSettings.frameBudgetMs > 0.0 && frameNs > flightRecorderSettings.frameBudgetMs * 1e6
+			&& (lastHitchDumpNs == 0 || now - lastHitchDumpNs > windowNs))
+		{
+			hitchFrameNs.store(frameNs, std::memory_order_relaxed);
+			dumpRequested.store(true, std::memory_order_relaxed);
+			lastHitchDumpNs = now;
+		}
+	}
+
+	lastFrameEndNs = now;
+}
+
+void Utilities::Profiler::TrackAllocation(uint64_t allocation, uint64_t bytes)
+{
+	{
+		std::lock_guard<std::mutex> lock(allocationsMutex);
+		allocationSizes[allocation] = bytes;
+	}
+
+	AddToCounter(ProfileCounter::MEMORY_ALLOCATIONS);
+	AddToCounter(ProfileCounter::DEVICE_MEMORY_BYTES, static_cast<int64_t>(bytes));
+}
+
+void Utilities::Profiler::TrackFree(uint64_t allocation)
+{
+	uint64_t bytes = 0;
+	{
+		std::lock_guard<std::mutex> lock(allocationsMutex);
+		auto it = allocationSizes.find(allocation);
+		if (it == allocationSizes.end())
+		{
+			return;
+		}
+
+		bytes = it->second;
+		allocationSizes.erase(it);
+	}
+
+	AddToCounter(ProfileCounter::DEVICE_MEMORY_BYTES, -static_cast<int64_t>(bytes));
+}
+
+const char* Utilities::Profiler::GetCounterName(ProfileCounter counter)
+{
+	return COUNTER_NAMES[static_cast<size_t>(counter)];
+}
+
+uint32_t Utilities::Profiler::InternName(const char* name)
+{
+	std::lock_guard<std::mutex> lock(namesMutex);
+
+	auto pointerIt = nameIdsByPointer.find(name);
+	if (pointerIt != nameIdsByPointer.end())
+	{
+		return pointerIt->second;
+	}
+
+	// Cleaned once here instead of for every event
+	std::string cleanName = name;
+	std::replace(cleanName.begin(), cleanName.end(), '"', '\'');
+	std::replace(cleanName.begin(), cleanName.end(), '\\', '/');
+
+	const std::string toEraseStr("__cdecl");
+	const size_t pos = cleanName.find(toEraseStr);
+	if (pos != std::string::npos)
+	{
+		cleanName.erase(pos, toEraseStr.length());
+	}
+
+	auto stringIt = nameIdsByString.find(cleanName);
+	uint32_t nameId = 0;
+
+	if (stringIt != nameIdsByString.end())
+	{
+		nameId = stringIt->second;
+	}
+	else
+	{
+		nameId = static_cast<uint32_t>(names.size());
+		names.push_back(cleanName);
+		nameIdsByString[cleanName] = nameId;
+	}
+
+	nameIdsByPointer[name] = nameId;
+	return nameId;
+}
+
+Utilities::Profiler::Statistics Utilities::Profiler::GetStatistics() const
+{
+	Statistics statistics;
+	statistics.writtenEvents = writtenEvents.load(std::memory_order_relaxed);
+	statistics.retainedEvents = retainedEventCount.load(std::memory_order_relaxed);
+	statistics.dumpCount = dumpCount.load(std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> lock(threadsMutex);
+	statistics.threadCount = static_cast<uint32_t>(threadBuffers.size());
+
+	for (const std::unique_ptr<ThreadBuffer>& threadBuffer : threadBuffers)
+	{
+		statistics.droppedEvents += threadBuffer->droppedEvents.load(std::memory_order_relaxed);
+	}
+
+	return statistics;
+}
+
+std::vector<Utilities::Profiler::ScopeSummary> Utilities::Profiler::GetScopeSummaries() const
+{
+	std::vector<ScopeSummary> summaries;
+	{
+		std::lock_guard<std::mutex> lock(histogramsMutex);
+		for (uint32_t track = 0; track < histograms.size(); track++)
+		{
+			for (uint32_t nameId = 0; nameId < histograms[track].size(); nameId++)
+			{
+				if (histograms[track][nameId].GetCount() > 0)
+				{
+					summaries.push_back(Summarise(static_cast<ProfileTrack>(track), nameId));
+				}
+			}
+		}
+	}
+
+	std::sort(summaries.begin(), summaries.end(), [](const ScopeSummary& a, const ScopeSummary& b) { return a.totalMs > b.totalMs; });
+	return summaries;
+}
+
+bool Utilities::Profiler::GetScopeSummary(const std::string& name, ScopeSummary& summary, ProfileTrack track /*= ProfileTrack::CPU*/) const
+{
+	uint32_t nameId = 0;
+	{
+		std::lock_guard<std::mutex> lock(namesMutex);
+		auto it = nameIdsByString.find(name);
+		if (it == nameIdsByString.end())
+		{
+			return false;
+		}
+		nameId = it->second;
+	}
+
+	std::lock_guard<std::mutex> lock(histogramsMutex);
+	const std::vector<ProfileHistogram>& trackHistograms = histograms[static_cast<size_t>(track)];
+	if (nameId >= trackHistograms.size() || trackHistograms[nameId].GetCount() == 0)
+	{
+		return false;
+	}
+
+	summary = Summarise(track, nameId);
+	return true;
+}
+
+Utilities::Profiler::ScopeSummary Utilities::Profiler::Summarise(ProfileTrack track, uint32_t nameId) const
+{
+	const ProfileHistogram& histogram = histograms[static_cast<size_t>(track)][nameId];
+
+	ScopeSummary summary;
+	{
+		std::lock_guard<std::mutex> lock(namesMutex);
+		summary.name = names[nameId];
+	}
+	summary.track = track;
+	summary.count = histogram.GetCount();
+	summary.totalMs = NsToMs(static_cast<double>(histogram.GetTotal()));
+	summary.minMs = NsToMs(static_cast<double>(histogram.GetMin()));
+	summary.meanMs = NsToMs(histogram.GetMean());
+	summary.p50Ms = NsToMs(static_cast<double>(histogram.GetPercentile(0.50)));
+	summary.p95Ms = NsToMs(static_cast<double>(histogram.GetPercentile(0.95)));
+	summary.p99Ms = NsToMs(static_cast<double>(histogram.GetPercentile(0.99)));
+	summary.maxMs = NsToMs(static_cast<double>(histogram.GetMax()));
+	return summary;
+}
+
+Utilities::Profiler::ThreadBuffer* Utilities::Profiler::RegisterThread()
+{
+	std::lock_guard<std::mutex> lock(threadsMutex);
+
+	threadBuffers.push_back(std::make_unique<ThreadBuffer>(static_cast<uint32_t>(threadBuffers.size())));
+	return threadBuffers.back().get();
+}
+
+void Utilities::Profiler::WriterLoop()
+{
+	std::unique_lock<std::mutex> lock(writerMutex);
+
+	while (!writerStop)
+	{
+		lock.unlock();
+		DrainThreadBuffers(true);
+
+		// The frame that went over budget was recorded before it asked, so this drain already has it
+		if (flightRecorder && dumpRequested.exchange(false))
+		{
+			WriteFlightRecording();
+		}
+		lock.lock();
+
+		writerWake.wait_for(lock, std::chrono::milliseconds(PROFILE_WRITER_INTERVAL_MS), [this]() { return writerStop; });
+	}
+}
+
+void Utilities::Profiler::DrainThreadBuffers(bool keepEvents)
+{
+	// Threads registering meanwhile are picked up next time
+	std::vector<ThreadBuffer*> buffers;
+	{
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		for (const std::unique_ptr<ThreadBuffer>& threadBuffer : threadBuffers)
+		{
+			buffers.push_back(threadBuffer.get());
+		}
+	}
+
+	size_t drainedEvents = 0;
+	std::unique_lock<std::mutex> histogramsLock(histogramsMutex, std::defer_lock);
+	if (keepEvents)
+	{
+		histogramsLock.lock();
+	}
+
+	auto addToHistogram = [&](const ProfileEvent& event)
+	{
+		if (event.track == ProfileTrack::COUNTER)
+		{
+			return;
+		}
+
+		std::vector<ProfileHistogram>& trackHistograms = histograms[static_cast<size_t>(event.track)];
+		if (event.nameId >= trackHistograms.size())
+		{
+			trackHistograms.resize(event.nameId + 1);
+		}
+		trackHistograms[event.nameId].Add(event.endNs - event.startNs);
+	};
+
+	for (ThreadBuffer* threadBuffer : buffers)
+	{
+		if (keepEvents && flightRecorder)
+		{
+			drainedEvents += threadBuffer->ring.Drain([&](const ProfileEvent& event)
+				{
+					addToHistogram(event);
+					retainedEvents.push_back({ event, threadBuffer->threadIndex });
+				});
+		}
+		else if (keepEvents)
+		{
+			drainedEvents += threadBuffer->ring.Drain([&](const ProfileEvent& event)
+				{
+					addToHistogram(event);
+					WriteEvent(outputStream, event, threadBuffer->threadIndex);
+				});
+		}
+		else
+		{
+			threadBuffer->ring.Drain([](const ProfileEvent&) {});
+		}
+	}
+
+	if (histogramsLock.owns_lock())
+	{
+		histogramsLock.unlock();
+	}
+
+	if (drainedEvents == 0)
+	{
+		return;
+	}
+
+	writtenEvents.fetch_add(drainedEvents, std::memory_order_relaxed);
+
+	if (flightRecorder)
+	{
+		TrimRetainedEvents();
+	}
+	else
+	{
+		outputStream.flush();
+	}
+}
+
+void Utilities::Profiler::TrimRetainedEvents()
+{
+	const int64_t cutoffNs = Now() - static_cast<int64_t>(flightRecorderSettings.windowSeconds * 1e9);
+
+	while (!retainedEvents.empty() && (GetEventEndNs(retainedEvents.front().event) < cutoffNs || retainedEvents.size() > flightRecorderSettings.maxEvents))
+	{
+		retainedEvents.pop_front();
+	}
+
+	retainedEventCount.store(retainedEvents.size(), std::memory_order_relaxed);
+}
+
+void Utilities::Profiler::WriteFlightRecording()
+{
+	TrimRetainedEvents();
+
+	const uint64_t dumpIndex = dumpCount.load(std::memory_order_relaxed);
+	const int64_t frameNs = hitchFrameNs.exchange(0);
+
+	std::ofstream dumpStream(flightRecorderSettings.filePrefix + "_" + std::to_string(dumpIndex) + ".json");
+	WriteTraceHeader(dumpStream, frameNs > 0 ? "Frame took " + std::to_string(frameNs / 1e6) + " ms" : "Requested");
+
+	for (const RetainedEvent& retained : retainedEvents)
+	{
+		WriteEvent(dumpStream, retained.event, retained.threadIndex);
+	}
+
+	dumpStream << "]}";
+	dumpStream.close();
+
+	dumpCount.store(dumpIndex + 1, std::memory_order_relaxed);
+}
+
+void Utilities::Profiler::WriteSummary()
+{
+	const std::vector<ScopeSummary> summaries = GetScopeSummaries();
+
+	std::ofstream summaryStream(summaryPath);
+	summaryStream << "{\"session\":\"" << sessionName << "\",\"scopes\":[";
+
+	for (size_t i = 0; i < summaries.size(); i++)
+	{
+		const ScopeSummary& summary = summaries[i];
+
+		char line[1024];
+		const int length = snprintf(line, sizeof(line),
+			"%s\n{\"name\":\"%s\",\"track\":\"%s\",\"count\":%llu,\"totalMs\":%.4f,\"minMs\":%.4f,\"meanMs\":%.4f,\"p50Ms\":%.4f,\"p95Ms\":%.4f,\"p99Ms\":%.4f,\"maxMs\":%.4f}",
+			i > 0 ? "," : "", summary.name.c_str(), summary.track == ProfileTrack::GPU ? "GPU" : "CPU", static_cast<unsigned long long>(summary.count), summary.totalMs, summary.minMs, summary.meanMs,
+			summary.p50Ms, summary.p95Ms, summary.p99Ms, summary.maxMs);
+
+		summaryStream.write(line, std::min(length, static_cast<int>(sizeof(line)) - 1));
+	}
+
+	summaryStream << "\n]}";
+}
+
+void Utilities::Profiler::WriteTraceHeader(std::ofstream& stream, const std::string& reason) const
+{
+	stream << "{\"otherData\": {\"session\":\"" << sessionName << "\"";
+	if (!reason.empty())
+	{
+		stream << ",\"reason\":\"" << reason << "\"";
+	}
+	stream << "},\"traceEvents\":[";
+
+	// Chrome's trace viewer draws every process as its own group, GPU scopes go under pid 1 with the GPU as its one thread
+	stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}}";
+	stream << ",{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}";
+	stream << ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Graphics queue\"}}";
+}
+
+void Utilities::Profiler::WriteEvent(std::ofstream& stream, const ProfileEvent& event, uint32_t threadIndex)
+{
+	if (event.nameId >= writerNames.size())
+	{
+		std::lock_guard<std::mutex> lock(namesMutex);
+		writerNames = names;
+	}
+
+	// Formatted into one buffer, stream insertion of every field is several times slower
+	char line[512];
+	if (event.track == ProfileTrack::COUNTER)
+	{
+		const int length = snprintf(line, sizeof(line), ",{\"name\":\"%s\",\"ph\":\"C\",\"pid\":0,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+			writerNames[event.nameId].c_str(), event.startNs / 1000.0, static_cast<long long>(event.endNs));
+
+		stream.write(line, std::min(length, static_cast<int>(sizeof(line)) - 1));
+		return;
+	}
+
+	const bool gpu = event.track == ProfileTrack::GPU;
+	const int length = snprintf(line, sizeof(line), ",{\"cat\":\"%s\",\"dur\":%.3f,\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f}",
+		gpu ? "gpu" : "function", (event.endNs - event.startNs) / 1000.0, writerNames[event.nameId].c_str(), gpu ? 1u : 0u, gpu ? 0u : threadIndex,
+		event.startNs / 1000.0);
+
+	stream.write(line, std::min(length, static_cast<int>(sizeof(line)) - 1));
+}
@@ -0,0 +1,338 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Utilities
+{
+	/** Timeline a scope is drawn on, GPU scopes are recorded by whichever thread read their timestamps back */
+	enum class ProfileTrack : uint32_t
+	{
+		CPU,
+		GPU,
+		COUNTER, // Counter samples, drawn as graphs instead of scopes
+		COUNT
+	};
+
+	/** Work counted as the renderer records it. Every counter but DEVICE_MEMORY_BYTES starts again from zero each frame */
+	enum class ProfileCounter : uint32_t
+	{
+		DRAW_CALLS,
+		DISPATCHES,
+		PIPELINE_BINDS,
+		DESCRIPTOR_SET_BINDS,
+		VERTEX_BUFFER_BINDS,
+		PIPELINE_BARRIERS,
+		UPLOADED_BYTES,
+		DROPPED_CLUSTER_LIGHTS, // Lights left out of a cluster's list because the index list was full
+		MEMORY_ALLOCATIONS,
+		DEVICE_MEMORY_BYTES, // Device memory allocated and not yet freed
+		COUNT
+	};
+
+	/** One finished scope. Names are interned once per call site, so recording copies no strings */
+	struct ProfileEvent
+	{
+		int64_t startNs;
+		int64_t endNs; // Value of a counter sample, which happens at startNs
+		uint32_t nameId;
+		ProfileTrack track; // Fits in what would be padding
+	};
+
+	/**
+	* Single producer, single consumer ring of profile events. Only the owning thread pushes and only the profiler's writer drains,
+	* so neither side takes a lock. A full ring drops the event instead of making the recording thread wait
+	*/
+	class ProfileEventRing
+	{
+	public:
+		/** Capacity is rounded up to a power of two */
+		explicit ProfileEventRing(uint32_t capacity);
+
+		bool Push(const ProfileEvent& event)
+		{
+			const uint64_t head = writeIndex.load(std::memory_order_relaxed);
+			if (head - readIndex.load(std::memory_order_acquire) == events.size())
+			{
+				return false;
+			}
+
+			events[head & mask] = event;
+			writeIndex.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		/** Hands every event pushed so far to func in order, returns how many there were */
+		template<typename Func>
+		size_t Drain(Func&& func)
+		{
+			uint64_t tail = readIndex.load(std::memory_order_relaxed);
+			const uint64_t head = writeIndex.load(std::memory_order_acquire);
+			const size_t count = static_cast<size_t>(head - tail);
+
+			for (; tail != head; tail++)
+			{
+				func(events[tail & mask]);
+			}
+
+			readIndex.store(tail, std::memory_order_release);
+			return count;
+		}
+
+	private:
+		std::vector<ProfileEvent> events;
+		uint64_t mask = 0;
+		alignas(64) std::atomic<uint64_t> writeIndex{ 0 };
+		alignas(64) std::atomic<uint64_t> readIndex{ 0 }; // Own cache line, the writer and recording thread don't share one
+	};
+
+	/**
+	* Log-linear histogram of scope durations in the style of HDR histograms. Every power of two is split into the same number of
+	* buckets, so percentiles stay within about 3% of the real value from nanoseconds to minutes in a fixed 10 KB
+	*/
+	class ProfileHistogram
+	{
+	public:
+		ProfileHistogram();
+
+		void Add(int64_t valueNs);
+		uint64_t GetCount() const
+		{
+			return count;
+		}
+		int64_t GetMin() const
+		{
+			return count > 0 ? minNs : 0;
+		}
+		int64_t GetMax() const
+		{
+			return maxNs;
+		}
+		int64_t GetTotal() const
+		{
+			return totalNs;
+		}
+		double GetMean() const
+		{
+			return count > 0 ? static_cast<double>(totalNs) / count : 0.0;
+		}
+		/** Duration the given fraction of samples took at most, 0.99 for p99 */
+		int64_t GetPercentile(double fraction) const;
+
+	private:
+		std::vector<uint64_t> buckets;
+		uint64_t count = 0;
+		int64_t minNs = INT64_MAX;
+		int64_t maxNs = 0;
+		int64_t totalNs = 0;
+	};
+
+	/** Flight recorder sessions keep only the recent past in memory and write it out when something goes wrong */
+	struct FlightRecorderSettings
+	{
+		double windowSeconds = 10.0;
+		double frameBudgetMs = 50.0; // Frames slower than this dump the window, 0 only dumps on request
+		size_t maxEvents = 1 << 21; // Caps memory when scopes are dense, the oldest go first
+		std::string filePrefix = "flight_recording"; // Dumps are written to <filePrefix>_<n>.json
+	};
+
+	/**
+	* Chrome trace profiler behind PROFILE_SCOPE and PROFILE_FUNCTION. Every thread records into its own ring, a background writer
+	* drains them into the trace file, so recording is a clock read and a few stores with no lock, formatting or file access.
+	* In flight recorder mode the writer keeps the last few seconds of events instead and only writes them out on a hitch or on request
+	*/
+	class Profiler
+	{
+	public:
+		struct Statistics
+		{
+			uint64_t writtenEvents = 0; // Drained from the rings, into the trace or the flight recorder's window
+			uint64_t droppedEvents = 0; // Rings that were full when their thread recorded
+			uint32_t threadCount = 0; // Threads that have recorded at least once
+			uint64_t retainedEvents = 0; // In the flight recorder's window
+			uint64_t dumpCount = 0; // Flight recordings written this run
+		};
+
+		using CounterValues = std::array<int64_t, static_cast<size_t>(ProfileCounter::COUNT)>;
+
+		/** Aggregated durations of one scope name over the current session */
+		struct ScopeSummary
+		{
+			std::string name;
+			ProfileTrack track = ProfileTrack::CPU;
+			uint64_t count = 0;
+			double totalMs = 0.0;
+			double minMs = 0.0;
+			double meanMs = 0.0;
+			double p50Ms = 0.0;
+			double p95Ms = 0.0;
+			double p99Ms = 0.0;
+			double maxMs = 0.0;
+		};
+
+		static Profiler& Get();
+		~Profiler();
+
+		/** Starts the writer, events recorded before a session are discarded. Scope statistics go to <filepath>_summary.json at the end */
+		void BeginSession(const std::string& name, const std::string& filepath = "results.json");
+		/** Starts the writer without a trace file, the last settings.windowSeconds of events are kept in memory until dumped.
+		* Scope statistics cover the whole session and go to <filePrefix>_summary.json at the end */
+		void BeginFlightRecorder(const std::string& name, const FlightRecorderSettings& settings = FlightRecorderSettings());
+		/** Stops the writer after it has written everything recorded so far, a flight recorder writes a dump only if one is pending */
+		void EndSession();
+		/** Has the writer dump the flight recorder's window on its next pass */
+		void RequestDump();
+		/** Called once per frame from the frame loop's thread. Records the frame as a scope, samples and resets the counters
+		* and dumps the window when the frame ran over budget */
+		void EndFrame();
+		bool IsSessionActive() const
+		{
+			return sessionActive.load(std::memory_order_relaxed);
+		}
+
+		/** Names are expected to live as long as the profiler, string literals and __FUNCSIG__ */
+		uint32_t InternName(const char* name);
+		Statistics GetStatistics() const;
+		/** Every scope seen this session as of the writer's last pass, most total time first */
+		std::vector<ScopeSummary> GetScopeSummaries() const;
+		/** Looks a scope up by its name as it appears in the trace, false if it hasn't finished yet this session */
+		bool GetScopeSummary(const std::string& name, ScopeSummary& summary, ProfileTrack track = ProfileTrack::CPU) const;
+
+		/** Counts whether or not a session is active, so the values are there for the application as well as the trace */
+		void AddToCounter(ProfileCounter counter, int64_t amount = 1)
+		{
+			counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+		}
+		/** Adds to MEMORY_ALLOCATIONS and DEVICE_MEMORY_BYTES, the size is kept until the allocation is freed */
+		void TrackAllocation(uint64_t allocation, uint64_t bytes);
+		void TrackFree(uint64_t allocation);
+		/** Counters of the last frame EndFrame closed, read from the frame loop's thread */
+		const CounterValues& GetFrameCounters() const
+		{
+			return frameCounters;
+		}
+		static const char* GetCounterName(ProfileCounter counter);
+
+		/** GPU scopes are expected on the profiler's clock, Now() */
+		void RecordScope(uint32_t nameId, int64_t startNs, int64_t endNs, ProfileTrack track = ProfileTrack::CPU)
+		{
+			if (!sessionActive.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			ThreadBuffer& threadBuffer = GetThreadBuffer();
+			if (!threadBuffer.ring.Push({ startNs, endNs, nameId, track }))
+			{
+				threadBuffer.droppedEvents.store(threadBuffer.droppedEvents.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			}
+		}
+
+		static int64_t Now()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+	private:
+		struct ThreadBuffer
+		{
+			ProfileEventRing ring;
+			uint32_t threadIndex;
+			std::atomic<uint64_t> droppedEvents{ 0 }; // Only written by the owning thread
+
+			explicit ThreadBuffer(uint32_t threadIndex);
+		};
+
+		std::atomic<bool> sessionActive{ false };
+		std::string sessionName;
+		std::string traceFilepath;
+		std::ofstream outputStream;
+
+		// Threads register once, their buffers are kept until the profiler is destroyed
+		mutable std::mutex threadsMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+
+		mutable std::mutex namesMutex;
+		std::vector<std::string> names; // Indexed by name id, cleaned up for the trace
+		std::unordered_map<const char*, uint32_t> nameIdsByPointer;
+		std::unordered_map<std::string, uint32_t> nameIdsByString; // Same function through different pointers
+		std::vector<std::string> writerNames; // Writer's copy, refreshed when it meets a new id
+
+		std::thread writerThread;
+		std::mutex writerMutex;
+		std::condition_variable writerWake;
+		bool writerStop = false;
+		std::atomic<uint64_t> writtenEvents{ 0 };
+
+		// Fed by the writer as it drains, so recording threads never touch them
+		mutable std::mutex histogramsMutex;
+		std::array<std::vector<ProfileHistogram>, static_cast<size_t>(ProfileTrack::COUNT)> histograms; // Indexed by track, then name id
+		std::string summaryPath;
+
+		struct RetainedEvent
+		{
+			ProfileEvent event;
+			uint32_t threadIndex;
+		};
+
+		bool flightRecorder = false; // Set before the writer starts
+		FlightRecorderSettings flightRecorderSettings;
+		std::deque<RetainedEvent> retainedEvents; // Writer only, roughly in end time order since rings are drained one after another
+		std::atomic<uint64_t> retainedEventCount{ 0 };
+		std::atomic<bool> dumpRequested{ false };
+		std::atomic<int64_t> hitchFrameNs{ 0 }; // Frame that requested the pending dump, 0 when it was requested by hand
+		std::atomic<uint64_t> dumpCount{ 0 };
+		int64_t lastFrameEndNs = 0; // Frame loop's thread only
+		int64_t lastHitchDumpNs = 0;
+
+		std::array<std::atomic<int64_t>, static_cast<size_t>(ProfileCounter::COUNT)> counters{};
+		CounterValues frameCounters{}; // Frame loop's thread only
+		std::mutex allocationsMutex;
+		std::unordered_map<uint64_t, uint64_t> allocationSizes; // Allocations are rare, a lock is cheap enough
+
+		Profiler() = default;
+
+		ThreadBuffer& GetThreadBuffer()
+		{
+			static thread_local ThreadBuffer* threadBuffer = nullptr;
+			if (threadBuffer == nullptr)
+			{
+				threadBuffer = RegisterThread();
+			}
+
+			return *threadBuffer;
+		}
+
+		ThreadBuffer* RegisterThread();
+		void StartWriter(const std::string& name);
+		void WriterLoop();
+		/** Drains every thread's ring, writing or retaining the events when keepEvents is set and discarding them otherwise */
+		void DrainThreadBuffers(bool keepEvents);
+		/** Forgets retained events older than the window, or past the cap */
+		void TrimRetainedEvents();
+		void WriteFlightRecording();
+		void WriteSummary();
+		ScopeSummary Summarise(ProfileTrack track, uint32_t nameId) const;
+		/** Opens traceEvents with the names of the CPU and GPU processes every event is written under */
+		void WriteTraceHeader(std::ofstream& stream, const std::string& reason) const;
+		/** Events follow the header's metadata, so each starts with a comma. Counter samples are written as Chrome's counter events */
+		void WriteEvent(std::ofstream& stream, const ProfileEvent& event, uint32_t threadIndex);
+	};
+
+	/** Ring size per thread, the writer drains every PROFILE_WRITER_INTERVAL_MS so this covers bursts of a few million scopes a second */
+	constexpr uint32_t PROFILE_RING_CAPACITY = 1 << 16;
+	constexpr uint32_t PROFILE_WRITER_INTERVAL_MS = 5;
+	// 32 buckets per power of two up to 2^40 ns, about 18 minutes, longer scopes land in the last bucket
+	constexpr uint32_t PROFILE_HISTOGRAM_SUB_BUCKET_BITS = 5;
+	constexpr uint32_t PROFILE_HISTOGRAM_MAX_BITS = 40;
+}
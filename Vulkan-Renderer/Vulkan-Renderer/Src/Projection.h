@@ -0,0 +1,17 @@
+#pragma once
+#include <GLM/glm.hpp>
+
+namespace Renderer
+{
+	/** Near plane of a zero to one depth perspective projection */
+	inline float GetProjectionNearPlane(const glm::mat4& projection)
+	{
+		return projection[3][2] / projection[2][2];
+	}
+
+	/** Far plane of a zero to one depth perspective projection */
+	inline float GetProjectionFarPlane(const glm::mat4& projection)
+	{
+		return projection[3][2] / (projection[2][2] + 1.0f);
+	}
+}
@@ -0,0 +1,939 @@
+#include "RenderGraph.h"
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <vulkan/vk_enum_string_helper.h>
+
+namespace
+{
+	constexpr VkAccessFlags WRITE_ACCESS_MASK = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+	/** What happened to a resource since its last write, and whether it all happened inside one render pass */
+	struct ResourceSyncState
+	{
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags writeStages = 0;
+		VkAccessFlags writeAccess = 0;
+		VkPipelineStageFlags readStages = 0; // Since the last write
+		VkPipelineStageFlags visibleStages = 0; // Reads the last write has already been made visible to
+		VkAccessFlags visibleAccess = 0;
+		int32_t renderPass = -1; // Render pass some of those accesses were in
+		uint32_t subpassMask = 0; // and their subpasses
+		bool outside = true; // Some were outside it, in a compute pass, another render pass or a previous frame
+	};
+
+	bool IsWriteAccess(Renderer::RenderGraphAccess access)
+	{
+		return access == Renderer::RenderGraphAccess::COLOUR_ATTACHMENT || access == Renderer::RenderGraphAccess::DEPTH_ATTACHMENT
+			|| access == Renderer::RenderGraphAccess::COMPUTE_STORAGE_WRITE;
+	}
+
+	bool IsAttachmentAccess(Renderer::RenderGraphAccess access)
+	{
+		return access == Renderer::RenderGraphAccess::COLOUR_ATTACHMENT || access == Renderer::RenderGraphAccess::DEPTH_ATTACHMENT
+			|| access == Renderer::RenderGraphAccess::DEPTH_ATTACHMENT_READ_ONLY || access == Renderer::RenderGraphAccess::INPUT_ATTACHMENT;
+	}
+
+	bool Discards(Renderer::RenderGraphAccess access, Renderer::RenderGraphLoad load)
+	{
+		return IsWriteAccess(access) && load != Renderer::RenderGraphLoad::LOAD;
+	}
+
+	uint32_t FindAttachment(const Renderer::CompiledRenderGraph::RenderPass& renderPass, Renderer::RenderGraphResource resource)
+	{
+		uint32_t attachmentIndex = 0;
+		while (attachmentIndex < renderPass.attachments.size() && renderPass.attachments[attachmentIndex].resource != resource)
+		{
+			attachmentIndex++;
+		}
+
+		return attachmentIndex;
+	}
+
+	void ApplyUse(ResourceSyncState& state, const Renderer::RenderGraphState& useState, bool isWrite, int32_t renderPass, uint32_t subpass)
+	{
+		if (isWrite)
+		{
+			state.writeStages = useState.stages;
+			state.writeAccess = useState.access & WRITE_ACCESS_MASK;
+			state.readStages = 0;
+			state.visibleStages = 0;
+			state.visibleAccess = 0;
+			state.renderPass = renderPass;
+			state.subpassMask = renderPass >= 0 ? 1u << subpass : 0;
+			state.outside = renderPass < 0;
+		}
+		else
+		{
+			state.readStages |= useState.stages;
+
+			if (renderPass >= 0 && (state.renderPass == renderPass || (state.renderPass < 0 && state.subpassMask == 0)))
+			{
+				state.renderPass = renderPass;
+				state.subpassMask |= 1u << subpass;
+			}
+			else
+			{
+				state.outside = true;
+			}
+		}
+
+		state.layout = useState.layout;
+	}
+
+	/** Dependencies between the same subpasses are merged into one */
+	void AddDependency(Renderer::CompiledRenderGraph::RenderPass& renderPass, uint32_t srcSubpass, uint32_t dstSubpass,
+		const Renderer::RenderGraphState& src, const Renderer::RenderGraphState& dst, VkDependencyFlags flags)
+	{
+		const VkPipelineStageFlags srcStages = src.stages != 0 ? src.stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+		const VkPipelineStageFlags dstStages = dst.stages != 0 ? dst.stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+		for (VkSubpassDependency& dependency : renderPass.dependencies)
+		{
+			if (dependency.srcSubpass == srcSubpass && dependency.dstSubpass == dstSubpass && dependency.dependencyFlags == flags)
+			{
+				dependency.srcStageMask |= srcStages;
+				dependency.dstStageMask |= dstStages;
+				dependency.srcAccessMask |= src.access;
+				dependency.dstAccessMask |= dst.access;
+				return;
+			}
+		}
+
+		VkSubpassDependency dependency = {};
+		dependency.srcSubpass = srcSubpass;
+		dependency.dstSubpass = dstSubpass;
+		dependency.srcStageMask = srcStages;
+		dependency.dstStageMask = dstStages;
+		dependency.srcAccessMask = src.access;
+		dependency.dstAccessMask = dst.access;
+		dependency.dependencyFlags = flags;
+		renderPass.dependencies.push_back(dependency);
+	}
+
+	VkDeviceSize AlignUp(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		return (size + alignment - 1) / alignment * alignment;
+	}
+}
+
+const Renderer::CompiledRenderGraph::Pass* Renderer::CompiledRenderGraph::FindPass(RenderGraphPass pass) const
+{
+	for (const Pass& compiledPass : passes)
+	{
+		if (compiledPass.pass == pass)
+		{
+			return &compiledPass;
+		}
+	}
+
+	return nullptr;
+}
+
+const Renderer::CompiledRenderGraph::RenderPass* Renderer::CompiledRenderGraph::FindRenderPass(RenderGraphPass pass) const
+{
+	const Pass* compiledPass = FindPass(pass);
+	return compiledPass != nullptr && compiledPass->renderPass >= 0 ? &renderPasses[compiledPass->renderPass] : nullptr;
+}
+
+Renderer::RenderGraphResource Renderer::RenderGraph::CreateImage(const std::string& name, const RenderGraphImageDesc& desc)
+{
+	Resource resource;
+	resource.name = name;
+	resource.image = desc;
+	resources.push_back(resource);
+
+	return static_cast<RenderGraphResource>(resources.size() - 1);
+}
+
+Renderer::RenderGraphResource Renderer::RenderGraph::CreateBuffer(const std::string& name, VkDeviceSize size)
+{
+	Resource resource;
+	resource.name = name;
+	resource.bufferSize = size;
+	resource.isBuffer = true;
+	resources.push_back(resource);
+
+	return static_cast<RenderGraphResource>(resources.size() - 1);
+}
+
+Renderer::RenderGraphResource Renderer::RenderGraph::ImportImage(const std::string& name, const RenderGraphImageDesc& desc,
+	const RenderGraphState& before, const RenderGraphState& after)
+{
+	Resource resource;
+	resource.name = name;
+	resource.image = desc;
+	resource.imported = true;
+	resource.before = before;
+	resource.after = after;
+	resources.push_back(resource);
+
+	return static_cast<RenderGraphResource>(resources.size() - 1);
+}
+
+Renderer::RenderGraphResource Renderer::RenderGraph::ImportBuffer(const std::string& name, const RenderGraphState& before, const RenderGraphState& after)
+{
+	Resource resource;
+	resource.name = name;
+	resource.isBuffer = true;
+	resource.imported = true;
+	resource.before = before;
+	resource.after = after;
+	resource.before.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	resource.after.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	resources.push_back(resource);
+
+	return static_cast<RenderGraphResource>(resources.size() - 1);
+}
+
+Renderer::RenderGraphPass Renderer::RenderGraph::AddPass(const std::string& name, RenderGraphPassType type)
+{
+	Pass pass;
+	pass.name = name;
+	pass.type = type;
+	passes.push_back(pass);
+
+	return static_cast<RenderGraphPass>(passes.size() - 1);
+}
+
+void Renderer::RenderGraph::Use(RenderGraphPass pass, RenderGraphResource resource, RenderGraphAccess access, RenderGraphLoad load /*= RenderGraphLoad::LOAD*/)
+{
+	if (pass >= passes.size() || resource >= resources.size())
+	{
+		throw std::runtime_error("Failed to add resource use, Invalid pass or resource");
+	}
+
+	if (load != RenderGraphLoad::LOAD && !IsWriteAccess(access))
+	{
+		throw std::runtime_error("Failed to add resource use, only writes can clear or discard");
+	}
+
+	if (load == RenderGraphLoad::CLEAR && !IsAttachmentAccess(access))
+	{
+		throw std::runtime_error("Failed to add resource use, only attachments can be cleared");
+	}
+
+	if (IsAttachmentAccess(access) && passes[pass].type != RenderGraphPassType::GRAPHICS)
+	{
+		throw std::runtime_error("Failed to add resource use, compute passes have no attachments");
+	}
+
+	passes[pass].uses.push_back({ resource, access, load });
+}
+
+void Renderer::RenderGraph::SetSideEffects(RenderGraphPass pass)
+{
+	passes[pass].sideEffects = true;
+}
+
+void Renderer::RenderGraph::Compile(CompiledRenderGraph& compiled) const
+{
+	compiled = CompiledRenderGraph();
+
+	// Culling, walking back from what is needed after the frame : imported resources, and graph resources whose first use
+	// next frame keeps their contents. A pass is kept when it writes something still needed or has side effects
+	std::vector<bool> live(resources.size(), false);
+	std::vector<bool> used(resources.size(), false);
+	for (const Pass& pass : passes)
+	{
+		for (const ResourceUse& use : pass.uses)
+		{
+			if (!used[use.resource])
+			{
+				used[use.resource] = true;
+				live[use.resource] = !Discards(use.access, use.load);
+			}
+		}
+	}
+
+	for (RenderGraphResource resource = 0; resource < resources.size(); resource++)
+	{
+		live[resource] = live[resource] || resources[resource].imported;
+	}
+
+	std::vector<bool> keepPass(passes.size(), false);
+	for (size_t passIndex = passes.size(); passIndex-- > 0;)
+	{
+		const Pass& pass = passes[passIndex];
+
+		bool keep = pass.sideEffects;
+		for (const ResourceUse& use : pass.uses)
+		{
+			keep = keep || (IsWriteAccess(use.access) && live[use.resource]);
+		}
+
+		if (!keep)
+		{
+			continue;
+		}
+
+		keepPass[passIndex] = true;
+
+		// What came before a clear or discard isn't needed, what the pass reads or loads is
+		for (const ResourceUse& use : pass.uses)
+		{
+			if (Discards(use.access, use.load))
+			{
+				live[use.resource] = false;
+			}
+		}
+
+		for (const ResourceUse& use : pass.uses)
+		{
+			if (!Discards(use.access, use.load))
+			{
+				live[use.resource] = true;
+			}
+		}
+	}
+
+	// Declaration order already has every writer before its readers, culled passes are left out of it
+	for (RenderGraphPass pass = 0; pass < passes.size(); pass++)
+	{
+		if (keepPass[pass])
+		{
+			CompiledRenderGraph::Pass compiledPass;
+			compiledPass.pass = pass;
+			compiled.passes.push_back(compiledPass);
+		}
+		else
+		{
+			compiled.culledPasses.push_back(pass);
+		}
+	}
+
+	// A graphics pass joins the render pass of the one before it as another subpass when it reads that render pass's attachments
+	// only at its own pixel, as input attachments or depth. Anything sampled has to be finished first, so it ends the render pass
+	auto canMerge = [&](const CompiledRenderGraph::RenderPass& renderPass, const Pass& pass)
+	{
+		bool readsAttachment = false;
+
+		for (const ResourceUse& use : pass.uses)
+		{
+			const Resource& resource = resources[use.resource];
+			const bool inRenderPass = FindAttachment(renderPass, use.resource) < renderPass.attachments.size();
+
+			if (inRenderPass && !IsAttachmentAccess(use.access))
+			{
+				return false;
+			}
+
+			if (IsAttachmentAccess(use.access) && (resource.image.width != renderPass.width || resource.image.height != renderPass.height))
+			{
+				return false;
+			}
+
+			readsAttachment = readsAttachment || (inRenderPass && use.access == RenderGraphAccess::INPUT_ATTACHMENT);
+		}
+
+		return readsAttachment;
+	};
+
+	std::vector<uint32_t> renderPassFirstPass;
+	int32_t openRenderPass = -1;
+
+	for (uint32_t passIndex = 0; passIndex < compiled.passes.size(); passIndex++)
+	{
+		CompiledRenderGraph::Pass& compiledPass = compiled.passes[passIndex];
+		const Pass& pass = passes[compiledPass.pass];
+
+		if (pass.type != RenderGraphPassType::GRAPHICS)
+		{
+			openRenderPass = -1;
+			continue;
+		}
+
+		if (openRenderPass < 0 || !canMerge(compiled.renderPasses[openRenderPass], pass))
+		{
+			compiled.renderPasses.emplace_back();
+			renderPassFirstPass.push_back(passIndex);
+			openRenderPass = static_cast<int32_t>(compiled.renderPasses.size() - 1);
+		}
+
+		CompiledRenderGraph::RenderPass& renderPass = compiled.renderPasses[openRenderPass];
+		compiledPass.renderPass = openRenderPass;
+		compiledPass.subpass = static_cast<uint32_t>(renderPass.subpasses.size());
+
+		CompiledRenderGraph::Subpass subpass;
+		subpass.pass = compiledPass.pass;
+
+		for (const ResourceUse& use : pass.uses)
+		{
+			if (!IsAttachmentAccess(use.access))
+			{
+				continue;
+			}
+
+			const Resource& resource = resources[use.resource];
+			if (resource.isBuffer)
+			{
+				throw std::runtime_error("Failed to compile render graph, " + resource.name + " is a buffer used as an attachment");
+			}
+
+			if (renderPass.attachments.empty())
+			{
+				renderPass.width = resource.image.width;
+				renderPass.height = resource.image.height;
+			}
+			else if (resource.image.width != renderPass.width || resource.image.height != renderPass.height)
+			{
+				throw std::runtime_error("Failed to compile render graph, attachments of " + pass.name + " differ in size");
+			}
+
+			const uint32_t attachmentIndex = FindAttachment(renderPass, use.resource);
+			if (attachmentIndex == renderPass.attachments.size())
+			{
+				CompiledRenderGraph::Attachment attachment;
+				attachment.resource = use.resource;
+				attachment.format = resource.image.format;
+				attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				attachment.finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				renderPass.attachments.push_back(attachment);
+			}
+
+			const VkAttachmentReference reference = { attachmentIndex, GetUseState(use).layout };
+
+			if (use.access == RenderGraphAccess::COLOUR_ATTACHMENT)
+			{
+				subpass.colourReferences.push_back(reference);
+			}
+			else if (use.access == RenderGraphAccess::INPUT_ATTACHMENT)
+			{
+				subpass.inputReferences.push_back(reference);
+			}
+			else
+			{
+				subpass.depthReference = reference;
+			}
+		}
+
+		renderPass.subpasses.push_back(subpass);
+	}
+
+	// Uses of every resource in execution order
+	struct ScheduledUse
+	{
+		uint32_t passIndex;
+		ResourceUse use;
+	};
+
+	std::vector<std::vector<ScheduledUse>> resourceUses(resources.size());
+	for (uint32_t passIndex = 0; passIndex < compiled.passes.size(); passIndex++)
+	{
+		for (const ResourceUse& use : passes[compiled.passes[passIndex].pass].uses)
+		{
+			resourceUses[use.resource].push_back({ passIndex, use });
+		}
+	}
+
+	// Memory plan, largest first. Each transient resource goes at the lowest offset free of everything alive at the same time
+	std::vector<RenderGraphResource> transientResources;
+	for (RenderGraphResource resource = 0; resource < resources.size(); resource++)
+	{
+		const std::vector<ScheduledUse>& uses = resourceUses[resource];
+		if (!resources[resource].imported && !uses.empty() && Discards(uses.front().use.access, uses.front().use.load))
+		{
+			transientResources.push_back(resource);
+		}
+	}
+
+	std::stable_sort(transientResources.begin(), transientResources.end(), [&](RenderGraphResource a, RenderGraphResource b)
+		{
+			return GetResourceSize(a) > GetResourceSize(b);
+		});
+
+	for (RenderGraphResource resource : transientResources)
+	{
+		CompiledRenderGraph::Placement placement;
+		placement.resource = resource;
+		placement.size = GetResourceSize(resource);
+		placement.firstPass = resourceUses[resource].front().passIndex;
+		placement.lastPass = resourceUses[resource].back().passIndex;
+
+		std::vector<const CompiledRenderGraph::Placement*> overlapping;
+		for (const CompiledRenderGraph::Placement& placed : compiled.placements)
+		{
+			if (placed.firstPass <= placement.lastPass && placement.firstPass <= placed.lastPass)
+			{
+				overlapping.push_back(&placed);
+			}
+		}
+
+		std::sort(overlapping.begin(), overlapping.end(), [](const CompiledRenderGraph::Placement* a, const CompiledRenderGraph::Placement* b)
+			{
+				return a->offset < b->offset;
+			});
+
+		placement.offset = 0;
+		for (const CompiledRenderGraph::Placement* placed : overlapping)
+		{
+			if (placement.offset + placement.size <= placed->offset)
+			{
+				break;
+			}
+			placement.offset = std::max(placement.offset, placed->offset + placed->size);
+		}
+
+		compiled.transientBytes += placement.size;
+		compiled.aliasedBytes = std::max(compiled.aliasedBytes, placement.offset + placement.size);
+		compiled.placements.push_back(placement);
+	}
+
+	// State every resource is left in by the previous frame : the imported before state, or the graph's own last uses
+	std::vector<ResourceSyncState> states(resources.size());
+	for (RenderGraphResource resource = 0; resource < resources.size(); resource++)
+	{
+		ResourceSyncState& state = states[resource];
+
+		if (resources[resource].imported)
+		{
+			const RenderGraphState& before = resources[resource].before;
+			state.layout = before.layout;
+			state.writeAccess = before.access & WRITE_ACCESS_MASK;
+			state.writeStages = state.writeAccess != 0 ? before.stages : 0;
+			state.readStages = state.writeAccess != 0 ? 0 : before.stages;
+			continue;
+		}
+
+		for (const ScheduledUse& scheduledUse : resourceUses[resource])
+		{
+			ApplyUse(state, GetUseState(scheduledUse.use), IsWriteAccess(scheduledUse.use.access), -1, 0);
+		}
+
+		state.visibleStages = 0;
+		state.visibleAccess = 0;
+		state.renderPass = -1;
+		state.subpassMask = 0;
+		state.outside = true;
+	}
+
+	// Aliased memory was last used by the resources placed there before, they have to be done with it
+	const std::vector<ResourceSyncState> previousFrameStates = states;
+	for (const CompiledRenderGraph::Placement& placement : compiled.placements)
+	{
+		for (const CompiledRenderGraph::Placement& previous : compiled.placements)
+		{
+			const bool sharesMemory = previous.offset < placement.offset + placement.size && placement.offset < previous.offset + previous.size;
+			if (sharesMemory && previous.lastPass < placement.firstPass)
+			{
+				const ResourceSyncState& previousState = previousFrameStates[previous.resource];
+				states[placement.resource].writeStages |= previousState.writeStages;
+				states[placement.resource].writeAccess |= previousState.writeAccess;
+				states[placement.resource].readStages |= previousState.readStages;
+			}
+		}
+	}
+
+	// Barriers, dependencies and attachment operations between consecutive uses of every resource. Hazards inside a render pass
+	// become subpass dependencies, a compute pass right after a render pass is handed the resource by the render pass's final
+	// layout and an outgoing dependency, anything else is synchronized where it's used
+	std::vector<std::vector<bool>> attachmentStarted(compiled.renderPasses.size());
+	for (size_t renderPassIndex = 0; renderPassIndex < compiled.renderPasses.size(); renderPassIndex++)
+	{
+		attachmentStarted[renderPassIndex].resize(compiled.renderPasses[renderPassIndex].attachments.size(), false);
+	}
+
+	for (RenderGraphResource resourceIndex = 0; resourceIndex < resources.size(); resourceIndex++)
+	{
+		const Resource& resource = resources[resourceIndex];
+		ResourceSyncState& state = states[resourceIndex];
+
+		for (const ScheduledUse& scheduledUse : resourceUses[resourceIndex])
+		{
+			CompiledRenderGraph::Pass& compiledPass = compiled.passes[scheduledUse.passIndex];
+			const RenderGraphState useState = GetUseState(scheduledUse.use);
+			const RenderGraphAccess access = scheduledUse.use.access;
+			const bool isWrite = IsWriteAccess(access);
+			const bool discards = Discards(access, scheduledUse.use.load);
+
+			const VkImageLayout oldLayout = discards ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+			const bool layoutChange = !resource.isBuffer && useState.layout != oldLayout;
+
+			RenderGraphState src;
+			src.layout = oldLayout;
+			src.stages = state.writeStages | (isWrite || layoutChange ? state.readStages : 0);
+			src.access = state.writeAccess;
+
+			// Writes wait for every access since the last write, reads only for the write unless it's already visible to them
+			const bool needsDependency = isWrite || layoutChange ? src.stages != 0 || layoutChange
+				: state.writeAccess != 0 && ((useState.stages & ~state.visibleStages) != 0 || (useState.access & ~state.visibleAccess) != 0);
+
+			const int32_t renderPassIndex = compiledPass.renderPass;
+
+			if (renderPassIndex >= 0 && IsAttachmentAccess(access))
+			{
+				CompiledRenderGraph::RenderPass& renderPass = compiled.renderPasses[renderPassIndex];
+				const uint32_t attachmentIndex = FindAttachment(renderPass, resourceIndex);
+				CompiledRenderGraph::Attachment& attachment = renderPass.attachments[attachmentIndex];
+
+				if (!attachmentStarted[renderPassIndex][attachmentIndex])
+				{
+					attachmentStarted[renderPassIndex][attachmentIndex] = true;
+					attachment.initialLayout = oldLayout;
+					attachment.loadOp = scheduledUse.use.load == RenderGraphLoad::CLEAR ? VK_ATTACHMENT_LOAD_OP_CLEAR
+						: oldLayout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_LOAD;
+				}
+
+				attachment.finalLayout = useState.layout;
+			}
+
+			if (needsDependency)
+			{
+				const VkDependencyFlags regionFlags = IsAttachmentAccess(access) ? VK_DEPENDENCY_BY_REGION_BIT : 0;
+
+				if (renderPassIndex >= 0 && state.renderPass == renderPassIndex)
+				{
+					CompiledRenderGraph::RenderPass& renderPass = compiled.renderPasses[renderPassIndex];
+					for (uint32_t subpass = 0; subpass < renderPass.subpasses.size(); subpass++)
+					{
+						if ((state.subpassMask & (1u << subpass)) != 0 && subpass != compiledPass.subpass)
+						{
+							AddDependency(renderPass, subpass, compiledPass.subpass, src, useState, regionFlags);
+						}
+					}
+
+					if (state.outside)
+					{
+						AddDependency(renderPass, VK_SUBPASS_EXTERNAL, compiledPass.subpass, src, useState, 0);
+					}
+				}
+				else if (renderPassIndex < 0 && state.renderPass >= 0 && !state.outside)
+				{
+					CompiledRenderGraph::RenderPass& renderPass = compiled.renderPasses[state.renderPass];
+					const uint32_t attachmentIndex = FindAttachment(renderPass, resourceIndex);
+					const bool isAttachment = attachmentIndex < renderPass.attachments.size();
+
+					if (layoutChange && !isAttachment)
+					{
+						compiledPass.barriers.push_back({ resourceIndex, src, useState });
+					}
+					else
+					{
+						// The render pass's final layout transition changes the layout on the way out
+						for (uint32_t subpass = 0; subpass < renderPass.subpasses.size(); subpass++)
+						{
+							if ((state.subpassMask & (1u << subpass)) != 0)
+							{
+								AddDependency(renderPass, subpass, VK_SUBPASS_EXTERNAL, src, useState, 0);
+							}
+						}
+
+						if (isAttachment)
+						{
+							renderPass.attachments[attachmentIndex].finalLayout = useState.layout;
+						}
+					}
+				}
+				else if (renderPassIndex < 0)
+				{
+					compiledPass.barriers.push_back({ resourceIndex, src, useState });
+				}
+				else if (!IsAttachmentAccess(access) && layoutChange)
+				{
+					// Only attachments can change layout inside a render pass, anything else is transitioned before it begins
+					compiled.passes[renderPassFirstPass[renderPassIndex]].barriers.push_back({ resourceIndex, src, useState });
+				}
+				else
+				{
+					AddDependency(compiled.renderPasses[renderPassIndex], VK_SUBPASS_EXTERNAL, compiledPass.subpass, src, useState, 0);
+				}
+			}
+
+			ApplyUse(state, useState, isWrite, renderPassIndex, compiledPass.subpass);
+
+			if (needsDependency && !isWrite)
+			{
+				state.visibleStages |= useState.stages;
+				state.visibleAccess |= useState.access;
+			}
+		}
+
+		// Imported resources are handed back in their after state
+		if (!resource.imported || resourceUses[resourceIndex].empty())
+		{
+			continue;
+		}
+
+		const RenderGraphState& after = resource.after;
+		const bool layoutChange = !resource.isBuffer && after.layout != VK_IMAGE_LAYOUT_UNDEFINED && after.layout != state.layout;
+		const bool needsDependency = layoutChange || (after.stages != 0 && (state.writeAccess != 0 || (after.access & WRITE_ACCESS_MASK) != 0));
+
+		if (!needsDependency)
+		{
+			continue;
+		}
+
+		RenderGraphState src;
+		src.layout = state.layout;
+		src.stages = state.writeStages | state.readStages;
+		src.access = state.writeAccess;
+
+		RenderGraphState dst = after;
+		dst.layout = layoutChange ? after.layout : state.layout;
+
+		const bool handOverFromRenderPass = state.renderPass >= 0 && !state.outside
+			&& FindAttachment(compiled.renderPasses[state.renderPass], resourceIndex) < compiled.renderPasses[state.renderPass].attachments.size();
+
+		if (handOverFromRenderPass)
+		{
+			CompiledRenderGraph::RenderPass& renderPass = compiled.renderPasses[state.renderPass];
+			renderPass.attachments[FindAttachment(renderPass, resourceIndex)].finalLayout = dst.layout;
+
+			for (uint32_t subpass = 0; subpass < renderPass.subpasses.size(); subpass++)
+			{
+				if ((state.subpassMask & (1u << subpass)) != 0)
+				{
+					AddDependency(renderPass, subpass, VK_SUBPASS_EXTERNAL, src, dst, 0);
+				}
+			}
+		}
+		else
+		{
+			compiled.finalBarriers.push_back({ resourceIndex, src, dst });
+		}
+	}
+
+	// Attachments are stored when the next use, this frame or the next, keeps what they hold
+	for (size_t renderPassIndex = 0; renderPassIndex < compiled.renderPasses.size(); renderPassIndex++)
+	{
+		for (CompiledRenderGraph::Attachment& attachment : compiled.renderPasses[renderPassIndex].attachments)
+		{
+			const std::vector<ScheduledUse>& uses = resourceUses[attachment.resource];
+
+			size_t lastUse = 0;
+			for (size_t useIndex = 0; useIndex < uses.size(); useIndex++)
+			{
+				if (compiled.passes[uses[useIndex].passIndex].renderPass == static_cast<int32_t>(renderPassIndex))
+				{
+					lastUse = useIndex;
+				}
+			}
+
+			bool keepContents = resources[attachment.resource].imported;
+			if (lastUse + 1 < uses.size())
+			{
+				keepContents = !Discards(uses[lastUse + 1].use.access, uses[lastUse + 1].use.load);
+			}
+			else if (!keepContents)
+			{
+				keepContents = !Discards(uses.front().use.access, uses.front().use.load);
+			}
+
+			attachment.storeOp = keepContents ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		}
+	}
+}
+
+std::string Renderer::RenderGraph::Describe(const CompiledRenderGraph& compiled) const
+{
+	constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(2);
+	out << "Render graph : " << compiled.passes.size() << " passes, " << compiled.culledPasses.size() << " culled, "
+		<< compiled.renderPasses.size() << " render passes";
+
+	auto describeBarrier = [&](const RenderGraphBarrier& barrier)
+	{
+		out << resources[barrier.resource].name << " : ";
+		if (barrier.src.layout != barrier.dst.layout)
+		{
+			out << string_VkImageLayout(barrier.src.layout) << " -> " << string_VkImageLayout(barrier.dst.layout) << ", ";
+		}
+		out << string_VkPipelineStageFlags(barrier.src.stages) << " -> " << string_VkPipelineStageFlags(barrier.dst.stages);
+	};
+
+	for (uint32_t passIndex = 0; passIndex < compiled.passes.size(); passIndex++)
+	{
+		const CompiledRenderGraph::Pass& compiledPass = compiled.passes[passIndex];
+		out << "\n\t" << passIndex << " " << passes[compiledPass.pass].name;
+
+		if (compiledPass.renderPass >= 0)
+		{
+			out << " : render pass " << compiledPass.renderPass << ", subpass " << compiledPass.subpass;
+		}
+		else
+		{
+			out << " : compute";
+		}
+
+		for (const RenderGraphBarrier& barrier : compiledPass.barriers)
+		{
+			out << "\n\t\tBarrier ";
+			describeBarrier(barrier);
+		}
+	}
+
+	for (size_t renderPassIndex = 0; renderPassIndex < compiled.renderPasses.size(); renderPassIndex++)
+	{
+		const CompiledRenderGraph::RenderPass& renderPass = compiled.renderPasses[renderPassIndex];
+		out << "\n\tRender pass " << renderPassIndex << " : " << renderPass.width << "x" << renderPass.height << ", "
+			<< renderPass.subpasses.size() << " subpasses, " << renderPass.dependencies.size() << " dependencies";
+
+		for (const CompiledRenderGraph::Attachment& attachment : renderPass.attachments)
+		{
+			out << "\n\t\t" << resources[attachment.resource].name << " : " << string_VkAttachmentLoadOp(attachment.loadOp) << ", "
+				<< string_VkAttachmentStoreOp(attachment.storeOp) << ", " << string_VkImageLayout(attachment.initialLayout) << " -> "
+				<< string_VkImageLayout(attachment.finalLayout);
+		}
+	}
+
+	for (const RenderGraphBarrier& barrier : compiled.finalBarriers)
+	{
+		out << "\n\tAfter the frame ";
+		describeBarrier(barrier);
+	}
+
+	if (!compiled.culledPasses.empty())
+	{
+		out << "\n\tCulled :";
+		for (RenderGraphPass pass : compiled.culledPasses)
+		{
+			out << " " << passes[pass].name;
+		}
+	}
+
+	out << "\n\tTransient memory : " << compiled.transientBytes / BYTES_PER_MB << " MB separately, "
+		<< compiled.aliasedBytes / BYTES_PER_MB << " MB aliased";
+
+	for (const CompiledRenderGraph::Placement& placement : compiled.placements)
+	{
+		out << "\n\t\t" << resources[placement.resource].name << " : " << placement.offset / BYTES_PER_MB << " MB, "
+			<< placement.size / BYTES_PER_MB << " MB, passes " << placement.firstPass << " to " << placement.lastPass;
+	}
+
+	return out.str();
+}
+
+const std::string& Renderer::RenderGraph::GetResourceName(RenderGraphResource resource) const
+{
+	return resources[resource].name;
+}
+
+const Renderer::RenderGraphImageDesc& Renderer::RenderGraph::GetImageDesc(RenderGraphResource resource) const
+{
+	return resources[resource].image;
+}
+
+const std::string& Renderer::RenderGraph::GetPassName(RenderGraphPass pass) const
+{
+	return passes[pass].name;
+}
+
+size_t Renderer::RenderGraph::GetPassCount() const
+{
+	return passes.size();
+}
+
+Renderer::RenderGraphState Renderer::RenderGraph::GetUseState(const ResourceUse& use) const
+{
+	const Resource& resource = resources[use.resource];
+	const bool depth = !resource.isBuffer && IsDepthFormat(resource.image.format);
+	const VkImageLayout sampledLayout = depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	RenderGraphState state;
+
+	switch (use.access)
+	{
+	case RenderGraphAccess::COLOUR_ATTACHMENT:
+		state = { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+		break;
+	case RenderGraphAccess::DEPTH_ATTACHMENT:
+		state = { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+		break;
+	case RenderGraphAccess::DEPTH_ATTACHMENT_READ_ONLY:
+		state = { VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT };
+		break;
+	case RenderGraphAccess::INPUT_ATTACHMENT:
+		state = { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_INPUT_ATTACHMENT_READ_BIT };
+		break;
+	case RenderGraphAccess::FRAGMENT_SAMPLED:
+		state = { sampledLayout, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT };
+		break;
+	case RenderGraphAccess::FRAGMENT_STORAGE_READ:
+		state = { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT };
+		break;
+	case RenderGraphAccess::COMPUTE_SAMPLED:
+		state = { sampledLayout, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT };
+		break;
+	case RenderGraphAccess::COMPUTE_STORAGE_READ:
+		state = { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT };
+		break;
+	case RenderGraphAccess::COMPUTE_STORAGE_WRITE:
+		state = { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT };
+		break;
+	}
+
+	// Buffers have no layout
+	if (resource.isBuffer)
+	{
+		state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	}
+
+	return state;
+}
+
+VkDeviceSize Renderer::RenderGraph::GetResourceSize(RenderGraphResource resource) const
+{
+	const Resource& graphResource = resources[resource];
+	const VkDeviceSize size = graphResource.isBuffer ? graphResource.bufferSize
+		: static_cast<VkDeviceSize>(graphResource.image.width) * graphResource.image.height * graphResource.image.layers * GetFormatBytesPerPixel(graphResource.image.format);
+
+	return AlignUp(size, RENDER_GRAPH_MEMORY_ALIGNMENT);
+}
+
+bool Renderer::IsDepthFormat(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool Renderer::HasStencilComponent(VkFormat format)
+{
+	return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+uint32_t Renderer::GetFormatBytesPerPixel(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_R8_UNORM:
+	case VK_FORMAT_R8_UINT:
+		return 1;
+	case VK_FORMAT_R8G8_UNORM:
+	case VK_FORMAT_R16_SFLOAT:
+	case VK_FORMAT_R16_UNORM:
+	case VK_FORMAT_R16_UINT:
+	case VK_FORMAT_D16_UNORM:
+		return 2;
+	case VK_FORMAT_R16G16B16A16_SFLOAT:
+	case VK_FORMAT_R16G16B16A16_UNORM:
+	case VK_FORMAT_R32G32_SFLOAT:
+	case VK_FORMAT_R32G32_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT: // Stencil is usually kept in its own plane, padded
+		return 8;
+	case VK_FORMAT_R32G32B32A32_SFLOAT:
+	case VK_FORMAT_R32G32B32A32_UINT:
+		return 16;
+	default:
+		// Every 32 bit colour and depth format
+		return 4;
+	}
+}
@@ -0,0 +1,202 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+namespace Renderer
+{
+	/**
+	* How a pass uses a resource, each maps to the layout, pipeline stages and access flags barriers and subpass dependencies are
+	* built from. Attachment uses make a graphics pass part of a render pass, input attachments let it merge into its writer's
+	*/
+	enum class RenderGraphAccess
+	{
+		COLOUR_ATTACHMENT,
+		DEPTH_ATTACHMENT, // Depth tested and written
+		DEPTH_ATTACHMENT_READ_ONLY, // Depth tested only
+		INPUT_ATTACHMENT, // Read by a fragment shader at its own pixel
+		FRAGMENT_SAMPLED,
+		FRAGMENT_STORAGE_READ,
+		COMPUTE_SAMPLED,
+		COMPUTE_STORAGE_READ,
+		COMPUTE_STORAGE_WRITE
+	};
+
+	/** What a write does with the resource's previous contents. Only attachments can be cleared */
+	enum class RenderGraphLoad
+	{
+		LOAD,
+		CLEAR,
+		DISCARD
+	};
+
+	enum class RenderGraphPassType
+	{
+		GRAPHICS,
+		COMPUTE
+	};
+
+	/** A use of a resource, or the state an imported resource is in before the frame and has to be left in after it */
+	struct RenderGraphState
+	{
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags stages = 0; // No stages after the frame means the next user synchronizes itself
+		VkAccessFlags access = 0;
+	};
+
+	struct RenderGraphImageDesc
+	{
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t layers = 1;
+	};
+
+	using RenderGraphResource = uint32_t;
+	using RenderGraphPass = uint32_t;
+
+	/** Pipeline barrier recorded outside render passes, buffers and unchanged layouts only need a memory barrier */
+	struct RenderGraphBarrier
+	{
+		RenderGraphResource resource;
+		RenderGraphState src; // Layout is the old layout
+		RenderGraphState dst; // Layout is the new layout
+	};
+
+	/**
+	* Output of RenderGraph::Compile, everything needed to create the render passes and record the frame without touching a device.
+	* Transient resources are first written by a clear or discard, their memory is planned so ones that are never alive at the
+	* same time share it
+	*/
+	struct CompiledRenderGraph
+	{
+		struct Attachment
+		{
+			RenderGraphResource resource;
+			VkFormat format;
+			VkAttachmentLoadOp loadOp;
+			VkAttachmentStoreOp storeOp;
+			VkImageLayout initialLayout;
+			VkImageLayout finalLayout;
+		};
+
+		struct Subpass
+		{
+			RenderGraphPass pass;
+			std::vector<VkAttachmentReference> colourReferences; // In the pass's declaration order, which is fragment output order
+			std::vector<VkAttachmentReference> inputReferences; // In declaration order, which is input_attachment_index order
+			VkAttachmentReference depthReference = { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED };
+		};
+
+		struct RenderPass
+		{
+			std::vector<Attachment> attachments; // In order of first use, the framebuffer's order
+			std::vector<Subpass> subpasses;
+			std::vector<VkSubpassDependency> dependencies;
+			uint32_t width = 0;
+			uint32_t height = 0;
+		};
+
+		struct Pass
+		{
+			RenderGraphPass pass;
+			int32_t renderPass = -1; // Compute passes aren't part of one
+			uint32_t subpass = 0;
+			std::vector<RenderGraphBarrier> barriers; // Recorded before the pass, or before its render pass begins
+		};
+
+		struct Placement
+		{
+			RenderGraphResource resource;
+			VkDeviceSize offset;
+			VkDeviceSize size;
+			uint32_t firstPass; // Execution order
+			uint32_t lastPass;
+		};
+
+		std::vector<Pass> passes; // Execution order, culled passes left out
+		std::vector<RenderPass> renderPasses;
+		std::vector<RenderGraphPass> culledPasses;
+		std::vector<RenderGraphBarrier> finalBarriers; // After the last pass, leave imported resources in their after state
+		std::vector<Placement> placements; // Transient resources only
+		VkDeviceSize transientBytes = 0; // Every transient resource in its own allocation
+		VkDeviceSize aliasedBytes = 0; // One allocation shared by all of them
+
+		const Pass* FindPass(RenderGraphPass pass) const;
+		const RenderPass* FindRenderPass(RenderGraphPass pass) const;
+	};
+
+	/**
+	* Frame graph of passes that declare which resources they read and write, in the order they are meant to run. Compiling culls
+	* passes nothing needs, merges graphics passes that read their predecessors' attachments at the same pixel into subpasses of one
+	* render pass, works out the barriers, subpass dependencies, load and store operations between every use of a resource and plans
+	* aliased memory for transient resources. Resources keep their contents across frames, so the first use of one synchronizes
+	* with its last use in the previous frame
+	*/
+	class RenderGraph
+	{
+	public:
+		RenderGraphResource CreateImage(const std::string& name, const RenderGraphImageDesc& desc);
+		RenderGraphResource CreateBuffer(const std::string& name, VkDeviceSize size);
+		/** Owned outside the graph, never culled away or aliased */
+		RenderGraphResource ImportImage(const std::string& name, const RenderGraphImageDesc& desc, const RenderGraphState& before, const RenderGraphState& after);
+		RenderGraphResource ImportBuffer(const std::string& name, const RenderGraphState& before, const RenderGraphState& after);
+
+		RenderGraphPass AddPass(const std::string& name, RenderGraphPassType type);
+		/** Uses are kept in declaration order, which orders colour outputs and input attachments */
+		void Use(RenderGraphPass pass, RenderGraphResource resource, RenderGraphAccess access, RenderGraphLoad load = RenderGraphLoad::LOAD);
+		/** Keeps a pass whose results leave the graph some other way, a readback or a present */
+		void SetSideEffects(RenderGraphPass pass);
+
+		void Compile(CompiledRenderGraph& compiled) const;
+		/** Schedule, render passes, barriers and memory plan in readable form */
+		std::string Describe(const CompiledRenderGraph& compiled) const;
+
+		const std::string& GetResourceName(RenderGraphResource resource) const;
+		const RenderGraphImageDesc& GetImageDesc(RenderGraphResource resource) const;
+		const std::string& GetPassName(RenderGraphPass pass) const;
+		size_t GetPassCount() const;
+
+	private:
+		struct Resource
+		{
+			std::string name;
+			RenderGraphImageDesc image;
+			VkDeviceSize bufferSize = 0;
+			bool isBuffer = false;
+			bool imported = false;
+			RenderGraphState before;
+			RenderGraphState after;
+		};
+
+		struct ResourceUse
+		{
+			RenderGraphResource resource;
+			RenderGraphAccess access;
+			RenderGraphLoad load;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			RenderGraphPassType type;
+			std::vector<ResourceUse> uses;
+			bool sideEffects = false;
+		};
+
+		std::vector<Resource> resources;
+		std::vector<Pass> passes;
+
+		RenderGraphState GetUseState(const ResourceUse& use) const;
+		VkDeviceSize GetResourceSize(RenderGraphResource resource) const;
+	};
+
+	/** Whether the format has a depth aspect, sampled depth stays in the read only depth layout */
+	bool IsDepthFormat(VkFormat format);
+	bool HasStencilComponent(VkFormat format);
+	uint32_t GetFormatBytesPerPixel(VkFormat format);
+
+	/** Every transient resource's memory is aligned to this, the largest alignment images usually ask for */
+	constexpr VkDeviceSize RENDER_GRAPH_MEMORY_ALIGNMENT = 64 * 1024;
+}
@@ -3,14 +3,12 @@
 #include <iostream>
 #include "ConstantsAndDefines.h"
 #include <array>
+#include <algorithm>
 
 Renderer::RenderPipeline::~RenderPipeline()
 {
 	PROFILE_FUNCTION();
 
-	_aligned_free(modelTransferSpace);
-	modelTransferSpace = nullptr;
-
 	vkDestroyDescriptorPool(pipelineCreateInfo.device.logicalDevice, inputDescriptorPool, nullptr);
 	vkDestroyDescriptorSetLayout(pipelineCreateInfo.device.logicalDevice, inputSetLayout, nullptr);
 
@@ -22,13 +20,13 @@ Renderer::RenderPipeline::~RenderPipeline()
 	for (size_t i = 0; i < vpUniformBuffer.size(); i++)
 	{
 		vkDestroyBuffer(pipelineCreateInfo.device.logicalDevice, vpUniformBuffer[i], nullptr);
-		vkFreeMemory(pipelineCreateInfo.device.logicalDevice, vpUniformBufferMemory[i], nullptr);
-		vkDestroyBuffer(pipelineCreateInfo.device.logicalDevice, modelUniformDynamicBuffer[i], nullptr);
-		vkFreeMemory(pipelineCreateInfo.device.logicalDevice, modelUniformDynamicBufferMemory[i], nullptr);
+		Utils::FreeMemory(pipelineCreateInfo.device.logicalDevice, vpUniformBufferMemory[i]);
 	}
 
 	vkDestroyPipeline(pipelineCreateInfo.device.logicalDevice, secondPipeline, nullptr);
 	vkDestroyPipelineLayout(pipelineCreateInfo.device.logicalDevice, secondPipelineLayout, nullptr);
+	vkDestroyPipeline(pipelineCreateInfo.device.logicalDevice, earlyGfxPipeline, nullptr);
+	vkDestroyPipeline(pipelineCreateInfo.device.logicalDevice, depthEqualGfxPipeline, nullptr);
 	vkDestroyPipeline(pipelineCreateInfo.device.logicalDevice, gfxPipeline, nullptr);
 	vkDestroyPipelineLayout(pipelineCreateInfo.device.logicalDevice, pipelineLayout, nullptr);
 }
@@ -56,45 +54,50 @@ void Renderer::RenderPipeline::Init(const RenderPipelineCreateInfo& pipelineCrea
 
 	VkPipelineShaderStageCreateInfo shaderStages[] = { vertexShaderCreateInfo, fragmentShaderCreateInfo };
 
-	VkVertexInputBindingDescription vertexBindingDesc = {};
-	vertexBindingDesc.binding = 0;
-	vertexBindingDesc.stride = sizeof(Utilities::Vertex);
+	// Binding 0 is the mesh's position stream and binding 1 its attribute stream
+	std::array<VkVertexInputBindingDescription, 2> vertexBindingDescs = {};
+	vertexBindingDescs[0].binding = 0;
+	vertexBindingDescs[0].stride = sizeof(glm::vec3);
 	/*
 	* VK_VERTEX_INPUT_RATE_VERTEX :If instance enabled the draw one instance at a time instead of one vertex for each mesh at the same time
 	* VK_VERTEX_INPUT_RATE_INSTANCE : Other way around
 	* */
-	vertexBindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	vertexBindingDescs[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	vertexBindingDescs[1].binding = 1;
+	vertexBindingDescs[1].stride = sizeof(Utilities::VertexAttributes);
+	vertexBindingDescs[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
 	std::array<VkVertexInputAttributeDescription, 4> vertAttributeDescs;
 	// Position
 	vertAttributeDescs[0].binding = 0;
 	vertAttributeDescs[0].location = 0;
 	vertAttributeDescs[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-	vertAttributeDescs[0].offset = offsetof(Vertex, pos);
+	vertAttributeDescs[0].offset = 0;
 
 	// Color
-	vertAttributeDescs[1].binding = 0;
+	vertAttributeDescs[1].binding = 1;
 	vertAttributeDescs[1].location = 1;
 	vertAttributeDescs[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-	vertAttributeDescs[1].offset = offsetof(Vertex, col);
+	vertAttributeDescs[1].offset = offsetof(VertexAttributes, col);
 
 	// Normal
-	vertAttributeDescs[2].binding = 0;
+	vertAttributeDescs[2].binding = 1;
 	vertAttributeDescs[2].location = 2;
 	vertAttributeDescs[2].format = VK_FORMAT_R32G32B32_SFLOAT;
-	vertAttributeDescs[2].offset = offsetof(Vertex, normal);
+	vertAttributeDescs[2].offset = offsetof(VertexAttributes, normal);
 
 	// UV
-	vertAttributeDescs[3].binding = 0;
+	vertAttributeDescs[3].binding = 1;
 	vertAttributeDescs[3].location = 3;
 	vertAttributeDescs[3].format = VK_FORMAT_R32G32_SFLOAT;
-	vertAttributeDescs[3].offset = offsetof(Vertex, uv);
+	vertAttributeDescs[3].offset = offsetof(VertexAttributes, uv);
 
 	VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
 
 	vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
-	vertexInputCreateInfo.pVertexBindingDescriptions = &vertexBindingDesc;
+	vertexInputCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexBindingDescs.size());
+	vertexInputCreateInfo.pVertexBindingDescriptions = vertexBindingDescs.data();
 	vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertAttributeDescs.size());
 	vertexInputCreateInfo.pVertexAttributeDescriptions = vertAttributeDescs.data();
 
@@ -151,7 +154,12 @@ void Renderer::RenderPipeline::Init(const RenderPipelineCreateInfo& pipelineCrea
 	colorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
 	colorBlendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
 	
-	std::array<VkPipelineColorBlendAttachmentState, 3> colourBlendAttachmentStates = { colorBlendAttachmentState, colorBlendAttachmentState, colorBlendAttachmentState };
+	// G-buffer targets are overwritten, blending would mix packed normals and positions
+	VkPipelineColorBlendAttachmentState gBufferBlendAttachmentState = colorBlendAttachmentState;
+	gBufferBlendAttachmentState.blendEnable = VK_FALSE;
+
+	const std::vector<GBufferTarget> gBufferTargets = GetGBufferColourTargets(pipelineCreateInfo.gBufferLayout);
+	std::vector<VkPipelineColorBlendAttachmentState> colourBlendAttachmentStates(gBufferTargets.size(), gBufferBlendAttachmentState);
 
 	colorBlendingCreateInfo.attachmentCount = static_cast<uint32_t>(colourBlendAttachmentStates.size());
 	colorBlendingCreateInfo.pAttachments = colourBlendAttachmentStates.data();
@@ -178,7 +186,8 @@ void Renderer::RenderPipeline::Init(const RenderPipelineCreateInfo& pipelineCrea
 	depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 	depthStencilCreateInfo.depthTestEnable = VK_TRUE;
 	depthStencilCreateInfo.depthWriteEnable = VK_TRUE;
-	depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+	// The main pass redraws what the early pass already laid down in depth, equal depth has to pass
+	depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
 	depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
 	depthStencilCreateInfo.stencilTestEnable = VK_FALSE;
 
@@ -207,6 +216,51 @@ void Renderer::RenderPipeline::Init(const RenderPipelineCreateInfo& pipelineCrea
 		throw std::runtime_error("Failed to create graphics pipeline");
 	}
 
+	// With a depth pre-pass every draw's depth is already final, only the surviving fragment of each pixel passes
+	depthStencilCreateInfo.depthWriteEnable = VK_FALSE;
+	depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+
+	vkResult = vkCreateGraphicsPipelines(pipelineCreateInfo.device.logicalDevice, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &depthEqualGfxPipeline);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create graphics pipeline");
+	}
+
+	depthStencilCreateInfo.depthWriteEnable = VK_TRUE;
+	depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	// The depth passes only lay down depth, so they run a position only vertex stage with no colour attachments
+	VkPipelineShaderStageCreateInfo depthOnlyShaderCreateInfo = vertexShaderCreateInfo;
+	depthOnlyShaderCreateInfo.module = pipelineCreateInfo.depthOnlyVertexModule;
+
+	VkPipelineVertexInputStateCreateInfo positionOnlyInputCreateInfo = vertexInputCreateInfo;
+	positionOnlyInputCreateInfo.vertexBindingDescriptionCount = 1;
+	positionOnlyInputCreateInfo.vertexAttributeDescriptionCount = 1;
+	positionOnlyInputCreateInfo.pVertexAttributeDescriptions = &vertAttributeDescs[0];
+
+	VkPipelineColorBlendStateCreateInfo depthOnlyBlendingCreateInfo = colorBlendingCreateInfo;
+	depthOnlyBlendingCreateInfo.attachmentCount = 0;
+	depthOnlyBlendingCreateInfo.pAttachments = nullptr;
+
+	graphicsPipelineCreateInfo.stageCount = 1;
+	graphicsPipelineCreateInfo.pStages = &depthOnlyShaderCreateInfo;
+	graphicsPipelineCreateInfo.pVertexInputState = &positionOnlyInputCreateInfo;
+	graphicsPipelineCreateInfo.pColorBlendState = &depthOnlyBlendingCreateInfo;
+	graphicsPipelineCreateInfo.renderPass = pipelineCreateInfo.earlyRenderPass;
+
+	vkResult = vkCreateGraphicsPipelines(pipelineCreateInfo.device.logicalDevice, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &earlyGfxPipeline);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create graphics pipeline");
+	}
+
+	graphicsPipelineCreateInfo.stageCount = 2;
+	graphicsPipelineCreateInfo.pVertexInputState = &vertexInputCreateInfo;
+	graphicsPipelineCreateInfo.pColorBlendState = &colorBlendingCreateInfo;
+	graphicsPipelineCreateInfo.renderPass = pipelineCreateInfo.renderPass;
+
 	vertexShaderCreateInfo.module = pipelineCreateInfo.secondPassShaderModule.vertexModule;
 	fragmentShaderCreateInfo.module = pipelineCreateInfo.secondPassShaderModule.fragmentModule;
 
@@ -219,12 +273,39 @@ void Renderer::RenderPipeline::Init(const RenderPipelineCreateInfo& pipelineCrea
 
 	depthStencilCreateInfo.depthWriteEnable = VK_FALSE;
 
+	// The compact layout has no position target, the lighting subpass rebuilds it from depth with the pushed inverse view projection
+	VkPushConstantRange reconstructionPushConstantRange = {};
+	reconstructionPushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	reconstructionPushConstantRange.offset = 0;
+	reconstructionPushConstantRange.size = sizeof(PushReconstruction);
+
+	const bool compactGBuffer = pipelineCreateInfo.gBufferLayout == GBufferLayout::COMPACT;
+
+	// The visibility layout fetches the triangle behind each pixel from the merged geometry and samples its texture itself
+	VkPushConstantRange visibilityPushConstantRange = reconstructionPushConstantRange;
+	visibilityPushConstantRange.size = sizeof(PushVisibility);
+
+	const bool visibilityGBuffer = pipelineCreateInfo.gBufferLayout == GBufferLayout::VISIBILITY;
+
+	// Every layout reads its cluster's light list from set 1, the visibility layout adds textures and geometry after it
+	const std::array<VkDescriptorSetLayout, 3> lightingSetLayouts = { inputSetLayout, pipelineCreateInfo.lightClusterSetLayout, pipelineCreateInfo.shadowSetLayout };
+	const std::array<VkDescriptorSetLayout, 5> visibilitySetLayouts = { inputSetLayout, pipelineCreateInfo.lightClusterSetLayout, pipelineCreateInfo.shadowSetLayout,
+		samplerSetLayout, pipelineCreateInfo.visibilitySetLayout };
+
 	VkPipelineLayoutCreateInfo secondPipelineCreateInfo = {};
 	secondPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	secondPipelineCreateInfo.setLayoutCount = 1;
-	secondPipelineCreateInfo.pSetLayouts = &inputSetLayout;
-	secondPipelineCreateInfo.pushConstantRangeCount = 0;
-	secondPipelineCreateInfo.pPushConstantRanges = nullptr;
+	secondPipelineCreateInfo.setLayoutCount = static_cast<uint32_t>(lightingSetLayouts.size());
+	secondPipelineCreateInfo.pSetLayouts = lightingSetLayouts.data();
+	secondPipelineCreateInfo.pushConstantRangeCount = compactGBuffer ? 1 : 0;
+	secondPipelineCreateInfo.pPushConstantRanges = compactGBuffer ? &reconstructionPushConstantRange : nullptr;
+
+	if (visibilityGBuffer)
+	{
+		secondPipelineCreateInfo.setLayoutCount = static_cast<uint32_t>(visibilitySetLayouts.size());
+		secondPipelineCreateInfo.pSetLayouts = visibilitySetLayouts.data();
+		secondPipelineCreateInfo.pushConstantRangeCount = 1;
+		secondPipelineCreateInfo.pPushConstantRanges = &visibilityPushConstantRange;
+	}
 
 	vkResult = vkCreatePipelineLayout(pipelineCreateInfo.device.logicalDevice, &secondPipelineCreateInfo, nullptr, &secondPipelineLayout);
 
@@ -251,10 +332,10 @@ void Renderer::RenderPipeline::Init(const RenderPipelineCreateInfo& pipelineCrea
 		throw std::runtime_error("Failed to create graphics pipeline");
 	}
 
-	AllocateDynamicBufferTransferSpace();
 	CreateUniformBuffers();
 	CreateDescriptorPool();
 	CreateDescriptorSets();
+	CreateTextureDescriptorSet();
 	CreateInputDescriptorSets();
 }
 
@@ -263,6 +344,16 @@ VkPipeline Renderer::RenderPipeline::GetPipeline() const
 	return gfxPipeline;
 }
 
+VkPipeline Renderer::RenderPipeline::GetDepthEqualPipeline() const
+{
+	return depthEqualGfxPipeline;
+}
+
+VkPipeline Renderer::RenderPipeline::GetEarlyPipeline() const
+{
+	return earlyGfxPipeline;
+}
+
 VkPipeline Renderer::RenderPipeline::GetSecondPipeline() const
 {
 	return secondPipeline;
@@ -283,9 +374,9 @@ VkDescriptorSet& Renderer::RenderPipeline::GetDescriptorSet(uint32_t index)
 	return (descriptorSets[index]);
 }
 
-VkDescriptorSet& Renderer::RenderPipeline::GetSamplerDescriptorSet(uint32_t index)
+VkDescriptorSet& Renderer::RenderPipeline::GetTextureDescriptorSet()
 {
-	return samplerDescriptorSets[index];
+	return textureDescriptorSet;
 }
 
 VkDescriptorSet& Renderer::RenderPipeline::GetInputDescriptorSet(uint32_t index)
@@ -306,60 +397,39 @@ void Renderer::RenderPipeline::SetViewMatrixFromLookAt(const glm::vec3& location
 	uboViewProjection.view = glm::lookAt(location, lookAt, upVec);
 }
 
+void Renderer::RenderPipeline::SetViewProjection(const UboViewProjection& viewProjection)
+{
+	uboViewProjection = viewProjection;
+}
+
 void Renderer::RenderPipeline::SetModelMatrix(const glm::mat4& mat)
 {
 
 }
 
-void Renderer::RenderPipeline::UpdateUniformBuffers(uint32_t imageIndex, const std::vector<Model>& modelList)
+const Utilities::UboViewProjection& Renderer::RenderPipeline::GetViewProjection() const
+{
+	return uboViewProjection;
+}
+
+void Renderer::RenderPipeline::UpdateUniformBuffers(uint32_t frameIndex)
 {
 	PROFILE_FUNCTION();
 
-	// Copy VP data
 	void* data = nullptr;
-	vkMapMemory(pipelineCreateInfo.device.logicalDevice, vpUniformBufferMemory[imageIndex], 0, sizeof(UboViewProjection), 0, &data);
+	vkMapMemory(pipelineCreateInfo.device.logicalDevice, vpUniformBufferMemory[frameIndex], 0, sizeof(UboViewProjection), 0, &data);
+	PROFILE_COUNT_ADD(UPLOADED_BYTES, sizeof(UboViewProjection));
 	memcpy(data, &uboViewProjection, sizeof(UboViewProjection));
-	vkUnmapMemory(pipelineCreateInfo.device.logicalDevice, vpUniformBufferMemory[imageIndex]);
-
-	// Copy Model data
-	size_t totalMeshCount = 0;
-	for (size_t i = 0; i < modelList.size(); i++)
-	{
-		totalMeshCount += modelList[i].GetMeshCount();
-		for (size_t j = 0; j < modelList[i].GetMeshCount(); j++)
-		{
-			UboModel* thisModel = (UboModel*)((uint64_t)modelTransferSpace + (i * modelUniformAlignment));
-			*thisModel = modelList[i].GetMesh(j)->GetModel();
-		}
-	}
-
-	vkMapMemory(pipelineCreateInfo.device.logicalDevice, modelUniformDynamicBufferMemory[imageIndex], 0, modelUniformAlignment * totalMeshCount, 0, &data);
-	memcpy(data, modelTransferSpace, modelUniformAlignment * totalMeshCount);
-	vkUnmapMemory(pipelineCreateInfo.device.logicalDevice, modelUniformDynamicBufferMemory[imageIndex]);
-}
-
-uint32_t Renderer::RenderPipeline::GetModelUniformAlignment() const
-{
-	return modelUniformAlignment;
+	vkUnmapMemory(pipelineCreateInfo.device.logicalDevice, vpUniformBufferMemory[frameIndex]);
 }
 
 uint32_t Renderer::RenderPipeline::CreateTextureDescriptor(VkImageView textureImage, VkSampler textureSampler)
 {
 	PROFILE_FUNCTION();
 
-	VkDescriptorSet descriptorSet;
-
-	VkDescriptorSetAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	allocInfo.descriptorPool = samplerDescriptorPool;
-	allocInfo.descriptorSetCount = 1;
-	allocInfo.pSetLayouts = &samplerSetLayout;
-
-	VkResult vkResult = vkAllocateDescriptorSets(pipelineCreateInfo.device.logicalDevice, &allocInfo, &descriptorSet);
-
-	if (vkResult != VK_SUCCESS)
+	if (textureCount >= textureCapacity)
 	{
-		throw std::runtime_error("Failed to allocate texture descriptor sets!");
+		throw std::runtime_error("Failed to create texture descriptor, texture array is full");
 	}
 
 	VkDescriptorImageInfo imageInfo = {};
@@ -367,21 +437,19 @@ uint32_t Renderer::RenderPipeline::CreateTextureDescriptor(VkImageView textureIm
 	imageInfo.imageView = textureImage;
 	imageInfo.sampler = textureSampler;
 
-
+	// The slot is new, so no pending command buffer reads it. Update unused while pending makes the write safe while earlier frames still use the set
 	VkWriteDescriptorSet descriptorWrite = {};
 	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	descriptorWrite.dstSet = descriptorSet;
+	descriptorWrite.dstSet = textureDescriptorSet;
 	descriptorWrite.dstBinding = 0;
-	descriptorWrite.dstArrayElement = 0;
+	descriptorWrite.dstArrayElement = textureCount;
 	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	descriptorWrite.descriptorCount = 1;
 	descriptorWrite.pImageInfo = &imageInfo;
 
 	vkUpdateDescriptorSets(pipelineCreateInfo.device.logicalDevice, 1, &descriptorWrite, 0, nullptr);
 
-	samplerDescriptorSets.push_back(descriptorSet);
-
-	return static_cast<uint32_t>(samplerDescriptorSets.size()) - 1;
+	return textureCount++;
 }
 
 void Renderer::RenderPipeline::CreateDescriptorSetLayout()
@@ -396,14 +464,7 @@ void Renderer::RenderPipeline::CreateDescriptorSetLayout()
 	vpLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 	vpLayoutBinding.pImmutableSamplers = nullptr;
 
-	VkDescriptorSetLayoutBinding modelLayoutBinding = {};
-	modelLayoutBinding.binding = 1;
-	modelLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-	modelLayoutBinding.descriptorCount = 1;
-	modelLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-	modelLayoutBinding.pImmutableSamplers = nullptr;
-
-	std::vector<VkDescriptorSetLayoutBinding> layoutBindings = { vpLayoutBinding , modelLayoutBinding };
+	std::vector<VkDescriptorSetLayoutBinding> layoutBindings = { vpLayoutBinding };
 
 	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
 	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -417,16 +478,38 @@ void Renderer::RenderPipeline::CreateDescriptorSetLayout()
 		throw std::runtime_error("Failed to create descriptor set layout");
 	}
 
-	// Texture sampler descriptor set layout
+	// Texture array descriptor set layout, sized to what the device allows for update after bind sets
+	VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties = {};
+	descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 deviceProperties = {};
+	deviceProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	deviceProperties.pNext = &descriptorIndexingProperties;
+	vkGetPhysicalDeviceProperties2(pipelineCreateInfo.device.physicalDevice, &deviceProperties);
+
+	textureCapacity = std::min(MAX_TEXTURES, descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers);
+	textureCapacity = std::min(textureCapacity, descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+
 	VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
 	samplerLayoutBinding.binding = 0;
 	samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	samplerLayoutBinding.descriptorCount = 1;
+	samplerLayoutBinding.descriptorCount = textureCapacity;
 	samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	samplerLayoutBinding.pImmutableSamplers = nullptr;
 
+	// Slots past the loaded textures are never written or read
+	VkDescriptorBindingFlags samplerBindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT
+		| VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo = {};
+	bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsCreateInfo.bindingCount = 1;
+	bindingFlagsCreateInfo.pBindingFlags = &samplerBindingFlags;
+
 	VkDescriptorSetLayoutCreateInfo textureLayoutCreateInfo = {};
 	textureLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	textureLayoutCreateInfo.pNext = &bindingFlagsCreateInfo;
+	textureLayoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
 	textureLayoutCreateInfo.bindingCount = 1;
 	textureLayoutCreateInfo.pBindings = &samplerLayoutBinding;
 
@@ -438,35 +521,17 @@ void Renderer::RenderPipeline::CreateDescriptorSetLayout()
 	}
 
 	// Create input attachment image descriptor set layout
-	// position input binding
-	VkDescriptorSetLayoutBinding positionInputLayoutBinding = {};
-	positionInputLayoutBinding.binding = 0;
-	positionInputLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-	positionInputLayoutBinding.descriptorCount = 1;
-	positionInputLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-	// normal input binding
-	VkDescriptorSetLayoutBinding normalInputLayoutBinding = {};
-	normalInputLayoutBinding.binding = 1;
-	normalInputLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-	normalInputLayoutBinding.descriptorCount = 1;
-	normalInputLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-	// colour input binding
-	VkDescriptorSetLayoutBinding colourInputLayoutBinding = {};
-	colourInputLayoutBinding.binding = 2;
-	colourInputLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-	colourInputLayoutBinding.descriptorCount = 1;
-	colourInputLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-	// depth input binding
-	VkDescriptorSetLayoutBinding depthInputLayoutBinding = {};
-	depthInputLayoutBinding.binding = 3;
-	depthInputLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-	depthInputLayoutBinding.descriptorCount = 1;
-	depthInputLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-	std::array<VkDescriptorSetLayoutBinding, 4> inputBindings = { positionInputLayoutBinding, normalInputLayoutBinding, colourInputLayoutBinding, depthInputLayoutBinding };
+	// One binding per G-buffer colour target in output order, followed by depth
+	const uint32_t inputAttachmentCount = static_cast<uint32_t>(GetGBufferColourTargets(pipelineCreateInfo.gBufferLayout).size()) + 1;
+	std::vector<VkDescriptorSetLayoutBinding> inputBindings(inputAttachmentCount);
+
+	for (uint32_t i = 0; i < inputAttachmentCount; i++)
+	{
+		inputBindings[i].binding = i;
+		inputBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+		inputBindings[i].descriptorCount = 1;
+		inputBindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	}
 
 	// Create descriptor set layout for input attachments
 	VkDescriptorSetLayoutCreateInfo inputLayoutCreateInfo = {};
@@ -488,25 +553,16 @@ void Renderer::RenderPipeline::CreateUniformBuffers()
 	PROFILE_FUNCTION();
 
 	VkDeviceSize vpBufferSize = sizeof(UboViewProjection);
-	VkDeviceSize modelBufferSize = static_cast<VkDeviceSize>(modelUniformAlignment) * MAX_OBJECTS;
-
-	vpUniformBuffer.resize(pipelineCreateInfo.swapchainImageCount);
-	vpUniformBufferMemory.resize(pipelineCreateInfo.swapchainImageCount);
 
-	modelUniformDynamicBuffer.resize(pipelineCreateInfo.swapchainImageCount);
-	modelUniformDynamicBufferMemory.resize(pipelineCreateInfo.swapchainImageCount);
+	vpUniformBuffer.resize(pipelineCreateInfo.frameCount);
+	vpUniformBufferMemory.resize(pipelineCreateInfo.frameCount);
 
-	for (size_t i = 0; i < pipelineCreateInfo.swapchainImageCount; i++)
+	for (size_t i = 0; i < pipelineCreateInfo.frameCount; i++)
 	{
 		Utils::CreateBuffer({ pipelineCreateInfo.device.physicalDevice,
 			pipelineCreateInfo.device.logicalDevice, vpBufferSize,
 			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			&vpUniformBuffer[i], &vpUniformBufferMemory[i] });
-
-		Utils::CreateBuffer({ pipelineCreateInfo.device.physicalDevice,
-			pipelineCreateInfo.device.logicalDevice, modelBufferSize,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			&modelUniformDynamicBuffer[i], &modelUniformDynamicBufferMemory[i] });
 	}
 }
 
@@ -520,16 +576,12 @@ void Renderer::RenderPipeline::CreateDescriptorPool()
 	vpPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	vpPoolSize.descriptorCount = static_cast<uint32_t>(vpUniformBuffer.size());
 
-	VkDescriptorPoolSize modelPoolSize = {};
-	modelPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-	modelPoolSize.descriptorCount = static_cast<uint32_t>(modelUniformDynamicBuffer.size());
-
 	// List of pool sizes
-	std::vector<VkDescriptorPoolSize> descriptorPoolSizes = { vpPoolSize, modelPoolSize };
+	std::vector<VkDescriptorPoolSize> descriptorPoolSizes = { vpPoolSize };
 
 	VkDescriptorPoolCreateInfo poolCreateInfo = {};
 	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	poolCreateInfo.maxSets = static_cast<uint32_t>(pipelineCreateInfo.swapchainImageCount);
+	poolCreateInfo.maxSets = static_cast<uint32_t>(pipelineCreateInfo.frameCount);
 	poolCreateInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
 	poolCreateInfo.pPoolSizes = descriptorPoolSizes.data();
 
@@ -545,11 +597,12 @@ void Renderer::RenderPipeline::CreateDescriptorPool()
 
 	VkDescriptorPoolSize samplerPoolSize = {};
 	samplerPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	samplerPoolSize.descriptorCount = MAX_OBJECTS; // TODO : Assumes 1 texture per object, Need to fix this
+	samplerPoolSize.descriptorCount = textureCapacity;
 
 	VkDescriptorPoolCreateInfo samplerPoolCreateInfo = {};
 	samplerPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	samplerPoolCreateInfo.maxSets = MAX_OBJECTS;
+	samplerPoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	samplerPoolCreateInfo.maxSets = 1;
 	samplerPoolCreateInfo.poolSizeCount = 1;
 	samplerPoolCreateInfo.pPoolSizes = &samplerPoolSize;
 
@@ -561,34 +614,16 @@ void Renderer::RenderPipeline::CreateDescriptorPool()
 	}
 
 	// Create input attachment descriptor pool
-	// position attachment pool
-	VkDescriptorPoolSize positionInputPoolSize = {};
-	positionInputPoolSize.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-	positionInputPoolSize.descriptorCount = static_cast<uint32_t>(pipelineCreateInfo.swapchainImageCount);
-
-	// normal attachment pool
-	VkDescriptorPoolSize normalInputPoolSize = {};
-	normalInputPoolSize.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-	normalInputPoolSize.descriptorCount = static_cast<uint32_t>(pipelineCreateInfo.swapchainImageCount);
-
-	// colour attachment pool
-	VkDescriptorPoolSize colourInputPoolSize = {};
-	colourInputPoolSize.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-	colourInputPoolSize.descriptorCount = static_cast<uint32_t>(pipelineCreateInfo.swapchainImageCount);
-
-	// depth attachment pool
-	VkDescriptorPoolSize depthInputPoolSize = {};
-	depthInputPoolSize.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-	depthInputPoolSize.descriptorCount = static_cast<uint32_t>(pipelineCreateInfo.swapchainImageCount);
-
-	std::array<VkDescriptorPoolSize, 4> inputPoolSizes = { positionInputPoolSize, normalInputPoolSize, colourInputPoolSize, depthInputPoolSize };
-	// Create input attachment pool
+	// G-buffer colour targets and depth, for every frame in flight
+	VkDescriptorPoolSize inputPoolSize = {};
+	inputPoolSize.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+	inputPoolSize.descriptorCount = static_cast<uint32_t>((GetGBufferColourTargets(pipelineCreateInfo.gBufferLayout).size() + 1) * pipelineCreateInfo.frameCount);
 
 	VkDescriptorPoolCreateInfo inputPoolCreateInfo = {};
 	inputPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	inputPoolCreateInfo.maxSets = static_cast<uint32_t>(pipelineCreateInfo.swapchainImageCount);
-	inputPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(inputPoolSizes.size());
-	inputPoolCreateInfo.pPoolSizes = inputPoolSizes.data();
+	inputPoolCreateInfo.maxSets = static_cast<uint32_t>(pipelineCreateInfo.frameCount);
+	inputPoolCreateInfo.poolSizeCount = 1;
+	inputPoolCreateInfo.pPoolSizes = &inputPoolSize;
 
 	vkResult = vkCreateDescriptorPool(pipelineCreateInfo.device.logicalDevice, &inputPoolCreateInfo, nullptr, &inputDescriptorPool);
 
@@ -603,14 +638,14 @@ void Renderer::RenderPipeline::CreateDescriptorSets()
 {
 	PROFILE_FUNCTION();
 
-	descriptorSets.resize(pipelineCreateInfo.swapchainImageCount);
-	std::vector<VkDescriptorSetLayout> setLayouts(pipelineCreateInfo.swapchainImageCount, descriptorSetLayout);
+	descriptorSets.resize(pipelineCreateInfo.frameCount);
+	std::vector<VkDescriptorSetLayout> setLayouts(pipelineCreateInfo.frameCount, descriptorSetLayout);
 
 	VkDescriptorSetAllocateInfo setAllocateInfo = {};
 
 	setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 	setAllocateInfo.descriptorPool = descriptorPool;
-	setAllocateInfo.descriptorSetCount = static_cast<uint32_t>(pipelineCreateInfo.swapchainImageCount);
+	setAllocateInfo.descriptorSetCount = static_cast<uint32_t>(pipelineCreateInfo.frameCount);
 	setAllocateInfo.pSetLayouts = setLayouts.data();
 
 	VkResult vkResult = vkAllocateDescriptorSets(pipelineCreateInfo.device.logicalDevice, &setAllocateInfo, descriptorSets.data());
@@ -619,7 +654,7 @@ void Renderer::RenderPipeline::CreateDescriptorSets()
 		throw std::runtime_error("Failed to allocate descriptor set");
 	}
 
-	for (size_t i = 0; i < pipelineCreateInfo.swapchainImageCount; i++)
+	for (size_t i = 0; i < pipelineCreateInfo.frameCount; i++)
 	{
 		VkDescriptorBufferInfo vpBufferInfo = {};
 		vpBufferInfo.buffer = vpUniformBuffer[i];
@@ -635,38 +670,46 @@ void Renderer::RenderPipeline::CreateDescriptorSets()
 		vpSetWrite.descriptorCount = 1;
 		vpSetWrite.pBufferInfo = &vpBufferInfo;
 
-		VkDescriptorBufferInfo modelBufferInfo = {};
-		modelBufferInfo.buffer = modelUniformDynamicBuffer[i];
-		modelBufferInfo.offset = 0;
-		modelBufferInfo.range = modelUniformAlignment;
+		vkUpdateDescriptorSets(pipelineCreateInfo.device.logicalDevice, 1, &vpSetWrite, 0, nullptr);
+	}
+}
 
-		VkWriteDescriptorSet modelSetWrite = {};
-		modelSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		modelSetWrite.dstSet = descriptorSets[i];
-		modelSetWrite.dstBinding = 1;
-		modelSetWrite.dstArrayElement = 0;
-		modelSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-		modelSetWrite.descriptorCount = 1;
-		modelSetWrite.pBufferInfo = &modelBufferInfo;
+void Renderer::RenderPipeline::CreateTextureDescriptorSet()
+{
+	PROFILE_FUNCTION();
 
-		std::vector<VkWriteDescriptorSet> setWrites = { vpSetWrite, modelSetWrite };
+	VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountAllocInfo = {};
+	variableCountAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+	variableCountAllocInfo.descriptorSetCount = 1;
+	variableCountAllocInfo.pDescriptorCounts = &textureCapacity;
 
-		vkUpdateDescriptorSets(pipelineCreateInfo.device.logicalDevice, static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.pNext = &variableCountAllocInfo;
+	allocInfo.descriptorPool = samplerDescriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &samplerSetLayout;
+
+	VkResult vkResult = vkAllocateDescriptorSets(pipelineCreateInfo.device.logicalDevice, &allocInfo, &textureDescriptorSet);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate texture descriptor sets!");
 	}
 }
 
 void Renderer::RenderPipeline::CreateInputDescriptorSets()
 {
 	PROFILE_FUNCTION();
-	// Resize array to hold descriptor set for each Swapchain image
-	inputDescriptorSets.resize(pipelineCreateInfo.swapchainImageCount);
+	// Resize array to hold descriptor set for each frame in flight
+	inputDescriptorSets.resize(pipelineCreateInfo.frameCount);
 
-	std::vector<VkDescriptorSetLayout> setLayouts(pipelineCreateInfo.swapchainImageCount, inputSetLayout);
+	std::vector<VkDescriptorSetLayout> setLayouts(pipelineCreateInfo.frameCount, inputSetLayout);
 
 	VkDescriptorSetAllocateInfo setAllocInfo = {};
 	setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 	setAllocInfo.descriptorPool = inputDescriptorPool;
-	setAllocInfo.descriptorSetCount = static_cast<uint32_t>(pipelineCreateInfo.swapchainImageCount);
+	setAllocInfo.descriptorSetCount = static_cast<uint32_t>(pipelineCreateInfo.frameCount);
 	setAllocInfo.pSetLayouts = setLayouts.data();
 
 	VkResult result = vkAllocateDescriptorSets(pipelineCreateInfo.device.logicalDevice, &setAllocInfo, inputDescriptorSets.data());
@@ -677,77 +720,34 @@ void Renderer::RenderPipeline::CreateInputDescriptorSets()
 	}
 
 	// Update each descriptor set with input attachment
+	// Every frame reads the same shared G-buffer, bindings follow the colour target order with depth last
+	std::vector<VkImageView> inputViews = pipelineCreateInfo.gBufferImageViews;
+	inputViews.push_back(pipelineCreateInfo.depthBufferImageView);
 
-	for (size_t i = 0; i < pipelineCreateInfo.swapchainImageCount; i++)
+	std::vector<VkDescriptorImageInfo> attachmentDescriptors(inputViews.size());
+	for (size_t i = 0; i < inputViews.size(); i++)
 	{
-		// Position attachment descriptor
-		VkDescriptorImageInfo positionAttachmentDescriptor = {};
-		positionAttachmentDescriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		positionAttachmentDescriptor.imageView = pipelineCreateInfo.positionBufferImageViewPtr->at(i);
-		positionAttachmentDescriptor.sampler = VK_NULL_HANDLE;
-
-		// Position attachment descriptor write
-		VkWriteDescriptorSet positionWrite = {};
-		positionWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		positionWrite.dstSet = inputDescriptorSets[i];
-		positionWrite.dstBinding = 0;
-		positionWrite.dstArrayElement = 0;
-		positionWrite.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-		positionWrite.descriptorCount = 1;
-		positionWrite.pImageInfo = &positionAttachmentDescriptor;
-
-		// Normal attachment descriptor
-		VkDescriptorImageInfo normalAttachmentDescriptor = {};
-		normalAttachmentDescriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		normalAttachmentDescriptor.imageView = pipelineCreateInfo.normalBufferImageViewPtr->at(i);
-		normalAttachmentDescriptor.sampler = VK_NULL_HANDLE;
-
-		// Normal attachment descriptor write
-		VkWriteDescriptorSet normalWrite = {};
-		normalWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		normalWrite.dstSet = inputDescriptorSets[i];
-		normalWrite.dstBinding = 1;
-		normalWrite.dstArrayElement = 0;
-		normalWrite.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-		normalWrite.descriptorCount = 1;
-		normalWrite.pImageInfo = &normalAttachmentDescriptor;
-
-		// Colour attachment descriptor
-		VkDescriptorImageInfo colourAttachmentDescriptor = {};
-		colourAttachmentDescriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		colourAttachmentDescriptor.imageView = pipelineCreateInfo.albedoBufferImageViewPtr->at(i);
-		colourAttachmentDescriptor.sampler = VK_NULL_HANDLE;
-
-		// Colour attachment descriptor write
-		VkWriteDescriptorSet colourWrite = {};
-		colourWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		colourWrite.dstSet = inputDescriptorSets[i];
-		colourWrite.dstBinding = 2;
-		colourWrite.dstArrayElement = 0;
-		colourWrite.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-		colourWrite.descriptorCount = 1;
-		colourWrite.pImageInfo = &colourAttachmentDescriptor;
-
-		// Depth attachment descriptor
-		VkDescriptorImageInfo depthAttachmentDescriptor = {};
-		depthAttachmentDescriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		depthAttachmentDescriptor.imageView = pipelineCreateInfo.depthBufferImageViewPtr->at(i);
-		depthAttachmentDescriptor.sampler = VK_NULL_HANDLE;
-
-		// Depth attachment descriptor write
-		VkWriteDescriptorSet depthWrite = {};
-		depthWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		depthWrite.dstSet = inputDescriptorSets[i];
-		depthWrite.dstBinding = 3;
-		depthWrite.dstArrayElement = 0;
-		depthWrite.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-		depthWrite.descriptorCount = 1;
-		depthWrite.pImageInfo = &depthAttachmentDescriptor;
-
-		std::array<VkWriteDescriptorSet, 4> setWrites = { positionWrite, normalWrite, colourWrite, depthWrite };
+		attachmentDescriptors[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		attachmentDescriptors[i].imageView = inputViews[i];
+		attachmentDescriptors[i].sampler = VK_NULL_HANDLE;
+	}
 
-		vkUpdateDescriptorSets(pipelineCreateInfo.device.logicalDevice, static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
+	for (size_t i = 0; i < pipelineCreateInfo.frameCount; i++)
+	{
+		std::vector<VkWriteDescriptorSet> setWrites(attachmentDescriptors.size());
+
+		for (uint32_t binding = 0; binding < setWrites.size(); binding++)
+		{
+			setWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			setWrites[binding].dstSet = inputDescriptorSets[i];
+			setWrites[binding].dstBinding = binding;
+			setWrites[binding].dstArrayElement = 0;
+			setWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			setWrites[binding].descriptorCount = 1;
+			setWrites[binding].pImageInfo = &attachmentDescriptors[binding];
+		}
 
+		vkUpdateDescriptorSets(pipelineCreateInfo.device.logicalDevice, static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
 	}
 }
 
@@ -755,17 +755,7 @@ void Renderer::RenderPipeline::CreatePushConstantRange()
 {
 	PROFILE_FUNCTION();
 
-	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 	pushConstantRange.offset = 0;
-	pushConstantRange.size = sizeof(glm::mat4);
-}
-
-void Renderer::RenderPipeline::AllocateDynamicBufferTransferSpace()
-{
-	PROFILE_FUNCTION();
-
-	modelUniformAlignment = (sizeof(UboModel) + pipelineCreateInfo.minUniformBufferOffset - 1) & ~(pipelineCreateInfo.minUniformBufferOffset - 1);
-
-	// Create space in memory to hold dynamic buffer that is aligned to our required alignment and holds MAX_OBJECTS
-	modelTransferSpace = (UboModel*)_aligned_malloc(modelUniformAlignment * MAX_OBJECTS, modelUniformAlignment);
+	pushConstantRange.size = sizeof(PushModel);
 }
@@ -2,6 +2,7 @@
 #include "VulkanRenderer.h"
 #include <string>
 #include "Mesh.h"
+#include "GBufferLayout.h"
 namespace Renderer
 {
 	class RenderPipeline
@@ -18,32 +19,43 @@ namespace Renderer
 		{
 			ShaderModuleSet firstPassShaderModule;
 			ShaderModuleSet secondPassShaderModule;
+			VkShaderModule depthOnlyVertexModule; // Position only vertex stage of the depth passes
 			VkExtent2D extent;
 			DeviceHandle device;
 			VkRenderPass renderPass;
-			size_t swapchainImageCount = 0;
-			VkDeviceSize minUniformBufferOffset;
-			std::vector<VkImageView>* positionBufferImageViewPtr = nullptr;
-			std::vector<VkImageView>* normalBufferImageViewPtr = nullptr;
-			std::vector<VkImageView>* albedoBufferImageViewPtr = nullptr;
-			std::vector<VkImageView>* depthBufferImageViewPtr = nullptr;
+			VkRenderPass earlyRenderPass; // Depth only pass drawing the early occlusion culling phase
+			size_t frameCount = 0; // Frames in flight, uniforms and descriptor sets are created once per frame
+			GBufferLayout gBufferLayout = GBufferLayout::STANDARD;
+			std::vector<VkImageView> gBufferImageViews; // Colour targets in GetGBufferColourTargets order, shared by every frame
+			VkImageView depthBufferImageView;
+			VkDescriptorSetLayout lightClusterSetLayout = nullptr; // Lights and per cluster light lists, set 1 of the lighting subpass
+			VkDescriptorSetLayout shadowSetLayout = nullptr; // Shadow cascades of the key light, set 2 of the lighting subpass
+			VkDescriptorSetLayout visibilitySetLayout = nullptr; // Merged geometry and draw table, set 4 of the visibility layout's lighting subpass
 		};
 
 		RenderPipeline() = default;
 		~RenderPipeline();
 		void Init(const RenderPipelineCreateInfo& pipelineCreateInfo);
 		VkPipeline GetPipeline() const;
+		/** G-buffer pipeline for after a depth pre-pass, tests equal without writing depth so each pixel is shaded once */
+		VkPipeline GetDepthEqualPipeline() const;
+		/** Position only depth pipeline, draws the early occlusion phase and the depth pre-pass */
+		VkPipeline GetEarlyPipeline() const;
 		VkPipeline GetSecondPipeline() const;
 		VkPipelineLayout GetPipelineLayout() const;
 		VkPipelineLayout GetSecondPipelineLayout() const;
 		VkDescriptorSet& GetDescriptorSet(uint32_t index);
-		VkDescriptorSet& GetSamplerDescriptorSet(uint32_t index);
+		/** Holds every texture, bound once per pass and indexed with the texture index pushed per draw */
+		VkDescriptorSet& GetTextureDescriptorSet();
 		VkDescriptorSet& GetInputDescriptorSet(uint32_t index);
 		void SetPerspectiveProjectionMatrix(float fov, float aspectRatio, float nearPlane, float farPlane);
 		void SetViewMatrixFromLookAt(const glm::vec3& location, const glm::vec3& lookAt, const glm::vec3& upVec);
+		void SetViewProjection(const UboViewProjection& viewProjection);
 		void SetModelMatrix(const glm::mat4& mat);
-		void UpdateUniformBuffers(uint32_t imageIndex, const std::vector<Model>& modelList);
-		uint32_t GetModelUniformAlignment() const;
+		const UboViewProjection& GetViewProjection() const;
+		/** Uploads the frame's view projection, model matrices are push constants set per draw */
+		void UpdateUniformBuffers(uint32_t frameIndex);
+		/** Writes the texture into the next free slot of the texture array and returns its index */
 		uint32_t CreateTextureDescriptor(VkImageView textureImage, VkSampler textureSampler);
 
 	private:
@@ -52,6 +64,8 @@ namespace Renderer
 		VkPipelineLayout pipelineLayout = nullptr;
 		VkPipelineLayout secondPipelineLayout = nullptr;
 		VkPipeline gfxPipeline = nullptr;
+		VkPipeline depthEqualGfxPipeline = nullptr;
+		VkPipeline earlyGfxPipeline = nullptr;
 		VkPipeline secondPipeline = nullptr;
 
 		VkDescriptorSetLayout descriptorSetLayout = nullptr;
@@ -62,28 +76,23 @@ namespace Renderer
 		VkDescriptorPool descriptorPool = nullptr;
 		VkDescriptorPool samplerDescriptorPool = nullptr;
 		VkDescriptorPool inputDescriptorPool = nullptr;
-		std::vector<VkDescriptorSet> descriptorSets; // We need as many of these as there are swapchain images
-		std::vector<VkDescriptorSet> samplerDescriptorSets; // We need one of these per image
-		std::vector<VkDescriptorSet> inputDescriptorSets; // We need one of these per image
-
-		uint32_t modelUniformAlignment;
-		UboModel* modelTransferSpace = nullptr;
+		std::vector<VkDescriptorSet> descriptorSets; // One per frame in flight
+		VkDescriptorSet textureDescriptorSet = nullptr; // Variable count array of all textures, updated after bind
+		uint32_t textureCapacity = 0;
+		uint32_t textureCount = 0;
+		std::vector<VkDescriptorSet> inputDescriptorSets; // One per frame in flight
 
 		std::vector<VkBuffer> vpUniformBuffer;
 		std::vector<VkDeviceMemory> vpUniformBufferMemory;
 
-		std::vector<VkBuffer> modelUniformDynamicBuffer;
-		std::vector<VkDeviceMemory> modelUniformDynamicBufferMemory;
-
 		UboViewProjection uboViewProjection;
 
 		void CreateDescriptorSetLayout();
 		void CreateUniformBuffers();
 		void CreateDescriptorPool();
 		void CreateDescriptorSets();
+		void CreateTextureDescriptorSet();
 		void CreateInputDescriptorSets();
 		void CreatePushConstantRange();
-
-		void AllocateDynamicBufferTransferSpace();
 	};
 }
\ No newline at end of file
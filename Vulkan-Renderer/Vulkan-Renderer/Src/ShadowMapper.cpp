@@ -0,0 +1,591 @@
+#include "ShadowMapper.h"
+#include <stdexcept>
+#include <cstring>
+
+Renderer::ShadowMapper::~ShadowMapper()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	for (size_t i = 0; i < uniformBuffers.size(); i++)
+	{
+		vkDestroyBuffer(device, uniformBuffers[i], nullptr);
+		Utils::FreeMemory(device, uniformBufferMemory[i]);
+	}
+
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+	vkDestroyPipeline(device, pipeline, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+
+	for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		vkDestroyFramebuffer(device, cascadeFrameBuffers[cascade], nullptr);
+		vkDestroyImageView(device, cascadeViews[cascade], nullptr);
+	}
+
+	vkDestroyRenderPass(device, renderPass, nullptr);
+	vkDestroySampler(device, shadowSampler, nullptr);
+	vkDestroyImageView(device, shadowMapView, nullptr);
+	vkDestroyImage(device, shadowMapImage, nullptr);
+	Utils::FreeMemory(device, shadowMapMemory);
+}
+
+void Renderer::ShadowMapper::Init(const ShadowMapperCreateInfo& shadowCreateInfo)
+{
+	PROFILE_FUNCTION();
+
+	createInfo = shadowCreateInfo;
+
+	CreateShadowMap();
+	CreateSampler();
+	CreateRenderPass();
+	CreateFrameBuffers();
+	CreateDescriptorSetLayout();
+	CreatePipeline();
+	CreateDescriptorPool();
+	CreateUniformBuffers();
+	CreateDescriptorSets();
+}
+
+void Renderer::ShadowMapper::UpdateCascades(uint32_t frameIndex, const ShadowCascades& cascades, const glm::vec3& toLight)
+{
+	PROFILE_FUNCTION();
+
+	ShadowUniforms shadowUniforms = {};
+	for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		shadowUniforms.cascadeViewProjections[cascade] = cascades[cascade].viewProjection;
+		shadowUniforms.cascadeSplits[cascade] = cascades[cascade].splitDepth;
+		shadowUniforms.cascadeTexelSizes[cascade] = cascades[cascade].texelSize;
+	}
+	shadowUniforms.toLight = glm::vec4(glm::normalize(toLight), 0.0f);
+
+	void* data = nullptr;
+	vkMapMemory(createInfo.device.logicalDevice, uniformBufferMemory[frameIndex], 0, sizeof(ShadowUniforms), 0, &data);
+	PROFILE_COUNT_ADD(UPLOADED_BYTES, sizeof(ShadowUniforms));
+	memcpy(data, &shadowUniforms, sizeof(ShadowUniforms));
+	vkUnmapMemory(createInfo.device.logicalDevice, uniformBufferMemory[frameIndex]);
+}
+
+void Renderer::ShadowMapper::RecordCascade(VkCommandBuffer commandBuffer, uint32_t cascade, const glm::mat4& cascadeViewProjection, const std::vector<ShadowCaster>& casters)
+{
+	PROFILE_FUNCTION();
+
+	VkClearValue clearValue = {};
+	clearValue.depthStencil.depth = 1.0f;
+
+	VkRenderPassBeginInfo renderPassBeginInfo = {};
+	renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassBeginInfo.renderPass = renderPass;
+	renderPassBeginInfo.framebuffer = cascadeFrameBuffers[cascade];
+	renderPassBeginInfo.renderArea.offset = { 0, 0 };
+	renderPassBeginInfo.renderArea.extent = { createInfo.shadowMapSize, createInfo.shadowMapSize };
+	renderPassBeginInfo.clearValueCount = 1;
+	renderPassBeginInfo.pClearValues = &clearValue;
+
+	vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	PROFILE_COUNT(PIPELINE_BINDS);
+
+	VkBuffer boundPositionBuffer = VK_NULL_HANDLE;
+
+	for (const ShadowCaster& caster : casters)
+	{
+		// Only the position stream is bound, shadow maps never fetch the other attributes
+		if (caster.mesh->GetPositionBuffer() != boundPositionBuffer)
+		{
+			VkBuffer positionBuffer = caster.mesh->GetPositionBuffer();
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &positionBuffer, &offset);
+			PROFILE_COUNT(VERTEX_BUFFER_BINDS);
+			vkCmdBindIndexBuffer(commandBuffer, caster.mesh->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			boundPositionBuffer = positionBuffer;
+		}
+
+		const glm::mat4 lightModelViewProjection = cascadeViewProjection * caster.model;
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &lightModelViewProjection);
+		vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(caster.mesh->GetIndexCount()), 1, 0, 0, 0);
+		PROFILE_COUNT(DRAW_CALLS);
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+}
+
+VkDescriptorSetLayout Renderer::ShadowMapper::GetDescriptorSetLayout() const
+{
+	return descriptorSetLayout;
+}
+
+VkDescriptorSet& Renderer::ShadowMapper::GetDescriptorSet(uint32_t frameIndex)
+{
+	return descriptorSets[frameIndex];
+}
+
+void Renderer::ShadowMapper::CreateShadowMap()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	VkImageCreateInfo imageCreateInfo = {};
+	imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageCreateInfo.extent = { createInfo.shadowMapSize, createInfo.shadowMapSize, 1 };
+	imageCreateInfo.mipLevels = 1;
+	imageCreateInfo.arrayLayers = SHADOW_CASCADE_COUNT;
+	imageCreateInfo.format = createInfo.depthFormat;
+	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageCreateInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkResult vkResult = vkCreateImage(device, &imageCreateInfo, nullptr, &shadowMapImage);
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create shadow map image");
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetImageMemoryRequirements(device, shadowMapImage, &memoryRequirements);
+
+	VkMemoryAllocateInfo memoryAllocInfo = {};
+	memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memoryAllocInfo.allocationSize = memoryRequirements.size;
+	memoryAllocInfo.memoryTypeIndex = Utils::FindMemoryTypeIndex(createInfo.device.physicalDevice, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	vkResult = Utils::AllocateMemory(device, &memoryAllocInfo, &shadowMapMemory);
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate memory for shadow map");
+	}
+
+	vkBindImageMemory(device, shadowMapImage, shadowMapMemory, 0);
+
+	VkImageViewCreateInfo viewCreateInfo = {};
+	viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewCreateInfo.image = shadowMapImage;
+	viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+	viewCreateInfo.format = createInfo.depthFormat;
+	viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	viewCreateInfo.subresourceRange.baseMipLevel = 0;
+	viewCreateInfo.subresourceRange.levelCount = 1;
+	viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+	viewCreateInfo.subresourceRange.layerCount = SHADOW_CASCADE_COUNT;
+
+	vkResult = vkCreateImageView(device, &viewCreateInfo, nullptr, &shadowMapView);
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create shadow map image view");
+	}
+
+	viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewCreateInfo.subresourceRange.layerCount = 1;
+
+	for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		viewCreateInfo.subresourceRange.baseArrayLayer = cascade;
+
+		vkResult = vkCreateImageView(device, &viewCreateInfo, nullptr, &cascadeViews[cascade]);
+		if (vkResult != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create shadow cascade image view");
+		}
+	}
+
+	// Start unshadowed and in the layout the lighting subpass samples, so a cascade can be read before it was ever rendered
+	VkCommandBuffer commandBuffer = Utils::BeginCmdBuffer(device, createInfo.commandPool);
+
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = shadowMapImage;
+	imageBarrier.subresourceRange = viewCreateInfo.subresourceRange;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = SHADOW_CASCADE_COUNT;
+	imageBarrier.srcAccessMask = 0;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+	PROFILE_COUNT(PIPELINE_BARRIERS);
+
+	VkClearDepthStencilValue farDepth = {};
+	farDepth.depth = 1.0f;
+	vkCmdClearDepthStencilImage(commandBuffer, shadowMapImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &farDepth, 1, &imageBarrier.subresourceRange);
+
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+	PROFILE_COUNT(PIPELINE_BARRIERS);
+
+	Utils::EndAndSubmitCmdBuffer(device, createInfo.commandPool, createInfo.queue, commandBuffer);
+}
+
+void Renderer::ShadowMapper::CreateSampler()
+{
+	PROFILE_FUNCTION();
+
+	// Comparison sampler, linear filtering blends four depth tests for a little hardware PCF
+	VkSamplerCreateInfo samplerCreateInfo = {};
+	samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+	samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerCreateInfo.compareEnable = VK_TRUE;
+	samplerCreateInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	samplerCreateInfo.anisotropyEnable = VK_FALSE;
+	samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerCreateInfo.minLod = 0.0f;
+	samplerCreateInfo.maxLod = 0.0f;
+
+	VkResult vkResult = vkCreateSampler(createInfo.device.logicalDevice, &samplerCreateInfo, nullptr, &shadowSampler);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create shadow map sampler");
+	}
+}
+
+void Renderer::ShadowMapper::CreateRenderPass()
+{
+	PROFILE_FUNCTION();
+
+	// A cascade is always cleared and fully redrawn, the other layers keep their contents
+	VkAttachmentDescription depthAttachment = {};
+	depthAttachment.format = createInfo.depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+	VkAttachmentReference depthAttachmentReference = {};
+	depthAttachmentReference.attachment = 0;
+	depthAttachmentReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 0;
+	subpass.pDepthStencilAttachment = &depthAttachmentReference;
+
+	std::array<VkSubpassDependency, 2> subpassDependencies{};
+
+	// The shadow map is shared by every frame in flight, the previous frame's lighting subpass must be done reading it
+	subpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	subpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	subpassDependencies[0].srcAccessMask = 0;
+	subpassDependencies[0].dstSubpass = 0;
+	subpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	subpassDependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	subpassDependencies[0].dependencyFlags = 0;
+
+	// Sampled by this frame's lighting subpass
+	subpassDependencies[1].srcSubpass = 0;
+	subpassDependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	subpassDependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	subpassDependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	subpassDependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	subpassDependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	subpassDependencies[1].dependencyFlags = 0;
+
+	VkRenderPassCreateInfo renderPassCreateInfo = {};
+	renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassCreateInfo.attachmentCount = 1;
+	renderPassCreateInfo.pAttachments = &depthAttachment;
+	renderPassCreateInfo.subpassCount = 1;
+	renderPassCreateInfo.pSubpasses = &subpass;
+	renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
+	renderPassCreateInfo.pDependencies = subpassDependencies.data();
+
+	VkResult vkResult = vkCreateRenderPass(createInfo.device.logicalDevice, &renderPassCreateInfo, nullptr, &renderPass);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create shadow render pass");
+	}
+}
+
+void Renderer::ShadowMapper::CreateFrameBuffers()
+{
+	PROFILE_FUNCTION();
+
+	for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		VkFramebufferCreateInfo frameBufferCreateInfo = {};
+		frameBufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		frameBufferCreateInfo.renderPass = renderPass;
+		frameBufferCreateInfo.attachmentCount = 1;
+		frameBufferCreateInfo.pAttachments = &cascadeViews[cascade];
+		frameBufferCreateInfo.width = createInfo.shadowMapSize;
+		frameBufferCreateInfo.height = createInfo.shadowMapSize;
+		frameBufferCreateInfo.layers = 1;
+
+		VkResult vkResult = vkCreateFramebuffer(createInfo.device.logicalDevice, &frameBufferCreateInfo, nullptr, &cascadeFrameBuffers[cascade]);
+
+		if (vkResult != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create shadow cascade framebuffer");
+		}
+	}
+}
+
+void Renderer::ShadowMapper::CreateDescriptorSetLayout()
+{
+	PROFILE_FUNCTION();
+
+	// Cascade uniforms and the shadow map, read by the lighting subpass
+	std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutCreateInfo.pBindings = bindings.data();
+
+	VkResult vkResult = vkCreateDescriptorSetLayout(createInfo.device.logicalDevice, &layoutCreateInfo, nullptr, &descriptorSetLayout);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor set layout");
+	}
+}
+
+void Renderer::ShadowMapper::CreatePipeline()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	// Light space transform of the caster, premultiplied on the CPU
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(glm::mat4);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = 0;
+	pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+	pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkResult vkResult = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline layout");
+	}
+
+	VkPipelineShaderStageCreateInfo vertexShaderCreateInfo = {};
+	vertexShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vertexShaderCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	vertexShaderCreateInfo.module = createInfo.shadowVertexModule;
+	vertexShaderCreateInfo.pName = "main";
+
+	// Position stream only, same binding 0 as the G-buffer pipelines
+	VkVertexInputBindingDescription positionBindingDesc = {};
+	positionBindingDesc.binding = 0;
+	positionBindingDesc.stride = sizeof(glm::vec3);
+	positionBindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	VkVertexInputAttributeDescription positionAttributeDesc = {};
+	positionAttributeDesc.binding = 0;
+	positionAttributeDesc.location = 0;
+	positionAttributeDesc.format = VK_FORMAT_R32G32B32_SFLOAT;
+	positionAttributeDesc.offset = 0;
+
+	VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
+	vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
+	vertexInputCreateInfo.pVertexBindingDescriptions = &positionBindingDesc;
+	vertexInputCreateInfo.vertexAttributeDescriptionCount = 1;
+	vertexInputCreateInfo.pVertexAttributeDescriptions = &positionAttributeDesc;
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+	VkViewport viewport = {};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(createInfo.shadowMapSize);
+	viewport.height = static_cast<float>(createInfo.shadowMapSize);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor = {};
+	scissor.offset = { 0,0 };
+	scissor.extent = { createInfo.shadowMapSize, createInfo.shadowMapSize };
+
+	VkPipelineViewportStateCreateInfo viewportStateCreateInfo = {};
+	viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportStateCreateInfo.viewportCount = 1;
+	viewportStateCreateInfo.pViewports = &viewport;
+	viewportStateCreateInfo.scissorCount = 1;
+	viewportStateCreateInfo.pScissors = &scissor;
+
+	// Depth clamp flattens casters between the light and the cascade onto its near plane instead of clipping them.
+	// No culling, the light space projection isn't y flipped like the camera's so winding differs, and open meshes still cast from both sides
+	VkPipelineRasterizationStateCreateInfo rasterizerCreateInfo = {};
+	rasterizerCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizerCreateInfo.depthClampEnable = VK_TRUE;
+	rasterizerCreateInfo.rasterizerDiscardEnable = VK_FALSE;
+	rasterizerCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizerCreateInfo.lineWidth = 1.0f;
+	rasterizerCreateInfo.cullMode = VK_CULL_MODE_NONE;
+	rasterizerCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterizerCreateInfo.depthBiasEnable = VK_TRUE;
+	rasterizerCreateInfo.depthBiasConstantFactor = 1.25f;
+	rasterizerCreateInfo.depthBiasSlopeFactor = 1.75f;
+
+	VkPipelineMultisampleStateCreateInfo multiSampleCreateInfo = {};
+	multiSampleCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multiSampleCreateInfo.sampleShadingEnable = VK_FALSE;
+	multiSampleCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineColorBlendStateCreateInfo colorBlendingCreateInfo = {};
+	colorBlendingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlendingCreateInfo.logicOpEnable = VK_FALSE;
+	colorBlendingCreateInfo.attachmentCount = 0;
+	colorBlendingCreateInfo.pAttachments = nullptr;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo = {};
+	depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencilCreateInfo.depthTestEnable = VK_TRUE;
+	depthStencilCreateInfo.depthWriteEnable = VK_TRUE;
+	depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
+	depthStencilCreateInfo.stencilTestEnable = VK_FALSE;
+
+	VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo = {};
+	graphicsPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	graphicsPipelineCreateInfo.stageCount = 1;
+	graphicsPipelineCreateInfo.pStages = &vertexShaderCreateInfo;
+	graphicsPipelineCreateInfo.pVertexInputState = &vertexInputCreateInfo;
+	graphicsPipelineCreateInfo.pInputAssemblyState = &inputAssembly;
+	graphicsPipelineCreateInfo.pViewportState = &viewportStateCreateInfo;
+	graphicsPipelineCreateInfo.pDynamicState = nullptr;
+	graphicsPipelineCreateInfo.pRasterizationState = &rasterizerCreateInfo;
+	graphicsPipelineCreateInfo.pMultisampleState = &multiSampleCreateInfo;
+	graphicsPipelineCreateInfo.pColorBlendState = &colorBlendingCreateInfo;
+	graphicsPipelineCreateInfo.pDepthStencilState = &depthStencilCreateInfo;
+	graphicsPipelineCreateInfo.layout = pipelineLayout;
+	graphicsPipelineCreateInfo.renderPass = renderPass;
+	graphicsPipelineCreateInfo.subpass = 0;
+	graphicsPipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+	graphicsPipelineCreateInfo.basePipelineIndex = -1;
+
+	vkResult = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &pipeline);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create shadow pipeline");
+	}
+}
+
+void Renderer::ShadowMapper::CreateDescriptorPool()
+{
+	PROFILE_FUNCTION();
+
+	const uint32_t frameCount = static_cast<uint32_t>(createInfo.frameCount);
+
+	std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].descriptorCount = frameCount;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[1].descriptorCount = frameCount;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = frameCount;
+	poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolCreateInfo.pPoolSizes = poolSizes.data();
+
+	VkResult vkResult = vkCreateDescriptorPool(createInfo.device.logicalDevice, &poolCreateInfo, nullptr, &descriptorPool);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor pool");
+	}
+}
+
+void Renderer::ShadowMapper::CreateUniformBuffers()
+{
+	PROFILE_FUNCTION();
+
+	const size_t frameCount = createInfo.frameCount;
+
+	uniformBuffers.resize(frameCount);
+	uniformBufferMemory.resize(frameCount);
+
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, sizeof(ShadowUniforms),
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&uniformBuffers[i], &uniformBufferMemory[i] });
+	}
+}
+
+void Renderer::ShadowMapper::CreateDescriptorSets()
+{
+	PROFILE_FUNCTION();
+
+	descriptorSets.resize(createInfo.frameCount);
+	std::vector<VkDescriptorSetLayout> setLayouts(descriptorSets.size(), descriptorSetLayout);
+
+	VkDescriptorSetAllocateInfo setAllocateInfo = {};
+	setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocateInfo.descriptorPool = descriptorPool;
+	setAllocateInfo.descriptorSetCount = static_cast<uint32_t>(descriptorSets.size());
+	setAllocateInfo.pSetLayouts = setLayouts.data();
+
+	if (vkAllocateDescriptorSets(createInfo.device.logicalDevice, &setAllocateInfo, descriptorSets.data()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate shadow descriptor sets");
+	}
+
+	for (size_t i = 0; i < descriptorSets.size(); i++)
+	{
+		VkDescriptorBufferInfo bufferInfo = { uniformBuffers[i], 0, sizeof(ShadowUniforms) };
+		VkDescriptorImageInfo imageInfo = { shadowSampler, shadowMapView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+
+		std::array<VkWriteDescriptorSet, 2> setWrites = {};
+		setWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		setWrites[0].dstSet = descriptorSets[i];
+		setWrites[0].dstBinding = 0;
+		setWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		setWrites[0].descriptorCount = 1;
+		setWrites[0].pBufferInfo = &bufferInfo;
+
+		setWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		setWrites[1].dstSet = descriptorSets[i];
+		setWrites[1].dstBinding = 1;
+		setWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		setWrites[1].descriptorCount = 1;
+		setWrites[1].pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(createInfo.device.logicalDevice, static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+#include <array>
+#include <vector>
+#include "Utils.h"
+#include "Mesh.h"
+#include "CascadedShadows.h"
+
+namespace Renderer
+{
+	using namespace Utilities;
+
+	/**
+	* Cascaded shadow maps of the key light, one layer of a depth array image per cascade. The image outlives frames so cached
+	* cascades keep their contents, the lighting subpass samples every layer through one descriptor set per frame
+	*/
+	class ShadowMapper
+	{
+	public:
+		struct ShadowMapperCreateInfo
+		{
+			DeviceHandle device;
+			VkQueue queue;
+			VkCommandPool commandPool;
+			size_t frameCount = 0; // Frames in flight, uniforms and descriptor sets are created once per frame
+			VkFormat depthFormat;
+			uint32_t shadowMapSize = 0;
+			VkShaderModule shadowVertexModule;
+		};
+
+		struct ShadowCaster
+		{
+			const Mesh* mesh;
+			glm::mat4 model;
+		};
+
+		ShadowMapper() = default;
+		~ShadowMapper();
+		void Init(const ShadowMapperCreateInfo& shadowCreateInfo);
+		/** Uploads the cascades the lighting subpass samples with, the frame's fence must have signalled */
+		void UpdateCascades(uint32_t frameIndex, const ShadowCascades& cascades, const glm::vec3& toLight);
+		/** Clears the cascade's layer and draws the casters into it, made visible to fragment shaders of the passes that follow */
+		void RecordCascade(VkCommandBuffer commandBuffer, uint32_t cascade, const glm::mat4& cascadeViewProjection, const std::vector<ShadowCaster>& casters);
+		VkDescriptorSetLayout GetDescriptorSetLayout() const;
+		VkDescriptorSet& GetDescriptorSet(uint32_t frameIndex);
+
+	private:
+		// Mirrors the lighting subpasses, std140
+		struct ShadowUniforms
+		{
+			glm::mat4 cascadeViewProjections[SHADOW_CASCADE_COUNT];
+			glm::vec4 cascadeSplits;
+			glm::vec4 cascadeTexelSizes;
+			glm::vec4 toLight;
+		};
+
+		ShadowMapperCreateInfo createInfo;
+
+		VkImage shadowMapImage = nullptr;
+		VkDeviceMemory shadowMapMemory = nullptr;
+		VkImageView shadowMapView = nullptr; // Every cascade, sampled
+		std::array<VkImageView, SHADOW_CASCADE_COUNT> cascadeViews = {}; // One layer each, rendered to
+		std::array<VkFramebuffer, SHADOW_CASCADE_COUNT> cascadeFrameBuffers = {};
+		VkSampler shadowSampler = nullptr;
+
+		VkRenderPass renderPass = nullptr;
+		VkPipelineLayout pipelineLayout = nullptr;
+		VkPipeline pipeline = nullptr;
+
+		VkDescriptorSetLayout descriptorSetLayout = nullptr;
+		VkDescriptorPool descriptorPool = nullptr;
+		std::vector<VkDescriptorSet> descriptorSets; // One per frame in flight
+		std::vector<VkBuffer> uniformBuffers;
+		std::vector<VkDeviceMemory> uniformBufferMemory;
+
+		void CreateShadowMap();
+		void CreateSampler();
+		void CreateRenderPass();
+		void CreateFrameBuffers();
+		void CreateDescriptorSetLayout();
+		void CreatePipeline();
+		void CreateDescriptorPool();
+		void CreateUniformBuffers();
+		void CreateDescriptorSets();
+	};
+}
@@ -0,0 +1,447 @@
+#include "SoftwareOcclusionCulling.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <iterator>
+
+void Renderer::SoftwareOcclusionCuller::Resize(uint32_t width, uint32_t height)
+{
+	tilesX = (width + TILE_WIDTH - 1) / TILE_WIDTH;
+	tilesY = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+	this->width = tilesX * TILE_WIDTH;
+	this->height = tilesY * TILE_HEIGHT;
+
+	tiles.resize(static_cast<size_t>(tilesX) * tilesY);
+	rowFirstPixel.resize(this->height);
+	rowLastPixel.resize(this->height);
+}
+
+void Renderer::SoftwareOcclusionCuller::BeginFrame(const glm::mat4& viewProjection)
+{
+	this->viewProjection = viewProjection;
+	statistics = {};
+
+	for (Tile& tile : tiles)
+	{
+		std::fill(std::begin(tile.coverage), std::end(tile.coverage), 0u);
+		tile.zMax0 = 1.0f;
+		tile.zMax1 = 0.0f;
+	}
+}
+
+void Renderer::SoftwareOcclusionCuller::RenderOccluder(const OccluderMesh& occluderMesh, const glm::mat4& modelMatrix)
+{
+	const glm::mat4 modelViewProjection = viewProjection * modelMatrix;
+
+	clipVertices.resize(occluderMesh.positions.size());
+	for (size_t i = 0; i < occluderMesh.positions.size(); i++)
+	{
+		clipVertices[i] = modelViewProjection * glm::vec4(occluderMesh.positions[i], 1.0f);
+	}
+
+	statistics.occluderTriangles += static_cast<uint32_t>(occluderMesh.indices.size() / 3);
+
+	auto toScreen = [this](const glm::vec4& clipPos)
+	{
+		const float inverseW = 1.0f / clipPos.w;
+		return glm::vec3((clipPos.x * inverseW * 0.5f + 0.5f) * width, (clipPos.y * inverseW * 0.5f + 0.5f) * height, clipPos.z * inverseW);
+	};
+
+	for (size_t i = 0; i + 2 < occluderMesh.indices.size(); i += 3)
+	{
+		const glm::vec4& clip0 = clipVertices[occluderMesh.indices[i]];
+		const glm::vec4& clip1 = clipVertices[occluderMesh.indices[i + 1]];
+		const glm::vec4& clip2 = clipVertices[occluderMesh.indices[i + 2]];
+
+		// Triangles crossing the near plane are skipped rather than clipped, drawing less occluder is always conservative
+		if (clip0.w <= 0.0f || clip1.w <= 0.0f || clip2.w <= 0.0f || clip0.z < 0.0f || clip1.z < 0.0f || clip2.z < 0.0f)
+		{
+			continue;
+		}
+
+		RasterizeTriangle(toScreen(clip0), toScreen(clip1), toScreen(clip2));
+	}
+}
+
+bool Renderer::SoftwareOcclusionCuller::IsBoxVisible(const BoundingBox& worldBounds) const
+{
+	return IsBoxVisible(worldBounds.GetCenter(), worldBounds.GetExtents());
+}
+
+void Renderer::SoftwareOcclusionCuller::CullBoxes(const BoundingBoxSoA& bounds, std::vector<uint32_t>& indices)
+{
+	size_t visibleCount = 0;
+
+	for (uint32_t index : indices)
+	{
+		const glm::vec3 center(bounds.centerX[index], bounds.centerY[index], bounds.centerZ[index]);
+		const glm::vec3 extents(bounds.extentX[index], bounds.extentY[index], bounds.extentZ[index]);
+
+		if (IsBoxVisible(center, extents))
+		{
+			indices[visibleCount++] = index;
+		}
+	}
+
+	statistics.testedBoxes += static_cast<uint32_t>(indices.size());
+	statistics.culledBoxes += static_cast<uint32_t>(indices.size() - visibleCount);
+	indices.resize(visibleCount);
+}
+
+const Renderer::SoftwareOcclusionCuller::Statistics& Renderer::SoftwareOcclusionCuller::GetStatistics() const
+{
+	return statistics;
+}
+
+uint32_t Renderer::SoftwareOcclusionCuller::GetWidth() const
+{
+	return width;
+}
+
+uint32_t Renderer::SoftwareOcclusionCuller::GetHeight() const
+{
+	return height;
+}
+
+bool Renderer::SoftwareOcclusionCuller::IsBoxVisible(const glm::vec3& center, const glm::vec3& extents) const
+{
+	// All 8 corners at once, 4 per register, as the projected center plus or minus the projected half axes
+	const glm::vec4 clipCenter = viewProjection * glm::vec4(center, 1.0f);
+	const glm::vec4 clipAxisX = viewProjection[0] * extents.x;
+	const glm::vec4 clipAxisY = viewProjection[1] * extents.y;
+	const glm::vec4 clipAxisZ = viewProjection[2] * extents.z;
+
+	const __m128 signX = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+	const __m128 signY = _mm_setr_ps(-1.0f, -1.0f, 1.0f, 1.0f);
+
+	__m128 nearCorners[4], farCorners[4]; // x, y, z, w of corners with -Z and +Z extents
+	for (int component = 0; component < 4; component++)
+	{
+		const __m128 base = _mm_add_ps(_mm_set1_ps(clipCenter[component]),
+			_mm_add_ps(_mm_mul_ps(signX, _mm_set1_ps(clipAxisX[component])), _mm_mul_ps(signY, _mm_set1_ps(clipAxisY[component]))));
+		const __m128 axisZ = _mm_set1_ps(clipAxisZ[component]);
+		nearCorners[component] = _mm_sub_ps(base, axisZ);
+		farCorners[component] = _mm_add_ps(base, axisZ);
+	}
+
+	// Crosses the near plane, can't be bounded on screen
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 behindNear = _mm_or_ps(_mm_or_ps(_mm_cmple_ps(nearCorners[3], zero), _mm_cmplt_ps(nearCorners[2], zero)),
+		_mm_or_ps(_mm_cmple_ps(farCorners[3], zero), _mm_cmplt_ps(farCorners[2], zero)));
+	if (_mm_movemask_ps(behindNear) != 0)
+	{
+		return true;
+	}
+
+	const __m128 halfWidth = _mm_set1_ps(width * 0.5f);
+	const __m128 halfHeight = _mm_set1_ps(height * 0.5f);
+	const __m128 nearInverseW = _mm_div_ps(_mm_set1_ps(1.0f), nearCorners[3]);
+	const __m128 farInverseW = _mm_div_ps(_mm_set1_ps(1.0f), farCorners[3]);
+
+	auto horizontalMin = [](__m128 value)
+	{
+		value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+		value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(value);
+	};
+
+	auto horizontalMax = [](__m128 value)
+	{
+		value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+		value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(value);
+	};
+
+	const __m128 nearScreenX = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(nearCorners[0], nearInverseW), halfWidth), halfWidth);
+	const __m128 farScreenX = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(farCorners[0], farInverseW), halfWidth), halfWidth);
+	const __m128 nearScreenY = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(nearCorners[1], nearInverseW), halfHeight), halfHeight);
+	const __m128 farScreenY = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(farCorners[1], farInverseW), halfHeight), halfHeight);
+	const __m128 nearDepth = _mm_mul_ps(nearCorners[2], nearInverseW);
+	const __m128 farDepth = _mm_mul_ps(farCorners[2], farInverseW);
+
+	// Depth is pulled forward a few ulps near 1, projecting center plus axes rounds differently than the occluder corners,
+	// so bounds resting exactly on an occluder face would otherwise flip to occluded
+	constexpr float DEPTH_BIAS = 1e-6f;
+	const glm::vec3 screenMin(horizontalMin(_mm_min_ps(nearScreenX, farScreenX)), horizontalMin(_mm_min_ps(nearScreenY, farScreenY)), horizontalMin(_mm_min_ps(nearDepth, farDepth)) - DEPTH_BIAS);
+	const glm::vec3 screenMax(horizontalMax(_mm_max_ps(nearScreenX, farScreenX)), horizontalMax(_mm_max_ps(nearScreenY, farScreenY)), 0.0f);
+
+	// Nothing outside the buffer was rasterized, leave rejecting it to frustum culling
+	if (screenMax.x < 0.0f || screenMax.y < 0.0f || screenMin.x >= width || screenMin.y >= height)
+	{
+		return true;
+	}
+
+	const int32_t firstX = static_cast<int32_t>(std::max(screenMin.x, 0.0f));
+	const int32_t firstY = static_cast<int32_t>(std::max(screenMin.y, 0.0f));
+	const int32_t lastX = static_cast<int32_t>(std::min(screenMax.x, width - 1.0f));
+	const int32_t lastY = static_cast<int32_t>(std::min(screenMax.y, height - 1.0f));
+
+	for (int32_t tileY = firstY / static_cast<int32_t>(TILE_HEIGHT); tileY <= lastY / static_cast<int32_t>(TILE_HEIGHT); tileY++)
+	{
+		const Tile* tileRow = &tiles[static_cast<size_t>(tileY) * tilesX];
+		const int32_t tileTop = tileY * TILE_HEIGHT;
+		const int32_t firstTileRow = std::max(firstY - tileTop, 0);
+		const int32_t lastTileRow = std::min(lastY - tileTop, static_cast<int32_t>(TILE_HEIGHT) - 1);
+
+		for (int32_t tileX = firstX / static_cast<int32_t>(TILE_WIDTH); tileX <= lastX / static_cast<int32_t>(TILE_WIDTH); tileX++)
+		{
+			const Tile& tile = tileRow[tileX];
+
+			if (screenMin.z <= tile.zMax0)
+			{
+				// Still hidden when the working layer covers every pixel of the box in this tile and is nearer than the box
+				if (screenMin.z <= tile.zMax1)
+				{
+					return true;
+				}
+
+				const int32_t tileLeft = tileX * TILE_WIDTH;
+				const int32_t firstBit = std::max(firstX - tileLeft, 0);
+				const int32_t lastBit = std::min(lastX - tileLeft, static_cast<int32_t>(TILE_WIDTH) - 1);
+				const uint32_t boxMask = (~0u >> (TILE_WIDTH - 1 - lastBit)) & (~0u << firstBit);
+
+				for (int32_t row = firstTileRow; row <= lastTileRow; row++)
+				{
+					if ((boxMask & ~tile.coverage[row]) != 0)
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+void Renderer::SoftwareOcclusionCuller::RasterizeTriangle(const glm::vec3& screen0, const glm::vec3& screen1, const glm::vec3& screen2)
+{
+	glm::vec3 vertex0 = screen0;
+	glm::vec3 vertex1 = screen1;
+	glm::vec3 vertex2 = screen2;
+
+	// Occluders are drawn double sided, wind every triangle counter clockwise so the inside of each edge is positive
+	float area = (vertex1.x - vertex0.x) * (vertex2.y - vertex0.y) - (vertex2.x - vertex0.x) * (vertex1.y - vertex0.y);
+	if (std::abs(area) < 1e-6f)
+	{
+		return;
+	}
+
+	if (area < 0.0f)
+	{
+		std::swap(vertex1, vertex2);
+		area = -area;
+	}
+
+	// Pixels are covered when their center is inside, clamp in float space first since off screen vertices can be huge
+	const float minX = std::max(std::min(std::min(vertex0.x, vertex1.x), vertex2.x), 0.0f);
+	const float maxX = std::min(std::max(std::max(vertex0.x, vertex1.x), vertex2.x), static_cast<float>(width));
+	const float minY = std::max(std::min(std::min(vertex0.y, vertex1.y), vertex2.y), 0.0f);
+	const float maxY = std::min(std::max(std::max(vertex0.y, vertex1.y), vertex2.y), static_cast<float>(height));
+
+	const int32_t firstColumn = static_cast<int32_t>(std::ceil(minX - 0.5f));
+	const int32_t lastColumn = static_cast<int32_t>(std::floor(maxX - 0.5f));
+	const int32_t firstRow = static_cast<int32_t>(std::ceil(minY - 0.5f));
+	const int32_t lastRow = static_cast<int32_t>(std::floor(maxY - 0.5f));
+
+	if (firstColumn > lastColumn || firstRow > lastRow)
+	{
+		return;
+	}
+
+	statistics.rasterizedTriangles++;
+
+	// Each edge a * x + b * y + c >= 0 bounds a row's span from one side at x = slope * y + offset, horizontal edges only accept or reject rows.
+	// Spans are pulled in by a fraction of a pixel so rounding never marks a pixel center on the edge as covered
+	constexpr float EDGE_BIAS = 1.0f / 256.0f;
+	__m128 leftSlopes[3], leftOffsets[3], rightSlopes[3], rightOffsets[3], rowSlopes[3], rowOffsets[3];
+	uint32_t leftCount = 0, rightCount = 0, rowCount = 0;
+
+	const glm::vec3* edgeStarts[3] = { &vertex0, &vertex1, &vertex2 };
+	const glm::vec3* edgeEnds[3] = { &vertex1, &vertex2, &vertex0 };
+	const float centerX = (minX + maxX) * 0.5f;
+
+	for (uint32_t edge = 0; edge < 3; edge++)
+	{
+		const float a = edgeStarts[edge]->y - edgeEnds[edge]->y;
+		const float b = edgeEnds[edge]->x - edgeStarts[edge]->x;
+		const float c = -(a * edgeStarts[edge]->x + b * edgeStarts[edge]->y);
+
+		if (a > 1e-6f)
+		{
+			leftSlopes[leftCount] = _mm_set1_ps(-b / a);
+			leftOffsets[leftCount++] = _mm_set1_ps(-c / a + EDGE_BIAS);
+		}
+		else if (a < -1e-6f)
+		{
+			rightSlopes[rightCount] = _mm_set1_ps(-b / a);
+			rightOffsets[rightCount++] = _mm_set1_ps(-c / a - EDGE_BIAS);
+		}
+		else
+		{
+			rowSlopes[rowCount] = _mm_set1_ps(b);
+			rowOffsets[rowCount++] = _mm_set1_ps(c + a * centerX - EDGE_BIAS * std::abs(b));
+		}
+	}
+
+	// Spans of 4 rows at a time, in pixel center coordinates clamped to the bounding box
+	const __m128 rowCenters = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 boxLeft = _mm_set1_ps(firstColumn + 0.5f);
+	const __m128 boxRight = _mm_set1_ps(lastColumn + 0.5f);
+	const __m128 leftLimit = _mm_set1_ps(lastColumn + 1.5f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128i emptyFirst = _mm_set1_epi32(1);
+	const __m128i emptyLast = _mm_setzero_si128();
+
+	alignas(16) int32_t spanFirst[4];
+	alignas(16) int32_t spanLast[4];
+
+	for (int32_t row = firstRow; row <= lastRow; row += 4)
+	{
+		const __m128 y = _mm_add_ps(_mm_set1_ps(static_cast<float>(row)), rowCenters);
+		__m128 left = boxLeft;
+		__m128 right = boxRight;
+		__m128 rejected = _mm_setzero_ps();
+
+		for (uint32_t i = 0; i < leftCount; i++)
+		{
+			left = _mm_max_ps(_mm_add_ps(_mm_mul_ps(leftSlopes[i], y), leftOffsets[i]), left);
+		}
+
+		left = _mm_min_ps(left, leftLimit);
+
+		for (uint32_t i = 0; i < rightCount; i++)
+		{
+			right = _mm_min_ps(_mm_add_ps(_mm_mul_ps(rightSlopes[i], y), rightOffsets[i]), right);
+		}
+
+		for (uint32_t i = 0; i < rowCount; i++)
+		{
+			rejected = _mm_or_ps(rejected, _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(rowSlopes[i], y), rowOffsets[i]), zero));
+		}
+
+		// first = ceil(left - 0.5), last = floor(right - 0.5), both are kept non negative and in int range so truncation works
+		const __m128 leftPixel = _mm_sub_ps(left, half);
+		__m128i first = _mm_cvttps_epi32(leftPixel);
+		first = _mm_sub_epi32(first, _mm_castps_si128(_mm_cmplt_ps(_mm_cvtepi32_ps(first), leftPixel)));
+		__m128i last = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_max_ps(right, zero), half)), _mm_set1_epi32(1));
+
+		const __m128i rejectedMask = _mm_castps_si128(rejected);
+		first = _mm_or_si128(_mm_andnot_si128(rejectedMask, first), _mm_and_si128(rejectedMask, emptyFirst));
+		last = _mm_or_si128(_mm_andnot_si128(rejectedMask, last), _mm_and_si128(rejectedMask, emptyLast));
+
+		_mm_store_si128(reinterpret_cast<__m128i*>(spanFirst), first);
+		_mm_store_si128(reinterpret_cast<__m128i*>(spanLast), last);
+
+		for (int32_t i = 0; i < 4 && row + i <= lastRow; i++)
+		{
+			rowFirstPixel[row + i] = spanFirst[i];
+			rowLastPixel[row + i] = spanLast[i];
+		}
+	}
+
+	const int32_t firstTileRow = firstRow / static_cast<int32_t>(TILE_HEIGHT);
+	const int32_t lastTileRow = lastRow / static_cast<int32_t>(TILE_HEIGHT);
+
+	// Rows of the first and last tile rows outside the triangle stay empty
+	for (int32_t row = firstTileRow * TILE_HEIGHT; row < firstRow; row++)
+	{
+		rowFirstPixel[row] = 1;
+		rowLastPixel[row] = 0;
+	}
+
+	for (int32_t row = lastRow + 1; row < (lastTileRow + 1) * static_cast<int32_t>(TILE_HEIGHT); row++)
+	{
+		rowFirstPixel[row] = 1;
+		rowLastPixel[row] = 0;
+	}
+
+	// Depth plane z = depthX * x + depthY * y + depthOffset, its maximum over a tile is at one of the corners
+	const float depthX = ((vertex1.z - vertex0.z) * (vertex2.y - vertex0.y) - (vertex2.z - vertex0.z) * (vertex1.y - vertex0.y)) / area;
+	const float depthY = ((vertex2.z - vertex0.z) * (vertex1.x - vertex0.x) - (vertex1.z - vertex0.z) * (vertex2.x - vertex0.x)) / area;
+	const float depthOffset = vertex0.z - depthX * vertex0.x - depthY * vertex0.y;
+	const float triangleMaxDepth = std::max(std::max(vertex0.z, vertex1.z), vertex2.z);
+	const float tileDepthSpan = std::max(depthX * TILE_WIDTH, 0.0f) + std::max(depthY * TILE_HEIGHT, 0.0f);
+
+	const int32_t firstTileX = firstColumn / static_cast<int32_t>(TILE_WIDTH);
+	const int32_t lastTileX = lastColumn / static_cast<int32_t>(TILE_WIDTH);
+
+	alignas(32) uint32_t coverage[TILE_HEIGHT];
+
+	for (int32_t tileY = firstTileRow; tileY <= lastTileRow; tileY++)
+	{
+		for (int32_t tileX = firstTileX; tileX <= lastTileX; tileX++)
+		{
+			BuildTileCoverage(tileY, tileX, coverage);
+
+			const float cornerDepth = depthOffset + depthX * (tileX * TILE_WIDTH) + depthY * (tileY * TILE_HEIGHT);
+			const float tileDepth = std::min(cornerDepth + tileDepthSpan, triangleMaxDepth);
+
+			UpdateTile(tiles[static_cast<size_t>(tileY) * tilesX + tileX], coverage, tileDepth);
+		}
+	}
+}
+
+void Renderer::SoftwareOcclusionCuller::UpdateTile(Tile& tile, const uint32_t* coverage, float triangleDepth)
+{
+	uint32_t anyCoverage = 0;
+	for (uint32_t row = 0; row < TILE_HEIGHT; row++)
+	{
+		anyCoverage |= coverage[row];
+	}
+
+	if (anyCoverage == 0)
+	{
+		return;
+	}
+
+	// Drop the working layer when the new triangle is much closer than it, the two would merge into a poor bound
+	if (tile.zMax1 - triangleDepth > tile.zMax0 - tile.zMax1)
+	{
+		std::fill(std::begin(tile.coverage), std::end(tile.coverage), 0u);
+		tile.zMax1 = 0.0f;
+	}
+
+	uint32_t fullCoverage = ~0u;
+	for (uint32_t row = 0; row < TILE_HEIGHT; row++)
+	{
+		tile.coverage[row] |= coverage[row];
+		fullCoverage &= tile.coverage[row];
+	}
+
+	tile.zMax1 = std::max(tile.zMax1, triangleDepth);
+
+	// Working layer covers the tile, both layers are valid bounds for every pixel so keep the nearer one
+	if (fullCoverage == ~0u)
+	{
+		tile.zMax0 = std::min(tile.zMax0, tile.zMax1);
+		tile.zMax1 = 0.0f;
+		std::fill(std::begin(tile.coverage), std::end(tile.coverage), 0u);
+	}
+}
+
+void Renderer::SoftwareOcclusionCuller::BuildTileCoverage(int32_t tileRow, int32_t tileX, uint32_t* coverage) const
+{
+	const int32_t firstRow = tileRow * TILE_HEIGHT;
+	const int32_t tileLeft = tileX * TILE_WIDTH;
+
+#if defined(__AVX2__)
+	// Shift counts above 31 give 0, so empty and out of tile spans need no special casing
+	const __m256i tileOffset = _mm256_set1_epi32(tileLeft);
+	const __m256i allBits = _mm256_set1_epi32(-1);
+	const __m256i first = _mm256_max_epi32(_mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&rowFirstPixel[firstRow])), tileOffset), _mm256_setzero_si256());
+	const __m256i last = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&rowLastPixel[firstRow])), tileOffset);
+	const __m256i lastShift = _mm256_sub_epi32(_mm256_set1_epi32(TILE_WIDTH - 1), _mm256_min_epi32(last, _mm256_set1_epi32(TILE_WIDTH - 1)));
+
+	const __m256i rowMasks = _mm256_and_si256(_mm256_srlv_epi32(allBits, lastShift), _mm256_sllv_epi32(allBits, first));
+	_mm256_store_si256(reinterpret_cast<__m256i*>(coverage), rowMasks);
+#else
+	for (uint32_t row = 0; row < TILE_HEIGHT; row++)
+	{
+		const int32_t first = std::max(rowFirstPixel[firstRow + row] - tileLeft, 0);
+		const int32_t last = std::min(rowLastPixel[firstRow + row] - tileLeft, static_cast<int32_t>(TILE_WIDTH) - 1);
+
+		coverage[row] = first <= last ? (~0u >> (TILE_WIDTH - 1 - last)) & (~0u << first) : 0u;
+	}
+#endif
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "BoundingVolumes.h"
+
+namespace Renderer
+{
+	using namespace Utilities;
+
+	/** Simplified, closed occluder geometry in model space, usually a few dozen triangles standing in for a large mesh */
+	struct OccluderMesh
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+	};
+
+	/**
+	* CPU occlusion culling in the style of masked software occlusion culling : occluders are rasterized into a low resolution
+	* buffer of 32x8 pixel tiles, each keeping a coverage bit mask and two conservative max depth layers instead of per pixel depth.
+	* Bounds are rejected when they are behind the reference layer of every tile they overlap
+	*/
+	class SoftwareOcclusionCuller
+	{
+	public:
+		static constexpr uint32_t TILE_WIDTH = 32;
+		static constexpr uint32_t TILE_HEIGHT = 8;
+
+		struct Statistics
+		{
+			uint32_t occluderTriangles = 0;
+			uint32_t rasterizedTriangles = 0; // Occluder triangles that were in front of the near plane and not degenerate
+			uint32_t testedBoxes = 0;
+			uint32_t culledBoxes = 0;
+		};
+
+		/** Width and height are rounded up to whole tiles */
+		void Resize(uint32_t width, uint32_t height);
+		/** Clears the buffer, occluders and tests afterwards use this view projection */
+		void BeginFrame(const glm::mat4& viewProjection);
+		void RenderOccluder(const OccluderMesh& occluderMesh, const glm::mat4& modelMatrix);
+		bool IsBoxVisible(const BoundingBox& worldBounds) const;
+		/** Removes the indices of occluded boxes, keeping the order of the rest */
+		void CullBoxes(const BoundingBoxSoA& bounds, std::vector<uint32_t>& indices);
+		const Statistics& GetStatistics() const;
+		uint32_t GetWidth() const;
+		uint32_t GetHeight() const;
+
+	private:
+		struct Tile
+		{
+			alignas(32) uint32_t coverage[TILE_HEIGHT]; // Pixels of the working layer, one row per element, bit i is pixel x + i
+			float zMax0; // Farthest depth over the whole tile, always valid
+			float zMax1; // Farthest depth of the pixels covered by the working layer
+		};
+
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t tilesX = 0;
+		uint32_t tilesY = 0;
+		glm::mat4 viewProjection = glm::mat4(1.0f);
+		Statistics statistics;
+
+		std::vector<Tile> tiles;
+		std::vector<glm::vec4> clipVertices; // Scratch space for the occluder being rendered
+		std::vector<int32_t> rowFirstPixel; // Span of the triangle being rasterized, one entry per buffer row
+		std::vector<int32_t> rowLastPixel;
+
+		bool IsBoxVisible(const glm::vec3& center, const glm::vec3& extents) const;
+		void RasterizeTriangle(const glm::vec3& screen0, const glm::vec3& screen1, const glm::vec3& screen2);
+		void UpdateTile(Tile& tile, const uint32_t* coverage, float triangleDepth);
+		void BuildTileCoverage(int32_t tileRow, int32_t tileX, uint32_t* coverage) const;
+	};
+}
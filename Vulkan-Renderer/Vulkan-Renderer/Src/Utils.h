@@ -1,9 +1,16 @@
 #pragma once
 #include <stb/stb_image.h>
 #include "ConstantsAndDefines.h"
+#include "Profiler.h"
 
-#define PROFILE_SCOPE(name) BenchmarkTimer timer##__LINE__(name)
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// The name is interned once per call site, the first time it runs
+#define PROFILE_SCOPE(name) static const uint32_t PROFILE_CONCAT(profileName, __LINE__) = Utilities::Profiler::Get().InternName(name); \
+	Utilities::BenchmarkTimer PROFILE_CONCAT(timer, __LINE__)(PROFILE_CONCAT(profileName, __LINE__))
 #define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCSIG__)
+#define PROFILE_COUNT(counter) Utilities::Profiler::Get().AddToCounter(Utilities::ProfileCounter::counter)
+#define PROFILE_COUNT_ADD(counter, amount) Utilities::Profiler::Get().AddToCounter(Utilities::ProfileCounter::counter, static_cast<int64_t>(amount))
 
 #include <vector>
 #include <string>
@@ -52,6 +59,14 @@ namespace Utilities
 		glm::vec2 uv;
 	};
 
+	/** Everything but the position, meshes store positions in their own tightly packed stream */
+	struct VertexAttributes
+	{
+		glm::vec3 col;
+		glm::vec3 normal;
+		glm::vec2 uv;
+	};
+
 	struct UboViewProjection
 	{
 		glm::mat4 projection;
@@ -143,97 +158,13 @@ namespace Utilities
 		VkDeviceMemory memory;
 	};
 
-	struct ProfileResult
-	{
-		std::string Name;
-		long long Start, End;
-		size_t ThreadID;
-	};
-
-	struct BenchmarkSession
-	{
-		std::string Name;
-	};
-
-	struct Benchmark
-	{
-	public:
-		Benchmark() : currentSession(nullptr), profileCount(0) {}
-
-		void BeginSession(const std::string& name, const std::string& filepath = "results.json")
-		{
-			outputStream.open(filepath);
-			WriteHeader();
-			currentSession = new BenchmarkSession{ name };
-		}
-
-		void EndSession()
-		{
-			WriteFooter();
-			outputStream.close();
-			delete currentSession;
-			currentSession = nullptr;
-			profileCount = 0;
-		}
-
-		void WriteProfile(const ProfileResult& result)
-		{
-			if (profileCount++ > 0)
-				outputStream << ",";
-
-			std::string name = result.Name;
-			std::replace(name.begin(), name.end(), '"', '\'');
-
-			const std::string toEraseStr("__cdecl");
-			const size_t pos = name.find(toEraseStr);
-			if (pos != std::string::npos)
-			{
-				name.erase(pos, toEraseStr.length());
-			}
-
-			outputStream << "{";
-			outputStream << "\"cat\":\"function\",";
-			outputStream << "\"dur\":" << (result.End - result.Start) << ',';
-			outputStream << "\"name\":\"" << name << "\",";
-			outputStream << "\"ph\":\"X\",";
-			outputStream << "\"pid\":0,";
-			outputStream << "\"tid\":" << result.ThreadID << ",";
-			outputStream << "\"ts\":" << result.Start;
-			outputStream << "}";
-
-			outputStream.flush();
-		}
-
-		void WriteHeader()
-		{
-			outputStream << "{\"otherData\": {},\"traceEvents\":[";
-			outputStream.flush();
-		}
-
-		void WriteFooter()
-		{
-			outputStream << "]}";
-			outputStream.flush();
-		}
-
-		static Benchmark& Get()
-		{
-			static Benchmark instance;
-			return instance;
-		}
-
-	private:
-		BenchmarkSession* currentSession;
-		std::ofstream outputStream;
-		int profileCount;
-	};
-
+	/** Records its lifetime as one profiler event */
 	struct BenchmarkTimer
 	{
 	public:
-		BenchmarkTimer(const char* name) : name(name), stopped(false)
+		BenchmarkTimer(uint32_t nameId) : nameId(nameId), stopped(false)
 		{
-			startTimepoint = std::chrono::high_resolution_clock::now();
+			startNs = Profiler::Now();
 		}
 
 		~BenchmarkTimer()
@@ -246,20 +177,13 @@ namespace Utilities
 
 		void Stop()
 		{
-			auto endTimepoint = std::chrono::high_resolution_clock::now();
-
-			long long start = std::chrono::time_point_cast<std::chrono::microseconds>(startTimepoint).time_since_epoch().count();
-			long long end = std::chrono::time_point_cast<std::chrono::microseconds>(endTimepoint).time_since_epoch().count();
-
-			size_t threadID = std::hash<std::thread::id>{}(std::this_thread::get_id());
-			Benchmark::Get().WriteProfile({ name, start, end, threadID });
-
+			Profiler::Get().RecordScope(nameId, startNs, Profiler::Now());
 			stopped = true;
 		}
 
 	private:
-		const char* name;
-		std::chrono::time_point<std::chrono::high_resolution_clock> startTimepoint;
+		uint32_t nameId;
+		int64_t startNs;
 		bool stopped;
 	};
 
@@ -331,7 +255,7 @@ namespace Utilities
 			memAllocInfo.memoryTypeIndex = FindMemoryTypeIndex(bufferInfo.physicalDevice, memRequirements.memoryTypeBits,
 				bufferInfo.memoryPropFlags);
 
-			vkResult = vkAllocateMemory(bufferInfo.device, &memAllocInfo, nullptr, bufferInfo.bufferMemory);
+			vkResult = AllocateMemory(bufferInfo.device, &memAllocInfo, bufferInfo.bufferMemory);
 			if (vkResult != VK_SUCCESS)
 			{
 				throw std::runtime_error("Failed to allocate vertex buffer memory");
@@ -340,6 +264,29 @@ namespace Utilities
 			vkBindBufferMemory(bufferInfo.device, *bufferInfo.buffer, *bufferInfo.bufferMemory, 0);
 		}
 
+		/** vkAllocateMemory that keeps the profiler's memory counters, memory from here has to go back through FreeMemory */
+		static VkResult AllocateMemory(VkDevice device, const VkMemoryAllocateInfo* allocateInfo, VkDeviceMemory* memory)
+		{
+			const VkResult vkResult = vkAllocateMemory(device, allocateInfo, nullptr, memory);
+			if (vkResult == VK_SUCCESS)
+			{
+				// Non-dispatchable handles are pointers or 64 bit integers depending on the platform
+				Profiler::Get().TrackAllocation((uint64_t)*memory, allocateInfo->allocationSize);
+			}
+
+			return vkResult;
+		}
+
+		static void FreeMemory(VkDevice device, VkDeviceMemory memory)
+		{
+			if (memory != VK_NULL_HANDLE)
+			{
+				Profiler::Get().TrackFree((uint64_t)memory);
+			}
+
+			vkFreeMemory(device, memory, nullptr);
+		}
+
 		static void CopyBuffer(const CopyBufferInfo& copyBufferInfo)
 		{
 			PROFILE_FUNCTION();
@@ -361,7 +308,13 @@ namespace Utilities
 			PROFILE_FUNCTION();
 
 			VkCommandBuffer transferCommandBuffer = BeginCmdBuffer(copyImgBufferInfo.device, copyImgBufferInfo.transCommandPool);
+			RecordCopyImageBuffer(transferCommandBuffer, copyImgBufferInfo);
+			EndAndSubmitCmdBuffer(copyImgBufferInfo.device, copyImgBufferInfo.transCommandPool, copyImgBufferInfo.transferQueue, transferCommandBuffer);
+		}
 
+		/** Same copy recorded into a command buffer the caller submits, the info's device, queue and pool are unused */
+		static void RecordCopyImageBuffer(VkCommandBuffer transferCommandBuffer, const CopyImageBufferInfo& copyImgBufferInfo)
+		{
 			VkBufferImageCopy imageRegion = {};
 			imageRegion.bufferOffset = 0;
 			imageRegion.bufferRowLength = 0;
@@ -374,8 +327,6 @@ namespace Utilities
 			imageRegion.imageExtent = { copyImgBufferInfo.width, copyImgBufferInfo.height, 1 };
 
 			vkCmdCopyBufferToImage(transferCommandBuffer, copyImgBufferInfo.srcBuffer, copyImgBufferInfo.dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageRegion);
-
-			EndAndSubmitCmdBuffer(copyImgBufferInfo.device, copyImgBufferInfo.transCommandPool, copyImgBufferInfo.transferQueue, transferCommandBuffer);
 		}
 
 		static VkCommandBuffer BeginCmdBuffer(VkDevice device, VkCommandPool cmdPool)
@@ -423,7 +374,13 @@ namespace Utilities
 			PROFILE_FUNCTION();
 
 			VkCommandBuffer transferCommandBuffer = BeginCmdBuffer(transitionImgLytInfo.device, transitionImgLytInfo.cmdPool);
+			RecordTransitionImageLayout(transferCommandBuffer, transitionImgLytInfo);
+			EndAndSubmitCmdBuffer(transitionImgLytInfo.device, transitionImgLytInfo.cmdPool, transitionImgLytInfo.queue, transferCommandBuffer);
+		}
 
+		/** Same barrier recorded into a command buffer the caller submits, the info's device, queue and pool are unused */
+		static void RecordTransitionImageLayout(VkCommandBuffer transferCommandBuffer, const TransitionImageLayoutInfo& transitionImgLytInfo)
+		{
 			VkImageMemoryBarrier imgMemoryBarrier = {};
 			imgMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 			imgMemoryBarrier.oldLayout = transitionImgLytInfo.oldLayout;
@@ -458,8 +415,7 @@ namespace Utilities
 			}
 
 			vkCmdPipelineBarrier(transferCommandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &imgMemoryBarrier);
-
-			EndAndSubmitCmdBuffer(transitionImgLytInfo.device, transitionImgLytInfo.cmdPool, transitionImgLytInfo.queue, transferCommandBuffer);
+			PROFILE_COUNT(PIPELINE_BARRIERS);
 		}
 
 		static VkShaderModule CreateShaderModule(VkDevice device, const std::vector<char>& code)
@@ -0,0 +1,336 @@
+#include "VisibilityBuffer.h"
+#include "GBufferLayout.h"
+#include <array>
+#include <stdexcept>
+#include <algorithm>
+#include <unordered_map>
+
+// second_subpass_visibility.frag reads both vertex streams as tightly packed float arrays
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "Position layout no longer matches the visibility buffer shader");
+static_assert(sizeof(VertexAttributes) == 8 * sizeof(float), "Vertex attribute layout no longer matches the visibility buffer shader");
+
+Renderer::VisibilityBuffer::~VisibilityBuffer()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	DestroyDrawBuffers();
+	DestroyGeometryBuffers();
+
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+}
+
+void Renderer::VisibilityBuffer::Init(const VisibilityBufferCreateInfo& visibilityCreateInfo)
+{
+	PROFILE_FUNCTION();
+
+	createInfo = visibilityCreateInfo;
+
+	CreateDescriptorSetLayout();
+	CreateDescriptorPool();
+	CreateGeometryBuffers(1, sizeof(uint32_t));
+	CreateDrawBuffers(MIN_DRAW_CAPACITY);
+	CreateDescriptorSets();
+}
+
+void Renderer::VisibilityBuffer::SetGeometry(const std::vector<Model>& modelList)
+{
+	PROFILE_FUNCTION();
+
+	drawGeometry.clear();
+	VkDeviceSize vertexCount = 0;
+	VkDeviceSize indexCount = 0;
+	uint32_t triangleCount = 0;
+
+	// Models made from shared meshes copy the mesh's buffer handles, so the index buffer identifies the geometry
+	std::unordered_map<VkBuffer, size_t> firstDrawOfMesh;
+	std::vector<const Mesh*> mergedMeshes;
+
+	for (const Model& model : modelList)
+	{
+		for (size_t meshIndex = 0; meshIndex < model.GetMeshCount(); meshIndex++)
+		{
+			const Mesh* mesh = model.GetMesh(meshIndex);
+			const auto mergedMesh = firstDrawOfMesh.emplace(mesh->GetIndexBuffer(), drawGeometry.size());
+
+			if (mergedMesh.second)
+			{
+				drawGeometry.push_back({ static_cast<uint32_t>(indexCount), static_cast<uint32_t>(vertexCount), mesh->GetTexId(), triangleCount });
+				mergedMeshes.push_back(mesh);
+				vertexCount += mesh->GetVertexCount();
+				indexCount += mesh->GetIndexCount();
+			}
+			else
+			{
+				DrawGeometry geometry = drawGeometry[mergedMesh.first->second];
+				geometry.textureIndex = mesh->GetTexId();
+				geometry.firstTriangle = triangleCount;
+				drawGeometry.push_back(geometry);
+			}
+
+			triangleCount += static_cast<uint32_t>(mesh->GetIndexCount() / 3);
+		}
+	}
+
+	// The previous buffers may still be read by frames in flight
+	vkDeviceWaitIdle(createInfo.device.logicalDevice);
+	DestroyGeometryBuffers();
+	CreateGeometryBuffers(std::max<VkDeviceSize>(vertexCount, 1), sizeof(uint32_t) * std::max<VkDeviceSize>(indexCount, 1));
+
+	// Mesh buffers are device local, so they are copied on the GPU in one submission. Indices stay local to their mesh,
+	// the lighting subpass adds the draw's vertex offset the same way an indexed draw would
+	if (!drawGeometry.empty())
+	{
+		VkCommandBuffer commandBuffer = Utils::BeginCmdBuffer(createInfo.device.logicalDevice, createInfo.commandPool);
+
+		for (const Mesh* mesh : mergedMeshes)
+		{
+			const DrawGeometry& geometry = drawGeometry[firstDrawOfMesh[mesh->GetIndexBuffer()]];
+
+			VkBufferCopy positionRegion = {};
+			positionRegion.dstOffset = sizeof(glm::vec3) * static_cast<VkDeviceSize>(geometry.vertexOffset);
+			positionRegion.size = sizeof(glm::vec3) * mesh->GetVertexCount();
+			vkCmdCopyBuffer(commandBuffer, mesh->GetPositionBuffer(), positionBuffer, 1, &positionRegion);
+
+			VkBufferCopy attributeRegion = {};
+			attributeRegion.dstOffset = sizeof(VertexAttributes) * static_cast<VkDeviceSize>(geometry.vertexOffset);
+			attributeRegion.size = sizeof(VertexAttributes) * mesh->GetVertexCount();
+			vkCmdCopyBuffer(commandBuffer, mesh->GetAttributeBuffer(), attributeBuffer, 1, &attributeRegion);
+
+			VkBufferCopy indexRegion = {};
+			indexRegion.dstOffset = sizeof(uint32_t) * static_cast<VkDeviceSize>(geometry.firstIndex);
+			indexRegion.size = sizeof(uint32_t) * mesh->GetIndexCount();
+			vkCmdCopyBuffer(commandBuffer, mesh->GetIndexBuffer(), indexBuffer, 1, &indexRegion);
+		}
+
+		Utils::EndAndSubmitCmdBuffer(createInfo.device.logicalDevice, createInfo.commandPool, createInfo.queue, commandBuffer);
+	}
+
+	if (drawGeometry.size() > drawCapacity)
+	{
+		DestroyDrawBuffers();
+		CreateDrawBuffers(std::max(static_cast<uint32_t>(drawGeometry.size()), drawCapacity * 2));
+	}
+
+	WriteDescriptorSets();
+}
+
+void Renderer::VisibilityBuffer::UpdateDrawData(uint32_t frameIndex, const std::vector<Model>& modelList)
+{
+	PROFILE_FUNCTION();
+
+	if (drawGeometry.empty())
+	{
+		return;
+	}
+
+	VkDevice device = createInfo.device.logicalDevice;
+	void* data = nullptr;
+
+	vkMapMemory(device, drawDataBufferMemory[frameIndex], 0, sizeof(DrawData) * drawGeometry.size(), 0, &data);
+	PROFILE_COUNT_ADD(UPLOADED_BYTES, sizeof(DrawData) * drawGeometry.size());
+	DrawData* drawData = static_cast<DrawData*>(data);
+
+	uint32_t drawIndex = 0;
+	for (const Model& model : modelList)
+	{
+		for (size_t meshIndex = 0; meshIndex < model.GetMeshCount(); meshIndex++, drawIndex++)
+		{
+			drawData[drawIndex].model = model.GetModelMatrix();
+			drawData[drawIndex].firstIndex = drawGeometry[drawIndex].firstIndex;
+			drawData[drawIndex].vertexOffset = drawGeometry[drawIndex].vertexOffset;
+			drawData[drawIndex].textureIndex = drawGeometry[drawIndex].textureIndex;
+			drawData[drawIndex].firstTriangle = drawGeometry[drawIndex].firstTriangle;
+		}
+	}
+
+	vkUnmapMemory(device, drawDataBufferMemory[frameIndex]);
+}
+
+uint32_t Renderer::VisibilityBuffer::GetDrawCount() const
+{
+	return static_cast<uint32_t>(drawGeometry.size());
+}
+
+VkDescriptorSetLayout Renderer::VisibilityBuffer::GetDescriptorSetLayout() const
+{
+	return descriptorSetLayout;
+}
+
+VkDescriptorSet& Renderer::VisibilityBuffer::GetDescriptorSet(uint32_t frameIndex)
+{
+	return descriptorSets[frameIndex];
+}
+
+void Renderer::VisibilityBuffer::CreateDescriptorSetLayout()
+{
+	PROFILE_FUNCTION();
+
+	// Positions, vertex attributes, indices, draw table
+	std::array<VkDescriptorSetLayoutBinding, 4> bindings = {};
+	for (uint32_t i = 0; i < bindings.size(); i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutCreateInfo.pBindings = bindings.data();
+
+	VkResult vkResult = vkCreateDescriptorSetLayout(createInfo.device.logicalDevice, &layoutCreateInfo, nullptr, &descriptorSetLayout);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor set layout");
+	}
+}
+
+void Renderer::VisibilityBuffer::CreateDescriptorPool()
+{
+	PROFILE_FUNCTION();
+
+	const uint32_t frameCount = static_cast<uint32_t>(createInfo.frameCount);
+
+	VkDescriptorPoolSize storageBufferPoolSize = {};
+	storageBufferPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	storageBufferPoolSize.descriptorCount = frameCount * 4;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = frameCount;
+	poolCreateInfo.poolSizeCount = 1;
+	poolCreateInfo.pPoolSizes = &storageBufferPoolSize;
+
+	VkResult vkResult = vkCreateDescriptorPool(createInfo.device.logicalDevice, &poolCreateInfo, nullptr, &descriptorPool);
+
+	if (vkResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor pool");
+	}
+}
+
+void Renderer::VisibilityBuffer::CreateDescriptorSets()
+{
+	PROFILE_FUNCTION();
+
+	descriptorSets.resize(createInfo.frameCount);
+	std::vector<VkDescriptorSetLayout> setLayouts(descriptorSets.size(), descriptorSetLayout);
+
+	VkDescriptorSetAllocateInfo setAllocateInfo = {};
+	setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocateInfo.descriptorPool = descriptorPool;
+	setAllocateInfo.descriptorSetCount = static_cast<uint32_t>(descriptorSets.size());
+	setAllocateInfo.pSetLayouts = setLayouts.data();
+
+	if (vkAllocateDescriptorSets(createInfo.device.logicalDevice, &setAllocateInfo, descriptorSets.data()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate visibility buffer descriptor sets");
+	}
+
+	WriteDescriptorSets();
+}
+
+void Renderer::VisibilityBuffer::CreateGeometryBuffers(VkDeviceSize vertexCount, VkDeviceSize indexBytes)
+{
+	PROFILE_FUNCTION();
+
+	Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, sizeof(glm::vec3) * vertexCount,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		&positionBuffer, &positionBufferMemory });
+
+	Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, sizeof(VertexAttributes) * vertexCount,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		&attributeBuffer, &attributeBufferMemory });
+
+	Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, indexBytes,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		&indexBuffer, &indexBufferMemory });
+}
+
+void Renderer::VisibilityBuffer::DestroyGeometryBuffers()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	vkDestroyBuffer(device, positionBuffer, nullptr);
+	Utils::FreeMemory(device, positionBufferMemory);
+	vkDestroyBuffer(device, attributeBuffer, nullptr);
+	Utils::FreeMemory(device, attributeBufferMemory);
+	vkDestroyBuffer(device, indexBuffer, nullptr);
+	Utils::FreeMemory(device, indexBufferMemory);
+
+	positionBuffer = nullptr;
+	positionBufferMemory = nullptr;
+	attributeBuffer = nullptr;
+	attributeBufferMemory = nullptr;
+	indexBuffer = nullptr;
+	indexBufferMemory = nullptr;
+}
+
+void Renderer::VisibilityBuffer::CreateDrawBuffers(uint32_t capacity)
+{
+	PROFILE_FUNCTION();
+
+	const size_t frameCount = createInfo.frameCount;
+	drawCapacity = capacity;
+
+	drawDataBuffers.resize(frameCount);
+	drawDataBufferMemory.resize(frameCount);
+
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		Utils::CreateBuffer({ createInfo.device.physicalDevice, createInfo.device.logicalDevice, sizeof(DrawData) * static_cast<VkDeviceSize>(capacity),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&drawDataBuffers[i], &drawDataBufferMemory[i] });
+	}
+}
+
+void Renderer::VisibilityBuffer::DestroyDrawBuffers()
+{
+	PROFILE_FUNCTION();
+
+	VkDevice device = createInfo.device.logicalDevice;
+
+	for (size_t i = 0; i < drawDataBuffers.size(); i++)
+	{
+		vkDestroyBuffer(device, drawDataBuffers[i], nullptr);
+		Utils::FreeMemory(device, drawDataBufferMemory[i]);
+	}
+
+	drawDataBuffers.clear();
+	drawDataBufferMemory.clear();
+}
+
+void Renderer::VisibilityBuffer::WriteDescriptorSets()
+{
+	PROFILE_FUNCTION();
+
+	for (size_t i = 0; i < descriptorSets.size(); i++)
+	{
+		std::array<VkDescriptorBufferInfo, 4> bufferInfos = {};
+		bufferInfos[0] = { positionBuffer, 0, VK_WHOLE_SIZE };
+		bufferInfos[1] = { attributeBuffer, 0, VK_WHOLE_SIZE };
+		bufferInfos[2] = { indexBuffer, 0, VK_WHOLE_SIZE };
+		bufferInfos[3] = { drawDataBuffers[i], 0, VK_WHOLE_SIZE };
+
+		std::array<VkWriteDescriptorSet, 4> setWrites = {};
+		for (uint32_t binding = 0; binding < setWrites.size(); binding++)
+		{
+			setWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			setWrites[binding].dstSet = descriptorSets[i];
+			setWrites[binding].dstBinding = binding;
+			setWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			setWrites[binding].descriptorCount = 1;
+			setWrites[binding].pBufferInfo = &bufferInfos[binding];
+		}
+
+		vkUpdateDescriptorSets(createInfo.device.logicalDevice, static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+#include <vector>
+#include "Utils.h"
+#include "Model.h"
+
+namespace Renderer
+{
+	using namespace Utilities;
+
+	/**
+	* Scene geometry for the visibility buffer layout's lighting subpass. Every distinct mesh's position stream, attribute stream and indices
+	* are copied into one storage buffer each, and a per frame draw table maps the triangle stored in each pixel to its draw's mesh range,
+	* transform and texture
+	*/
+	class VisibilityBuffer
+	{
+	public:
+		struct VisibilityBufferCreateInfo
+		{
+			DeviceHandle device;
+			VkQueue queue;
+			VkCommandPool commandPool;
+			size_t frameCount = 0; // Frames in flight, draw tables and descriptor sets are created once per frame
+		};
+
+		VisibilityBuffer() = default;
+		~VisibilityBuffer();
+		void Init(const VisibilityBufferCreateInfo& visibilityCreateInfo);
+		/**
+		* Waits for the GPU and merges every mesh the models draw, meshes shared between models once. Draw items are numbered in model
+		* then mesh order, together they must have at most VISIBILITY_MAX_TRIANGLES triangles
+		*/
+		void SetGeometry(const std::vector<Model>& modelList);
+		/** Writes the draw table read by this frame's lighting subpass, the frame's fence must have signalled */
+		void UpdateDrawData(uint32_t frameIndex, const std::vector<Model>& modelList);
+		uint32_t GetDrawCount() const;
+		VkDescriptorSetLayout GetDescriptorSetLayout() const;
+		VkDescriptorSet& GetDescriptorSet(uint32_t frameIndex);
+
+	private:
+		struct DrawGeometry
+		{
+			uint32_t firstIndex;
+			uint32_t vertexOffset;
+			uint32_t textureIndex;
+			uint32_t firstTriangle;
+		};
+
+		// Mirrors second_subpass_visibility.frag, std430
+		struct DrawData
+		{
+			glm::mat4 model;
+			uint32_t firstIndex;
+			uint32_t vertexOffset;
+			uint32_t textureIndex;
+			uint32_t firstTriangle;
+		};
+
+		static constexpr uint32_t MIN_DRAW_CAPACITY = 256;
+
+		VisibilityBufferCreateInfo createInfo;
+		std::vector<DrawGeometry> drawGeometry; // Static part of the draw table, same order as the renderer's draw items
+		uint32_t drawCapacity = 0;
+
+		VkBuffer positionBuffer = nullptr;
+		VkDeviceMemory positionBufferMemory = nullptr;
+		VkBuffer attributeBuffer = nullptr;
+		VkDeviceMemory attributeBufferMemory = nullptr;
+		VkBuffer indexBuffer = nullptr;
+		VkDeviceMemory indexBufferMemory = nullptr;
+
+		std::vector<VkBuffer> drawDataBuffers; // One per frame in flight
+		std::vector<VkDeviceMemory> drawDataBufferMemory;
+
+		VkDescriptorSetLayout descriptorSetLayout = nullptr;
+		VkDescriptorPool descriptorPool = nullptr;
+		std::vector<VkDescriptorSet> descriptorSets; // One per frame in flight
+
+		void CreateDescriptorSetLayout();
+		void CreateDescriptorPool();
+		void CreateDescriptorSets();
+		void CreateGeometryBuffers(VkDeviceSize vertexCount, VkDeviceSize indexBytes);
+		void DestroyGeometryBuffers();
+		void CreateDrawBuffers(uint32_t capacity);
+		void DestroyDrawBuffers();
+		void WriteDescriptorSets();
+	};
+}
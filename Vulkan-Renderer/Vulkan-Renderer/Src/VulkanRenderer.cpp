@@ -17,26 +17,56 @@ namespace Renderer
 	{
 		PROFILE_FUNCTION();
 		this->window = window;
+		headless = false;
+
+		return InitRenderer();
+	}
+
+	bool VulkanRenderer::InitHeadless(const HeadlessCreateInfo& headlessCreateInfo)
+	{
+		PROFILE_FUNCTION();
+		this->headlessCreateInfo = headlessCreateInfo;
+		window = nullptr;
+		headless = true;
+
+		return InitRenderer();
+	}
+
+	bool VulkanRenderer::InitRenderer()
+	{
+		PROFILE_FUNCTION();
 
 		try
 		{
 			CreateInstance();
 			CreateValidationDebugMessenger();
-			CreateSurface();
+			if (!headless)
+			{
+				CreateSurface();
+			}
 			GetPhysicalDevice();
 			CreateLogicalDevice();
-			CreateSwapChain();
-			CreateRenderPass();
-			CreateAlbedoBufferImage();
-			CreatePositionBufferImage();
-			CreateNormalBufferImage();
-			CreateDepthBufferImage();
-			CreateRenderPipeline();
-			CreateFrameBuffers();
+			if (headless)
+			{
+				CreateOffscreenTargets();
+			}
+			else
+			{
+				CreateSwapChain();
+			}
+			CreateRenderPasses();
 			CreateCommandPool();
-			CreateCommandBuffers();
+			CreateGpuProfiler();
+			CreateGBuffer();
+			ReportGBufferMemory();
+			CreateFrameContexts();
+			CreateVisibilityBuffer();
+			CreateLightClusterer();
+			CreateShadowMapper();
+			CreateRenderPipeline();
+			CreateOcclusionCuller();
 			CreateTextureSampler();
-			CreateSynchronization();
+			softwareOcclusionCuller.Resize(SOFTWARE_OCCLUSION_WIDTH, SOFTWARE_OCCLUSION_HEIGHT);
 
 			// Default texture, Will be assigned if no texture can be found on 3D model file
 			CreateTexture("testTexture.jpg");
@@ -61,7 +91,25 @@ namespace Renderer
 
 		if (modelId >= 0 && modelId < modelList.size())
 		{
+			// A static model may be in cached shadow cascades, they have to be rendered again without it
+			if (!modelIsDynamic[modelId])
+			{
+				for (uint32_t meshIndex = 0; meshIndex < modelList[modelId].GetMeshCount(); meshIndex++)
+				{
+					shadowCascadeCache.InvalidateStaticBounds(drawItemBounds.Get(modelFirstDrawItem[modelId] + meshIndex));
+				}
+				modelIsDynamic[modelId] = true;
+				dynamicModels.push_back(modelId);
+			}
+			modelLastMovedFrame[modelId] = frameNumber;
+
 			modelList[modelId].SetModelMatrix(modelMat);
+			UpdateModelBounds(modelId);
+
+			for (uint32_t meshIndex = 0; meshIndex < modelList[modelId].GetMeshCount(); meshIndex++)
+			{
+				bvhRefitItems.push_back(modelFirstDrawItem[modelId] + meshIndex);
+			}
 		}
 		else
 		{
@@ -69,32 +117,339 @@ namespace Renderer
 		}
 	}
 
+	void VulkanRenderer::SetCamera(const glm::vec3& location, const glm::vec3& lookAt)
+	{
+		renderPipelinePtr->SetViewMatrixFromLookAt(location, lookAt, GLOBAL_UP);
+	}
+
+	void VulkanRenderer::SetOcclusionCullingEnabled(bool enabled)
+	{
+		occlusionCullerPtr->SetEnabled(enabled);
+	}
+
+	void VulkanRenderer::SetFramesInFlight(uint32_t frameCount)
+	{
+		PROFILE_FUNCTION();
+
+		if (frameCount == 0 || frameCount > MAX_FRAMES_IN_FLIGHT)
+		{
+			throw std::runtime_error("Failed to set frames in flight, Invalid count");
+		}
+
+		if (frameCount == framesInFlight)
+		{
+			return;
+		}
+
+		// Uniforms and descriptor sets of the pipeline and culler are sized by the frame count, so they are rebuilt with the frames
+		RebuildRenderResources([&]()
+			{
+				DestroyFrameContexts();
+				framesInFlight = frameCount;
+				currentFrame = 0;
+				CreateFrameContexts();
+			});
+	}
+
+	uint32_t VulkanRenderer::GetFramesInFlight() const
+	{
+		return framesInFlight;
+	}
+
+	void VulkanRenderer::SetGBufferLayout(GBufferLayout layout)
+	{
+		PROFILE_FUNCTION();
+
+		if (layout == gBufferLayout)
+		{
+			return;
+		}
+
+		if (layout == GBufferLayout::VISIBILITY && !visibilityBufferSupported)
+		{
+			std::cout << "\nVisibility buffer layout needs the geometryShader and shaderSampledImageArrayNonUniformIndexing features, keeping "
+				<< GetGBufferLayoutName(gBufferLayout);
+			return;
+		}
+
+		if (layout == GBufferLayout::VISIBILITY && drawItemTriangleCount > VISIBILITY_MAX_TRIANGLES)
+		{
+			std::cout << "\nVisibility buffer layout can't number the scene's " << drawItemTriangleCount << " triangles, keeping "
+				<< GetGBufferLayoutName(gBufferLayout);
+			return;
+		}
+
+		// Attachment formats and counts are baked into the render pass, its framebuffers and the G-buffer pipelines
+		RebuildRenderResources([&]()
+			{
+				DestroyGBuffer();
+				DestroyRenderPasses();
+
+				gBufferLayout = layout;
+
+				CreateRenderPasses();
+				CreateGBuffer();
+				ReportGBufferMemory();
+			});
+	}
+
+	GBufferLayout VulkanRenderer::GetGBufferLayout() const
+	{
+		return gBufferLayout;
+	}
+
+	void VulkanRenderer::SetDepthPrepassEnabled(bool enabled)
+	{
+		PROFILE_FUNCTION();
+
+		if (enabled == depthPrepassEnabled)
+		{
+			return;
+		}
+
+		// The pre-pass is a pass of its own in the frame graph, the main render pass's initial depth layout changes with it
+		RebuildRenderResources([&]()
+			{
+				DestroyGBuffer();
+				DestroyRenderPasses();
+
+				depthPrepassEnabled = enabled;
+
+				CreateRenderPasses();
+				CreateGBuffer();
+			});
+	}
+
+	bool VulkanRenderer::IsDepthPrepassEnabled() const
+	{
+		return depthPrepassEnabled;
+	}
+
+	const VulkanRenderer::GpuPassTimings& VulkanRenderer::GetGpuPassTimings() const
+	{
+		return gpuPassTimings;
+	}
+
+	void VulkanRenderer::SetModelOccluder(int32_t modelId, const OccluderMesh& occluderMesh)
+	{
+		if (modelId < 0 || static_cast<size_t>(modelId) >= modelList.size())
+		{
+			throw std::runtime_error("Failed to set model occluder, Invalid index");
+		}
+
+		for (ModelOccluder& modelOccluder : modelOccluders)
+		{
+			if (modelOccluder.modelIndex == static_cast<uint32_t>(modelId))
+			{
+				modelOccluder.mesh = occluderMesh;
+				return;
+			}
+		}
+
+		modelOccluders.push_back({ static_cast<uint32_t>(modelId), occluderMesh });
+	}
+
+	void VulkanRenderer::SetSoftwareOcclusionCullingEnabled(bool enabled)
+	{
+		softwareOcclusionEnabled = enabled;
+	}
+
+	const SoftwareOcclusionCuller::Statistics& VulkanRenderer::GetSoftwareOcclusionStatistics() const
+	{
+		return softwareOcclusionCuller.GetStatistics();
+	}
+
+	const DrawList::Statistics& VulkanRenderer::GetDrawStatistics() const
+	{
+		return drawStatistics;
+	}
+
+	uint32_t VulkanRenderer::AddLight(const PointLight& light)
+	{
+		lights.push_back(light);
+		return static_cast<uint32_t>(lights.size() - 1);
+	}
+
+	void VulkanRenderer::UpdateLight(uint32_t lightId, const PointLight& light)
+	{
+		if (lightId >= lights.size())
+		{
+			throw std::runtime_error("Failed to update light, Invalid id");
+		}
+
+		lights[lightId] = light;
+	}
+
+	void VulkanRenderer::ClearLights()
+	{
+		lights.clear();
+	}
+
+	size_t VulkanRenderer::GetLightCount() const
+	{
+		return lights.size();
+	}
+
+	void VulkanRenderer::SetKeyLightDirection(const glm::vec3& toLight)
+	{
+		// Every cascade's projection follows the light, so the cache sees them all change
+		keyLightDirection = glm::normalize(toLight);
+	}
+
+	const glm::vec3& VulkanRenderer::GetKeyLightDirection() const
+	{
+		return keyLightDirection;
+	}
+
+	const VulkanRenderer::ShadowStatistics& VulkanRenderer::GetShadowStatistics() const
+	{
+		return shadowStatistics;
+	}
+
+	std::string VulkanRenderer::DescribeFrameGraph() const
+	{
+		return frameGraph.Describe(compiledFrameGraph);
+	}
+
+	bool VulkanRenderer::IsHeadless() const
+	{
+		return headless;
+	}
+
+	VkExtent2D VulkanRenderer::GetOutputExtent() const
+	{
+		return swapChainExtent;
+	}
+
+	void VulkanRenderer::WaitForFrames()
+	{
+		PROFILE_FUNCTION();
+
+		std::vector<VkFence> fences;
+		for (const FrameContext& frame : frames)
+		{
+			fences.push_back(frame.drawFence);
+		}
+
+		vkWaitForFences(deviceHandle.logicalDevice, static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+
+	bool VulkanRenderer::ReadbackLastFrame(std::vector<uint8_t>& rgba)
+	{
+		PROFILE_FUNCTION();
+
+		if (!headless || frameNumber == 0)
+		{
+			return false;
+		}
+
+		WaitForFrames();
+
+		const VkDeviceSize outputSize = static_cast<VkDeviceSize>(swapChainExtent.width) * swapChainExtent.height * 4;
+		VkBuffer readbackBuffer = nullptr;
+		VkDeviceMemory readbackBufferMemory = nullptr;
+
+		CreateBufferInfo readbackBufferInfo = {};
+		readbackBufferInfo.physicalDevice = deviceHandle.physicalDevice;
+		readbackBufferInfo.device = deviceHandle.logicalDevice;
+		readbackBufferInfo.bufferSize = outputSize;
+		readbackBufferInfo.bufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		readbackBufferInfo.memoryPropFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		readbackBufferInfo.buffer = &readbackBuffer;
+		readbackBufferInfo.bufferMemory = &readbackBufferMemory;
+		Utils::CreateBuffer(readbackBufferInfo);
+
+		VkCommandBuffer commandBuffer = Utils::BeginCmdBuffer(deviceHandle.logicalDevice, gfxCommandPool);
+
+		// The lighting pass leaves the output in transfer source layout when headless
+		VkBufferImageCopy imageRegion = {};
+		imageRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageRegion.imageSubresource.layerCount = 1;
+		imageRegion.imageExtent = { swapChainExtent.width, swapChainExtent.height, 1 };
+		vkCmdCopyImageToBuffer(commandBuffer, swapChainImages[lastImageIndex].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &imageRegion);
+
+		VkBufferMemoryBarrier hostBarrier = {};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		hostBarrier.buffer = readbackBuffer;
+		hostBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &hostBarrier, 0, nullptr);
+		PROFILE_COUNT(PIPELINE_BARRIERS);
+
+		Utils::EndAndSubmitCmdBuffer(deviceHandle.logicalDevice, gfxCommandPool, graphicsQueue, commandBuffer);
+
+		void* data = nullptr;
+		vkMapMemory(deviceHandle.logicalDevice, readbackBufferMemory, 0, outputSize, 0, &data);
+		rgba.resize(static_cast<size_t>(outputSize));
+		memcpy(rgba.data(), data, static_cast<size_t>(outputSize));
+		vkUnmapMemory(deviceHandle.logicalDevice, readbackBufferMemory);
+
+		vkDestroyBuffer(deviceHandle.logicalDevice, readbackBuffer, nullptr);
+		Utils::FreeMemory(deviceHandle.logicalDevice, readbackBufferMemory);
+		return true;
+	}
+
 	void VulkanRenderer::Draw()
 	{
 		PROFILE_FUNCTION();
 
+		FrameContext& frame = frames[currentFrame];
+
 		uint32_t imageIndex = 0;
 		{
 			PROFILE_SCOPE("Wait, Reset Fences & Accquire Image");
 
-			vkWaitForFences(deviceHandle.logicalDevice, 1, &drawFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
-			vkResetFences(deviceHandle.logicalDevice, 1, &drawFences[currentFrame]);
+			vkWaitForFences(deviceHandle.logicalDevice, 1, &frame.drawFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+			vkResetFences(deviceHandle.logicalDevice, 1, &frame.drawFence);
+
+			// An offscreen target is only used by its own frame context, the fence above already covers its last use
+			if (headless)
+			{
+				imageIndex = currentFrame;
+			}
+			else
+			{
+				vkAcquireNextImageKHR(deviceHandle.logicalDevice, swapChain, std::numeric_limits<uint64_t>::max(), frame.imageAvailable, VK_NULL_HANDLE, &imageIndex);
+			}
+		}
+
+		ReadGpuPassTimings(currentFrame);
+
+		CullScene();
+		BuildDrawList();
 
-			vkAcquireNextImageKHR(deviceHandle.logicalDevice, swapChain, std::numeric_limits<uint64_t>::max(), imageAvailable[currentFrame], VK_NULL_HANDLE, &imageIndex);
+		// The fence wait above means the GPU is done with everything this frame index owns
+		const UboViewProjection& viewProjection = renderPipelinePtr->GetViewProjection();
+		occlusionCullerPtr->UpdateDrawData(currentFrame, drawItemBounds, drawItemIndexCounts, viewProjection.projection * viewProjection.view);
+
+		if (visibilityBufferPtr != nullptr)
+		{
+			if (visibilityGeometryDirty)
+			{
+				visibilityBufferPtr->SetGeometry(modelList);
+			}
+			visibilityBufferPtr->UpdateDrawData(currentFrame, modelList);
 		}
+		visibilityGeometryDirty = false;
 
-		RecordCommands(imageIndex);
+		lightClustererPtr->UpdateLights(currentFrame, lights, viewProjection.view, viewProjection.projection);
+		UpdateShadowCascades();
 
-		renderPipelinePtr->UpdateUniformBuffers(imageIndex, modelList);
+		RecordCommands(currentFrame, imageIndex);
+
+		renderPipelinePtr->UpdateUniformBuffers(currentFrame);
 
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 		submitInfo.commandBufferCount = 1;
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &imageAvailable[currentFrame];
-		submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = &renderFinished[currentFrame];
+		submitInfo.waitSemaphoreCount = headless ? 0 : 1;
+		submitInfo.pWaitSemaphores = &frame.imageAvailable;
+		submitInfo.pCommandBuffers = &frame.commandBuffer;
+		submitInfo.signalSemaphoreCount = headless ? 0 : 1;
+		submitInfo.pSignalSemaphores = &frame.renderFinished;
 
 		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 		submitInfo.pWaitDstStageMask = waitStages;
@@ -102,29 +457,35 @@ namespace Renderer
 		{
 			PROFILE_SCOPE("Queue Submit & Present");
 
-			VkResult vkResult = vkQueueSubmit(graphicsQueue, 1, &submitInfo, drawFences[currentFrame]);
+			VkResult vkResult = vkQueueSubmit(graphicsQueue, 1, &submitInfo, frame.drawFence);
 			if (vkResult != VK_SUCCESS)
 			{
 				throw std::runtime_error("Failed to submit command buffer to queue");
 			}
 
-			VkPresentInfoKHR presentInfo = {};
-			presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-			presentInfo.waitSemaphoreCount = 1;
-			presentInfo.pWaitSemaphores = &renderFinished[currentFrame];
-			presentInfo.swapchainCount = 1;
-			presentInfo.pSwapchains = &swapChain;
-			presentInfo.pImageIndices = &imageIndex;
+			if (!headless)
+			{
+				VkPresentInfoKHR presentInfo = {};
+				presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+				presentInfo.waitSemaphoreCount = 1;
+				presentInfo.pWaitSemaphores = &frame.renderFinished;
+				presentInfo.swapchainCount = 1;
+				presentInfo.pSwapchains = &swapChain;
+				presentInfo.pImageIndices = &imageIndex;
 
-			vkResult = vkQueuePresentKHR(presentationQueue, &presentInfo);
+				vkResult = vkQueuePresentKHR(presentationQueue, &presentInfo);
 
-			if (vkResult != VK_SUCCESS)
-			{
-				throw std::runtime_error("Failed to present to queue");
+				if (vkResult != VK_SUCCESS)
+				{
+					throw std::runtime_error("Failed to present to queue");
+				}
 			}
 		}
 
-		currentFrame = (currentFrame + 1) % MAX_FRAME_DRAWS;
+		lastImageIndex = imageIndex;
+
+		currentFrame = (currentFrame + 1) % framesInFlight;
+		frameNumber++;
 	}
 
 	void VulkanRenderer::CleanUp()
@@ -137,63 +498,70 @@ namespace Renderer
 			modelList[i].DestroyModel();
 		}
 
+		for (Mesh& mesh : sharedMeshes)
+		{
+			mesh.DestroyBuffers();
+		}
+
 		vkDestroySampler(deviceHandle.logicalDevice, textureSampler, nullptr);
 
 		for (size_t i = 0; i < textureHandles.size(); i++)
 		{
 			vkDestroyImageView(deviceHandle.logicalDevice, textureImgViews[i], nullptr);
 			vkDestroyImage(deviceHandle.logicalDevice, textureHandles[i].image, nullptr);
-			vkFreeMemory(deviceHandle.logicalDevice, textureHandles[i].memory, nullptr);
+			Utils::FreeMemory(deviceHandle.logicalDevice, textureHandles[i].memory);
 		}
 
-		for (size_t i = 0; i < depthBufferImage.size(); i++)
+		if (occlusionCullerPtr != nullptr)
 		{
-			vkDestroyImageView(deviceHandle.logicalDevice, depthBufferImageView[i], nullptr);
-			vkDestroyImage(deviceHandle.logicalDevice, depthBufferImage[i], nullptr);
-			vkFreeMemory(deviceHandle.logicalDevice, depthBufferImageMemory[i], nullptr);
+			delete occlusionCullerPtr;
+			occlusionCullerPtr = nullptr;
 		}
 
-		for (size_t i = 0; i < positionBufferImage.size(); i++)
+		if (visibilityBufferPtr != nullptr)
 		{
-			vkDestroyImageView(deviceHandle.logicalDevice, positionBufferImageView[i], nullptr);
-			vkDestroyImage(deviceHandle.logicalDevice, positionBufferImage[i], nullptr);
-			vkFreeMemory(deviceHandle.logicalDevice, positionBufferImageMemory[i], nullptr);
+			delete visibilityBufferPtr;
+			visibilityBufferPtr = nullptr;
 		}
 
-		for (size_t i = 0; i < normalBufferImage.size(); i++)
+		if (lightClustererPtr != nullptr)
 		{
-			vkDestroyImageView(deviceHandle.logicalDevice, normalBufferImageView[i], nullptr);
-			vkDestroyImage(deviceHandle.logicalDevice, normalBufferImage[i], nullptr);
-			vkFreeMemory(deviceHandle.logicalDevice, normalBufferImageMemory[i], nullptr);
+			delete lightClustererPtr;
+			lightClustererPtr = nullptr;
 		}
 
-		for (size_t i = 0; i < albedoBufferImage.size(); i++)
+		if (shadowMapperPtr != nullptr)
 		{
-			vkDestroyImageView(deviceHandle.logicalDevice, albedoBufferImageView[i], nullptr);
-			vkDestroyImage(deviceHandle.logicalDevice, albedoBufferImage[i], nullptr);
-			vkFreeMemory(deviceHandle.logicalDevice, albedoBufferImageMemory[i], nullptr);
+			delete shadowMapperPtr;
+			shadowMapperPtr = nullptr;
 		}
 
-		for (size_t i = 0; i < MAX_FRAME_DRAWS; i++)
+		if (gpuProfilerPtr != nullptr)
 		{
-			vkDestroySemaphore(deviceHandle.logicalDevice, renderFinished[i], nullptr);
-			vkDestroySemaphore(deviceHandle.logicalDevice, imageAvailable[i], nullptr);
-			vkDestroyFence(deviceHandle.logicalDevice, drawFences[i], nullptr);
+			delete gpuProfilerPtr;
+			gpuProfilerPtr = nullptr;
 		}
 
+		DestroyFrameContexts();
+		DestroyGBuffer();
 		vkDestroyCommandPool(deviceHandle.logicalDevice, gfxCommandPool, nullptr);
 
-		for (auto frameBuffer : swapchainFrameBuffers)
+		if (headless)
 		{
-			vkDestroyFramebuffer(deviceHandle.logicalDevice, frameBuffer, nullptr);
+			for (FrameAttachment& target : offscreenTargets)
+			{
+				DestroyFrameAttachment(target);
+			}
 		}
-
-		for (const auto& image : swapChainImages)
+		else
 		{
-			vkDestroyImageView(deviceHandle.logicalDevice, image.imageView, nullptr);
+			for (const auto& image : swapChainImages)
+			{
+				vkDestroyImageView(deviceHandle.logicalDevice, image.imageView, nullptr);
+			}
 		}
 
-		vkDestroyRenderPass(deviceHandle.logicalDevice, renderPass, nullptr);
+		DestroyRenderPasses();
 
 		if (renderPipelinePtr != nullptr)
 		{
@@ -201,8 +569,11 @@ namespace Renderer
 			renderPipelinePtr = nullptr;
 		}
 
-		vkDestroySwapchainKHR(deviceHandle.logicalDevice, swapChain, nullptr);
-		vkDestroySurfaceKHR(instance, surface, nullptr);
+		if (!headless)
+		{
+			vkDestroySwapchainKHR(deviceHandle.logicalDevice, swapChain, nullptr);
+			vkDestroySurfaceKHR(instance, surface, nullptr);
+		}
 		vkDestroyDevice(deviceHandle.logicalDevice, nullptr);
 		DestroyValidationDebugMessenger();
 		vkDestroyInstance(instance, nullptr);
@@ -226,10 +597,9 @@ namespace Renderer
 
 		std::vector<const char*> instanceExtensions;
 
+		// Surface extensions, a headless instance has nothing to present to
 		uint32_t glfwExtensionCount = 0;
-		const char** glfwExtensions;
-
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		const char** glfwExtensions = headless ? nullptr : glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
 		for (size_t i = 0; i < glfwExtensionCount; i++)
 		{
@@ -328,7 +698,7 @@ namespace Renderer
 			VkPhysicalDeviceProperties deviceProps;
 			vkGetPhysicalDeviceProperties(deviceHandle.physicalDevice, &deviceProps);
 
-			minUniformBufferOffset = deviceProps.limits.minUniformBufferOffsetAlignment;
+			timestampPeriod = deviceProps.limits.timestampComputeAndGraphics ? deviceProps.limits.timestampPeriod : 0.0f;
 		}
 		else
 		{
@@ -362,14 +732,55 @@ namespace Renderer
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
-		deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(DEVICE_EXTENSIONS.size());
-		deviceCreateInfo.ppEnabledExtensionNames = DEVICE_EXTENSIONS.data();
+
+		// Optional, GPU scopes fall back to a one off calibration against a submission without it
+		std::vector<const char*> deviceExtensions = headless ? std::vector<const char*>() : DEVICE_EXTENSIONS;
+		calibratedTimestampsSupported = timestampPeriod != 0.0f && CheckCalibratedTimestampSupport();
+		if (calibratedTimestampsSupported)
+		{
+			deviceExtensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+		}
+
+		deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+		deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
+
+		VkPhysicalDeviceDescriptorIndexingFeatures supportedIndexingFeatures = {};
+		supportedIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+		VkPhysicalDeviceFeatures2 supportedFeatures = {};
+		supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures.pNext = &supportedIndexingFeatures;
+		vkGetPhysicalDeviceFeatures2(deviceHandle.physicalDevice, &supportedFeatures);
+
+		VkPhysicalDeviceProperties deviceProps;
+		vkGetPhysicalDeviceProperties(deviceHandle.physicalDevice, &deviceProps);
+
+		// The visibility layout writes gl_PrimitiveID from the fragment shader, its lighting subpass indexes textures per pixel
+		// and binds five descriptor sets, one more than every device has to support
+		visibilityBufferSupported = supportedFeatures.features.geometryShader && supportedIndexingFeatures.shaderSampledImageArrayNonUniformIndexing
+			&& deviceProps.limits.maxBoundDescriptorSets >= 5;
+
+		multiDrawIndirectSupported = supportedFeatures.features.multiDrawIndirect;
 
 		VkPhysicalDeviceFeatures deviceFeatures = {};
 		deviceFeatures.depthClamp = VK_TRUE;
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		deviceFeatures.drawIndirectFirstInstance = VK_TRUE; // Indirect draws carry their draw item index as the first instance
+		deviceFeatures.geometryShader = visibilityBufferSupported ? VK_TRUE : VK_FALSE;
+		deviceFeatures.multiDrawIndirect = multiDrawIndirectSupported ? VK_TRUE : VK_FALSE; // Runs of draws sharing all state go in one indirect call
 		deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
 
+		// Core in 1.2, lets every texture live in one partially bound array that is written while in use
+		VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures = {};
+		descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+		descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = visibilityBufferSupported ? VK_TRUE : VK_FALSE;
+		deviceCreateInfo.pNext = &descriptorIndexingFeatures;
+
 		VkResult vkResult = vkCreateDevice(deviceHandle.physicalDevice, &deviceCreateInfo, nullptr, &deviceHandle.logicalDevice);
 		if (vkResult != VK_SUCCESS)
 		{
@@ -473,375 +884,430 @@ namespace Renderer
 		}
 	}
 
-	void VulkanRenderer::CreateRenderPass()
+	void VulkanRenderer::CreateOffscreenTargets()
 	{
 		PROFILE_FUNCTION();
 
-		// Attachments
-		// Subpass 1 attachments - Input Attachments
+		// Byte order of the readback, supported as a colour attachment everywhere
+		swapChainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		swapChainExtent = { headlessCreateInfo.width, headlessCreateInfo.height };
 
-		std::array<VkSubpassDescription, 2> subpasses{};
+		offscreenTargets.resize(MAX_FRAMES_IN_FLIGHT);
+		for (FrameAttachment& target : offscreenTargets)
+		{
+			CreateImageInfo imageCreateInfo = {};
+			imageCreateInfo.format = swapChainImageFormat;
+			imageCreateInfo.width = swapChainExtent.width;
+			imageCreateInfo.height = swapChainExtent.height;
+			imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageCreateInfo.useFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			imageCreateInfo.propFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-		// Depth Attachment
-		VkAttachmentDescription depthAttachment = {};
-		depthAttachment.format = GetSuitableFormat(
-			{ VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT },
-			VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
-		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		// Normal attachment
-		VkAttachmentDescription positionAttachment = {};
-		positionAttachment.format = GetSuitableFormat(
-			{ VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT },
-			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-		positionAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		positionAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		positionAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		positionAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		positionAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		positionAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		positionAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		// Normal attachment
-		VkAttachmentDescription normalAttachment = {};
-		normalAttachment.format = GetSuitableFormat(
-			{ VK_FORMAT_R8G8B8A8_UNORM },
-			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-		normalAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		normalAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		normalAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		normalAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		normalAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		normalAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		normalAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		// Albedo attachment
-		VkAttachmentDescription albedoAttachment = {};
-		albedoAttachment.format = GetSuitableFormat(
-			{ VK_FORMAT_R8G8B8A8_UNORM },
-			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-		albedoAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		albedoAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		albedoAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		albedoAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		albedoAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		albedoAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		albedoAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		// Position Attachment reference
-		VkAttachmentReference positionAttachmentReference = {};
-		positionAttachmentReference.attachment = 1;
-		positionAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		// Normal Attachment reference
-		VkAttachmentReference normalAttachmentReference = {};
-		normalAttachmentReference.attachment = 2;
-		normalAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		// Albedo Attachment reference
-		VkAttachmentReference albedoAttachmentReference = {};
-		albedoAttachmentReference.attachment = 3;
-		albedoAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		std::array<VkAttachmentReference, 3> colourAttachments = { positionAttachmentReference, normalAttachmentReference, albedoAttachmentReference };
-
-		// Depth Attachment reference
-		VkAttachmentReference depthAttachmentReference = {};
-		depthAttachmentReference.attachment = 4;
-		depthAttachmentReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		// Set up Subpass 1
-		subpasses[0].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpasses[0].colorAttachmentCount = static_cast<uint32_t>(colourAttachments.size());
-		subpasses[0].pColorAttachments = colourAttachments.data();
-		subpasses[0].pDepthStencilAttachment = &depthAttachmentReference;
-
-		// Subpass 2 attachments - Input Attachments
-
-		// Swapchain Colour attachment
-		VkAttachmentDescription swapchainColourAttachment{};
-		swapchainColourAttachment.format = swapChainImageFormat;
-		swapchainColourAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		swapchainColourAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		swapchainColourAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		swapchainColourAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		swapchainColourAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		swapchainColourAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		swapchainColourAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-		// Colour Attachment reference
-		VkAttachmentReference swapchainColourAttachmentReference = {};
-		swapchainColourAttachmentReference.attachment = 0;
-		swapchainColourAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		// References to attachments that subpass will take input from
-		std::array<VkAttachmentReference, 4> inputReferences;
-		inputReferences[0].attachment = 1;
-		inputReferences[0].layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		inputReferences[1].attachment = 2;
-		inputReferences[1].layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		inputReferences[2].attachment = 3;
-		inputReferences[2].layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		inputReferences[3].attachment = 4;
-		inputReferences[3].layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-		// Set up Subpass 2
-		subpasses[1].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpasses[1].colorAttachmentCount = 1;
-		subpasses[1].pColorAttachments = &swapchainColourAttachmentReference;
-		subpasses[1].inputAttachmentCount = static_cast<uint32_t>(inputReferences.size());
-		subpasses[1].pInputAttachments = inputReferences.data();
-
-		// Subpass dependencies
-
-		std::array<VkSubpassDependency, 5> subpassDependencies{};
-		subpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-		subpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-		subpassDependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-		subpassDependencies[0].dstSubpass = 0;
-		subpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		subpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		subpassDependencies[0].dependencyFlags = 0;
-
-		// Subpass 1 layout (position/normal/albedo/depth) to subpass 2 layout (shader read)
-		subpassDependencies[1].srcSubpass = 0;
-		subpassDependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		subpassDependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		subpassDependencies[1].dstSubpass = 1;
-		subpassDependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		subpassDependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		subpassDependencies[1].dependencyFlags = 0;
-
-		subpassDependencies[2].srcSubpass = 0;
-		subpassDependencies[2].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		subpassDependencies[2].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		subpassDependencies[2].dstSubpass = 1;
-		subpassDependencies[2].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		subpassDependencies[2].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		subpassDependencies[2].dependencyFlags = 0;
-
-		subpassDependencies[3].srcSubpass = 0;
-		subpassDependencies[3].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		subpassDependencies[3].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		subpassDependencies[3].dstSubpass = 1;
-		subpassDependencies[3].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		subpassDependencies[3].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		subpassDependencies[3].dependencyFlags = 0;
-
-		subpassDependencies[4].srcSubpass = 0;
-		subpassDependencies[4].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		subpassDependencies[4].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		subpassDependencies[4].dstSubpass = VK_SUBPASS_EXTERNAL;
-		subpassDependencies[4].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-		subpassDependencies[4].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-		subpassDependencies[4].dependencyFlags = 0;
-
-		std::array<VkAttachmentDescription, 5> renderPassAttachments = { swapchainColourAttachment, positionAttachment, normalAttachment, albedoAttachment, depthAttachment };
+			target.image = CreateImage(imageCreateInfo, &target.memory);
 
-		VkRenderPassCreateInfo renderPassCreateInfo = {};
-		renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(renderPassAttachments.size());
-		renderPassCreateInfo.pAttachments = renderPassAttachments.data();
-		renderPassCreateInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
-		renderPassCreateInfo.pSubpasses = subpasses.data();
-		renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
-		renderPassCreateInfo.pDependencies = subpassDependencies.data();
+			CreateImageViewInfo createImageViewInfo{};
+			createImageViewInfo.image = target.image;
+			createImageViewInfo.format = swapChainImageFormat;
+			createImageViewInfo.aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
+			createImageViewInfo.mipmapCount = 1;
 
-		VkResult vkResult = vkCreateRenderPass(deviceHandle.logicalDevice, &renderPassCreateInfo, nullptr, &renderPass);
+			target.view = CreateImageView(createImageViewInfo);
 
-		if (vkResult != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to create render pass");
+			SwapChainImage swapChainImage = {};
+			swapChainImage.image = target.image;
+			swapChainImage.imageView = target.view;
+			swapChainImages.push_back(swapChainImage);
 		}
-
 	}
 
-	void VulkanRenderer::CreateRenderPipeline()
+	void VulkanRenderer::BuildFrameGraph()
 	{
 		PROFILE_FUNCTION();
 
-		using namespace Utilities;
-
-		auto vertCode = Utils::ReadFile(COMPILED_SHADER_PATH + std::string("simple_shader.vert") + COMPILED_SHADER_SUFFIX);
-		auto fragCode = Utils::ReadFile(COMPILED_SHADER_PATH + std::string("simple_shader.frag") + COMPILED_SHADER_SUFFIX);
+		frameGraph = RenderGraph();
+		frameGraphIds = {};
 
-		auto secondPassVertCode = Utils::ReadFile(COMPILED_SHADER_PATH + std::string("second_subpass.vert") + COMPILED_SHADER_SUFFIX);
-		auto secondPassFragCode = Utils::ReadFile(COMPILED_SHADER_PATH + std::string("second_subpass.frag") + COMPILED_SHADER_SUFFIX);
+		const VkFormat depthFormat = GetSuitableFormat(
+			{ VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT },
+			VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+		const VkFormat shadowFormat = GetSuitableFormat({ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM },
+			VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
 
-		VkShaderModule vertexShaderModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, vertCode);
-		VkShaderModule fragmentShaderModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, fragCode);
+		// Acquired with the colour output stage waiting on the image, presented after the frame. Headless output is left ready to be copied out
+		const RenderGraphState outputFinalState = headless
+			? RenderGraphState{ VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT }
+			: RenderGraphState{ VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0 };
+		frameGraphIds.swapchain = frameGraph.ImportImage(headless ? "Offscreen output" : "Swapchain", { swapChainImageFormat, swapChainExtent.width, swapChainExtent.height },
+			{ VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0 }, outputFinalState);
 
-		VkShaderModule secondPassVertexShaderModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, secondPassVertCode);
-		VkShaderModule secondPassfragmentShaderModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, secondPassFragCode);
+		// The shadow mapper and light clusterer make their results visible to fragment shaders themselves, and the culler
+		// synchronizes its pyramid, so the graph only orders the passes around them
+		frameGraphIds.shadowMap = frameGraph.ImportImage("Shadow map", { shadowFormat, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, SHADOW_CASCADE_COUNT },
+			{ VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT },
+			{ VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, 0, 0 });
+		frameGraphIds.lightLists = frameGraph.ImportBuffer("Light lists",
+			{ VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT }, {});
+		frameGraphIds.depthPyramid = frameGraph.ImportImage("Depth pyramid", { VK_FORMAT_R32_SFLOAT }, // Only used by compute, its extent doesn't matter here
+			{ VK_IMAGE_LAYOUT_GENERAL, 0, 0 }, { VK_IMAGE_LAYOUT_GENERAL, 0, 0 });
 
-		renderPipelinePtr = new RenderPipeline();
+		frameGraphIds.depth = frameGraph.CreateImage("Depth", { depthFormat, swapChainExtent.width, swapChainExtent.height });
 
-		RenderPipeline::RenderPipelineCreateInfo pipelineCreateInfo = {};
-		RenderPipeline::ShaderModuleSet firstPassShaderModuleSet{ vertexShaderModule, fragmentShaderModule };
-		RenderPipeline::ShaderModuleSet secondPassShaderModuleSet{ secondPassVertexShaderModule, secondPassfragmentShaderModule };
+		const std::vector<GBufferTarget> gBufferTargets = GetGBufferColourTargets(gBufferLayout);
+		for (const GBufferTarget& target : gBufferTargets)
+		{
+			frameGraphIds.gBuffer.push_back(frameGraph.CreateImage(target.name, { target.format, swapChainExtent.width, swapChainExtent.height }));
+		}
 
-		pipelineCreateInfo.firstPassShaderModule = firstPassShaderModuleSet;
-		pipelineCreateInfo.secondPassShaderModule = secondPassShaderModuleSet;
+		// Early occlusion phase, its depth seeds the Hi-Z pyramid the late phase is tested against
+		frameGraphIds.earlyDepthPass = frameGraph.AddPass("Early depth", RenderGraphPassType::GRAPHICS);
+		frameGraph.Use(frameGraphIds.earlyDepthPass, frameGraphIds.depth, RenderGraphAccess::DEPTH_ATTACHMENT, RenderGraphLoad::CLEAR);
 
-		pipelineCreateInfo.extent = swapChainExtent;
-		pipelineCreateInfo.device = deviceHandle;
-		pipelineCreateInfo.renderPass = renderPass;
-		pipelineCreateInfo.swapchainImageCount = swapChainImages.size();
-		pipelineCreateInfo.minUniformBufferOffset = minUniformBufferOffset;
-		pipelineCreateInfo.positionBufferImageViewPtr = &positionBufferImageView;
-		pipelineCreateInfo.normalBufferImageViewPtr = &normalBufferImageView;
-		pipelineCreateInfo.albedoBufferImageViewPtr = &albedoBufferImageView;
-		pipelineCreateInfo.depthBufferImageViewPtr = &depthBufferImageView;
+		frameGraphIds.depthPyramidPass = frameGraph.AddPass("Depth pyramid", RenderGraphPassType::COMPUTE);
+		frameGraph.Use(frameGraphIds.depthPyramidPass, frameGraphIds.depth, RenderGraphAccess::COMPUTE_SAMPLED);
+		frameGraph.Use(frameGraphIds.depthPyramidPass, frameGraphIds.depthPyramid, RenderGraphAccess::COMPUTE_STORAGE_WRITE);
 
-		renderPipelinePtr->Init(pipelineCreateInfo);
+		frameGraphIds.depthPrepassPass = static_cast<RenderGraphPass>(-1);
+		if (depthPrepassEnabled)
+		{
+			frameGraphIds.depthPrepassPass = frameGraph.AddPass("Depth pre-pass", RenderGraphPassType::GRAPHICS);
+			frameGraph.Use(frameGraphIds.depthPrepassPass, frameGraphIds.depth, RenderGraphAccess::DEPTH_ATTACHMENT);
+		}
 
-		vkDestroyShaderModule(deviceHandle.logicalDevice, fragmentShaderModule, nullptr);
-		vkDestroyShaderModule(deviceHandle.logicalDevice, vertexShaderModule, nullptr);
+		// Colour outputs in fragment output order. After the pre-pass depth is final and only tested equal against
+		frameGraphIds.gBufferPass = frameGraph.AddPass("G-buffer", RenderGraphPassType::GRAPHICS);
+		for (RenderGraphResource gBufferTarget : frameGraphIds.gBuffer)
+		{
+			frameGraph.Use(frameGraphIds.gBufferPass, gBufferTarget, RenderGraphAccess::COLOUR_ATTACHMENT, RenderGraphLoad::CLEAR);
+		}
+		frameGraph.Use(frameGraphIds.gBufferPass, frameGraphIds.depth,
+			depthPrepassEnabled ? RenderGraphAccess::DEPTH_ATTACHMENT_READ_ONLY : RenderGraphAccess::DEPTH_ATTACHMENT);
 
-		vkDestroyShaderModule(deviceHandle.logicalDevice, secondPassVertexShaderModule, nullptr);
-		vkDestroyShaderModule(deviceHandle.logicalDevice, secondPassfragmentShaderModule, nullptr);
+		// Input attachments in input_attachment_index order, the colour targets then depth. Reading them at the same pixel makes
+		// lighting a second subpass of the G-buffer's render pass
+		frameGraphIds.lightingPass = frameGraph.AddPass("Lighting", RenderGraphPassType::GRAPHICS);
+		frameGraph.Use(frameGraphIds.lightingPass, frameGraphIds.swapchain, RenderGraphAccess::COLOUR_ATTACHMENT, RenderGraphLoad::CLEAR);
+		for (RenderGraphResource gBufferTarget : frameGraphIds.gBuffer)
+		{
+			frameGraph.Use(frameGraphIds.lightingPass, gBufferTarget, RenderGraphAccess::INPUT_ATTACHMENT);
+		}
+		frameGraph.Use(frameGraphIds.lightingPass, frameGraphIds.depth, RenderGraphAccess::INPUT_ATTACHMENT);
+		frameGraph.Use(frameGraphIds.lightingPass, frameGraphIds.shadowMap, RenderGraphAccess::FRAGMENT_SAMPLED);
+		frameGraph.Use(frameGraphIds.lightingPass, frameGraphIds.lightLists, RenderGraphAccess::FRAGMENT_STORAGE_READ);
+		frameGraph.SetSideEffects(frameGraphIds.lightingPass);
 	}
 
-	void VulkanRenderer::CreateAlbedoBufferImage()
+	void VulkanRenderer::CreateRenderPasses()
 	{
 		PROFILE_FUNCTION();
 
-		albedoBufferImage.resize(swapChainImages.size());
-		albedoBufferImageMemory.resize(swapChainImages.size());
-		albedoBufferImageView.resize(swapChainImages.size());
+		BuildFrameGraph();
+		frameGraph.Compile(compiledFrameGraph);
 
-		VkFormat colourFormat = GetSuitableFormat(
-			{ VK_FORMAT_R8G8B8A8_UNORM },
-			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+		const CompiledRenderGraph::Pass* gBufferPass = compiledFrameGraph.FindPass(frameGraphIds.gBufferPass);
+		const CompiledRenderGraph::Pass* lightingPass = compiledFrameGraph.FindPass(frameGraphIds.lightingPass);
+		const CompiledRenderGraph::RenderPass* earlyRenderPassDesc = compiledFrameGraph.FindRenderPass(frameGraphIds.earlyDepthPass);
 
-		CreateImageInfo imageCreateInfo = {};
-		imageCreateInfo.format = colourFormat;
-		imageCreateInfo.width = swapChainExtent.width;
-		imageCreateInfo.height = swapChainExtent.height;
-		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-		imageCreateInfo.useFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
-		imageCreateInfo.propFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		// The pipelines are created for the G-buffer and lighting subpasses 0 and 1 of one render pass
+		if (gBufferPass == nullptr || lightingPass == nullptr || earlyRenderPassDesc == nullptr || gBufferPass->renderPass != lightingPass->renderPass
+			|| gBufferPass->subpass != 0 || lightingPass->subpass != 1)
+		{
+			throw std::runtime_error("Failed to create render passes, the frame graph didn't compile to the G-buffer and lighting subpasses");
+		}
+
+		const CompiledRenderGraph::RenderPass& mainRenderPass = compiledFrameGraph.renderPasses[gBufferPass->renderPass];
+
+		earlyRenderPass = CreateCompiledRenderPass(*earlyRenderPassDesc);
+		renderPass = CreateCompiledRenderPass(mainRenderPass);
 
-		for (size_t i = 0; i < swapChainImages.size(); i++)
+		// Same single depth attachment as the early pass, so it stays compatible with its pipeline and framebuffer
+		if (depthPrepassEnabled)
 		{
-			albedoBufferImage[i] = CreateImage(imageCreateInfo, &albedoBufferImageMemory[i]);
+			depthPrepassRenderPass = CreateCompiledRenderPass(*compiledFrameGraph.FindRenderPass(frameGraphIds.depthPrepassPass));
+		}
 
-			CreateImageViewInfo createImageViewInfo{};
-			createImageViewInfo.image = albedoBufferImage[i];
-			createImageViewInfo.format = colourFormat;
-			createImageViewInfo.aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
-			createImageViewInfo.mipmapCount = 1;
+		const std::vector<GBufferTarget> gBufferTargets = GetGBufferColourTargets(gBufferLayout);
+		clearValues.assign(mainRenderPass.attachments.size(), {});
 
-			albedoBufferImageView[i] = CreateImageView(createImageViewInfo);
+		for (size_t i = 0; i < mainRenderPass.attachments.size(); i++)
+		{
+			const RenderGraphResource resource = mainRenderPass.attachments[i].resource;
+
+			if (resource == frameGraphIds.swapchain)
+			{
+				clearValues[i].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+			}
+			else if (resource == frameGraphIds.depth)
+			{
+				clearValues[i].depthStencil.depth = 1.0f;
+			}
+
+			for (size_t target = 0; target < frameGraphIds.gBuffer.size(); target++)
+			{
+				if (resource == frameGraphIds.gBuffer[target])
+				{
+					clearValues[i].color = gBufferTargets[target].clearValue;
+				}
+			}
 		}
 	}
 
-	void VulkanRenderer::CreatePositionBufferImage()
+	void VulkanRenderer::DestroyRenderPasses()
+	{
+		vkDestroyRenderPass(deviceHandle.logicalDevice, renderPass, nullptr);
+		vkDestroyRenderPass(deviceHandle.logicalDevice, earlyRenderPass, nullptr);
+		vkDestroyRenderPass(deviceHandle.logicalDevice, depthPrepassRenderPass, nullptr);
+
+		renderPass = nullptr;
+		earlyRenderPass = nullptr;
+		depthPrepassRenderPass = nullptr;
+	}
+
+	VkRenderPass VulkanRenderer::CreateCompiledRenderPass(const CompiledRenderGraph::RenderPass& compiledRenderPass) const
 	{
 		PROFILE_FUNCTION();
 
-		positionBufferImage.resize(swapChainImages.size());
-		positionBufferImageMemory.resize(swapChainImages.size());
-		positionBufferImageView.resize(swapChainImages.size());
+		std::vector<VkAttachmentDescription> attachments(compiledRenderPass.attachments.size());
+		for (size_t i = 0; i < attachments.size(); i++)
+		{
+			const CompiledRenderGraph::Attachment& attachment = compiledRenderPass.attachments[i];
 
-		VkFormat colourFormat = GetSuitableFormat(
-			{ VK_FORMAT_R32G32B32A32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT },
-			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+			attachments[i].format = attachment.format;
+			attachments[i].samples = VK_SAMPLE_COUNT_1_BIT;
+			attachments[i].loadOp = attachment.loadOp;
+			attachments[i].storeOp = attachment.storeOp;
+			attachments[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachments[i].initialLayout = attachment.initialLayout;
+			attachments[i].finalLayout = attachment.finalLayout;
+		}
 
-		CreateImageInfo imageCreateInfo = {};
-		imageCreateInfo.format = colourFormat;
-		imageCreateInfo.width = swapChainExtent.width;
-		imageCreateInfo.height = swapChainExtent.height;
-		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-		imageCreateInfo.useFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
-		imageCreateInfo.propFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		std::vector<VkSubpassDescription> subpasses(compiledRenderPass.subpasses.size());
+		for (size_t i = 0; i < subpasses.size(); i++)
+		{
+			const CompiledRenderGraph::Subpass& subpass = compiledRenderPass.subpasses[i];
+
+			subpasses[i].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpasses[i].colorAttachmentCount = static_cast<uint32_t>(subpass.colourReferences.size());
+			subpasses[i].pColorAttachments = subpass.colourReferences.data();
+			subpasses[i].inputAttachmentCount = static_cast<uint32_t>(subpass.inputReferences.size());
+			subpasses[i].pInputAttachments = subpass.inputReferences.data();
+			subpasses[i].pDepthStencilAttachment = subpass.depthReference.attachment != VK_ATTACHMENT_UNUSED ? &subpass.depthReference : nullptr;
+		}
+
+		VkRenderPassCreateInfo renderPassCreateInfo = {};
+		renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassCreateInfo.pAttachments = attachments.data();
+		renderPassCreateInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+		renderPassCreateInfo.pSubpasses = subpasses.data();
+		renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(compiledRenderPass.dependencies.size());
+		renderPassCreateInfo.pDependencies = compiledRenderPass.dependencies.data();
+
+		VkRenderPass createdRenderPass = nullptr;
+		VkResult vkResult = vkCreateRenderPass(deviceHandle.logicalDevice, &renderPassCreateInfo, nullptr, &createdRenderPass);
 
-		for (size_t i = 0; i < swapChainImages.size(); i++)
+		if (vkResult != VK_SUCCESS)
 		{
-			positionBufferImage[i] = CreateImage(imageCreateInfo, &positionBufferImageMemory[i]);
+			throw std::runtime_error("Failed to create render pass");
+		}
 
-			CreateImageViewInfo createImageViewInfo{};
-			createImageViewInfo.image = positionBufferImage[i];
-			createImageViewInfo.format = colourFormat;
-			createImageViewInfo.aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
-			createImageViewInfo.mipmapCount = 1;
+		return createdRenderPass;
+	}
+
+	VulkanRenderer::FrameAttachment VulkanRenderer::GetFrameGraphAttachment(RenderGraphResource resource, uint32_t imageIndex) const
+	{
+		if (resource == frameGraphIds.swapchain)
+		{
+			return { swapChainImages[imageIndex].image, nullptr, swapChainImages[imageIndex].imageView };
+		}
+
+		if (resource == frameGraphIds.depth)
+		{
+			return depthAttachment;
+		}
+
+		for (size_t target = 0; target < frameGraphIds.gBuffer.size(); target++)
+		{
+			if (resource == frameGraphIds.gBuffer[target])
+			{
+				return gBufferAttachments[target];
+			}
+		}
+
+		return {};
+	}
+
+	void VulkanRenderer::RecordFrameGraphBarriers(VkCommandBuffer commandBuffer, const std::vector<RenderGraphBarrier>& barriers, uint32_t imageIndex) const
+	{
+		for (const RenderGraphBarrier& barrier : barriers)
+		{
+			const VkPipelineStageFlags srcStages = barrier.src.stages != 0 ? barrier.src.stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+			const VkPipelineStageFlags dstStages = barrier.dst.stages != 0 ? barrier.dst.stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+			if (barrier.src.layout == barrier.dst.layout)
+			{
+				VkMemoryBarrier memoryBarrier = {};
+				memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+				memoryBarrier.srcAccessMask = barrier.src.access;
+				memoryBarrier.dstAccessMask = barrier.dst.access;
+				vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+				PROFILE_COUNT(PIPELINE_BARRIERS);
+				continue;
+			}
+
+			const FrameAttachment attachment = GetFrameGraphAttachment(barrier.resource, imageIndex);
+			if (attachment.image == nullptr)
+			{
+				throw std::runtime_error("Failed to record frame graph barrier, " + frameGraph.GetResourceName(barrier.resource) + " isn't owned by the renderer");
+			}
+
+			VkImageMemoryBarrier imageBarrier = {};
+			imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageBarrier.oldLayout = barrier.src.layout;
+			imageBarrier.newLayout = barrier.dst.layout;
+			imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image = attachment.image;
+			const VkFormat format = frameGraph.GetImageDesc(barrier.resource).format;
+			imageBarrier.subresourceRange.aspectMask = !IsDepthFormat(format) ? VK_IMAGE_ASPECT_COLOR_BIT
+				: HasStencilComponent(format) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+			imageBarrier.subresourceRange.levelCount = 1;
+			imageBarrier.subresourceRange.layerCount = 1;
+			imageBarrier.srcAccessMask = barrier.src.access;
+			imageBarrier.dstAccessMask = barrier.dst.access;
+			vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+			PROFILE_COUNT(PIPELINE_BARRIERS);
+		}
+	}
 
-			positionBufferImageView[i] = CreateImageView(createImageViewInfo);
+	void VulkanRenderer::RecordFrameGraphBarriers(VkCommandBuffer commandBuffer, RenderGraphPass pass, uint32_t imageIndex) const
+	{
+		const CompiledRenderGraph::Pass* compiledPass = compiledFrameGraph.FindPass(pass);
+		if (compiledPass != nullptr)
+		{
+			RecordFrameGraphBarriers(commandBuffer, compiledPass->barriers, imageIndex);
 		}
 	}
 
-	void VulkanRenderer::CreateNormalBufferImage()
+	void VulkanRenderer::CreateRenderPipeline()
 	{
 		PROFILE_FUNCTION();
 
-		normalBufferImage.resize(swapChainImages.size());
-		normalBufferImageMemory.resize(swapChainImages.size());
-		normalBufferImageView.resize(swapChainImages.size());
+		using namespace Utilities;
+
+		std::string gBufferFragName = "simple_shader.frag";
+		std::string lightingFragName = "second_subpass.frag";
+
+		if (gBufferLayout == GBufferLayout::COMPACT)
+		{
+			gBufferFragName = "gbuffer_compact.frag";
+			lightingFragName = "second_subpass_compact.frag";
+		}
+		else if (gBufferLayout == GBufferLayout::VISIBILITY)
+		{
+			gBufferFragName = "visibility.frag";
+			lightingFragName = "second_subpass_visibility.frag";
+		}
+
+		auto vertCode = Utils::ReadFile(COMPILED_SHADER_PATH + std::string("simple_shader.vert") + COMPILED_SHADER_SUFFIX);
+		auto depthOnlyVertCode = Utils::ReadFile(COMPILED_SHADER_PATH + std::string("depth_only.vert") + COMPILED_SHADER_SUFFIX);
+		auto fragCode = Utils::ReadFile(COMPILED_SHADER_PATH + gBufferFragName + COMPILED_SHADER_SUFFIX);
+
+		auto secondPassVertCode = Utils::ReadFile(COMPILED_SHADER_PATH + std::string("second_subpass.vert") + COMPILED_SHADER_SUFFIX);
+		auto secondPassFragCode = Utils::ReadFile(COMPILED_SHADER_PATH + lightingFragName + COMPILED_SHADER_SUFFIX);
+
+		VkShaderModule vertexShaderModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, vertCode);
+		VkShaderModule fragmentShaderModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, fragCode);
+		VkShaderModule depthOnlyVertexShaderModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, depthOnlyVertCode);
+
+		VkShaderModule secondPassVertexShaderModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, secondPassVertCode);
+		VkShaderModule secondPassfragmentShaderModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, secondPassFragCode);
+
+		renderPipelinePtr = new RenderPipeline();
+
+		RenderPipeline::RenderPipelineCreateInfo pipelineCreateInfo = {};
+		RenderPipeline::ShaderModuleSet firstPassShaderModuleSet{ vertexShaderModule, fragmentShaderModule };
+		RenderPipeline::ShaderModuleSet secondPassShaderModuleSet{ secondPassVertexShaderModule, secondPassfragmentShaderModule };
+
+		pipelineCreateInfo.firstPassShaderModule = firstPassShaderModuleSet;
+		pipelineCreateInfo.secondPassShaderModule = secondPassShaderModuleSet;
+		pipelineCreateInfo.depthOnlyVertexModule = depthOnlyVertexShaderModule;
+
+		pipelineCreateInfo.extent = swapChainExtent;
+		pipelineCreateInfo.device = deviceHandle;
+		pipelineCreateInfo.renderPass = renderPass;
+		pipelineCreateInfo.earlyRenderPass = earlyRenderPass;
+		pipelineCreateInfo.frameCount = frames.size();
+
+		pipelineCreateInfo.gBufferLayout = gBufferLayout;
+		pipelineCreateInfo.depthBufferImageView = depthAttachment.view;
+		pipelineCreateInfo.lightClusterSetLayout = lightClustererPtr->GetDescriptorSetLayout();
+		pipelineCreateInfo.shadowSetLayout = shadowMapperPtr->GetDescriptorSetLayout();
+		pipelineCreateInfo.visibilitySetLayout = visibilityBufferPtr != nullptr ? visibilityBufferPtr->GetDescriptorSetLayout() : nullptr;
+
+		for (const FrameAttachment& attachment : gBufferAttachments)
+		{
+			pipelineCreateInfo.gBufferImageViews.push_back(attachment.view);
+		}
+
+		renderPipelinePtr->Init(pipelineCreateInfo);
 
-		VkFormat colourFormat = GetSuitableFormat(
-			{ VK_FORMAT_R8G8B8A8_UNORM },
-			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+		vkDestroyShaderModule(deviceHandle.logicalDevice, fragmentShaderModule, nullptr);
+		vkDestroyShaderModule(deviceHandle.logicalDevice, vertexShaderModule, nullptr);
+		vkDestroyShaderModule(deviceHandle.logicalDevice, depthOnlyVertexShaderModule, nullptr);
+
+		vkDestroyShaderModule(deviceHandle.logicalDevice, secondPassVertexShaderModule, nullptr);
+		vkDestroyShaderModule(deviceHandle.logicalDevice, secondPassfragmentShaderModule, nullptr);
+	}
+
+	void VulkanRenderer::CreateColourBufferImage(VkFormat format, FrameAttachment& attachment)
+	{
+		PROFILE_FUNCTION();
 
 		CreateImageInfo imageCreateInfo = {};
-		imageCreateInfo.format = colourFormat;
+		imageCreateInfo.format = format;
 		imageCreateInfo.width = swapChainExtent.width;
 		imageCreateInfo.height = swapChainExtent.height;
 		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-		imageCreateInfo.useFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
-		imageCreateInfo.propFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		imageCreateInfo.useFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		imageCreateInfo.propFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
 
-		for (size_t i = 0; i < swapChainImages.size(); i++)
-		{
-			normalBufferImage[i] = CreateImage(imageCreateInfo, &normalBufferImageMemory[i]);
+		attachment.image = CreateImage(imageCreateInfo, &attachment.memory);
 
-			CreateImageViewInfo createImageViewInfo{};
-			createImageViewInfo.image = normalBufferImage[i];
-			createImageViewInfo.format = colourFormat;
-			createImageViewInfo.aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
-			createImageViewInfo.mipmapCount = 1;
+		CreateImageViewInfo createImageViewInfo{};
+		createImageViewInfo.image = attachment.image;
+		createImageViewInfo.format = format;
+		createImageViewInfo.aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
+		createImageViewInfo.mipmapCount = 1;
 
-			normalBufferImageView[i] = CreateImageView(createImageViewInfo);
-		}
+		attachment.view = CreateImageView(createImageViewInfo);
 	}
 
 	void VulkanRenderer::CreateDepthBufferImage()
 	{
 		PROFILE_FUNCTION();
 
-		depthBufferImage.resize(swapChainImages.size());
-		depthBufferImageMemory.resize(swapChainImages.size());
-		depthBufferImageView.resize(swapChainImages.size());
-
 		VkFormat depthFormat = GetSuitableFormat(
 			{ VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT },
-			VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+			VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
 
 		CreateImageInfo imageCreateInfo = {};
 		imageCreateInfo.format = depthFormat;
 		imageCreateInfo.width = swapChainExtent.width;
 		imageCreateInfo.height = swapChainExtent.height;
 		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-		imageCreateInfo.useFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+		imageCreateInfo.useFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 		imageCreateInfo.propFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-		for (size_t i = 0; i < swapChainImages.size(); i++)
-		{
-			depthBufferImage[i] = CreateImage(imageCreateInfo, &depthBufferImageMemory[i]);
+		depthAttachment.image = CreateImage(imageCreateInfo, &depthAttachment.memory);
 
-			CreateImageViewInfo createImageViewInfo{};
-			createImageViewInfo.image = depthBufferImage[i];
-			createImageViewInfo.format = depthFormat;
-			createImageViewInfo.aspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT;
-			createImageViewInfo.mipmapCount = 1;
+		CreateImageViewInfo createImageViewInfo{};
+		createImageViewInfo.image = depthAttachment.image;
+		createImageViewInfo.format = depthFormat;
+		createImageViewInfo.aspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT;
+		createImageViewInfo.mipmapCount = 1;
 
-			depthBufferImageView[i] = CreateImageView(createImageViewInfo);
-		}
+		depthAttachment.view = CreateImageView(createImageViewInfo);
 	}
 
 	void VulkanRenderer::CreateFrameBuffers()
@@ -850,9 +1316,16 @@ namespace Renderer
 
 		swapchainFrameBuffers.resize(swapChainImages.size());
 
+		// Views in the compiled render pass's attachment order
+		const CompiledRenderGraph::RenderPass& mainRenderPass = *compiledFrameGraph.FindRenderPass(frameGraphIds.gBufferPass);
+
 		for (size_t i = 0; i < swapchainFrameBuffers.size(); i++)
 		{
-			std::array<VkImageView, 5> attachments = { swapChainImages[i].imageView, positionBufferImageView[i], normalBufferImageView[i], albedoBufferImageView[i], depthBufferImageView[i] };
+			std::vector<VkImageView> attachments;
+			for (const CompiledRenderGraph::Attachment& attachment : mainRenderPass.attachments)
+			{
+				attachments.push_back(GetFrameGraphAttachment(attachment.resource, static_cast<uint32_t>(i)).view);
+			}
 
 			VkFramebufferCreateInfo frameBufferCreateInfo = {};
 			frameBufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -870,6 +1343,22 @@ namespace Renderer
 				throw std::runtime_error("Failed to create a frame buffer");
 			}
 		}
+
+		VkFramebufferCreateInfo frameBufferCreateInfo = {};
+		frameBufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		frameBufferCreateInfo.renderPass = earlyRenderPass;
+		frameBufferCreateInfo.attachmentCount = 1;
+		frameBufferCreateInfo.pAttachments = &depthAttachment.view;
+		frameBufferCreateInfo.width = swapChainExtent.width;
+		frameBufferCreateInfo.height = swapChainExtent.height;
+		frameBufferCreateInfo.layers = 1;
+
+		VkResult vkResult = vkCreateFramebuffer(deviceHandle.logicalDevice, &frameBufferCreateInfo, nullptr, &earlyFrameBuffer);
+
+		if (vkResult != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create a frame buffer");
+		}
 	}
 
 	void VulkanRenderer::CreateCommandPool()
@@ -891,117 +1380,489 @@ namespace Renderer
 		}
 	}
 
-	void VulkanRenderer::CreateCommandBuffers()
+	void VulkanRenderer::CreateOcclusionCuller()
 	{
 		PROFILE_FUNCTION();
 
-		commandBuffers.resize(swapchainFrameBuffers.size());
-		VkCommandBufferAllocateInfo allocateInfo = {};
+		auto downsampleCode = Utils::ReadFile(COMPILED_SHADER_PATH + std::string("hiz_downsample.comp") + COMPILED_SHADER_SUFFIX);
+		auto cullCode = Utils::ReadFile(COMPILED_SHADER_PATH + std::string("occlusion_cull.comp") + COMPILED_SHADER_SUFFIX);
 
-		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocateInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
-		allocateInfo.commandPool = gfxCommandPool;
-		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		VkShaderModule downsampleShaderModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, downsampleCode);
+		VkShaderModule cullShaderModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, cullCode);
 
-		VkResult vkResult = vkAllocateCommandBuffers(deviceHandle.logicalDevice, &allocateInfo, commandBuffers.data());
+		occlusionCullerPtr = new OcclusionCuller();
 
-		if (vkResult != VK_SUCCESS)
+		OcclusionCuller::OcclusionCullerCreateInfo cullerCreateInfo = {};
+		cullerCreateInfo.device = deviceHandle;
+		cullerCreateInfo.queue = graphicsQueue;
+		cullerCreateInfo.commandPool = gfxCommandPool;
+		cullerCreateInfo.extent = swapChainExtent;
+		cullerCreateInfo.frameCount = frames.size();
+		cullerCreateInfo.downsampleShaderModule = downsampleShaderModule;
+		cullerCreateInfo.cullShaderModule = cullShaderModule;
+
+		cullerCreateInfo.depthBufferImageViews.assign(frames.size(), depthAttachment.view);
+
+		occlusionCullerPtr->Init(cullerCreateInfo);
+
+		vkDestroyShaderModule(deviceHandle.logicalDevice, downsampleShaderModule, nullptr);
+		vkDestroyShaderModule(deviceHandle.logicalDevice, cullShaderModule, nullptr);
+	}
+
+	void VulkanRenderer::CreateVisibilityBuffer()
+	{
+		PROFILE_FUNCTION();
+
+		if (gBufferLayout != GBufferLayout::VISIBILITY)
 		{
-			throw std::runtime_error("Failed to allocate command buffer");
+			return;
 		}
+
+		visibilityBufferPtr = new VisibilityBuffer();
+
+		VisibilityBuffer::VisibilityBufferCreateInfo visibilityCreateInfo = {};
+		visibilityCreateInfo.device = deviceHandle;
+		visibilityCreateInfo.queue = graphicsQueue;
+		visibilityCreateInfo.commandPool = gfxCommandPool;
+		visibilityCreateInfo.frameCount = frames.size();
+
+		visibilityBufferPtr->Init(visibilityCreateInfo);
+		visibilityBufferPtr->SetGeometry(modelList);
 	}
 
-	void VulkanRenderer::CreateSynchronization()
+	void VulkanRenderer::CreateLightClusterer()
 	{
 		PROFILE_FUNCTION();
 
-		imageAvailable.resize(MAX_FRAME_DRAWS);
-		renderFinished.resize(MAX_FRAME_DRAWS);
-		drawFences.resize(MAX_FRAME_DRAWS);
+		auto clusterCode = Utils::ReadFile(COMPILED_SHADER_PATH + std::string("light_cluster.comp") + COMPILED_SHADER_SUFFIX);
+		VkShaderModule clusterShaderModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, clusterCode);
 
-		VkSemaphoreCreateInfo semaphoreCreateInfo = {};
-		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		lightClustererPtr = new LightClusterer();
 
-		VkFenceCreateInfo fenceCreateInfo = {};
-		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		LightClusterer::LightClustererCreateInfo clustererCreateInfo = {};
+		clustererCreateInfo.device = deviceHandle;
+		clustererCreateInfo.extent = swapChainExtent;
+		clustererCreateInfo.frameCount = frames.size();
+		clustererCreateInfo.clusterShaderModule = clusterShaderModule;
 
-		for (size_t i = 0; i < MAX_FRAME_DRAWS; i++)
-		{
-			VkResult vkResult1 = vkCreateSemaphore(deviceHandle.logicalDevice, &semaphoreCreateInfo, nullptr, &imageAvailable[i]);
-			VkResult vkResult2 = vkCreateSemaphore(deviceHandle.logicalDevice, &semaphoreCreateInfo, nullptr, &renderFinished[i]);
-			VkResult vkResult3 = vkCreateFence(deviceHandle.logicalDevice, &fenceCreateInfo, nullptr, &drawFences[i]);
+		lightClustererPtr->Init(clustererCreateInfo);
 
-			if (vkResult1 != VK_SUCCESS || vkResult2 != VK_SUCCESS || vkResult3 != VK_SUCCESS)
-			{
-				throw std::runtime_error("Failed to create semaphore");
-			}
-		}
+		vkDestroyShaderModule(deviceHandle.logicalDevice, clusterShaderModule, nullptr);
 	}
 
-	void VulkanRenderer::CreateTextureSampler()
+	void VulkanRenderer::CreateShadowMapper()
 	{
 		PROFILE_FUNCTION();
 
-		VkSamplerCreateInfo samplerCreateInfo = {};
-		samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
-		samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
-		samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerCreateInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-		samplerCreateInfo.anisotropyEnable = VK_TRUE;
-		samplerCreateInfo.maxAnisotropy = 16.0f;
-		samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
-		samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		samplerCreateInfo.mipLodBias = 0.0f;
-		samplerCreateInfo.minLod = 0.0f;
-		samplerCreateInfo.maxLod = 8.0f;
+		auto shadowVertCode = Utils::ReadFile(COMPILED_SHADER_PATH + std::string("shadow_depth.vert") + COMPILED_SHADER_SUFFIX);
+		VkShaderModule shadowVertexModule = Utils::CreateShaderModule(deviceHandle.logicalDevice, shadowVertCode);
 
-		VkResult vkResult = vkCreateSampler(deviceHandle.logicalDevice, &samplerCreateInfo, nullptr, &textureSampler);
+		shadowMapperPtr = new ShadowMapper();
+
+		ShadowMapper::ShadowMapperCreateInfo shadowCreateInfo = {};
+		shadowCreateInfo.device = deviceHandle;
+		shadowCreateInfo.queue = graphicsQueue;
+		shadowCreateInfo.commandPool = gfxCommandPool;
+		shadowCreateInfo.frameCount = frames.size();
+		// Depth only formats, a stencil aspect would need separate views for rendering and sampling
+		shadowCreateInfo.depthFormat = GetSuitableFormat({ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM },
+			VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+		shadowCreateInfo.shadowMapSize = SHADOW_MAP_SIZE;
+		shadowCreateInfo.shadowVertexModule = shadowVertexModule;
+
+		shadowMapperPtr->Init(shadowCreateInfo);
+
+		// The new shadow map starts empty
+		shadowCascadeCache.Invalidate();
+
+		vkDestroyShaderModule(deviceHandle.logicalDevice, shadowVertexModule, nullptr);
+	}
+
+	void VulkanRenderer::CreateCommandBuffer(FrameContext& frame)
+	{
+		PROFILE_FUNCTION();
+
+		// A pool per frame lets the whole frame's allocations be reset at once instead of per command buffer
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		QueueFamilyIndices queueIndices = GetQueueFamilyIndices(deviceHandle.physicalDevice);
+		poolInfo.queueFamilyIndex = queueIndices.graphicsFamily;
+
+		VkResult vkResult = vkCreateCommandPool(deviceHandle.logicalDevice, &poolInfo, nullptr, &frame.commandPool);
 
 		if (vkResult != VK_SUCCESS)
 		{
-			throw std::runtime_error("Failed to create texture sampler!");
+			throw std::runtime_error("Failed to create command pool");
+		}
+
+		VkCommandBufferAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandBufferCount = 1;
+		allocateInfo.commandPool = frame.commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+		vkResult = vkAllocateCommandBuffers(deviceHandle.logicalDevice, &allocateInfo, &frame.commandBuffer);
+
+		if (vkResult != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate command buffer");
 		}
 	}
 
-	int32_t VulkanRenderer::CreateTexture(const std::string& fileName, bool useMipmaps /*=false*/)
+	void VulkanRenderer::CreateSynchronization(FrameContext& frame)
 	{
 		PROFILE_FUNCTION();
 
-		uint32_t mipmapCount = 1;
-		int32_t textureImgLoc = CreateTextureImage(fileName, useMipmaps ? &mipmapCount : nullptr);
+		VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-		CreateImageViewInfo createImageViewInfo{};
-		createImageViewInfo.image = textureHandles[textureImgLoc].image;
-		createImageViewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-		createImageViewInfo.aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
-		createImageViewInfo.mipmapCount = mipmapCount;
+		VkFenceCreateInfo fenceCreateInfo = {};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-		VkImageView imgView = CreateImageView(createImageViewInfo);
-		textureImgViews.push_back(imgView);
+		VkResult vkResult1 = vkCreateSemaphore(deviceHandle.logicalDevice, &semaphoreCreateInfo, nullptr, &frame.imageAvailable);
+		VkResult vkResult2 = vkCreateSemaphore(deviceHandle.logicalDevice, &semaphoreCreateInfo, nullptr, &frame.renderFinished);
+		VkResult vkResult3 = vkCreateFence(deviceHandle.logicalDevice, &fenceCreateInfo, nullptr, &frame.drawFence);
 
-		int32_t descLoc = renderPipelinePtr->CreateTextureDescriptor(imgView, textureSampler);
+		if (vkResult1 != VK_SUCCESS || vkResult2 != VK_SUCCESS || vkResult3 != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create semaphore");
+		}
+	}
 
-		return descLoc;
+	void VulkanRenderer::CreateGpuProfiler()
+	{
+		PROFILE_FUNCTION();
+
+		Profiler& profiler = Profiler::Get();
+		gpuScopeNames.lightClustering = profiler.InternName("Light clustering");
+		gpuScopeNames.shadows = profiler.InternName("Shadow cascades");
+		gpuScopeNames.earlyDepth = profiler.InternName("Early depth");
+		gpuScopeNames.depthPyramid = profiler.InternName("Depth pyramid & late cull");
+		gpuScopeNames.depthPrepass = profiler.InternName("Depth pre-pass");
+		gpuScopeNames.gBuffer = profiler.InternName("G-buffer subpass");
+		gpuScopeNames.lighting = profiler.InternName("Lighting subpass");
+		gpuScopeNames.textureUpload = profiler.InternName("Texture upload");
+
+		gpuProfilerPtr = new GpuProfiler();
+
+		GpuProfiler::GpuProfilerCreateInfo gpuProfilerCreateInfo = {};
+		gpuProfilerCreateInfo.device = deviceHandle;
+		gpuProfilerCreateInfo.queue = graphicsQueue;
+		gpuProfilerCreateInfo.commandPool = gfxCommandPool;
+		gpuProfilerCreateInfo.frameCount = MAX_FRAMES_IN_FLIGHT;
+		gpuProfilerCreateInfo.timestampPeriod = timestampPeriod;
+		gpuProfilerCreateInfo.calibratedTimestamps = calibratedTimestampsSupported;
+
+		gpuProfilerPtr->Init(gpuProfilerCreateInfo);
 	}
 
-	int32_t VulkanRenderer::CreateTextureImage(const std::string& fileName, uint32_t* mipmapCount /*=nullptr*/)
+	void VulkanRenderer::ReadGpuPassTimings(uint32_t frameIndex)
 	{
 		PROFILE_FUNCTION();
 
-		TextureInfo texInfo;
-		stbi_uc* imageData = Utils::LoadTextureFile(fileName, texInfo);
+		gpuProfilerPtr->ReadFrame(frameIndex);
+		if (gpuProfilerPtr->GetFrameScopes().empty())
+		{
+			return;
+		}
 
-		VkBuffer imageStagingBuffer = nullptr;
-		VkDeviceMemory imageStagingBufferMemory = nullptr;
+		gpuPassTimings = {};
+		for (const GpuProfiler::Scope& scope : gpuProfilerPtr->GetFrameScopes())
+		{
+			const float scopeMs = static_cast<float>(scope.endNs - scope.startNs) * 1e-6f;
 
-		CreateBufferInfo bufferInfo{};
-		bufferInfo.physicalDevice = deviceHandle.physicalDevice;
-		bufferInfo.device = deviceHandle.logicalDevice;
-		bufferInfo.bufferSize = texInfo.imageSize;
+			if (scope.nameId == gpuScopeNames.shadows)
+			{
+				gpuPassTimings.shadowMs += scopeMs;
+			}
+			else if (scope.nameId == gpuScopeNames.earlyDepth || scope.nameId == gpuScopeNames.depthPrepass)
+			{
+				gpuPassTimings.depthMs += scopeMs;
+			}
+			else if (scope.nameId == gpuScopeNames.gBuffer)
+			{
+				gpuPassTimings.gBufferMs += scopeMs;
+			}
+			else if (scope.nameId == gpuScopeNames.lighting)
+			{
+				gpuPassTimings.lightingMs += scopeMs;
+			}
+		}
+	}
+
+	void VulkanRenderer::CreateFrameContexts()
+	{
+		PROFILE_FUNCTION();
+
+		frames.resize(framesInFlight);
+
+		for (FrameContext& frame : frames)
+		{
+			CreateCommandBuffer(frame);
+			CreateSynchronization(frame);
+		}
+
+		// Frame indices are handed out again, scopes recorded under the old ones can't be matched to their frames any more
+		gpuProfilerPtr->ResetFrames();
+	}
+
+	void VulkanRenderer::DestroyFrameContexts()
+	{
+		PROFILE_FUNCTION();
+
+		for (FrameContext& frame : frames)
+		{
+			vkDestroySemaphore(deviceHandle.logicalDevice, frame.renderFinished, nullptr);
+			vkDestroySemaphore(deviceHandle.logicalDevice, frame.imageAvailable, nullptr);
+			vkDestroyFence(deviceHandle.logicalDevice, frame.drawFence, nullptr);
+
+			// Destroying the pool frees its command buffer
+			vkDestroyCommandPool(deviceHandle.logicalDevice, frame.commandPool, nullptr);
+		}
+
+		frames.clear();
+	}
+
+	void VulkanRenderer::CreateGBuffer()
+	{
+		PROFILE_FUNCTION();
+
+		const std::vector<GBufferTarget> gBufferTargets = GetGBufferColourTargets(gBufferLayout);
+		gBufferAttachments.resize(gBufferTargets.size());
+
+		for (size_t i = 0; i < gBufferTargets.size(); i++)
+		{
+			CreateColourBufferImage(gBufferTargets[i].format, gBufferAttachments[i]);
+		}
+
+		CreateDepthBufferImage();
+		CreateFrameBuffers();
+	}
+
+	void VulkanRenderer::DestroyGBuffer()
+	{
+		PROFILE_FUNCTION();
+
+		for (VkFramebuffer frameBuffer : swapchainFrameBuffers)
+		{
+			vkDestroyFramebuffer(deviceHandle.logicalDevice, frameBuffer, nullptr);
+		}
+
+		swapchainFrameBuffers.clear();
+		vkDestroyFramebuffer(deviceHandle.logicalDevice, earlyFrameBuffer, nullptr);
+		earlyFrameBuffer = nullptr;
+
+		DestroyFrameAttachment(depthAttachment);
+
+		for (FrameAttachment& attachment : gBufferAttachments)
+		{
+			DestroyFrameAttachment(attachment);
+		}
+
+		gBufferAttachments.clear();
+	}
+
+	void VulkanRenderer::ReportGBufferMemory() const
+	{
+		PROFILE_FUNCTION();
+
+		struct NamedAttachment
+		{
+			const char* name;
+			const FrameAttachment* attachment;
+			bool transient;
+		};
+
+		const std::vector<GBufferTarget> gBufferTargets = GetGBufferColourTargets(gBufferLayout);
+		std::vector<NamedAttachment> attachments;
+
+		for (size_t i = 0; i < gBufferTargets.size(); i++)
+		{
+			attachments.push_back({ gBufferTargets[i].name, &gBufferAttachments[i], true });
+		}
+
+		attachments.push_back({ "depth", &depthAttachment, false });
+
+		constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+		VkDeviceSize allocatedBytes = 0;
+		VkDeviceSize committedBytes = 0;
+
+		std::cout << "\n" << GetGBufferLayoutName(gBufferLayout) << " G-buffer memory at "
+			<< swapChainExtent.width << "x" << swapChainExtent.height << ", " << GetGBufferBytesPerPixel(gBufferLayout) << " bytes per pixel :";
+
+		for (const NamedAttachment& namedAttachment : attachments)
+		{
+			VkMemoryRequirements memoryRequirements;
+			vkGetImageMemoryRequirements(deviceHandle.logicalDevice, namedAttachment.attachment->image, &memoryRequirements);
+
+			// Same choice CreateImage made, lazily allocated memory is only backed where the GPU spills tiles out of on chip memory
+			const bool lazilyAllocated = namedAttachment.transient &&
+				HasMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+
+			VkDeviceSize committed = memoryRequirements.size;
+			if (lazilyAllocated)
+			{
+				vkGetDeviceMemoryCommitment(deviceHandle.logicalDevice, namedAttachment.attachment->memory, &committed);
+			}
+
+			allocatedBytes += memoryRequirements.size;
+			committedBytes += committed;
+
+			std::cout << "\n\t" << namedAttachment.name << " : " << memoryRequirements.size / BYTES_PER_MB << " MB"
+				<< (lazilyAllocated ? " lazily allocated, " : " device local, ") << committed / BYTES_PER_MB << " MB committed";
+		}
+
+		// Before sharing every frame in flight had its own set of the same images
+		std::cout << "\n\tShared : " << allocatedBytes / BYTES_PER_MB << " MB allocated, " << committedBytes / BYTES_PER_MB << " MB committed"
+			<< "\n\tOne per frame : " << allocatedBytes * framesInFlight / BYTES_PER_MB << " MB at " << framesInFlight << " frames in flight, "
+			<< allocatedBytes * MAX_FRAMES_IN_FLIGHT / BYTES_PER_MB << " MB at " << MAX_FRAMES_IN_FLIGHT;
+	}
+
+	void VulkanRenderer::DestroyFrameAttachment(FrameAttachment& attachment)
+	{
+		vkDestroyImageView(deviceHandle.logicalDevice, attachment.view, nullptr);
+		vkDestroyImage(deviceHandle.logicalDevice, attachment.image, nullptr);
+		Utils::FreeMemory(deviceHandle.logicalDevice, attachment.memory);
+		attachment = {};
+	}
+
+	void VulkanRenderer::RebuildRenderResources(const std::function<void()>& rebuild)
+	{
+		PROFILE_FUNCTION();
+
+		vkDeviceWaitIdle(deviceHandle.logicalDevice);
+
+		const UboViewProjection viewProjection = renderPipelinePtr->GetViewProjection();
+		const bool occlusionCullingEnabled = occlusionCullerPtr->IsEnabled();
+
+		delete occlusionCullerPtr;
+		occlusionCullerPtr = nullptr;
+		delete renderPipelinePtr;
+		renderPipelinePtr = nullptr;
+		delete visibilityBufferPtr;
+		visibilityBufferPtr = nullptr;
+		delete lightClustererPtr;
+		lightClustererPtr = nullptr;
+		delete shadowMapperPtr;
+		shadowMapperPtr = nullptr;
+
+		rebuild();
+
+		CreateVisibilityBuffer();
+		CreateLightClusterer();
+		CreateShadowMapper();
+		CreateRenderPipeline();
+		CreateOcclusionCuller();
+
+		// Registering in creation order gives every texture its previous index
+		for (VkImageView textureImgView : textureImgViews)
+		{
+			renderPipelinePtr->CreateTextureDescriptor(textureImgView, textureSampler);
+		}
+
+		renderPipelinePtr->SetViewProjection(viewProjection);
+		occlusionCullerPtr->SetEnabled(occlusionCullingEnabled);
+	}
+
+	void VulkanRenderer::CreateTextureSampler()
+	{
+		PROFILE_FUNCTION();
+
+		VkSamplerCreateInfo samplerCreateInfo = {};
+		samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+		samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+		samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerCreateInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		samplerCreateInfo.anisotropyEnable = VK_TRUE;
+		samplerCreateInfo.maxAnisotropy = 16.0f;
+		samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
+		samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerCreateInfo.mipLodBias = 0.0f;
+		samplerCreateInfo.minLod = 0.0f;
+		samplerCreateInfo.maxLod = 8.0f;
+
+		VkResult vkResult = vkCreateSampler(deviceHandle.logicalDevice, &samplerCreateInfo, nullptr, &textureSampler);
+
+		if (vkResult != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create texture sampler!");
+		}
+	}
+
+	int32_t VulkanRenderer::CreateTexture(const std::string& fileName, bool useMipmaps /*=false*/)
+	{
+		PROFILE_FUNCTION();
+
+		uint32_t mipmapCount = 1;
+		int32_t textureImgLoc = CreateTextureImage(fileName, useMipmaps ? &mipmapCount : nullptr);
+
+		return CreateTextureDescriptor(textureImgLoc, mipmapCount);
+	}
+
+	int32_t VulkanRenderer::CreateTexture(uint32_t width, uint32_t height, const uint8_t* rgba)
+	{
+		PROFILE_FUNCTION();
+
+		TextureInfo texInfo;
+		texInfo.width = static_cast<int32_t>(width);
+		texInfo.height = static_cast<int32_t>(height);
+		texInfo.channelCount = 4;
+		texInfo.imageSize = static_cast<VkDeviceSize>(width) * height * 4;
+
+		uint32_t mipmapCount = 1;
+		int32_t textureImgLoc = CreateTextureImage(rgba, texInfo, &mipmapCount);
+
+		return CreateTextureDescriptor(textureImgLoc, mipmapCount);
+	}
+
+	int32_t VulkanRenderer::CreateTextureDescriptor(int32_t textureImgLoc, uint32_t mipmapCount)
+	{
+		PROFILE_FUNCTION();
+
+		CreateImageViewInfo createImageViewInfo{};
+		createImageViewInfo.image = textureHandles[textureImgLoc].image;
+		createImageViewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+		createImageViewInfo.aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
+		createImageViewInfo.mipmapCount = mipmapCount;
+
+		VkImageView imgView = CreateImageView(createImageViewInfo);
+		textureImgViews.push_back(imgView);
+
+		int32_t descLoc = renderPipelinePtr->CreateTextureDescriptor(imgView, textureSampler);
+
+		return descLoc;
+	}
+
+	int32_t VulkanRenderer::CreateTextureImage(const std::string& fileName, uint32_t* mipmapCount /*=nullptr*/)
+	{
+		PROFILE_FUNCTION();
+
+		TextureInfo texInfo;
+		stbi_uc* imageData = Utils::LoadTextureFile(fileName, texInfo);
+
+		int32_t textureImgLoc = CreateTextureImage(imageData, texInfo, mipmapCount);
+		stbi_image_free(imageData);
+
+		return textureImgLoc;
+	}
+
+	int32_t VulkanRenderer::CreateTextureImage(const void* pixels, const TextureInfo& texInfo, uint32_t* mipmapCount /*=nullptr*/)
+	{
+		PROFILE_FUNCTION();
+
+		VkBuffer imageStagingBuffer = nullptr;
+		VkDeviceMemory imageStagingBufferMemory = nullptr;
+
+		CreateBufferInfo bufferInfo{};
+		bufferInfo.physicalDevice = deviceHandle.physicalDevice;
+		bufferInfo.device = deviceHandle.logicalDevice;
+		bufferInfo.bufferSize = texInfo.imageSize;
 		bufferInfo.bufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 		bufferInfo.memoryPropFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 		bufferInfo.buffer = &imageStagingBuffer;
@@ -1011,204 +1872,646 @@ namespace Renderer
 
 		void* data = nullptr;
 		vkMapMemory(deviceHandle.logicalDevice, imageStagingBufferMemory, 0, texInfo.imageSize, 0, &data);
-		memcpy(data, imageData, static_cast<size_t>(texInfo.imageSize));
+		PROFILE_COUNT_ADD(UPLOADED_BYTES, texInfo.imageSize);
+		memcpy(data, pixels, static_cast<size_t>(texInfo.imageSize));
 		vkUnmapMemory(deviceHandle.logicalDevice, imageStagingBufferMemory);
 
-		stbi_image_free(imageData);
-
 		// Create image to hold final texture
 		VkImage texImage;
 		VkDeviceMemory texImageMemory;
 
-		if (mipmapCount != nullptr)
+		if (mipmapCount != nullptr)
+		{
+			*mipmapCount = static_cast<uint32_t>(std::floor(std::log2(std::max(texInfo.width, texInfo.height)))) + 1;
+		}
+
+		CreateImageInfo createImageInfo{};
+		createImageInfo.width = texInfo.width;
+		createImageInfo.height = texInfo.height;
+		createImageInfo.mipmapCount = (mipmapCount == nullptr) ? 1 : *mipmapCount;
+		createImageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+		createImageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		createImageInfo.useFlags = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		createImageInfo.propFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+		texImage = CreateImage(createImageInfo, &texImageMemory);
+
+		// Transition, copy and mip generation go in one upload batch, one submission and one wait instead of three
+
+		VkCommandBuffer uploadCommandBuffer = Utils::BeginCmdBuffer(deviceHandle.logicalDevice, gfxCommandPool);
+		const uint32_t uploadScope = gpuProfilerPtr->BeginUploadScope(uploadCommandBuffer, gpuScopeNames.textureUpload);
+
+		// Transition image to be destination for copy operation
+
+		TransitionImageLayoutInfo transitionInfo{};
+		transitionInfo.device = deviceHandle.logicalDevice;
+		transitionInfo.cmdPool = gfxCommandPool;
+		transitionInfo.queue = graphicsQueue;
+		transitionInfo.image = texImage;
+		transitionInfo.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		transitionInfo.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		transitionInfo.mipmapCount = createImageInfo.mipmapCount;
+
+		Utils::RecordTransitionImageLayout(uploadCommandBuffer, transitionInfo);
+
+		// Copy data to image
+
+		CopyImageBufferInfo cpyImgBufInfo{};
+		cpyImgBufInfo.device = deviceHandle.logicalDevice;
+		cpyImgBufInfo.width = texInfo.width;
+		cpyImgBufInfo.height = texInfo.height;
+		cpyImgBufInfo.transferQueue = graphicsQueue;
+		cpyImgBufInfo.transCommandPool = gfxCommandPool;
+		cpyImgBufInfo.srcBuffer = imageStagingBuffer;
+		cpyImgBufInfo.dstImage = texImage;
+
+		Utils::RecordCopyImageBuffer(uploadCommandBuffer, cpyImgBufInfo);
+
+		CreateMipmapInfo createMipmapInfo{};
+		createMipmapInfo.image = texImage;
+		createMipmapInfo.imageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		createMipmapInfo.texWidth = texInfo.width;
+		createMipmapInfo.texHeight = texInfo.height;
+		createMipmapInfo.mipLevels = createImageInfo.mipmapCount;
+
+		GenerateMipmaps(uploadCommandBuffer, createMipmapInfo);
+
+		gpuProfilerPtr->EndUploadScope(uploadCommandBuffer, uploadScope);
+		Utils::EndAndSubmitCmdBuffer(deviceHandle.logicalDevice, gfxCommandPool, graphicsQueue, uploadCommandBuffer);
+
+		textureHandles.push_back({ texImage, texImageMemory });
+
+		vkDestroyBuffer(deviceHandle.logicalDevice, imageStagingBuffer, nullptr);
+		Utils::FreeMemory(deviceHandle.logicalDevice, imageStagingBufferMemory);
+
+		return static_cast<int32_t>(textureHandles.size()) - 1;
+	}
+
+	void VulkanRenderer::GenerateMipmaps(VkCommandBuffer commandBuffer, const CreateMipmapInfo& createMipmapInfo)
+	{
+		// Check if image format supports linear blitting
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(deviceHandle.physicalDevice, createMipmapInfo.imageFormat, &formatProperties);
+
+		if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
+			throw std::runtime_error("texture image format does not support linear blitting!");
+		}
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.image = createMipmapInfo.image;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.subresourceRange.levelCount = 1;
+
+		int32_t mipWidth = createMipmapInfo.texWidth;
+		int32_t mipHeight = createMipmapInfo.texHeight;
+
+		for (uint32_t i = 1; i < createMipmapInfo.mipLevels; i++) {
+			barrier.subresourceRange.baseMipLevel = i - 1;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+				0, nullptr,
+				0, nullptr,
+				1, &barrier);
+			PROFILE_COUNT(PIPELINE_BARRIERS);
+
+			VkImageBlit blit{};
+			blit.srcOffsets[0] = { 0, 0, 0 };
+			blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.mipLevel = i - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = 1;
+			blit.dstOffsets[0] = { 0, 0, 0 };
+			blit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
+			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.dstSubresource.mipLevel = i;
+			blit.dstSubresource.baseArrayLayer = 0;
+			blit.dstSubresource.layerCount = 1;
+
+			vkCmdBlitImage(commandBuffer,
+				createMipmapInfo.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				createMipmapInfo.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1, &blit,
+				VK_FILTER_LINEAR);
+
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+				0, nullptr,
+				0, nullptr,
+				1, &barrier);
+			PROFILE_COUNT(PIPELINE_BARRIERS);
+
+			if (mipWidth > 1) mipWidth /= 2;
+			if (mipHeight > 1) mipHeight /= 2;
+		}
+
+		barrier.subresourceRange.baseMipLevel = createMipmapInfo.mipLevels - 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier);
+		PROFILE_COUNT(PIPELINE_BARRIERS);
+	}
+
+	int32_t VulkanRenderer::CreateModel(const std::string& fileName, float scaleFactor /*= 1.0f*/)
+	{
+		PROFILE_FUNCTION();
+
+		const std::pair<std::string, float> modelKey(fileName, scaleFactor);
+		auto loadedModel = loadedModelMeshes.find(modelKey);
+		if (loadedModel != loadedModelMeshes.end())
+		{
+			return CreateModelFromMeshes(loadedModel->second);
+		}
+
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(MODELS_PATH + fileName, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices);
+
+		if (scene == nullptr)
+		{
+			throw std::runtime_error("Failed to load model : " + fileName);
+		}
+
+		std::vector<std::string> textureNames = Model::LoadMaterials(scene);
+		std::vector<int> matToTex(textureNames.size());
+
+		for (size_t i = 0; i < textureNames.size(); i++)
+		{
+			if (textureNames[i].empty())
+			{
+				matToTex[i] = 0;
+			}
+			else
+			{
+				matToTex[i] = CreateTexture(textureNames[i], true);
+			}
+		}
+
+		std::vector<Mesh> modelMeshes = Model::LoadNode(deviceHandle.physicalDevice, deviceHandle.logicalDevice,
+			graphicsQueue, gfxCommandPool, scene->mRootNode, scene, matToTex, scaleFactor);
+
+		std::vector<int32_t>& meshIds = loadedModelMeshes[modelKey];
+		for (const Mesh& mesh : modelMeshes)
+		{
+			meshIds.push_back(static_cast<int32_t>(sharedMeshes.size()));
+			sharedMeshes.push_back(mesh);
+		}
+
+		return CreateModelFromMeshes(meshIds);
+	}
+
+	int32_t VulkanRenderer::CreateMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, int32_t textureId /*= 0*/)
+	{
+		PROFILE_FUNCTION();
+
+		// Mesh takes non const pointers but only reads through them
+		sharedMeshes.push_back(Mesh(deviceHandle.physicalDevice, deviceHandle.logicalDevice, graphicsQueue, gfxCommandPool,
+			const_cast<std::vector<Vertex>*>(&vertices), const_cast<std::vector<uint32_t>*>(&indices), static_cast<uint32_t>(textureId)));
+
+		return static_cast<int32_t>(sharedMeshes.size()) - 1;
+	}
+
+	int32_t VulkanRenderer::CreateModelFromMeshes(const std::vector<int32_t>& meshIds, const glm::mat4& modelMat /*= glm::mat4(1.0f)*/)
+	{
+		PROFILE_FUNCTION();
+
+		std::vector<Mesh> modelMeshes;
+		modelMeshes.reserve(meshIds.size());
+
+		for (int32_t meshId : meshIds)
+		{
+			if (meshId < 0 || static_cast<size_t>(meshId) >= sharedMeshes.size())
+			{
+				throw std::runtime_error("Failed to create model, Invalid mesh index");
+			}
+			modelMeshes.push_back(sharedMeshes[meshId]);
+		}
+
+		Model model = Model(modelMeshes, false);
+		model.SetModelMatrix(modelMat);
+
+		return AddModel(model);
+	}
+
+	size_t VulkanRenderer::GetModelCount() const
+	{
+		return modelList.size();
+	}
+
+	int32_t VulkanRenderer::AddModel(const Model& model)
+	{
+		PROFILE_FUNCTION();
+
+		uint64_t modelTriangleCount = 0;
+		for (uint32_t meshIndex = 0; meshIndex < model.GetMeshCount(); meshIndex++)
+		{
+			modelTriangleCount += model.GetMesh(meshIndex)->GetIndexCount() / 3;
+		}
+
+		// Checked here rather than when the merged geometry is rebuilt, which happens in the middle of drawing a frame
+		if (gBufferLayout == GBufferLayout::VISIBILITY && drawItemTriangleCount + modelTriangleCount > VISIBILITY_MAX_TRIANGLES)
+		{
+			throw std::runtime_error("Failed to add model, Too many triangles in the scene for visibility IDs");
+		}
+		drawItemTriangleCount += modelTriangleCount;
+
+		modelList.push_back(model);
+
+		const uint32_t modelIndex = static_cast<uint32_t>(modelList.size() - 1);
+		modelFirstDrawItem.push_back(static_cast<uint32_t>(drawItems.size()));
+
+		// New geometry starts out dynamic, cached shadow cascades pick it up once it has settled
+		modelLastMovedFrame.push_back(frameNumber);
+		modelIsDynamic.push_back(true);
+		dynamicModels.push_back(modelIndex);
+
+		for (uint32_t meshIndex = 0; meshIndex < model.GetMeshCount(); meshIndex++)
+		{
+			const VkBuffer indexBuffer = model.GetMesh(meshIndex)->GetIndexBuffer();
+			const uint32_t geometryId = geometryIds.emplace(indexBuffer, static_cast<uint32_t>(geometryIds.size())).first->second;
+
+			drawItems.push_back({ modelIndex, meshIndex, geometryId });
+			drawItemIndexCounts.push_back(static_cast<uint32_t>(model.GetMesh(meshIndex)->GetIndexCount()));
+		}
+
+		drawItemBounds.Resize(drawItems.size());
+		UpdateModelBounds(modelIndex);
+		sceneBvhNeedsBuild = true;
+
+		// Merged once before the next frame, rebuilding it per model would copy every earlier model's geometry again
+		visibilityGeometryDirty = true;
+
+		return modelIndex;
+	}
+
+	void VulkanRenderer::UpdateModelBounds(int32_t modelId)
+	{
+		const Model& model = modelList[modelId];
+		const uint32_t firstDrawItem = modelFirstDrawItem[modelId];
+
+		for (size_t meshIndex = 0; meshIndex < model.GetMeshCount(); meshIndex++)
+		{
+			BoundingBox worldBounds = model.GetMesh(meshIndex)->GetLocalBounds().Transform(model.GetModelMatrix());
+			drawItemBounds.Set(firstDrawItem + meshIndex, worldBounds);
+		}
+	}
+
+	bool VulkanRenderer::IsModelStatic(uint32_t modelIndex) const
+	{
+		return frameNumber - modelLastMovedFrame[modelIndex] > STATIC_MODEL_FRAMES;
+	}
+
+	void VulkanRenderer::UpdateShadowCascades()
+	{
+		PROFILE_FUNCTION();
+
+		const UboViewProjection& viewProjection = renderPipelinePtr->GetViewProjection();
+		FitShadowCascades(viewProjection.view, viewProjection.projection, keyLightDirection, MAX_SHADOW_DISTANCE, SHADOW_MAP_SIZE, shadowCascades);
+
+		// Only recently moved models can hold a cascade out of the cache. Moving ones are kept to the cached cascades of their own
+		// slice so they don't hold the far cascades out too. A model that settles joins the cached cascades it now covers
+		std::array<bool, SHADOW_CASCADE_COUNT> hasDynamicCasters = {};
+		for (size_t i = 0; i < dynamicModels.size();)
+		{
+			const uint32_t modelIndex = dynamicModels[i];
+			const uint32_t firstDrawItem = modelFirstDrawItem[modelIndex];
+			const uint32_t meshCount = static_cast<uint32_t>(modelList[modelIndex].GetMeshCount());
+
+			if (IsModelStatic(modelIndex))
+			{
+				for (uint32_t meshIndex = 0; meshIndex < meshCount; meshIndex++)
+				{
+					shadowCascadeCache.InvalidateStaticBounds(drawItemBounds.Get(firstDrawItem + meshIndex));
+				}
+
+				modelIsDynamic[modelIndex] = false;
+				dynamicModels[i] = dynamicModels.back();
+				dynamicModels.pop_back();
+				continue;
+			}
+
+			for (uint32_t meshIndex = 0; meshIndex < meshCount; meshIndex++)
+			{
+				const BoundingBox bounds = drawItemBounds.Get(firstDrawItem + meshIndex);
+				for (uint32_t cascade = FIRST_CACHED_SHADOW_CASCADE; cascade < SHADOW_CASCADE_COUNT; cascade++)
+				{
+					hasDynamicCasters[cascade] = hasDynamicCasters[cascade] || CascadeSliceContainsCaster(shadowCascades, cascade, viewProjection.view, bounds);
+				}
+			}
+			i++;
+		}
+
+		shadowCascadeCache.Update(shadowCascades, hasDynamicCasters, renderShadowCascades);
+
+		for (std::vector<ShadowMapper::ShadowCaster>& casters : shadowCasters)
+		{
+			casters.clear();
+		}
+
+		UpdateSceneBvh();
+
+		// Cached cascades keep their shadow map, so only the cascades rendered this frame need their casters
+		for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+		{
+			if (!renderShadowCascades[cascade])
+			{
+				continue;
+			}
+
+			// Casters aren't view frustum culled, anything between a cascade and the light can throw a shadow into it,
+			// so the cascade's near plane is replaced by one every point is in front of
+			Frustum casterFrustum = Frustum::FromViewProjection(shadowCascades[cascade].viewProjection);
+			casterFrustum.planes[4] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+			if (drawItems.size() >= BVH_CULLING_MIN_DRAW_ITEMS)
+			{
+				sceneBvh.CullFrustum(casterFrustum, cascadeCasterItems);
+			}
+			else
+			{
+				FrustumCuller::Cull(casterFrustum, drawItemBounds, cascadeCasterItems);
+			}
+
+			// Never cached, the nearest cascades take every moving caster in reach
+			const bool restrictDynamicToSlice = cascade >= FIRST_CACHED_SHADOW_CASCADE;
+
+			for (uint32_t drawItemIndex : cascadeCasterItems)
+			{
+				const DrawItem& drawItem = drawItems[drawItemIndex];
+				const Model& model = modelList[drawItem.modelIndex];
+				const BoundingBox bounds = drawItemBounds.Get(drawItemIndex);
+
+				const bool containsCaster = restrictDynamicToSlice && modelIsDynamic[drawItem.modelIndex]
+					? CascadeSliceContainsCaster(shadowCascades, cascade, viewProjection.view, bounds)
+					: CascadeContainsCaster(shadowCascades[cascade].viewProjection, bounds);
+
+				if (containsCaster)
+				{
+					shadowCasters[cascade].push_back({ model.GetMesh(drawItem.meshIndex), model.GetModelMatrix() });
+				}
+			}
+		}
+		shadowMapperPtr->UpdateCascades(currentFrame, shadowCascades, keyLightDirection);
+
+		shadowStatistics = {};
+		for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+		{
+			if (renderShadowCascades[cascade])
+			{
+				shadowStatistics.cascadesRendered++;
+				shadowStatistics.casterDraws += static_cast<uint32_t>(shadowCasters[cascade].size());
+			}
+			else
+			{
+				shadowStatistics.cascadesCached++;
+			}
+		}
+	}
+
+	void VulkanRenderer::RecordShadowCascades(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		PROFILE_FUNCTION();
+
+		const uint32_t shadowScope = gpuProfilerPtr->BeginScope(commandBuffer, frameIndex, gpuScopeNames.shadows);
+		for (uint32_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+		{
+			if (renderShadowCascades[cascade])
+			{
+				shadowMapperPtr->RecordCascade(commandBuffer, cascade, shadowCascades[cascade].viewProjection, shadowCasters[cascade]);
+			}
+		}
+		gpuProfilerPtr->EndScope(commandBuffer, frameIndex, shadowScope);
+	}
+
+	void VulkanRenderer::UpdateSceneBvh()
+	{
+		PROFILE_FUNCTION();
+
+		if (sceneBvhNeedsBuild)
+		{
+			sceneBvh.Build(drawItemBounds);
+			sceneBvhNeedsBuild = false;
+			bvhRefitItems.clear();
+			framesSinceBvhCheck = 0;
+		}
+		else if (!bvhRefitItems.empty())
+		{
+			sceneBvh.RefitItems(drawItemBounds, bvhRefitItems);
+			bvhRefitItems.clear();
+		}
+	}
+
+	void VulkanRenderer::CullScene()
+	{
+		PROFILE_FUNCTION();
+
+		// Refits keep the topology, so periodically check whether moved objects have made the tree loose enough to rebuild
+		if (++framesSinceBvhCheck >= BVH_REBUILD_CHECK_INTERVAL)
 		{
-			*mipmapCount = static_cast<uint32_t>(std::floor(std::log2(std::max(texInfo.width, texInfo.height)))) + 1;
+			framesSinceBvhCheck = 0;
+			UpdateSceneBvh();
+			sceneBvhNeedsBuild = sceneBvh.NeedsRebuild();
 		}
 
-		CreateImageInfo createImageInfo{};
-		createImageInfo.width = texInfo.width;
-		createImageInfo.height = texInfo.height;
-		createImageInfo.mipmapCount = (mipmapCount == nullptr) ? 1 : *mipmapCount;
-		createImageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-		createImageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-		createImageInfo.useFlags = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-		createImageInfo.propFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		UpdateSceneBvh();
 
-		texImage = CreateImage(createImageInfo, &texImageMemory);
+		const UboViewProjection& viewProjection = renderPipelinePtr->GetViewProjection();
+		Frustum frustum = Frustum::FromViewProjection(viewProjection.projection * viewProjection.view);
 
-		// Transition image to be destination for copy operation
+		if (drawItems.size() >= BVH_CULLING_MIN_DRAW_ITEMS)
+		{
+			sceneBvh.CullFrustum(frustum, visibleDrawItems);
+		}
+		else
+		{
+			FrustumCuller::Cull(frustum, drawItemBounds, visibleDrawItems);
+		}
 
-		TransitionImageLayoutInfo transitionInfo{};
-		transitionInfo.device = deviceHandle.logicalDevice;
-		transitionInfo.cmdPool = gfxCommandPool;
-		transitionInfo.queue = graphicsQueue;
-		transitionInfo.image = texImage;
-		transitionInfo.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		transitionInfo.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		transitionInfo.mipmapCount = createImageInfo.mipmapCount;
+		if (softwareOcclusionEnabled && !modelOccluders.empty())
+		{
+			PROFILE_SCOPE("Software Occlusion Culling");
 
-		Utils::TransitionImageLayout(transitionInfo);
+			softwareOcclusionCuller.BeginFrame(viewProjection.projection * viewProjection.view);
+			for (const ModelOccluder& modelOccluder : modelOccluders)
+			{
+				softwareOcclusionCuller.RenderOccluder(modelOccluder.mesh, modelList[modelOccluder.modelIndex].GetModelMatrix());
+			}
 
-		// Copy data to image
+			softwareOcclusionCuller.CullBoxes(drawItemBounds, visibleDrawItems);
+		}
+	}
 
-		CopyImageBufferInfo cpyImgBufInfo{};
-		cpyImgBufInfo.device = deviceHandle.logicalDevice;
-		cpyImgBufInfo.width = texInfo.width;
-		cpyImgBufInfo.height = texInfo.height;
-		cpyImgBufInfo.transferQueue = graphicsQueue;
-		cpyImgBufInfo.transCommandPool = gfxCommandPool;
-		cpyImgBufInfo.srcBuffer = imageStagingBuffer;
-		cpyImgBufInfo.dstImage = texImage;
+	void VulkanRenderer::BuildDrawList()
+	{
+		PROFILE_FUNCTION();
 
-		Utils::CopyImageBuffer(cpyImgBufInfo);
+		const glm::mat4& view = renderPipelinePtr->GetViewProjection().view;
+		const glm::vec4 viewDepthRow(-view[0][2], -view[1][2], -view[2][2], -view[3][2]);
 
-		textureHandles.push_back({ texImage, texImageMemory });
+		drawList.Clear();
+		drawList.Reserve(visibleDrawItems.size());
 
-		vkDestroyBuffer(deviceHandle.logicalDevice, imageStagingBuffer, nullptr);
-		vkFreeMemory(deviceHandle.logicalDevice, imageStagingBufferMemory, nullptr);
+		for (uint32_t drawItemIndex : visibleDrawItems)
+		{
+			const DrawItem& drawItem = drawItems[drawItemIndex];
+			const Mesh* mesh = modelList[drawItem.modelIndex].GetMesh(drawItem.meshIndex);
 
-		CreateMipmapInfo createMipmapInfo{};
-		createMipmapInfo.image = texImage;
-		createMipmapInfo.imageFormat = VK_FORMAT_R8G8B8A8_UNORM;
-		createMipmapInfo.texWidth = texInfo.width;
-		createMipmapInfo.texHeight = texInfo.height;
-		createMipmapInfo.mipLevels = createImageInfo.mipmapCount;
+			const glm::vec4 center(drawItemBounds.centerX[drawItemIndex], drawItemBounds.centerY[drawItemIndex], drawItemBounds.centerZ[drawItemIndex], 1.0f);
+			const float viewDepth = glm::dot(viewDepthRow, center);
 
-		GenerateMipmaps(createMipmapInfo);
+			// Draws of the same mesh share their buffers. Past the key's geometry bits ids alias, which only costs rebinds
+			drawList.Add(DrawList::MakeKey(0, 0, mesh->GetTexId(), drawItem.geometryId, viewDepth), drawItemIndex);
+		}
 
-		return static_cast<int32_t>(textureHandles.size()) - 1;
+		drawList.Sort();
 	}
 
-	void VulkanRenderer::GenerateMipmaps(const CreateMipmapInfo& createMipmapInfo)
+	int32_t VulkanRenderer::PickModel(double cursorX, double cursorY, float* hitDistance)
 	{
-		// Check if image format supports linear blitting
-		VkFormatProperties formatProperties;
-		vkGetPhysicalDeviceFormatProperties(deviceHandle.physicalDevice, createMipmapInfo.imageFormat, &formatProperties);
+		PROFILE_FUNCTION();
 
-		if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
-			throw std::runtime_error("texture image format does not support linear blitting!");
+		int windowWidth = static_cast<int>(swapChainExtent.width), windowHeight = static_cast<int>(swapChainExtent.height);
+		if (!headless)
+		{
+			glfwGetWindowSize(window, &windowWidth, &windowHeight);
 		}
 
-		VkCommandBuffer commandBuffer = Utils::BeginCmdBuffer(deviceHandle.logicalDevice, gfxCommandPool);
-
-		VkImageMemoryBarrier barrier{};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.image = createMipmapInfo.image;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
-		barrier.subresourceRange.levelCount = 1;
-
-		int32_t mipWidth = createMipmapInfo.texWidth;
-		int32_t mipHeight = createMipmapInfo.texHeight;
+		if (windowWidth == 0 || windowHeight == 0)
+		{
+			return -1;
+		}
 
-		for (uint32_t i = 1; i < createMipmapInfo.mipLevels; i++) {
-			barrier.subresourceRange.baseMipLevel = i - 1;
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		// Projection has its Y flipped for Vulkan, so window Y maps straight onto NDC Y
+		const glm::vec2 ndc(2.0f * static_cast<float>(cursorX) / windowWidth - 1.0f, 2.0f * static_cast<float>(cursorY) / windowHeight - 1.0f);
 
-			vkCmdPipelineBarrier(commandBuffer,
-				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-				0, nullptr,
-				0, nullptr,
-				1, &barrier);
+		const UboViewProjection& viewProjection = renderPipelinePtr->GetViewProjection();
+		const glm::mat4 inverseViewProjection = glm::inverse(viewProjection.projection * viewProjection.view);
 
-			VkImageBlit blit{};
-			blit.srcOffsets[0] = { 0, 0, 0 };
-			blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
-			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			blit.srcSubresource.mipLevel = i - 1;
-			blit.srcSubresource.baseArrayLayer = 0;
-			blit.srcSubresource.layerCount = 1;
-			blit.dstOffsets[0] = { 0, 0, 0 };
-			blit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
-			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			blit.dstSubresource.mipLevel = i;
-			blit.dstSubresource.baseArrayLayer = 0;
-			blit.dstSubresource.layerCount = 1;
+		glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, 0.0f, 1.0f);
+		glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+		nearPoint /= nearPoint.w;
+		farPoint /= farPoint.w;
 
-			vkCmdBlitImage(commandBuffer,
-				createMipmapInfo.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				createMipmapInfo.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				1, &blit,
-				VK_FILTER_LINEAR);
+		return RayCastModels(glm::vec3(nearPoint), glm::normalize(glm::vec3(farPoint - nearPoint)), hitDistance);
+	}
 
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	int32_t VulkanRenderer::RayCastModels(const glm::vec3& origin, const glm::vec3& direction, float* hitDistance)
+	{
+		PROFILE_FUNCTION();
 
-			vkCmdPipelineBarrier(commandBuffer,
-				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-				0, nullptr,
-				0, nullptr,
-				1, &barrier);
+		UpdateSceneBvh();
 
-			if (mipWidth > 1) mipWidth /= 2;
-			if (mipHeight > 1) mipHeight /= 2;
+		BoundingVolumeHierarchy::RayHit hit;
+		if (!sceneBvh.RayCast({ origin, direction }, hit))
+		{
+			return -1;
 		}
 
-		barrier.subresourceRange.baseMipLevel = createMipmapInfo.mipLevels - 1;
-		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		vkCmdPipelineBarrier(commandBuffer,
-			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-			0, nullptr,
-			0, nullptr,
-			1, &barrier);
+		if (hitDistance != nullptr)
+		{
+			*hitDistance = hit.distance;
+		}
 
-		Utils::EndAndSubmitCmdBuffer(deviceHandle.logicalDevice, gfxCommandPool, graphicsQueue, commandBuffer);
+		return static_cast<int32_t>(drawItems[hit.itemIndex].modelIndex);
 	}
 
-	int32_t VulkanRenderer::CreateModel(const std::string& fileName, float scaleFactor /*= 1.0f*/)
+	void VulkanRenderer::RecordCommands(uint32_t frameIndex, uint32_t imageIndex)
 	{
 		PROFILE_FUNCTION();
 
-		Assimp::Importer importer;
-		const aiScene* scene = importer.ReadFile(MODELS_PATH + fileName, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices);
+		FrameContext& frame = frames[frameIndex];
+		VkCommandBuffer commandBuffer = frame.commandBuffer;
 
-		if (scene == nullptr)
-		{
-			throw std::runtime_error("Failed to load model : " + fileName);
-		}
+		// The frame's fence has signalled, so everything allocated from its pool can be recycled at once
+		vkResetCommandPool(deviceHandle.logicalDevice, frame.commandPool, 0);
 
-		std::vector<std::string> textureNames = Model::LoadMaterials(scene);
-		std::vector<int> matToTex(textureNames.size());
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
-		for (size_t i = 0; i < textureNames.size(); i++)
+		VkResult vkResult = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		if (vkResult != VK_SUCCESS)
 		{
-			if (textureNames[i].empty())
-			{
-				matToTex[i] = 0;
-			}
-			else
-			{
-				matToTex[i] = CreateTexture(textureNames[i], true);
-			}
+			throw std::runtime_error("Failed to record command buffer");
 		}
 
-		std::vector<Mesh> modelMeshes = Model::LoadNode(deviceHandle.physicalDevice, deviceHandle.logicalDevice,
-			graphicsQueue, gfxCommandPool, scene->mRootNode, scene, matToTex, scaleFactor);
+		drawStatistics = {};
 
-		Model model = Model(modelMeshes);
-		modelList.push_back(model);
+		gpuProfilerPtr->BeginFrame(commandBuffer, frameIndex);
 
-		return modelList.size() - 1;
-	}
+		// Light lists only depend on the camera, they are ready long before the lighting subpass reads them
+		const uint32_t lightClusteringScope = gpuProfilerPtr->BeginScope(commandBuffer, frameIndex, gpuScopeNames.lightClustering);
+		lightClustererPtr->RecordClusterPass(commandBuffer, frameIndex);
+		gpuProfilerPtr->EndScope(commandBuffer, frameIndex, lightClusteringScope);
 
-	void VulkanRenderer::RecordCommands(uint32_t currentImageIndex)
-	{
-		PROFILE_FUNCTION();
+		// Cached cascades are skipped, the shadow map keeps what they were last rendered with
+		RecordShadowCascades(commandBuffer, frameIndex);
 
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		// Early phase : draw what was visible against last frame's depth pyramid
+		occlusionCullerPtr->RecordCullPass(commandBuffer, frameIndex, OcclusionCuller::CullPhase::EARLY);
+		RecordFrameGraphBarriers(commandBuffer, frameGraphIds.earlyDepthPass, imageIndex);
+
+		VkRenderPassBeginInfo earlyRenderpassBeginInfo = {};
+		earlyRenderpassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		earlyRenderpassBeginInfo.renderPass = earlyRenderPass;
+		earlyRenderpassBeginInfo.renderArea.offset = { 0, 0 };
+		earlyRenderpassBeginInfo.renderArea.extent = swapChainExtent;
+
+		VkClearValue earlyClearValue = {};
+		earlyClearValue.depthStencil.depth = 1.0f;
+		earlyRenderpassBeginInfo.pClearValues = &earlyClearValue;
+		earlyRenderpassBeginInfo.clearValueCount = 1;
+		earlyRenderpassBeginInfo.framebuffer = earlyFrameBuffer;
+
+		const uint32_t earlyDepthScope = gpuProfilerPtr->BeginScope(commandBuffer, frameIndex, gpuScopeNames.earlyDepth);
+		vkCmdBeginRenderPass(commandBuffer, &earlyRenderpassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		RecordGBufferDraws(commandBuffer, frameIndex, renderPipelinePtr->GetEarlyPipeline(),
+			occlusionCullerPtr->GetIndirectBuffer(frameIndex, OcclusionCuller::CullPhase::EARLY));
+		vkCmdEndRenderPass(commandBuffer);
+		gpuProfilerPtr->EndScope(commandBuffer, frameIndex, earlyDepthScope);
+
+		// Late phase : rebuild the pyramid from the early depth and test what it rejected against it
+		RecordFrameGraphBarriers(commandBuffer, frameGraphIds.depthPyramidPass, imageIndex);
+		const uint32_t depthPyramidScope = gpuProfilerPtr->BeginScope(commandBuffer, frameIndex, gpuScopeNames.depthPyramid);
+		occlusionCullerPtr->RecordDepthPyramid(commandBuffer, frameIndex);
+		occlusionCullerPtr->RecordCullPass(commandBuffer, frameIndex, OcclusionCuller::CullPhase::LATE);
+		gpuProfilerPtr->EndScope(commandBuffer, frameIndex, depthPyramidScope);
+
+		// The early depth already covers the early draws, the pre-pass adds the late draws so depth is final before any shading
+		if (depthPrepassEnabled)
+		{
+			earlyRenderpassBeginInfo.renderPass = depthPrepassRenderPass;
+			earlyRenderpassBeginInfo.clearValueCount = 0;
+			earlyRenderpassBeginInfo.pClearValues = nullptr;
+
+			RecordFrameGraphBarriers(commandBuffer, frameGraphIds.depthPrepassPass, imageIndex);
+			const uint32_t depthPrepassScope = gpuProfilerPtr->BeginScope(commandBuffer, frameIndex, gpuScopeNames.depthPrepass);
+			vkCmdBeginRenderPass(commandBuffer, &earlyRenderpassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+			RecordGBufferDraws(commandBuffer, frameIndex, renderPipelinePtr->GetEarlyPipeline(),
+				occlusionCullerPtr->GetIndirectBuffer(frameIndex, OcclusionCuller::CullPhase::LATE));
+			vkCmdEndRenderPass(commandBuffer);
+			gpuProfilerPtr->EndScope(commandBuffer, frameIndex, depthPrepassScope);
+		}
 
 		VkRenderPassBeginInfo renderpassBeginInfo = {};
 		renderpassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -1216,73 +2519,185 @@ namespace Renderer
 		renderpassBeginInfo.renderArea.offset = { 0, 0 };
 		renderpassBeginInfo.renderArea.extent = swapChainExtent;
 
-		std::array<VkClearValue, 5> clearValues = {};
-		clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-		clearValues[1].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-		clearValues[2].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-		clearValues[3].color = { 0.3f, 0.5f, 0.6f, 1.0f };
-		clearValues[4].depthStencil.depth = 1.0f;
 		renderpassBeginInfo.pClearValues = clearValues.data();
 		renderpassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 
-		renderpassBeginInfo.framebuffer = swapchainFrameBuffers[currentImageIndex];
+		renderpassBeginInfo.framebuffer = swapchainFrameBuffers[imageIndex];
 
-		VkResult vkResult = vkBeginCommandBuffer(commandBuffers[currentImageIndex], &beginInfo);
-		if (vkResult != VK_SUCCESS)
+		RecordFrameGraphBarriers(commandBuffer, frameGraphIds.gBufferPass, imageIndex);
+		vkCmdBeginRenderPass(commandBuffer, &renderpassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		const uint32_t gBufferScope = gpuProfilerPtr->BeginScope(commandBuffer, frameIndex, gpuScopeNames.gBuffer);
+
+		// The early draws only laid down depth, they fill the G-buffer here at equal depth before the disoccluded late draws.
+		// Without the pre-pass the late draws still test and write depth, so they can overdraw each other
+		VkPipeline gBufferPipeline = depthPrepassEnabled ? renderPipelinePtr->GetDepthEqualPipeline() : renderPipelinePtr->GetPipeline();
+		RecordGBufferDraws(commandBuffer, frameIndex, gBufferPipeline,
+			occlusionCullerPtr->GetIndirectBuffer(frameIndex, OcclusionCuller::CullPhase::EARLY));
+		RecordGBufferDraws(commandBuffer, frameIndex, gBufferPipeline,
+			occlusionCullerPtr->GetIndirectBuffer(frameIndex, OcclusionCuller::CullPhase::LATE));
+
+		// Start second sub pass
+
+		gpuProfilerPtr->EndScope(commandBuffer, frameIndex, gBufferScope);
+		vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+		const uint32_t lightingScope = gpuProfilerPtr->BeginScope(commandBuffer, frameIndex, gpuScopeNames.lighting);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderPipelinePtr->GetSecondPipeline());
+		PROFILE_COUNT(PIPELINE_BINDS);
+		std::array<VkDescriptorSet, 3> lightingSets = { renderPipelinePtr->GetInputDescriptorSet(frameIndex), lightClustererPtr->GetDescriptorSet(frameIndex),
+			shadowMapperPtr->GetDescriptorSet(frameIndex) };
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderPipelinePtr->GetSecondPipelineLayout(),
+			0, static_cast<uint32_t>(lightingSets.size()), lightingSets.data(), 0, nullptr);
+		PROFILE_COUNT(DESCRIPTOR_SET_BINDS);
+
+		if (gBufferLayout == GBufferLayout::COMPACT)
 		{
-			throw std::runtime_error("Failed to record command buffer");
+			const UboViewProjection& viewProjection = renderPipelinePtr->GetViewProjection();
+
+			PushReconstruction pushReconstruction = {};
+			pushReconstruction.inverseViewProjection = glm::inverse(viewProjection.projection * viewProjection.view);
+			pushReconstruction.inverseExtent = glm::vec2(1.0f / swapChainExtent.width, 1.0f / swapChainExtent.height);
+
+			vkCmdPushConstants(commandBuffer, renderPipelinePtr->GetSecondPipelineLayout(), VK_SHADER_STAGE_FRAGMENT_BIT,
+				0, sizeof(PushReconstruction), &pushReconstruction);
+			drawStatistics.pushConstantUpdates++;
+		}
+		else if (gBufferLayout == GBufferLayout::VISIBILITY)
+		{
+			// Textures and the merged geometry follow the light lists and shadows, the triangle behind each pixel is projected again
+			std::array<VkDescriptorSet, 2> visibilitySets = { renderPipelinePtr->GetTextureDescriptorSet(), visibilityBufferPtr->GetDescriptorSet(frameIndex) };
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderPipelinePtr->GetSecondPipelineLayout(),
+				3, static_cast<uint32_t>(visibilitySets.size()), visibilitySets.data(), 0, nullptr);
+			PROFILE_COUNT(DESCRIPTOR_SET_BINDS);
+			drawStatistics.descriptorSetBinds++;
+
+			const UboViewProjection& viewProjection = renderPipelinePtr->GetViewProjection();
+
+			PushVisibility pushVisibility = {};
+			pushVisibility.viewProjection = viewProjection.projection * viewProjection.view;
+			pushVisibility.inverseExtent = glm::vec2(1.0f / swapChainExtent.width, 1.0f / swapChainExtent.height);
+			pushVisibility.drawCount = visibilityBufferPtr->GetDrawCount();
+
+			vkCmdPushConstants(commandBuffer, renderPipelinePtr->GetSecondPipelineLayout(), VK_SHADER_STAGE_FRAGMENT_BIT,
+				0, sizeof(PushVisibility), &pushVisibility);
+			drawStatistics.pushConstantUpdates++;
 		}
 
-		vkCmdBeginRenderPass(commandBuffers[currentImageIndex], &renderpassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+		PROFILE_COUNT(DRAW_CALLS);
+		drawStatistics.pipelineBinds++;
+		drawStatistics.descriptorSetBinds++;
+		drawStatistics.draws++;
 
-		// Bind pipeline to used in render pass
+		vkCmdEndRenderPass(commandBuffer);
+		gpuProfilerPtr->EndScope(commandBuffer, frameIndex, lightingScope);
 
-		vkCmdBindPipeline(commandBuffers[currentImageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, renderPipelinePtr->GetPipeline());
+		RecordFrameGraphBarriers(commandBuffer, compiledFrameGraph.finalBarriers, imageIndex);
 
-		for (size_t j = 0; j < modelList.size(); j++)
+		vkResult = vkEndCommandBuffer(commandBuffer);
+		if (vkResult != VK_SUCCESS)
 		{
-			Model thisModel = modelList[j];
-			vkCmdPushConstants(commandBuffers[currentImageIndex], renderPipelinePtr->GetPipelineLayout(),
-				VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &thisModel.GetModelMatrix());
+			throw std::runtime_error("Failed to end command buffer");
+		}
+
+	}
 
-			for (size_t k = 0; k < thisModel.GetMeshCount(); k++)
+	void VulkanRenderer::RecordGBufferDraws(VkCommandBuffer commandBuffer, uint32_t frameIndex, VkPipeline pipeline, VkBuffer indirectBuffer)
+	{
+		PROFILE_FUNCTION();
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		PROFILE_COUNT(PIPELINE_BINDS);
+		drawStatistics.pipelineBinds++;
+
+		// The view projection and every texture stay bound for the whole pass, model matrices are push constants
+		std::array<VkDescriptorSet, 2> passSets = { renderPipelinePtr->GetDescriptorSet(frameIndex), renderPipelinePtr->GetTextureDescriptorSet() };
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderPipelinePtr->GetPipelineLayout(),
+			0, static_cast<uint32_t>(passSets.size()), passSets.data(), 0, nullptr);
+		PROFILE_COUNT(DESCRIPTOR_SET_BINDS);
+		drawStatistics.descriptorSetBinds++;
+
+		uint32_t boundModelIndex = std::numeric_limits<uint32_t>::max();
+		uint32_t boundTexId = std::numeric_limits<uint32_t>::max();
+		VkBuffer boundPositionBuffer = VK_NULL_HANDLE;
+		VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+
+		// Consecutive commands recorded with the same state, drawn by one indirect call
+		uint32_t batchFirstDrawItem = 0;
+		uint32_t batchDrawCount = 0;
+
+		auto flushBatch = [&]()
+		{
+			if (batchDrawCount == 0)
 			{
-				VkBuffer vertexBuffers[] = { thisModel.GetMesh(k)->GetVertexBuffer() };
-				VkDeviceSize offsets[] = { 0 };
-				vkCmdBindVertexBuffers(commandBuffers[currentImageIndex], 0, 1, vertexBuffers, offsets);
-				vkCmdBindIndexBuffer(commandBuffers[currentImageIndex], thisModel.GetMesh(k)->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+				return;
+			}
 
-				//Dynamic offset amount
-				uint32_t dynamicOffset = renderPipelinePtr->GetModelUniformAlignment() * static_cast<uint32_t>(j);
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, batchFirstDrawItem * sizeof(VkDrawIndexedIndirectCommand), batchDrawCount,
+				sizeof(VkDrawIndexedIndirectCommand));
+			PROFILE_COUNT(DRAW_CALLS);
+			drawStatistics.draws++;
+			batchDrawCount = 0;
+		};
 
-				std::array<VkDescriptorSet, 2> descSetGroup = {
-					renderPipelinePtr->GetDescriptorSet(currentImageIndex),
-					renderPipelinePtr->GetSamplerDescriptorSet(thisModel.GetMesh(k)->GetTexId()) };
+		// Sorted by state, so only the changes between neighbouring draws are recorded.
+		// Frustum culled on the CPU, the GPU occlusion test decides each command's instance count
+		for (const DrawList::Entry& entry : drawList.GetEntries())
+		{
+			const DrawItem& drawItem = drawItems[entry.drawItem];
+			const Model& thisModel = modelList[drawItem.modelIndex];
+			const Mesh* thisMesh = thisModel.GetMesh(drawItem.meshIndex);
 
-				vkCmdBindDescriptorSets(commandBuffers[currentImageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS,
-					renderPipelinePtr->GetPipelineLayout(), 0, static_cast<uint32_t>(descSetGroup.size()), descSetGroup.data(), 1, &dynamicOffset);
+			const bool pushChanged = drawItem.modelIndex != boundModelIndex || thisMesh->GetTexId() != boundTexId;
+			const bool buffersChanged = thisMesh->GetPositionBuffer() != boundPositionBuffer || thisMesh->GetIndexBuffer() != boundIndexBuffer;
 
-				vkCmdDrawIndexed(commandBuffers[currentImageIndex], static_cast<uint32_t>(thisModel.GetMesh(k)->GetIndexCount()), 1, 0, 0, 0);
+			// Commands of a batch have to be adjacent in the indirect buffer
+			if (pushChanged || buffersChanged || !multiDrawIndirectSupported || entry.drawItem != batchFirstDrawItem + batchDrawCount)
+			{
+				flushBatch();
 			}
-		}
 
-		// Start second sub pass
+			if (pushChanged)
+			{
+				PushModel pushModel = {};
+				pushModel.model = thisModel.GetModelMatrix();
+				pushModel.textureIndex = thisMesh->GetTexId();
+
+				vkCmdPushConstants(commandBuffer, renderPipelinePtr->GetPipelineLayout(),
+					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushModel), &pushModel);
+
+				boundModelIndex = drawItem.modelIndex;
+				boundTexId = thisMesh->GetTexId();
+				drawStatistics.pushConstantUpdates++;
+			}
 
-		vkCmdNextSubpass(commandBuffers[currentImageIndex], VK_SUBPASS_CONTENTS_INLINE);
-		vkCmdBindPipeline(commandBuffers[currentImageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, renderPipelinePtr->GetSecondPipeline());
-		vkCmdBindDescriptorSets(commandBuffers[currentImageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, renderPipelinePtr->GetSecondPipelineLayout(),
-			0, 1, &renderPipelinePtr->GetInputDescriptorSet(currentImageIndex), 0, nullptr);
+			// Both streams change together, depth only pipelines have no binding 1 and never fetch the attributes
+			if (thisMesh->GetPositionBuffer() != boundPositionBuffer)
+			{
+				VkBuffer vertexBuffers[] = { thisMesh->GetPositionBuffer(), thisMesh->GetAttributeBuffer() };
+				VkDeviceSize offsets[] = { 0, 0 };
+				vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+				PROFILE_COUNT(VERTEX_BUFFER_BINDS);
 
-		vkCmdDraw(commandBuffers[currentImageIndex], 3, 1, 0, 0);
+				boundPositionBuffer = thisMesh->GetPositionBuffer();
+				drawStatistics.vertexBufferBinds++;
+			}
 
-		vkCmdEndRenderPass(commandBuffers[currentImageIndex]);
+			if (thisMesh->GetIndexBuffer() != boundIndexBuffer)
+			{
+				vkCmdBindIndexBuffer(commandBuffer, thisMesh->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
 
-		vkResult = vkEndCommandBuffer(commandBuffers[currentImageIndex]);
-		if (vkResult != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to end command buffer");
+				boundIndexBuffer = thisMesh->GetIndexBuffer();
+				drawStatistics.indexBufferBinds++;
+			}
+
+			if (batchDrawCount == 0)
+			{
+				batchFirstDrawItem = entry.drawItem;
+			}
+			batchDrawCount++;
 		}
 
+		flushBatch();
 	}
 
 	bool VulkanRenderer::CheckInstanceExtensionSupport(std::vector<const char*>* checkExtensions) const
@@ -1349,24 +2764,66 @@ namespace Renderer
 		return true;
 	}
 
+	bool VulkanRenderer::CheckCalibratedTimestampSupport() const
+	{
+		PROFILE_FUNCTION();
+
+		uint32_t extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(deviceHandle.physicalDevice, nullptr, &extensionCount, nullptr);
+
+		std::vector<VkExtensionProperties> extensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(deviceHandle.physicalDevice, nullptr, &extensionCount, extensions.data());
+
+		auto found = std::find_if(extensions.begin(), extensions.end(), [](const VkExtensionProperties& extension)
+			{
+				return strcmp(extension.extensionName, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0;
+			});
+
+		auto getTimeDomains = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT");
+		if (found == extensions.end() || getTimeDomains == nullptr)
+		{
+			return false;
+		}
+
+		uint32_t timeDomainCount = 0;
+		getTimeDomains(deviceHandle.physicalDevice, &timeDomainCount, nullptr);
+
+		std::vector<VkTimeDomainEXT> timeDomains(timeDomainCount);
+		getTimeDomains(deviceHandle.physicalDevice, &timeDomainCount, timeDomains.data());
+
+		return std::find(timeDomains.begin(), timeDomains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != timeDomains.end();
+	}
+
 	bool VulkanRenderer::CheckDeviceSuitable(VkPhysicalDevice device) const
 	{
 		PROFILE_FUNCTION();
 
-		VkPhysicalDeviceFeatures deviceFeatures = {};
-		vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
+		VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures = {};
+		descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+		VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
+		deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		deviceFeatures2.pNext = &descriptorIndexingFeatures;
+		vkGetPhysicalDeviceFeatures2(device, &deviceFeatures2);
+		const VkPhysicalDeviceFeatures& deviceFeatures = deviceFeatures2.features;
+
+		const bool bindlessTexturesSupported = descriptorIndexingFeatures.runtimeDescriptorArray && descriptorIndexingFeatures.descriptorBindingPartiallyBound
+			&& descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount && descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+			&& descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending;
 
 		QueueFamilyIndices indices = GetQueueFamilyIndices(device);
-		bool extensionsSupported = CheckDeviceExtensionSupport(device);
+		// Headless rendering needs neither the swapchain extension nor a surface it can present to
+		bool extensionsSupported = headless || CheckDeviceExtensionSupport(device);
 
-		bool swapChainValid = false;
-		if (extensionsSupported)
+		bool swapChainValid = headless;
+		if (extensionsSupported && !headless)
 		{
 			SwapChainInfo swapChainInfo = GetSwapChainDetails(device);
 			swapChainValid = !swapChainInfo.presentationModes.empty() && !swapChainInfo.surfaceFormats.empty();
 		}
 
-		return indices.IsValid() && extensionsSupported && swapChainValid && deviceFeatures.samplerAnisotropy;
+		return indices.IsValid() && extensionsSupported && swapChainValid && deviceFeatures.samplerAnisotropy && deviceFeatures.drawIndirectFirstInstance
+			&& bindlessTexturesSupported;
 	}
 
 	bool VulkanRenderer::CheckValidationLayerSupport(std::vector<const char*>* validationLayers) const
@@ -1416,8 +2873,16 @@ namespace Renderer
 				indices.graphicsFamily = static_cast<int>(index);
 			}
 
+			// Nothing is presented when headless, the graphics queue stands in for the presentation queue
 			VkBool32 presentationSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, static_cast<uint32_t>(index), surface, &presentationSupport);
+			if (headless)
+			{
+				presentationSupport = familyProps[index].queueFlags & VK_QUEUE_GRAPHICS_BIT ? VK_TRUE : VK_FALSE;
+			}
+			else
+			{
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, static_cast<uint32_t>(index), surface, &presentationSupport);
+			}
 
 			if (familyProps[index].queueCount > 0 && presentationSupport)
 			{
@@ -1572,12 +3037,19 @@ namespace Renderer
 		VkMemoryRequirements memoryRequirements;
 		vkGetImageMemoryRequirements(deviceHandle.logicalDevice, image, &memoryRequirements);
 
+		// Only tile based GPUs expose lazily allocated memory, elsewhere transient attachments get ordinary device memory
+		VkMemoryPropertyFlags propFlags = createImageInfo.propFlags;
+		if ((propFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0 && !HasMemoryType(memoryRequirements.memoryTypeBits, propFlags))
+		{
+			propFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		}
+
 		VkMemoryAllocateInfo memoryAllocInfo = {};
 		memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 		memoryAllocInfo.allocationSize = memoryRequirements.size;
-		memoryAllocInfo.memoryTypeIndex = Utils::FindMemoryTypeIndex(deviceHandle.physicalDevice, memoryRequirements.memoryTypeBits, createImageInfo.propFlags);
+		memoryAllocInfo.memoryTypeIndex = Utils::FindMemoryTypeIndex(deviceHandle.physicalDevice, memoryRequirements.memoryTypeBits, propFlags);
 
-		vkResult = vkAllocateMemory(deviceHandle.logicalDevice, &memoryAllocInfo, nullptr, imageMemory);
+		vkResult = Utils::AllocateMemory(deviceHandle.logicalDevice, &memoryAllocInfo, imageMemory);
 		if (vkResult != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to allocate memory for image");
@@ -1588,6 +3060,22 @@ namespace Renderer
 		return image;
 	}
 
+	bool VulkanRenderer::HasMemoryType(uint32_t allowedTypes, VkMemoryPropertyFlags memPropFlags) const
+	{
+		VkPhysicalDeviceMemoryProperties memProps;
+		vkGetPhysicalDeviceMemoryProperties(deviceHandle.physicalDevice, &memProps);
+
+		for (uint32_t i = 0; i < memProps.memoryTypeCount; i++)
+		{
+			if ((allowedTypes & (1 << i)) && (memProps.memoryTypes[i].propertyFlags & memPropFlags) == memPropFlags)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
 	VkImageView VulkanRenderer::CreateImageView(const CreateImageViewInfo& createImageViewInfo)
 	{
 		PROFILE_FUNCTION();
@@ -4,9 +4,23 @@
 #include <GLM/gtc/matrix_transform.hpp>
 #include <vector>
 #include <set>
+#include <map>
 #include "Utils.h"
 #include "Mesh.h"
 #include "Model.h"
+#include "FrustumCulling.h"
+#include "BoundingVolumeHierarchy.h"
+#include "OcclusionCulling.h"
+#include "SoftwareOcclusionCulling.h"
+#include "DrawList.h"
+#include "GBufferLayout.h"
+#include "VisibilityBuffer.h"
+#include "LightClusterer.h"
+#include "CascadedShadows.h"
+#include "ShadowMapper.h"
+#include "RenderGraph.h"
+#include "GpuProfiler.h"
+#include <functional>
 
 using namespace Utilities;
 namespace Renderer
@@ -16,20 +30,206 @@ namespace Renderer
 	class VulkanRenderer
 	{
 	public:
+		/** GPU time of the last completed use of a frame context, zero when the device can't write timestamps on the graphics queue */
+		struct GpuPassTimings
+		{
+			float shadowMs = 0.0f; // Only the cascades that weren't cached
+			float depthMs = 0.0f; // Early occlusion pass and the depth pre-pass
+			float gBufferMs = 0.0f;
+			float lightingMs = 0.0f;
+		};
+
+		/** Key light's shadow cascades rendered and kept from earlier frames in the last frame */
+		struct ShadowStatistics
+		{
+			uint32_t cascadesRendered = 0;
+			uint32_t cascadesCached = 0;
+			uint32_t casterDraws = 0;
+		};
+
+		/** Output of a renderer without a window, surface or swapchain */
+		struct HeadlessCreateInfo
+		{
+			uint32_t width = 1920;
+			uint32_t height = 1080;
+		};
+
 		bool Init(GLFWwindow* window);
+		/** Renders into offscreen colour images with the same passes and pipelines and never touches GLFW or VK_KHR_swapchain,
+		* so it runs on machines without a display and on software ICDs such as lavapipe. Draw() submits without acquiring or presenting */
+		bool InitHeadless(const HeadlessCreateInfo& headlessCreateInfo);
+		bool IsHeadless() const;
+		VkExtent2D GetOutputExtent() const;
+		/** Blocks until the GPU has finished every frame submitted so far */
+		void WaitForFrames();
+		/** Waits for the last submitted frame and copies its output into rgba, width * height RGBA8 pixels from the top left.
+		* Headless only, swapchain images can't be copied from. Returns false when there is nothing to read */
+		bool ReadbackLastFrame(std::vector<uint8_t>& rgba);
+		/** The file is imported and uploaded once per scale, later models of the same file share its meshes */
 		int32_t CreateModel(const std::string& fileName, float scaleFactor = 1.0f);
+		/** Uploads generated geometry once, the returned mesh id can be shared by any number of models */
+		int32_t CreateMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, int32_t textureId = 0);
+		/** Model drawing meshes made with CreateMesh, models sharing a mesh share its buffers */
+		int32_t CreateModelFromMeshes(const std::vector<int32_t>& meshIds, const glm::mat4& modelMat = glm::mat4(1.0f));
+		/** Texture from width * height RGBA8 pixels with a full mip chain, returns its index in the texture array */
+		int32_t CreateTexture(uint32_t width, uint32_t height, const uint8_t* rgba);
+		size_t GetModelCount() const;
 		void Update(int32_t modelId, const glm::mat4& modelMat);
+		/** Moves the camera to location, looking at lookAt with GLOBAL_UP as up */
+		void SetCamera(const glm::vec3& location, const glm::vec3& lookAt);
+		/** Returns the id of the closest model under the cursor position (window coordinates) or -1 if nothing was hit */
+		int32_t PickModel(double cursorX, double cursorY, float* hitDistance = nullptr);
+		int32_t RayCastModels(const glm::vec3& origin, const glm::vec3& direction, float* hitDistance = nullptr);
+		/** GPU Hi-Z occlusion culling, when disabled every frustum visible draw item goes through the early pass */
+		void SetOcclusionCullingEnabled(bool enabled);
+		/** Waits for the GPU and rebuilds every per frame resource, more frames trade latency for CPU and GPU overlap */
+		void SetFramesInFlight(uint32_t frameCount);
+		uint32_t GetFramesInFlight() const;
+		/** Waits for the GPU and rebuilds the G-buffer, render pass and pipelines with the given attachment layout.
+		* The visibility layout is skipped on devices without fragment primitive IDs or non uniform texture indexing */
+		void SetGBufferLayout(GBufferLayout layout);
+		GBufferLayout GetGBufferLayout() const;
+		/** Lays down the late phase's depth before the G-buffer pass, which then tests equal without writing depth so overdrawn
+		* pixels never pay G-buffer bandwidth. Waits for the GPU and recompiles the frame graph's render passes */
+		void SetDepthPrepassEnabled(bool enabled);
+		bool IsDepthPrepassEnabled() const;
+		const GpuPassTimings& GetGpuPassTimings() const;
+		/** Simplified stand in geometry for a large model, rasterized on the CPU to reject draw items behind it before submission */
+		void SetModelOccluder(int32_t modelId, const OccluderMesh& occluderMesh);
+		void SetSoftwareOcclusionCullingEnabled(bool enabled);
+		const SoftwareOcclusionCuller::Statistics& GetSoftwareOcclusionStatistics() const;
+		/** Draws and state changes recorded for the last frame */
+		const DrawList::Statistics& GetDrawStatistics() const;
+		/** Point lights shaded by the clustered lighting pass on top of the key light, returns the light's id */
+		uint32_t AddLight(const PointLight& light);
+		void UpdateLight(uint32_t lightId, const PointLight& light);
+		void ClearLights();
+		size_t GetLightCount() const;
+		/** Direction from the scene towards the shadow casting key light, changing it re-renders every shadow cascade */
+		void SetKeyLightDirection(const glm::vec3& toLight);
+		const glm::vec3& GetKeyLightDirection() const;
+		const ShadowStatistics& GetShadowStatistics() const;
+		/** Schedule, render passes, barriers and transient memory plan the frame graph compiled to */
+		std::string DescribeFrameGraph() const;
 		void Draw();
 		void CleanUp();
 
 	private:
+		struct DrawItem
+		{
+			uint32_t modelIndex;
+			uint32_t meshIndex;
+			uint32_t geometryId; // Same for every draw of a shared mesh, the draw list groups them by it
+		};
+
+		struct ModelOccluder
+		{
+			uint32_t modelIndex;
+			OccluderMesh mesh;
+		};
+
+		struct FrameAttachment
+		{
+			VkImage image = nullptr;
+			VkDeviceMemory memory = nullptr;
+			VkImageView view = nullptr;
+		};
+
+		/** Resources and passes of the frame graph the render passes are compiled from */
+		struct FrameGraphIds
+		{
+			RenderGraphResource swapchain;
+			RenderGraphResource depth;
+			std::vector<RenderGraphResource> gBuffer; // GetGBufferColourTargets order
+			RenderGraphResource shadowMap;
+			RenderGraphResource lightLists;
+			RenderGraphResource depthPyramid;
+			RenderGraphPass earlyDepthPass;
+			RenderGraphPass depthPyramidPass;
+			RenderGraphPass depthPrepassPass; // Only declared while the depth pre-pass is enabled
+			RenderGraphPass gBufferPass;
+			RenderGraphPass lightingPass;
+		};
+
+		/** Everything a frame in flight writes, reused once its fence signals. Uniforms and descriptor sets are indexed by the same frame index */
+		struct FrameContext
+		{
+			VkCommandPool commandPool = nullptr;
+			VkCommandBuffer commandBuffer = nullptr;
+
+			VkSemaphore imageAvailable = nullptr;
+			VkSemaphore renderFinished = nullptr;
+			VkFence drawFence = nullptr;
+		};
+
+		/** Profiler names of the GPU scopes recorded around passes and uploads */
+		struct GpuScopeNames
+		{
+			uint32_t lightClustering;
+			uint32_t shadows;
+			uint32_t earlyDepth;
+			uint32_t depthPyramid; // Pyramid downsample and the late cull pass
+			uint32_t depthPrepass;
+			uint32_t gBuffer;
+			uint32_t lighting;
+			uint32_t textureUpload;
+		};
+
 		mutable DeviceHandle deviceHandle;
 
 		GLFWwindow* window = nullptr;
-		int currentFrame = 0;
+		bool headless = false;
+		HeadlessCreateInfo headlessCreateInfo;
+		std::vector<FrameAttachment> offscreenTargets; // Headless stand ins for the swapchain images, views shared with swapChainImages
+		uint32_t lastImageIndex = 0; // Output image of the last submitted frame
+		uint32_t currentFrame = 0;
+		uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+		std::vector<FrameContext> frames;
+
+		// G-buffer shared by every frame in flight, the render pass dependencies order each frame's use after the previous one's.
+		// Colour targets never leave the main render pass so they are transient, depth is kept for the Hi-Z downsample
+		GBufferLayout gBufferLayout = GBufferLayout::STANDARD;
+		std::vector<FrameAttachment> gBufferAttachments; // Colour targets in GetGBufferColourTargets order
+		FrameAttachment depthAttachment;
+		VkFramebuffer earlyFrameBuffer = nullptr;
+		std::vector<VkFramebuffer> swapchainFrameBuffers; // One per swapchain image, pairing it with the shared G-buffer
 
 		//Scene Objects
 		std::vector<Model> modelList;
+		std::map<VkBuffer, uint32_t> geometryIds; // Keyed on the index buffer, so every draw of a mesh gets the same id
+		std::vector<Mesh> sharedMeshes; // Made with CreateMesh or CreateModel, owned here rather than by the models drawing them
+		std::map<std::pair<std::string, float>, std::vector<int32_t>> loadedModelMeshes; // Shared mesh ids of every file and scale CreateModel imported
+		std::vector<DrawItem> drawItems; // One per mesh of every model
+		std::vector<uint32_t> modelFirstDrawItem; // Models own a contiguous range of draw items
+		std::vector<uint32_t> drawItemIndexCounts; // Same order as drawItems, written into the indirect draw commands
+		uint64_t drawItemTriangleCount = 0; // Triangles of every draw item, the visibility layout gives each its own ID
+		BoundingBoxSoA drawItemBounds; // World space bounds, same order as drawItems
+		std::vector<uint32_t> visibleDrawItems; // Indices into drawItems that passed culling this frame
+		DrawList drawList; // Visible draw items sorted by state
+		DrawList::Statistics drawStatistics;
+		BoundingVolumeHierarchy sceneBvh; // Built over drawItemBounds
+		std::vector<uint32_t> bvhRefitItems; // Draw items moved since the last refit
+		bool sceneBvhNeedsBuild = true;
+		bool visibilityGeometryDirty = false; // Models were added since the merged visibility geometry was last built
+		uint32_t framesSinceBvhCheck = 0;
+		SoftwareOcclusionCuller softwareOcclusionCuller;
+		std::vector<ModelOccluder> modelOccluders;
+		bool softwareOcclusionEnabled = false;
+		bool depthPrepassEnabled = false;
+		GpuPassTimings gpuPassTimings;
+		GpuScopeNames gpuScopeNames;
+		std::vector<PointLight> lights; // Indexed by light id
+		uint64_t frameNumber = 0;
+		std::vector<uint64_t> modelLastMovedFrame; // Frame number of each model's last move, recently moved models are dynamic shadow casters
+		std::vector<uint32_t> dynamicModels; // Models drawn as dynamic shadow casters until UpdateShadowCascades sees them settle
+		std::vector<bool> modelIsDynamic; // Whether each model is in dynamicModels
+		glm::vec3 keyLightDirection = DEFAULT_KEY_LIGHT_DIRECTION;
+		ShadowCascades shadowCascades;
+		ShadowCascadeCache shadowCascadeCache;
+		std::array<bool, SHADOW_CASCADE_COUNT> renderShadowCascades = {};
+		std::array<std::vector<ShadowMapper::ShadowCaster>, SHADOW_CASCADE_COUNT> shadowCasters;
+		std::vector<uint32_t> cascadeCasterItems; // Draw items the scene query returned for the cascade being gathered
+		ShadowStatistics shadowStatistics;
 
 		VkInstance instance;
 		VkQueue graphicsQueue;
@@ -40,46 +240,40 @@ namespace Renderer
 		VkExtent2D swapChainExtent;
 		VkSampler textureSampler;
 
-		mutable VkDeviceSize minUniformBufferOffset;
+		mutable float timestampPeriod = 0.0f; // Nanoseconds per tick, zero when the graphics queue can't write timestamps
+		bool calibratedTimestampsSupported = false;
 
-		VkRenderPass renderPass;
+		// Render passes, their dependencies and attachment operations come from the compiled frame graph
+		RenderGraph frameGraph;
+		CompiledRenderGraph compiledFrameGraph;
+		FrameGraphIds frameGraphIds;
+		std::vector<VkClearValue> clearValues; // Main render pass, in its compiled attachment order
+		VkRenderPass renderPass = nullptr; // G-buffer and lighting subpasses
+		VkRenderPass earlyRenderPass = nullptr; // Early occlusion culling phase, depth only
+		VkRenderPass depthPrepassRenderPass = nullptr; // Loads the early depth and adds the late phase's, same framebuffer as the early pass
 		RenderPipeline* renderPipelinePtr = nullptr;
+		OcclusionCuller* occlusionCullerPtr = nullptr;
+		VisibilityBuffer* visibilityBufferPtr = nullptr; // Only created for the visibility layout
+		bool visibilityBufferSupported = false;
+		bool multiDrawIndirectSupported = false; // Without it every indirect call draws a single command
+		LightClusterer* lightClustererPtr = nullptr;
+		ShadowMapper* shadowMapperPtr = nullptr;
+		GpuProfiler* gpuProfilerPtr = nullptr;
 
 		std::vector<SwapChainImage> swapChainImages;
-		std::vector<VkFramebuffer> swapchainFrameBuffers;
-		std::vector<VkCommandBuffer> commandBuffers;
-
-		VkCommandPool gfxCommandPool;
 
-		std::vector<VkImage> albedoBufferImage;
-		std::vector<VkDeviceMemory> albedoBufferImageMemory;
-		std::vector<VkImageView> albedoBufferImageView;
-
-		std::vector<VkImage> positionBufferImage;
-		std::vector<VkDeviceMemory> positionBufferImageMemory;
-		std::vector<VkImageView> positionBufferImageView;
-
-		std::vector<VkImage> normalBufferImage;
-		std::vector<VkDeviceMemory> normalBufferImageMemory;
-		std::vector<VkImageView> normalBufferImageView;
-
-		std::vector<VkImage> depthBufferImage;
-		std::vector<VkDeviceMemory> depthBufferImageMemory;
-		std::vector<VkImageView> depthBufferImageView;
+		VkCommandPool gfxCommandPool; // One time transfer and setup work, frames record from their own pools
 
 		// Assets
 		std::vector<TextureHandle> textureHandles;
 		std::vector<VkImageView> textureImgViews;
 
-		// Synchronization
-		std::vector<VkSemaphore> imageAvailable;
-		std::vector<VkSemaphore> renderFinished;
-		std::vector<VkFence> drawFences;
-
 		// Misc
 		VkDebugUtilsMessengerEXT debugMessenger;
 
 
+		/** Everything Init and InitHeadless share, surface and swapchain creation are skipped when headless */
+		bool InitRenderer();
 		void CreateInstance();
 		void CreateValidationDebugMessenger();
 		void DestroyValidationDebugMessenger();
@@ -87,24 +281,66 @@ namespace Renderer
 		void CreateLogicalDevice();
 		void CreateSurface();
 		void CreateSwapChain();
-		void CreateRenderPass();
+		/** One colour image per frame that can be in flight, each frame context renders into the image with its index */
+		void CreateOffscreenTargets();
+		/** Declares this frame's passes and what they read and write, for the current G-buffer layout and depth pre-pass setting */
+		void BuildFrameGraph();
+		void CreateRenderPasses();
+		void DestroyRenderPasses();
+		VkRenderPass CreateCompiledRenderPass(const CompiledRenderGraph::RenderPass& compiledRenderPass) const;
+		/** Graph resources the renderer owns, imported ones are kept by the culler, clusterer and shadow mapper */
+		FrameAttachment GetFrameGraphAttachment(RenderGraphResource resource, uint32_t imageIndex) const;
+		/** Image barriers for layout changes, memory barriers for everything else */
+		void RecordFrameGraphBarriers(VkCommandBuffer commandBuffer, const std::vector<RenderGraphBarrier>& barriers, uint32_t imageIndex) const;
+		void RecordFrameGraphBarriers(VkCommandBuffer commandBuffer, RenderGraphPass pass, uint32_t imageIndex) const;
 		void CreateRenderPipeline();
-		void CreateAlbedoBufferImage();
-		void CreatePositionBufferImage();
-		void CreateNormalBufferImage();
+		void CreateColourBufferImage(VkFormat format, FrameAttachment& attachment);
 		void CreateDepthBufferImage();
 		void CreateFrameBuffers();
+		void CreateGBuffer();
+		void DestroyGBuffer();
+		/** Prints the G-buffer's allocated and committed memory against what one G-buffer per frame in flight would take */
+		void ReportGBufferMemory() const;
 		void CreateCommandPool();
-		void CreateCommandBuffers();
-		void CreateSynchronization();
+		void CreateOcclusionCuller();
+		void CreateVisibilityBuffer();
+		void CreateLightClusterer();
+		void CreateShadowMapper();
+		void CreateCommandBuffer(FrameContext& frame);
+		void CreateSynchronization(FrameContext& frame);
+		void CreateGpuProfiler();
+		/** Reads the frame context's GPU scopes from its previous submission and sums them into the pass timings, its fence must have signalled */
+		void ReadGpuPassTimings(uint32_t frameIndex);
+		void CreateFrameContexts();
+		void DestroyFrameContexts();
+		void DestroyFrameAttachment(FrameAttachment& attachment);
+		/** Waits for the GPU and recreates the pipeline and culler around the rebuild, keeping textures, camera and culling state */
+		void RebuildRenderResources(const std::function<void()>& rebuild);
 		void CreateTextureSampler();
 		int32_t CreateTexture(const std::string& fileName, bool useMapMaps = false);
 		/** Will return texture Id and if mipmapCount reference is passed in then will create texture with mipmaps enabled */
 		int32_t CreateTextureImage(const std::string& fileName, uint32_t* mipmapCount = nullptr);
-		void GenerateMipmaps(const CreateMipmapInfo& createMipmapInfo);
-		void RecordCommands(uint32_t currentImageIndex);
+		int32_t CreateTextureImage(const void* pixels, const TextureInfo& texInfo, uint32_t* mipmapCount = nullptr);
+		/** Creates the view of a texture image and its descriptor, returns its index in the texture array */
+		int32_t CreateTextureDescriptor(int32_t textureImgLoc, uint32_t mipmapCount);
+		/** Registers a model's draw items, bounds and uniforms, shared by every way of creating a model */
+		int32_t AddModel(const Model& model);
+		void GenerateMipmaps(VkCommandBuffer commandBuffer, const CreateMipmapInfo& createMipmapInfo);
+		void UpdateModelBounds(int32_t modelId);
+		void UpdateSceneBvh();
+		/** Models that haven't moved for STATIC_MODEL_FRAMES frames have settled and may stay in cached shadow cascades */
+		bool IsModelStatic(uint32_t modelIndex) const;
+		/** Fits this frame's cascades, gathers their casters and decides which cascades are rendered */
+		void UpdateShadowCascades();
+		void RecordShadowCascades(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		void CullScene();
+		void BuildDrawList();
+		void RecordCommands(uint32_t frameIndex, uint32_t imageIndex);
+		void RecordGBufferDraws(VkCommandBuffer commandBuffer, uint32_t frameIndex, VkPipeline pipeline, VkBuffer indirectBuffer);
 		bool CheckInstanceExtensionSupport(std::vector<const char*>* checkExtensions) const;
 		bool CheckDeviceExtensionSupport(VkPhysicalDevice physDevice) const;
+		/** VK_EXT_calibrated_timestamps with the device time domain, lets GPU scopes be put on the CPU clock without a submission */
+		bool CheckCalibratedTimestampSupport() const;
 		bool CheckDeviceSuitable(VkPhysicalDevice device) const;
 		bool CheckValidationLayerSupport(std::vector<const char*>* validationLayers) const;
 		QueueFamilyIndices GetQueueFamilyIndices(VkPhysicalDevice device) const;
@@ -113,7 +349,9 @@ namespace Renderer
 		VkPresentModeKHR GetSuitablePresentationMode(const std::vector<VkPresentModeKHR>& presentationMode) const;
 		VkExtent2D GetSuitableSwapExtent(const VkSurfaceCapabilitiesKHR& surfaceCapabilities) const;
 		VkFormat GetSuitableFormat(const std::vector<VkFormat>& formats, VkImageTiling tiling, VkFormatFeatureFlags featureFlags) const;
+		/** Falls back to device local memory when lazily allocated memory is requested but the device has none for the image */
 		VkImage CreateImage(const CreateImageInfo& createImageInfo, VkDeviceMemory* imageMemory) const;
+		bool HasMemoryType(uint32_t allowedTypes, VkMemoryPropertyFlags memPropFlags) const;
 		VkImageView CreateImageView(const CreateImageViewInfo& createImageViewInfo);
 
 		static VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData);